@@ -31,7 +31,8 @@
 // FilmScan -- objects for handling scanned images of film.
 //
 // FilmFrame - a scan of a single frame. Pixel values are mapped to [0-1], with
-//             zero being black and one being white.
+//             zero being black and one being white (or [0-65535] for
+//             FilmFrame16).
 // FilmStrip - a sequence of FilmFrames (usually short; not the entire film)
 // FilmScan - the main interface to a scanned film source (not used currently,
 //            see project.h instead for an object that holds the working
@@ -41,7 +42,7 @@
 #define FILESCAN_CPP
 
 #include <iostream>
-#include <dirent.h>
+#include <algorithm>
 #include <errno.h>
 #include <ctype.h>
 #include <cmath>
@@ -90,6 +91,8 @@
 #endif
 
 #include "DPX.h"
+#include "dpxunpack.h"
+#include "imagesequence.h"
 #include "readframedpx.h"
 #include "readframetiff.h"
 #include "vfbexception.h"
@@ -106,98 +109,181 @@
 //-----------------------------------------------------------------------------
 Video::~Video()
 {
+	// the decode thread uses the codec and format contexts
+	decoder.Stop();
+
 	if(frameNative) av_frame_free(&frameNative);
 	if(frameGray16)
 	{
 		av_frame_free(&frameGray16);
 	}
-	if(frameRGB)
-	{
-		av_frame_free(&frameRGB);
-	}
 	if(convertGray16) sws_freeContext(convertGray16);
 	if(convertRGB) sws_freeContext(convertRGB);
-	if(codec) avcodec_close(codec);
+	if(codec) avcodec_free_context(&codec);
 	if(format) avformat_close_input(&format);
 }
 
 //----------------------------------------------------------------------------
-bool Video::ReadNextFrame(size_t currfnum)
+// FrameTimestamp - presentation time of a decoded frame, in stream ticks
+static int64_t FrameTimestamp(const AVFrame *frame)
 {
-	AVPacket packet;
-	int done;
-	int frame_id;
+	if(frame->best_effort_timestamp != AV_NOPTS_VALUE)
+		return frame->best_effort_timestamp;
+	return (frame->pts != AV_NOPTS_VALUE) ? frame->pts : frame->pkt_dts;
+}
 
-	//if(this->frameNative == NULL) this->frameNative = av_frame_alloc();
+//----------------------------------------------------------------------------
+long Video::FrameNumberOf(int64_t ts) const
+{
+	if(this->index.IsReady()) return this->index.FrameAt(ts);
+	return long(std::llround((ts - this->startPTS) / this->ticksPerFrame));
+}
 
-	while(av_read_frame(this->format, &packet)>=0)
+//----------------------------------------------------------------------------
+int64_t Video::TimestampOf(long frameNum) const
+{
+	if(this->index.IsReady())
 	{
-		// Is this a packet from the right stream?
-		if(packet.stream_index == this->streamIdx)
-		{
-			// Decode video frame
-            avcodec_decode_video2(this->codec, this->frameNative, &done,
-					&packet);
+		if(frameNum >= this->index.NumFrames())
+			frameNum = this->index.NumFrames() - 1;
+		return this->index.PTS(std::max(0L, frameNum));
+	}
+	return this->startPTS + std::llround(frameNum * this->ticksPerFrame);
+}
 
-			// Did we get a complete video frame?
-			if(done)
-			{
-				this->dts = packet.dts;
-				this->curFrame = currfnum;
-				// this->curFrame = (this->dts - this->dtsBase)/this->dtsStep + 1;
+//----------------------------------------------------------------------------
+// SeekBefore - restart the decode thread on the keyframe at or before
+// frameNum. The decoder then has to be run forward to the frame.
+void Video::SeekBefore(long frameNum)
+{
+	long key = this->index.IsReady() ?
+		this->index.KeyframeBefore(frameNum) : frameNum;
 
-				av_packet_unref(&packet);
-				return true;
-			}
-		}
-		av_packet_unref(&packet);
-	}
-	this->dts = 0;
-	this->curFrame = 0;
+	this->decoder.Seek(TimestampOf(key));
 
-	return false;
+	this->decodedFrame = -1;
 }
 
-bool Video::ReadFrame(size_t frameNum = 0)
+//----------------------------------------------------------------------------
+// DecodeNextFrame - take the next frame (in presentation order) off the
+// decode thread's queue into frameNative and return its frame number. False
+// at the end of the stream.
+bool Video::DecodeNextFrame(long &frameNum)
 {
+	AVFrame *frame = this->decoder.Next();
+	if(!frame) return false;
 
-	//if(frameNum == 0) return ReadNextFrame();
+	// the queued frame's buffers move over; nothing is copied
+	av_frame_unref(this->frameNative);
+	av_frame_move_ref(this->frameNative, frame);
+	av_frame_free(&frame);
 
-	// asking for the current frame again?
-	if(this->curFrame == frameNum) return true;
+	frameNum = FrameNumberOf(FrameTimestamp(this->frameNative));
+	this->decodedFrame = frameNum;
+	return true;
+}
+
+//----------------------------------------------------------------------------
+// ReadFrame - make frameNum the current frame. Frames near the last one
+// read are usually in the GOP cache. Otherwise the decoder runs forward if
+// frameNum is ahead of it in the same GOP, or seeks to the keyframe before
+// frameNum; every frame decoded on the way is cached.
+bool Video::ReadFrame(size_t n)
+{
+	long frameNum = long(n);
 
-	// asking for the next frame explicitly?
-	if(this->curFrame+1 == frameNum) return ReadNextFrame(frameNum);
+	// frames cached under the constant frame rate assumption may be
+	// numbered differently by the index, so start over once it is ready
+	if(!this->indexed && this->index.IsReady())
+	{
+		this->indexed = true;
+		this->gop.Clear();
+		this->current = NULL;
+		this->curFrame = -1;
+		this->decodedFrame = -1;
+	}
 
-	size_t target = this->dtsBase + (frameNum)*this->dtsStep;
+	// asking for the current frame again?
+	if(this->current && this->curFrame == frameNum) return true;
 
-	int seekflags = AVSEEK_FLAG_ANY;
+	const AVFrame *cached = this->gop.Find(frameNum);
+	if(cached)
+	{
+		this->current = cached;
+		this->curFrame = frameNum;
+		return true;
+	}
 
-	if(target < this->dts) seekflags |= AVSEEK_FLAG_BACKWARD;
+	bool ahead = this->decodedFrame >= 0 && frameNum > this->decodedFrame &&
+		(this->index.IsReady() ?
+			this->index.KeyframeBefore(frameNum) <= this->decodedFrame :
+			frameNum - this->decodedFrame <= VIDEO_GOP_CACHE_FRAMES);
+	if(!ahead) SeekBefore(frameNum);
 
-	av_seek_frame(this->format, this->streamIdx, target, seekflags);
+	long decoded;
+	while(DecodeNextFrame(decoded))
+	{
+		const AVFrame *copy = this->gop.Put(decoded, this->frameNative);
 
-	// do
-	// {
-	//    if(!ReadNextFrame()) return false;
-	// } while(this->dts < target);
-	if(!ReadNextFrame(frameNum)) return false;
+		// past it means frameNum has no frame of its own: show the next
+		if(decoded >= frameNum)
+		{
+			this->current = copy ? copy : this->frameNative;
+			this->curFrame = frameNum;
+			return true;
+		}
+	}
 
-	return true;
+	this->current = NULL;
+	this->curFrame = -1;
+	return false;
 }
 
-double *Video::GetFrame(size_t frameNum, double *buf=NULL)
+//----------------------------------------------------------------------------
+// NativeLayout - can frames of this pixel format be handed over as they are?
+// They can if every component is a plane of its own, of 8 bit or (little
+// endian) 16 bit samples: planar YUV, planar GBR and gray.
+static bool NativeLayout(int pixFmt, FrameTexture::PlaneLayout &layout,
+		int &nPlanes, int &depth)
 {
+	const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(AVPixelFormat(pixFmt));
+	if(desc == NULL) return false;
 
-	if(buf == NULL)
+	if(desc->flags & (AV_PIX_FMT_FLAG_BE | AV_PIX_FMT_FLAG_PAL |
+			AV_PIX_FMT_FLAG_BITSTREAM | AV_PIX_FMT_FLAG_HWACCEL |
+			AV_PIX_FMT_FLAG_FLOAT | AV_PIX_FMT_FLAG_ALPHA))
+		return false;
+
+	nPlanes = desc->nb_components;
+	if(nPlanes != 1 && nPlanes != 3) return false;
+
+	bool rgb = (desc->flags & AV_PIX_FMT_FLAG_RGB) != 0;
+	layout = (nPlanes == 1) ? FrameTexture::PLANES_GRAY :
+		(rgb ? FrameTexture::PLANES_GBR : FrameTexture::PLANES_YUV);
+
+	// R, G and B components live in planes 2, 0 and 1
+	static const int gbrPlane[3] = { 2, 0, 1 };
+
+	depth = desc->comp[0].depth;
+	int bytes = (depth > 8) ? 2 : 1;
+	for(int c=0; c<nPlanes; ++c)
 	{
-		buf = new double [this->codec->width * this->codec->height];
-		if(buf == NULL)
-		{
-			throw vfbexception("Out of Memory: DPX buf");
-		}
+		const AVComponentDescriptor &comp = desc->comp[c];
+		int plane = (layout == FrameTexture::PLANES_GBR) ? gbrPlane[c] : c;
+		if(comp.plane != plane || comp.step != bytes || comp.offset != 0 ||
+				comp.shift != 0 || comp.depth != depth)
+			return false;
 	}
 
+	return depth >= 8 && depth <= 16;
+}
+
+//----------------------------------------------------------------------------
+// GetFramePlanes - hand frameNum's decoded planes to frame without copying or
+// converting anything: frame keeps a reference to the decoder's buffers.
+// False if the pixel format can't be used as it is (see NativeLayout()).
+bool Video::GetFramePlanes(size_t frameNum, FrameTexture *frame)
+{
 	if(this->ReadFrame(frameNum) == false)
 	{
 		throw vfbexception(
@@ -205,43 +291,124 @@ double *Video::GetFrame(size_t frameNum, double *buf=NULL)
 					arg(frameNum));
 	}
 
-	//if(this->frameGray16 == NULL) this->frameGray16 = av_frame_alloc();
+	FrameTexture::PlaneLayout layout;
+	int nPlanes, depth;
+	if(!NativeLayout(this->current->format, layout, nPlanes, depth))
+		return false;
 
-	// Convert the image from its native format to Gray16
-	sws_scale(this->convertGray16,
-			(uint8_t const * const *)this->frameNative->data,
-			this->frameNative->linesize, 0, this->codec->height,
-			this->frameGray16->data, this->frameGray16->linesize);
+	for(int i=0; i<nPlanes; ++i)
+		if(this->current->linesize[i] < 0) return false;
 
-	// translate Gray16 to double:
-	const uint16_t *buf16;
-	double scale = 1.0/(0x00FFFF);
-	long i(0);
-	for(int y=0; y<this->codec->height; ++y)
+	AVFrame *ref = av_frame_clone(this->current);
+	if(ref == NULL)
+	{
+		throw vfbexception("Out of Memory: video frame reference");
+	}
+	std::shared_ptr<void> owner(ref, [](void *p) {
+			AVFrame *f = (AVFrame *)p;
+			av_frame_free(&f);
+		});
+
+	const AVPixFmtDescriptor *desc =
+		av_pix_fmt_desc_get(AVPixelFormat(ref->format));
+	FrameTexture::Plane planes[3];
+	for(int i=0; i<nPlanes; ++i)
 	{
-		buf16 = (uint16_t *)
-				(this->frameGray16->data[0] + y*this->frameGray16->linesize[0]);
+		bool chroma = (layout == FrameTexture::PLANES_YUV) && i > 0;
+		int sx = chroma ? desc->log2_chroma_w : 0;
+		int sy = chroma ? desc->log2_chroma_h : 0;
+
+		planes[i].data = ref->data[i];
+		planes[i].stride = ref->linesize[i];
+		planes[i].width = AV_CEIL_RSHIFT(ref->width, sx);
+		planes[i].height = AV_CEIL_RSHIFT(ref->height, sy);
+	}
+
+	frame->SetPlanes(owner, layout, nPlanes, planes, depth);
 
-		for(int x=0; x<this->codec->width; ++x)
-			buf[i++] = double(buf16[x]) * scale;
+	// the YUV matrix, guessing from the frame size when it isn't tagged
+	switch(ref->colorspace)
+	{
+	case AVCOL_SPC_BT470BG:
+	case AVCOL_SPC_SMPTE170M:
+		frame->kr = 0.299f;
+		frame->kb = 0.114f;
+		break;
+	case AVCOL_SPC_BT2020_NCL:
+	case AVCOL_SPC_BT2020_CL:
+		frame->kr = 0.2627f;
+		frame->kb = 0.0593f;
+		break;
+	case AVCOL_SPC_UNSPECIFIED:
+		if(ref->height <= 576)
+		{
+			frame->kr = 0.299f;
+			frame->kb = 0.114f;
+			break;
+		}
+		// fall through
+	default:
+		frame->kr = 0.2126f;
+		frame->kb = 0.0722f;
+		break;
 	}
+	frame->fullRange = (ref->color_range == AVCOL_RANGE_JPEG) ||
+		ref->format == AV_PIX_FMT_YUVJ420P ||
+		ref->format == AV_PIX_FMT_YUVJ422P ||
+		ref->format == AV_PIX_FMT_YUVJ444P;
 
-	return buf;
+	return true;
 }
 
-
-unsigned char *Video::GetFrameImage(size_t frameNum, unsigned char *buf,
-		int &width,int &height,bool &endian)
+//----------------------------------------------------------------------------
+// GetFrame - the frame's luma (see FilmScan::GetFrame()). Native planes are
+// converted in a single pass; anything else goes through swscale.
+template <typename T>
+T *Video::GetFrame(size_t frameNum, T *buf)
 {
 	if(buf == NULL)
 	{
-        buf = new unsigned char [this->codec->width * this->codec->height * 4];
+		buf = new T [this->codec->width * this->codec->height];
 		if(buf == NULL)
 		{
-			throw vfbexception("Out of Memory: video buf");
+			throw vfbexception("Out of Memory: DPX buf");
 		}
 	}
 
+	FrameTexture planes;
+	if(GetFramePlanes(frameNum, &planes))
+	{
+		for(int y=0; y<planes.height; ++y)
+			planes.PlanarToLuma(y, buf + size_t(y)*planes.width);
+		return buf;
+	}
+
+	// Convert the image from its native format to Gray16
+	sws_scale(this->convertGray16,
+			(uint8_t const * const *)this->current->data,
+			this->current->linesize, 0, this->codec->height,
+			this->frameGray16->data, this->frameGray16->linesize);
+
+	// translate Gray16 to T
+	for(int y=0; y<this->codec->height; ++y)
+	{
+		DPXSamplesToGray((const uint16_t *)(this->frameGray16->data[0] +
+					y*this->frameGray16->linesize[0]),
+				buf + size_t(y)*this->codec->width, this->codec->width, 1);
+	}
+
+	return buf;
+}
+
+//----------------------------------------------------------------------------
+// GetFrameImage - frameNum as one packed image of 16 bit samples in
+// frame->buf, for pixel formats GetFramePlanes() can't hand over as they
+// are. RGB48 and RGBA64 frames are copied as they are, in either byte order
+// (GL swaps the bytes on upload); anything else is converted to RGBA64, so
+// nothing deeper than 8 bits is truncated. frame->buf is reused if it holds
+// frame->bufSize >= the image's bytes, and replaced otherwise.
+void Video::GetFrameImage(size_t frameNum, FrameTexture *frame)
+{
 	if(this->ReadFrame(frameNum) == false)
 	{
 		throw vfbexception(
@@ -249,33 +416,75 @@ unsigned char *Video::GetFrameImage(size_t frameNum, unsigned char *buf,
 					arg(frameNum));
 	}
 
-	// Convert the image from its native format to RGB
-	sws_scale(this->convertRGB,
-			(uint8_t const * const *)this->frameNative->data,
-			this->frameNative->linesize, 0, this->codec->height,
-			this->frameRGB->data, this->frameRGB->linesize);
+	const int fmt = this->current->format;
+	const int width = this->codec->width;
+	const int height = this->codec->height;
+	bool packed16 = true;
+	int nComponents = 4;
+
+	switch(fmt)
+	{
+	case AV_PIX_FMT_RGB48LE:
+	case AV_PIX_FMT_RGB48BE:
+		nComponents = 3;
+		break;
+	case AV_PIX_FMT_RGBA64LE:
+	case AV_PIX_FMT_RGBA64BE:
+		break;
+	default:
+		packed16 = false;
+		break;
+	}
+
+	const size_t rowBytes = size_t(width) * nComponents * 2;
+	const int size = int(rowBytes * height);
 
-	width = this->codec->width;
-	height = this->codec->height;
-	endian = false;
-    memcpy(buf,this->frameRGB->data[0],width*height*4);
+	frame->ReleaseMapping();
 
-	return buf;
-}
-#endif
+	// the buffer may be a recycled one, sized for some other frame
+	if(frame->buf != NULL && frame->bufSize < size)
+	{
+		delete [] frame->buf;
+		frame->buf = NULL;
+	}
+	if(frame->buf == NULL)
+	{
+		frame->buf = new unsigned char [size];
+		if(frame->buf == NULL)
+		{
+			throw vfbexception("Out of Memory: video buf");
+		}
+		frame->bufSize = size;
+	}
 
-//-----------------------------------------------------------------------------
-FilmFrame::FilmFrame(unsigned int r, unsigned int c)
-{
-	rows = r;
-	cols = c;
-	buf.resize(r*c);
-}
+	if(packed16)
+	{
+		for(int y=0; y<height; ++y)
+			memcpy(frame->buf + y*rowBytes, this->current->data[0] +
+					ptrdiff_t(y)*this->current->linesize[0], rowBytes);
 
-//-----------------------------------------------------------------------------
-FilmFrame::~FilmFrame()
-{
+		// AV_PIX_FMT_RGB48 and AV_PIX_FMT_RGBA64 are the host's byte order
+		frame->isNonNativeEndianess = (fmt != AV_PIX_FMT_RGB48 &&
+				fmt != AV_PIX_FMT_RGBA64);
+	}
+	else
+	{
+		// Convert the image from its native format straight into buf
+		uint8_t *dst[4] = { frame->buf, NULL, NULL, NULL };
+		int dstStride[4] = { int(rowBytes), 0, 0, 0 };
+		sws_scale(this->convertRGB,
+				(uint8_t const * const *)this->current->data,
+				this->current->linesize, 0, height,
+				dst, dstStride);
+		frame->isNonNativeEndianess = false;
+	}
+
+	frame->width = width;
+	frame->height = height;
+	frame->nComponents = nComponents;
+	frame->format = GL_UNSIGNED_SHORT;
 }
+#endif
 
 //-----------------------------------------------------------------------------
 
@@ -349,10 +558,11 @@ void FilmScan::Reset()
 {
 	if(name) { delete [] name; name = NULL; }
 	if(path) { delete [] path; path = NULL; }
-	if(fnbuf) { delete [] fnbuf; fnbuf = NULL; }
 	srcFormat = SOURCE_UNKNOWN;
 	firstFrame = 0;
 	numFrames = 0;
+	gaps.clear();
+	dpxIndex = DPXFrameIndex();
 	width = 0;
 	height = 0;
 	#ifdef USELIBAV
@@ -400,15 +610,31 @@ bool FilmScan::SourceDPX(const std::string filename)
 
 	SourceIdentifyImageSet(filename);
 
+	// read every frame's header once, or reuse the headers read last time
+	if(!dpxIndex.Load(*this))
+	{
+		dpxIndex.Build(*this);
+		dpxIndex.Save(*this);
+	}
+
 	// Pull the TimeCode from the first DPX in the sequence:
-	sprintf(this->fnbuf+strlen(this->path)+1, this->name, this->FirstFrame());
-	if(!img.Open(this->fnbuf))
+	const DPXFrameInfo *firstInfo = dpxIndex.Find(this->FirstFrame());
+	if(firstInfo)
+	{
+		char TC[16];
+		firstInfo->TimeCode(TC);
+		this->TimeCode = TC;
+		return true;
+	}
+
+	std::string firstFn = FrameFileName(this->FirstFrame());
+	if(!img.Open(firstFn.c_str()))
 	{
 		QString msg;
 		int err;
 
 		msg += QString("FilmScan: Cannot open ");
-		msg += QString(this->fnbuf);
+		msg += QString(firstFn.c_str());
 		msg += QString("\n");
 		if((err=errno)!=0) msg += QString(strerror(err));
 		throw vfbexception(msg);
@@ -422,7 +648,7 @@ bool FilmScan::SourceDPX(const std::string filename)
 		int err;
 
 		msg += QString("FilmScan: Invalid DPX header in ");
-		msg += QString(this->fnbuf);
+		msg += QString(firstFn.c_str());
 		img.Close();
 		throw vfbexception(msg);
 	}
@@ -509,10 +735,6 @@ bool FilmScan::SourceIdentifyImageSet(const std::string filename)
 	const char *cp, *ext;
 	len = filename.length();
 
-	// allocate a buffer for temporary filenames later
-	this->fnbuf = new char [len+1];
-	strcpy(this->fnbuf, filename.c_str());
-
 	// find the extension (or leave it blank if none)
 	ext = "";
 	lenE = 1;
@@ -586,83 +808,19 @@ bool FilmScan::SourceIdentifyImageSet(const std::string filename)
 		#endif
 	}
 
-	DIR *dirp;
-
-	if((dirp = opendir(this->path)) == NULL)
-	{
-		QString msg;
-		int err;
+	// find all files that match the pattern
+	ImageSequence seq;
+	seq.Discover(this->path, std::string(cp+1, lenF), numdigits, ext);
 
-		msg += QString("FilmScan: Cannot read directory folder ");
-		msg += QString(this->path);
-		msg += QString("\n");
-		if((err=errno)!=0) msg += QString(strerror(err));
-		throw vfbexception(msg);
-	}
+	// take the frames around the given one, spanning any small gaps
+	ImageSequence::Range range = seq.SequenceAround(inputFrame);
+	if(range.first > range.second)
+		throw vfbexception(QString("FilmScan: No frames matching %1 in %2")
+				.arg(this->name).arg(this->path));
 
-	// find all files that match the pattern and record their frame numbers
-	std::vector<long> frames;
-	long curFrame(0);
-	frames.reserve(1000);
-	while(1)
-	{
-		errno = 0;
-		struct dirent *dp;
-		if((dp = readdir(dirp)) != NULL)
-		{
-			// is it a file?
-			#ifdef _DIRENT_HAVE_D_TYPE
-			if(!(dp->d_type == DT_REG || dp->d_type == DT_UNKNOWN)) continue;
-			#endif
-
-			// leading string of characters matches?
-			if(strncmp(dp->d_name, this->name, lenF)!=0) continue;
-
-			// ... followed by correct number of digits?
-			for(cp = dp->d_name+lenF; isdigit(*cp); cp++) ;
-			if(cp - dp->d_name != lenF+numdigits) continue;
-
-			// ... followed by extension?
-			if(strcmp(cp, ext) != 0) continue;
-
-			// Then save this frame number in the list (vector) of frames
-			sscanf(dp->d_name+lenF, "%ld", &curFrame);
-			if(frames.capacity() == frames.size())
-				frames.reserve(frames.capacity()+1000);
-			frames.push_back(curFrame);
-		}
-		else
-			break;
-	}
-	if(errno!=0)
-	{
-		QString msg;
-		int err;
-
-		msg += QString("FilmScan: Error reading directory folder ");
-		msg += QString(this->path);
-		msg += QString("\n");
-		if((err=errno)!=0) msg += QString(strerror(err));
-		throw vfbexception(msg);
-	}
-
-
-	// find the frame given in the input argument filename
-	std::vector<long>::iterator framei;
-	std::sort(frames.begin(), frames.end());
-	framei = std::lower_bound(frames.begin(), frames.end(), inputFrame);
-
-	// seek in both directions to find the largest contiguous set of
-	// frames containing the given frame.
-	long firstIdx(framei - frames.begin());
-	while(firstIdx > 0 && frames[firstIdx-1] == frames[firstIdx] - 1)
-		firstIdx--;
-	this->firstFrame = frames[firstIdx];
-
-	long lastIdx(framei - frames.begin());
-	while(lastIdx < frames.size() && frames[lastIdx+1] == frames[lastIdx] + 1)
-		lastIdx++;
-	this->numFrames = frames[lastIdx] - this->firstFrame + 1;
+	this->firstFrame = range.first;
+	this->numFrames = range.second - range.first + 1;
+	this->gaps = seq.GapsIn(range);
 
 	return true;
 }
@@ -673,8 +831,10 @@ bool FilmScan::SourceLibAV(const std::string filename)
 {
 	#ifdef USELIBAV
 	{
-	// accept any recognized codec
+	// accept any recognized codec (registration is automatic from 4.0 on)
+#if LIBAVFORMAT_VERSION_INT < AV_VERSION_INT(58, 9, 100)
 	av_register_all();
+#endif
 
 	vid = new Video;
 
@@ -709,7 +869,7 @@ bool FilmScan::SourceLibAV(const std::string filename)
 	vid->streamIdx = -1;
 	for(int i=0; i<vid->format->nb_streams; ++i)
 	{
-		if(vid->format->streams[i]->codec->codec_type==AVMEDIA_TYPE_VIDEO)
+		if(vid->format->streams[i]->codecpar->codec_type==AVMEDIA_TYPE_VIDEO)
 		{
 			vid->streamIdx=i;
 			DE = av_dict_get(vid->format->streams[i]->metadata,"timecode",NULL ,0);
@@ -764,7 +924,7 @@ bool FilmScan::SourceLibAV(const std::string filename)
 		vid->streamIdx = -1;
 		for(int i=0; i<vid->format->nb_streams; ++i)
 		{
-			if(vid->format->streams[i]->codec->codec_type==AVMEDIA_TYPE_VIDEO)
+			if(vid->format->streams[i]->codecpar->codec_type==AVMEDIA_TYPE_VIDEO)
 			{
 				vid->streamIdx=i;
 				break;
@@ -781,16 +941,20 @@ bool FilmScan::SourceLibAV(const std::string filename)
     }
 #endif
 
+	AVStream *stream = vid->format->streams[vid->streamIdx];
+	AVRational rate = stream->avg_frame_rate.num ? stream->avg_frame_rate :
+		stream->r_frame_rate;
+
 	// ask the stream how many frames it has
-	if((this->numFrames=vid->format->streams[vid->streamIdx]->nb_frames) == 0)
+	if((this->numFrames=stream->nb_frames) == 0)
 	{
 		// TODO: if it doesn't know, guess based on duration and then validate.
 		//
-		this->numFrames =
-				(int)(( vid->format->streams[vid->streamIdx]->duration /
-					(double)AV_TIME_BASE ) *
-					vid->format->streams[vid->streamIdx]->codec->time_base.den +
-					0.5);
+		double seconds = (stream->duration != AV_NOPTS_VALUE) ?
+			stream->duration * av_q2d(stream->time_base) :
+			vid->format->duration / (double)AV_TIME_BASE;
+		if(rate.num > 0 && rate.den > 0)
+			this->numFrames = (int)(seconds * av_q2d(rate) + 0.5);
 
 		/* FAILED ATTEMPT TO USE LIBAV TO READ IMAGES
 		if(this->numFrames < 0)
@@ -810,14 +974,8 @@ bool FilmScan::SourceLibAV(const std::string filename)
 
 	this->firstFrame = 0;
 
-	AVCodecContext *codecOrig;
-	AVCodec *decoder;
-
-	// Get a pointer to the codec context for the video stream
-	codecOrig=vid->format->streams[vid->streamIdx]->codec;
-
 	// Find the decoder for the video stream
-	decoder=avcodec_find_decoder(codecOrig->codec_id);
+	const AVCodec *decoder=avcodec_find_decoder(stream->codecpar->codec_id);
 	if(decoder==NULL)
 	{
 		avformat_close_input(&(vid->format));
@@ -826,16 +984,22 @@ bool FilmScan::SourceLibAV(const std::string filename)
 		throw vfbexception("Unsupported codec.");
 	}
 
-	// Copy codec context
+	// Set up a codec context from the stream parameters
 	vid->codec = avcodec_alloc_context3(decoder);
-	if(avcodec_copy_context(vid->codec, codecOrig) != 0)
+	if(vid->codec==NULL ||
+			avcodec_parameters_to_context(vid->codec, stream->codecpar) < 0)
 	{
 		avformat_close_input(&(vid->format));
 		delete vid;
 		vid = NULL;
 		throw vfbexception("Couldn't copy codec context");
 	}
-	avcodec_close(codecOrig);
+	vid->codec->pkt_timebase = stream->time_base;
+
+	// Let the decoder use every core: frame threading for long-GOP codecs,
+	// slice threading for intra codecs that support it
+	vid->codec->thread_count = 0;
+	vid->codec->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
 
 	// Open codec
 	if(avcodec_open2(vid->codec, decoder, NULL)<0)
@@ -856,34 +1020,9 @@ bool FilmScan::SourceLibAV(const std::string filename)
 		throw vfbexception("Couldn't allocate frame structure");
 	}
 
-	// Allocate an RGB frame
-	vid->frameRGB=av_frame_alloc();
-	if(vid->frameRGB==NULL)
-	{
-		avformat_close_input(&(vid->format));
-		delete vid;
-		vid = NULL;
-		throw vfbexception ("Couldn't allocate frame structure");
-	}
-
 	this->width = vid->codec->width;
 	this->height = vid->codec->height;
 
-	// allocate RGB buffer (to be freed when vid is destroyed)
-	uint8_t *buffer = (uint8_t *)av_malloc(
-			av_image_get_buffer_size(
-                    AV_PIX_FMT_RGBA,
-					vid->codec->width, vid->codec->height,1));
-
-	// Assign appropriate parts of buffer to image planes in frameRGB
-	// Note that frameRGB is an AVFrame, but AVFrame is a superset
-	// of AVPicture
-	//avpicture_fill((AVPicture *)vid->frameRGB, buffer, AV_PIX_FMT_RGBA64LE,
-	//		vid->codec->width, vid->codec->height);
-
-	av_image_fill_arrays(vid->frameRGB->data, vid->frameRGB->linesize, buffer,
-            AV_PIX_FMT_RGBA, vid->codec->width, vid->codec->height, 1);
-
 	// Allocate a Gray16 frame
 	vid->frameGray16=av_frame_alloc();
 	if(vid->frameGray16==NULL)
@@ -894,7 +1033,7 @@ bool FilmScan::SourceLibAV(const std::string filename)
 		throw vfbexception("Couldn't allocate frame structure");
 	}
 	// allocate Gray16 buffer (to be freed when vid is destroyed)
-	buffer = (uint8_t *)av_malloc(
+	uint8_t *buffer = (uint8_t *)av_malloc(
 			av_image_get_buffer_size(
 					AV_PIX_FMT_GRAY16, vid->codec->width, vid->codec->height, 1
 					));
@@ -906,14 +1045,15 @@ bool FilmScan::SourceLibAV(const std::string filename)
 			buffer, AV_PIX_FMT_GRAY16,
 			vid->codec->width, vid->codec->height, 1);
 
-	// initialize SWS context for conversion to RGB
+	// initialize SWS context for conversion to 16 bit RGBA, for the pixel
+	// formats that can't be shown as they are
 	vid->convertRGB = sws_getContext(
 			vid->codec->width,
 			vid->codec->height,
 			vid->codec->pix_fmt,
 			vid->codec->width,
 			vid->codec->height,
-            AV_PIX_FMT_RGBA, //rgba
+			AV_PIX_FMT_RGBA64, // native byte order
 			SWS_BILINEAR,
 			NULL,
 			NULL,
@@ -935,13 +1075,20 @@ bool FilmScan::SourceLibAV(const std::string filename)
 			);
 
 
-	// Read two frames to calibrate seek-to-frame parameters
-	vid->ReadNextFrame(0);
-	vid->dtsBase = vid->dts;
-	vid->ReadNextFrame(1);
-	vid->dtsStep = vid->dts;
+	// Frame timing until the seek index is ready: a constant rate from the
+	// start of the stream
+	vid->startPTS = (stream->start_time != AV_NOPTS_VALUE) ?
+		stream->start_time : 0;
+	if(rate.num > 0 && rate.den > 0)
+		vid->ticksPerFrame = av_q2d(av_inv_q(rate)) / av_q2d(stream->time_base);
+
+	// find every frame's timestamp and the keyframes in the background
+	vid->index.Start(filename, vid->streamIdx);
 
-	// reset to first frame
+	// decode ahead of the reader from here on
+	vid->decoder.Start(vid->format, vid->codec, vid->streamIdx);
+
+	// start on the first frame
 	vid->ReadFrame(0);
 
 	int len = filename.length();
@@ -968,7 +1115,6 @@ FilmScan::~FilmScan()
 {
 	if(this->name) delete [] this->name;
 	if(this->path) delete [] this->path;
-	if(this->fnbuf) delete [] this->fnbuf;
 	#ifdef USELIBAV
 	if(this->vid) delete this->vid;
 	#endif
@@ -976,8 +1122,37 @@ FilmScan::~FilmScan()
 
 
 //-----------------------------------------------------------------------------
+// FrameFileName - full path of the image file holding the given frame of an
+// image sequence. The name is built in a local buffer so that any number of
+// threads can read frames at once. A frame missing from the sequence is
+// read from the last frame before the gap.
+std::string FilmScan::FrameFileName(long frameNum) const
+{
+	frameNum = PresentFrame(frameNum);
+
+	std::vector<char> fn(strlen(this->path) + strlen(this->name) + 32);
 
-double* FilmScan::GetFrame(long frameNum, double *buf) const
+	int len = snprintf(fn.data(), fn.size(), "%s/", this->path);
+	snprintf(fn.data()+len, fn.size()-len, this->name, frameNum);
+
+	return std::string(fn.data());
+}
+
+//-----------------------------------------------------------------------------
+long FilmScan::PresentFrame(long frameNum) const
+{
+	auto gap = std::lower_bound(gaps.begin(), gaps.end(), frameNum,
+			[](const std::pair<long, long> &g, long f) { return g.second < f; });
+
+	if(gap != gaps.end() && gap->first <= frameNum)
+		return gap->first - 1;
+	return frameNum;
+}
+
+//-----------------------------------------------------------------------------
+
+template <typename T>
+T *FilmScan::GetFrame(long frameNum, T *buf) const
 {
 	if(frameNum < this->FirstFrame() || frameNum > this->LastFrame())
 	{
@@ -987,12 +1162,11 @@ double* FilmScan::GetFrame(long frameNum, double *buf) const
 	switch(this->srcFormat)
 	{
 	case SOURCE_DPX:
-		sprintf(this->fnbuf+strlen(this->path)+1, this->name, frameNum);
-		buf = ReadFrameDPX(fnbuf, buf);
+		buf = ReadFrameDPX(FrameFileName(frameNum).c_str(), buf,
+				dpxIndex.Find(frameNum));
 		break;
 	case SOURCE_TIFF:
-		sprintf(this->fnbuf+strlen(this->path)+1, this->name, frameNum);
-		buf = ReadFrameTIFF(fnbuf, buf);
+		buf = ReadFrameTIFF(FrameFileName(frameNum).c_str(), buf);
 		break;
 	case SOURCE_LIBAV:
 		if(this->vid) buf = this->vid->GetFrame(frameNum, buf);
@@ -1016,8 +1190,7 @@ double* FilmScan::GetFrame(long frameNum, double *buf) const
 	}
 	else
 	{
-		sprintf(this->fnbuf+strlen(this->path)+1, this->name, frameNum);
-		buf = ReadFrameDPX(fnbuf, buf);
+		buf = ReadFrameDPX(FrameFileName(frameNum).c_str(), buf);
 	}
 
 #endif
@@ -1042,24 +1215,22 @@ FrameTexture* FilmScan::GetFrameImage(long frameNum, FrameTexture *frame) const
 	switch(this->srcFormat)
 	{
 	case SOURCE_DPX:
-		sprintf(this->fnbuf+strlen(this->path)+1, this->name, frameNum);
-		frame->buf = ReadFrameDPX_ImageData(fnbuf, frame->buf, frame->bufSize,
-				frame->width, frame->height, frame->isNonNativeEndianess,
-				frame->format, frame->nComponents);
+		ReadFrameDPX_ImageData(FrameFileName(frameNum).c_str(), frame,
+				dpxIndex.Find(frameNum));
 		break;
 	case SOURCE_TIFF:
-		sprintf(this->fnbuf+strlen(this->path)+1, this->name, frameNum);
-		frame->buf = ReadFrameTIFF_ImageData(fnbuf, frame->buf,
-				frame->width, frame->height, frame->isNonNativeEndianess,
-				frame->format, frame->nComponents);
+		frame->ReleaseMapping();
+		frame->buf = ReadFrameTIFF_ImageData(FrameFileName(frameNum).c_str(),
+				frame->buf, frame->bufSize, frame->width, frame->height,
+				frame->isNonNativeEndianess, frame->format, frame->nComponents);
 		break;
 	case SOURCE_LIBAV:
 		if(this->vid)
 		{
-			frame->buf = this->vid->GetFrameImage(frameNum, frame->buf,
-					frame->width, frame->height, frame->isNonNativeEndianess);
-			frame->nComponents = 4;
-            frame->format = GL_UNSIGNED_INT_8_8_8_8_REV;
+			// native planes when possible, converted in the shader
+			if(this->vid->GetFramePlanes(frameNum, frame)) break;
+
+			this->vid->GetFrameImage(frameNum, frame);
 		}
 		else throw vfbexception("Internal video structure not ready");
 		break;
@@ -1072,7 +1243,8 @@ FrameTexture* FilmScan::GetFrameImage(long frameNum, FrameTexture *frame) const
 
 //-----------------------------------------------------------------------------
 
-FilmStrip FilmScan::GetFrameRange(long frameRange[2]) const
+template <typename T>
+FilmStripT<T> FilmScan::GetFrameRange(long frameRange[2]) const
 {
 	if(frameRange[0] < this->FirstFrame() ||
 			frameRange[1] < frameRange[0] ||
@@ -1085,18 +1257,37 @@ FilmStrip FilmScan::GetFrameRange(long frameRange[2]) const
 
 	long nFrames, i;
 	unsigned int r, c;
-	FilmStrip frames;
+	FilmStripT<T> frames;
 
 	nFrames = frameRange[1] - frameRange[0] + 1;
 	r = this->Height();
 	c = this->Width();
 
-	frames.resize(nFrames, FilmFrame(r,c));
+	frames.resize(nFrames, FilmFrameT<T>(r,c));
 
 	for(i = 0; i<nFrames; i++)
 	{
-		(void)GetFrame(frameRange[0] + i, frames[i]);
+		(void)GetFrame(frameRange[0] + i, (T *)(frames[i]));
 	}
 
 	return frames;
 }
+
+//-----------------------------------------------------------------------------
+template <typename T>
+FilmFrameT<T> FilmScan::GetFrame(long frameNum) const
+{
+	FilmFrameT<T> frame(this->Height(), this->Width());
+	(void)GetFrame(frameNum, (T *)(frame));
+	return frame;
+}
+
+template float *FilmScan::GetFrame<float>(long, float *) const;
+template double *FilmScan::GetFrame<double>(long, double *) const;
+template uint16_t *FilmScan::GetFrame<uint16_t>(long, uint16_t *) const;
+template FilmFrameT<float> FilmScan::GetFrame<float>(long) const;
+template FilmFrameT<uint16_t> FilmScan::GetFrame<uint16_t>(long) const;
+template FilmFrameT<double> FilmScan::GetFrame<double>(long) const;
+template FilmStripT<float> FilmScan::GetFrameRange<float>(long [2]) const;
+template FilmStripT<uint16_t> FilmScan::GetFrameRange<uint16_t>(long [2]) const;
+template FilmStripT<double> FilmScan::GetFrameRange<double>(long [2]) const;
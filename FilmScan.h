@@ -30,7 +30,7 @@
 
 // FilmScan -- objects for handling scanned images of film.
 //
-// FilmFrame - a scan of a single frame
+// FilmFrame - a scan of a single frame (FilmFrameT<T> for other sample types)
 // FilmStrip - a sequence of FilmFrames (usually short; not the entire film)
 // FilmScan - the main interface to a scanned film source (not used currently,
 //            see project.h instead for an object that holds the working
@@ -49,28 +49,40 @@ extern "C"
 #include <libavformat/avformat.h>
 #include <libswscale/swscale.h>
 #include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
 #include <libavutil/timecode.h>
 }
+#include "videodecoder.h"
+#include "videoseek.h"
 #endif
 
+#include <cstdint>
+#include <utility>
 #include <vector>
 #include <QOpenGLTexture>
 
+#include "dpxframeindex.h"
 #include "frametexture.h"
 
-class FilmFrame {
+// One gray sample per pixel: float or double values in [0-1], uint16_t
+// values in [0-65535]. The analysis code uses FilmFrame (float); a frame of
+// doubles takes twice the memory and bandwidth for no useful precision.
+template <typename T>
+class FilmFrameT {
 private:
-	std::vector <double> buf;
+	std::vector <T> buf;
 	unsigned int rows, cols;
 public:
-	FilmFrame() : buf(), rows(0), cols(0) {} ;
-	FilmFrame(unsigned int r, unsigned int c);
-	~FilmFrame();
-	// data() is only available in C++11, so use the old &(p[0]) construction
-	//double *operator[](unsigned int r) { return buf.data()+(r*cols); } ;
-	//operator double*() { return buf.data(); }
-	double *operator[](unsigned int r) { return &(buf[r*cols]); } ;
-	operator double*() { return &(buf[0]); }
+	typedef T SampleType;
+
+	FilmFrameT() : buf(), rows(0), cols(0) {} ;
+	FilmFrameT(unsigned int r, unsigned int c)
+		: buf(size_t(r)*c), rows(r), cols(c) {} ;
+	T *operator[](unsigned int r) { return &(buf[size_t(r)*cols]); } ;
+	const T *operator[](unsigned int r) const
+		{ return &(buf[size_t(r)*cols]); } ;
+	operator T*() { return buf.data(); }
+	operator const T*() const { return buf.data(); }
 	unsigned int Width() const { return cols; } ;
 	unsigned int Height() const { return rows; } ;
 	unsigned int Cols() const { return cols; } ;
@@ -78,7 +90,13 @@ public:
 
 };
 
-typedef std::vector< FilmFrame > FilmStrip;
+typedef FilmFrameT<float> FilmFrame;
+typedef FilmFrameT<uint16_t> FilmFrame16;
+typedef FilmFrameT<double> FilmFrameD;
+
+template <typename T>
+using FilmStripT = std::vector< FilmFrameT<T> >;
+typedef FilmStripT<float> FilmStrip;
 
 #ifdef USELIBAV
 class Video {
@@ -90,28 +108,47 @@ public:
 	SwsContext *convertRGB;
 	SwsContext *convertGray16;
 	AVFrame *frameNative;
-	AVFrame *frameRGB;
 	AVFrame *frameGray16;
-	size_t curFrame;
-	size_t dts;
-	size_t dtsBase; // DTS of first frame
-	size_t dtsStep; // DTS between frames
+
+	const AVFrame *current; // the frame last read (frameNative or cached)
+	long curFrame;          // its frame number, -1 if none
+	long decodedFrame;      // last frame out of the decoder, -1 after a seek
+
+	// frame timing, assuming a constant frame rate, until the index is ready
+	int64_t startPTS;
+	double ticksPerFrame;
+
+	VideoSeekIndex index;
+	VideoFrameCache gop;
+	bool indexed;           // gop and decodedFrame are numbered by the index
+	VideoDecodeThread decoder;
 
 	Video()
 		: format(NULL), codec(NULL), streamIdx(0),
 		convertRGB(NULL), convertGray16(NULL),
-		frameNative(NULL), frameRGB(NULL), frameGray16(NULL),
-		curFrame(0), dts(0), dtsBase(0), dtsStep(1) {};
+		frameNative(NULL), frameGray16(NULL),
+		current(NULL), curFrame(-1), decodedFrame(-1),
+		startPTS(0), ticksPerFrame(1), indexed(false) {};
 	~Video();
 
+private:
+	long FrameNumberOf(int64_t ts) const;
+	int64_t TimestampOf(long frameNum) const;
+	void SeekBefore(long frameNum);
+	bool DecodeNextFrame(long &frameNum);
+
 public:
-	bool ReadNextFrame(size_t currFrameNum);
 	bool ReadFrame(size_t frameNum);
 
-	double *GetFrame(size_t frameNum, double *buf);
+	// the decoded planes as they are, shared with the decoder
+	bool GetFramePlanes(size_t frameNum, FrameTexture *frame);
+
+	template <typename T>
+	T *GetFrame(size_t frameNum, T *buf);
 
-	unsigned char *GetFrameImage(size_t frameNum, unsigned char *buf,
-			int &width,int &height,bool &endian);
+	// the frame as one packed image of 16 bit samples (RGB48 or RGBA64),
+	// in frame->buf, which is replaced if it is too small
+	void GetFrameImage(size_t frameNum, FrameTexture *frame);
 };
 #endif
 
@@ -128,13 +165,18 @@ class FilmScan {
 private:
 	char *name;
 	char *path;
-	char *fnbuf;
 	SourceFormat srcFormat;
 	long firstFrame;
 	long numFrames;
 	unsigned int width;
 	unsigned int height;
 
+	// frames missing from an image sequence, as sorted first/last pairs
+	std::vector<std::pair<long, long> > gaps;
+
+	// headers of a DPX sequence's frames
+	DPXFrameIndex dpxIndex;
+
 #ifdef USELIBAV
 	Video *vid = NULL;
 #endif
@@ -147,11 +189,11 @@ public:
 public:
 #ifdef USELIBAV
 	FilmScan()
-		: name(NULL), path(NULL), fnbuf(NULL),
+		: name(NULL), path(NULL),
 		firstFrame(0), numFrames(0), width(0), height(0), vid(NULL)	{} ;
 #else
 	FilmScan()
-		: name(NULL), path(NULL), fnbuf(NULL),
+		: name(NULL), path(NULL),
 		firstFrame(0), numFrames(0), width(0), height(0) {} ;
 #endif
 	FilmScan(const std::string filename) { Source(filename); };
@@ -178,11 +220,26 @@ public:
 	static SourceFormat StrToSourceFormat(const char *str);
 	const char *GetPath() const { return path; }
 	const char *GetBaseName() const { return name; }
-
-	double *GetFrame(long frameNum, double *buf) const;
+	std::string FrameFileName(long frameNum) const;
+	const std::vector<std::pair<long, long> > &Gaps() const { return gaps; }
+	// frameNum, or the frame before it if it is in a gap
+	long PresentFrame(long frameNum) const;
+	const DPXFrameIndex &DPXIndex() const { return dpxIndex; }
+
+	// Image sequences can be read from several threads at once. Video
+	// sources decode sequentially from shared codec state and can't.
+	bool IsThreadSafe() const { return srcFormat != SOURCE_LIBAV; }
+
+	// gray frames: T is float, double ([0-1]) or uint16_t ([0-65535])
+	template <typename T>
+	T *GetFrame(long frameNum, T *buf) const;
 	FrameTexture *GetFrameImage(long frameNum, FrameTexture *frame) const;
-	FilmFrame GetFrame(long frameNum) const;
-    FilmStrip GetFrameRange(long frameRange[2]) const;
+	template <typename T=float>
+	FilmFrameT<T> GetFrame(long frameNum) const;
+	// every frame of the range in memory at once: for long ranges use a
+	// FilmStripReader, which streams them (see filmstripreader.h)
+	template <typename T=float>
+	FilmStripT<T> GetFrameRange(long frameRange[2]) const;
 
 };
 
@@ -109,25 +109,46 @@ else:CONFIG(debug, debug|release): QMAKE_LIBDIR += $$PWD/debug/
 #------------------------------------------------------------------------------
 SOURCES += \
     attributelabel.cpp \
+    audiosink.cpp \
+    batchmode.cpp \
     decimalelidedelegate.cpp \
+    dpxframeindex.cpp \
+    dpxunpack.cpp \
     eventdataform.cpp \
     eventdialog.cpp \
     eventfilter.cpp \
     eventfilterdialog.cpp \
+    eventintervalindex.cpp \
     eventquickconfig.cpp \
+    exportsession.cpp \
+    extractjob.cpp \
+    extractscheduler.cpp \
     filmgauge.cpp \
+    filmstripreader.cpp \
+    framecache.cpp \
+    frameprefetcher.cpp \
     frametexture.cpp \
+    imagesequence.cpp \
     listselectdialog.cpp \
     main.cpp\
+    mappedinstream.cpp \
     mainwindow.cpp \
     FilmScan.cpp \
+    overlapregistration.cpp \
+    overlapsearch.cpp \
+    overlaptrack.cpp \
     project.cpp \
     propertiesdialog.cpp \
     propertylist.cpp \
     readframedpx.cpp \
+    soundextractor.cpp \
     vbevent.cpp \
     vbproject.cpp \
+    videodecoder.cpp \
+    videoencoder.cpp \
+    videoseek.cpp \
     openglwindow.cpp \
+    pixelreadback.cpp \
     frame_view_gl.cpp \
     readframetiff.cpp \
     preferencesdialog.cpp \
@@ -137,27 +158,48 @@ SOURCES += \
 HEADERS  += mainwindow.h \
     FilmScan.h \
     attributelabel.h \
+    audiosink.h \
+    batchmode.h \
     decimalelidedelegate.h \
+    dpxframeindex.h \
+    dpxunpack.h \
     eventdataform.h \
     eventdialog.h \
     eventfilter.h \
     eventfilterdialog.h \
+    eventintervalindex.h \
     eventquickconfig.h \
+    exportsession.h \
+    extractjob.h \
+    extractscheduler.h \
     filmgauge.h \
+    filmstripreader.h \
+    framecache.h \
+    frameprefetcher.h \
     frametexture.h \
+    imagesequence.h \
     listselectdialog.h \
+    mappedinstream.h \
     overlap.h \
+    overlapregistration.h \
+    overlapsearch.h \
+    overlaptrack.h \
     project.h \
     propertiesdialog.h \
     propertylist.h \
     readframedpx.h \
+    soundextractor.h \
     DPX.h \
     DPXHeader.h \
     DPXStream.h \
     vbevent.h \
     vbproject.h \
+    videodecoder.h \
+    videoencoder.h \
+    videoseek.h \
     vfbexception.h \
     openglwindow.h \
+    pixelreadback.h \
     frame_view_gl.h \
     readframetiff.h \
     preferencesdialog.h \
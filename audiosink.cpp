@@ -0,0 +1,518 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+#include <algorithm>
+
+#include <QDateTime>
+#include <QFileInfo>
+
+#include "audiosink.h"
+#include "vfbexception.h"
+
+#ifdef USELIBAV
+extern "C"
+{
+#include <libavutil/channel_layout.h>
+}
+#endif
+
+#ifndef UMAX
+#define UMAX(b) ((1ull<<(b))-1)
+#endif
+
+//-----------------------------------------------------------------------------
+static void AppendLE(QByteArray &b, uint64_t v, int nbytes)
+{
+	for(int i=0; i<nbytes; ++i)
+		b.append(char((v >> (8*i)) & 0xff));
+}
+
+static void AppendFixed(QByteArray &b, const QString &s, int len)
+{
+	QByteArray field = s.toLatin1().left(len);
+	field.append(QByteArray(len - field.size(), '\0'));
+	b.append(field);
+}
+
+// [0,1] to a signed sample of the given depth, as the muxer maps it
+static inline int64_t ToPCM(float v, int bits)
+{
+	const int64_t full = int64_t(UMAX(bits));
+	const int64_t smin = -int64_t(UMAX(bits-1)) - 1;
+	const int64_t smax = int64_t(UMAX(bits-1));
+
+	return std::min(std::max(int64_t(v*full) - full/2, smin), smax);
+}
+
+//-----------------------------------------------------------------------------
+AudioSink *OpenAudioSink(const QString &fn, int samplingRate, int bitDepth,
+		const MetaData *meta)
+{
+	if(QFileInfo(fn).suffix().compare("flac", Qt::CaseInsensitive) == 0)
+	{
+#ifdef USELIBAV
+		FlacSink *flac = new FlacSink;
+		try
+		{
+			flac->Open(fn, samplingRate, bitDepth, meta);
+		}
+		catch(...)
+		{
+			delete flac;
+			throw;
+		}
+		return flac;
+#else
+		throw vfbexception(QString("Cannot write %1: built without FLAC")
+				.arg(fn));
+#endif
+	}
+
+	WavSink *wav = new WavSink;
+	try
+	{
+		wav->Open(fn, samplingRate, bitDepth, meta);
+	}
+	catch(...)
+	{
+		delete wav;
+		throw;
+	}
+	return wav;
+}
+
+//-----------------------------------------------------------------------------
+WavSink::~WavSink()
+{
+	// a sink that was never closed leaves the sizes in its header at 0
+	if(file.isOpen()) file.close();
+}
+
+//-----------------------------------------------------------------------------
+void WavSink::Open(const QString &fn, int samplingRate, int bits,
+		const MetaData *bext)
+{
+	const int channels = 2;
+	const int bytesPerSample = bits / 8;
+
+	if(bits != 16 && bits != 24 && bits != 32)
+		throw vfbexception(QString("Cannot write %1 bit WAV").arg(bits));
+
+	QByteArray header;
+	QByteArray bextChunk;
+
+	if(bext)
+	{
+		QDateTime now = QDateTime::currentDateTime();
+		AppendFixed(bextChunk, bext->description, 256);
+		AppendFixed(bextChunk, bext->originator, 32);
+		AppendFixed(bextChunk, bext->originatorReference, 32);
+		AppendFixed(bextChunk, now.toString("yyyy-MM-dd"), 10);
+		AppendFixed(bextChunk, now.toString("hh:mm:ss"), 8);
+		AppendLE(bextChunk, bext->timeReference, 8);
+		AppendLE(bextChunk, bext->version, 2);
+		bextChunk.append(QByteArray(64 + 10 + 180, '\0')); // UMID, loudness
+		bextChunk.append(bext->codingHistory.toLatin1());
+		if(bextChunk.size() & 1) bextChunk.append('\0');
+	}
+
+	riffBase = 4 + (8 + 16) + 8;
+	if(bext) riffBase += 8 + bextChunk.size();
+
+	header.append("RIFF");
+	riffSizePos = header.size();
+	AppendLE(header, 0, 4); // patched by Close()
+	header.append("WAVE");
+	if(bext)
+	{
+		header.append("bext");
+		AppendLE(header, bextChunk.size(), 4);
+		header.append(bextChunk);
+	}
+	header.append("fmt ");
+	AppendLE(header, 16, 4);
+	AppendLE(header, 1, 2); // PCM
+	AppendLE(header, channels, 2);
+	AppendLE(header, samplingRate, 4);
+	AppendLE(header, uint64_t(samplingRate) * channels * bytesPerSample, 4);
+	AppendLE(header, channels * bytesPerSample, 2);
+	AppendLE(header, bits, 2);
+	header.append("data");
+	dataSizePos = header.size();
+	AppendLE(header, 0, 4); // patched by Close()
+
+	file.setFileName(fn);
+	if(!file.open(QIODevice::WriteOnly))
+		throw vfbexception(QString("Cannot write %1").arg(fn));
+	if(file.write(header) != header.size())
+		throw vfbexception(QString("Error writing %1").arg(fn));
+
+	bitDepth = bits;
+	dataSize = 0;
+}
+
+//-----------------------------------------------------------------------------
+void WavSink::Write(const float *left, const float *right, size_t n)
+{
+	const int bytesPerSample = bitDepth / 8;
+	const float *ch[2] = { left, right };
+	QByteArray block;
+
+	if(riffBase + dataSize + uint64_t(n) * 2 * bytesPerSample > 0xffffffffull)
+		throw vfbexception(QString("%1 would exceed the 4GB WAV limit")
+				.arg(file.fileName()));
+
+	for(size_t i=0; i<n; ++i)
+	{
+		for(int c=0; c<2; ++c)
+			AppendLE(block, uint64_t(ToPCM(ch[c][i], bitDepth)),
+					bytesPerSample);
+
+		if(block.size() >= 65536 || i+1 == n)
+		{
+			if(file.write(block) != block.size())
+				throw vfbexception(QString("Error writing %1")
+						.arg(file.fileName()));
+			dataSize += block.size();
+			block.clear();
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+void WavSink::Close()
+{
+	if(!file.isOpen()) return;
+
+	QByteArray size;
+	bool ok = file.seek(riffSizePos);
+	AppendLE(size, riffBase + dataSize, 4);
+	ok = ok && file.write(size) == size.size();
+	size.clear();
+	AppendLE(size, dataSize, 4);
+	ok = ok && file.seek(dataSizePos) && file.write(size) == size.size();
+	file.close();
+
+	if(!ok)
+		throw vfbexception(QString("Error writing %1").arg(file.fileName()));
+}
+
+#ifdef USELIBAV
+//-----------------------------------------------------------------------------
+void FlacSink::Free()
+{
+	av_frame_free(&frame);
+	av_packet_free(&packet);
+	avcodec_free_context(&codec);
+	if(format)
+	{
+		if(format->pb) avio_closep(&format->pb);
+		avformat_free_context(format);
+		format = NULL;
+	}
+	stream = NULL;
+}
+
+//-----------------------------------------------------------------------------
+void FlacSink::Open(const QString &filename, int samplingRate, int bits,
+		const MetaData *meta)
+{
+	QByteArray name = filename.toUtf8();
+	const AVCodec *enc;
+
+	fn = filename;
+	bitDepth = (bits > 16) ? 24 : 16;
+	pts = 0;
+	filled = 0;
+
+	try
+	{
+		if(avformat_alloc_output_context2(&format, NULL, "flac",
+				name.constData()) < 0 || format == NULL)
+			throw vfbexception("Cannot create FLAC output context");
+		if((enc = avcodec_find_encoder(AV_CODEC_ID_FLAC)) == NULL)
+			throw vfbexception("No FLAC encoder");
+		if((stream = avformat_new_stream(format, NULL)) == NULL ||
+				(codec = avcodec_alloc_context3(enc)) == NULL ||
+				(frame = av_frame_alloc()) == NULL ||
+				(packet = av_packet_alloc()) == NULL)
+			throw vfbexception("Cannot allocate FLAC encoder");
+
+		codec->sample_rate = samplingRate;
+		codec->sample_fmt = (bitDepth == 16) ?
+			AV_SAMPLE_FMT_S16 : AV_SAMPLE_FMT_S32;
+		codec->bits_per_raw_sample = bitDepth;
+		codec->time_base = AVRational{ 1, samplingRate };
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 28, 100)
+		av_channel_layout_default(&codec->ch_layout, 2);
+#else
+		codec->channel_layout = AV_CH_LAYOUT_STEREO;
+		codec->channels = 2;
+#endif
+		if(format->oformat->flags & AVFMT_GLOBALHEADER)
+			codec->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+		if(avcodec_open2(codec, enc, NULL) < 0)
+			throw vfbexception("Cannot open FLAC encoder");
+		if(avcodec_parameters_from_context(stream->codecpar, codec) < 0)
+			throw vfbexception("Cannot set FLAC stream parameters");
+		stream->time_base = codec->time_base;
+
+		if(meta)
+		{
+			av_dict_set(&format->metadata, "DESCRIPTION",
+					meta->description.toUtf8().constData(), 0);
+			av_dict_set(&format->metadata, "ORIGINATOR",
+					meta->originator.toUtf8().constData(), 0);
+			av_dict_set(&format->metadata, "TIME_REFERENCE",
+					QString::number(meta->timeReference).toUtf8()
+					.constData(), 0);
+			av_dict_set(&format->metadata, "CODING_HISTORY",
+					meta->codingHistory.trimmed().toUtf8().constData(), 0);
+		}
+
+		if(avio_open(&format->pb, name.constData(), AVIO_FLAG_WRITE) < 0)
+			throw vfbexception(QString("Cannot write %1").arg(fn));
+		if(avformat_write_header(format, NULL) < 0)
+			throw vfbexception(QString("Error writing %1").arg(fn));
+
+		frame->format = codec->sample_fmt;
+		frame->sample_rate = samplingRate;
+		frame->nb_samples = (codec->frame_size > 0) ? codec->frame_size : 4096;
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 28, 100)
+		av_channel_layout_copy(&frame->ch_layout, &codec->ch_layout);
+#else
+		frame->channel_layout = codec->channel_layout;
+		frame->channels = codec->channels;
+#endif
+		if(av_frame_get_buffer(frame, 0) < 0)
+			throw vfbexception("Cannot allocate FLAC frame");
+		frameSize = frame->nb_samples;
+	}
+	catch(...)
+	{
+		Free();
+		throw;
+	}
+}
+
+//-----------------------------------------------------------------------------
+void FlacSink::Encode(AVFrame *f)
+{
+	int ret = avcodec_send_frame(codec, f);
+
+	while(ret >= 0)
+	{
+		ret = avcodec_receive_packet(codec, packet);
+		if(ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) return;
+		if(ret < 0) break;
+
+		av_packet_rescale_ts(packet, codec->time_base, stream->time_base);
+		packet->stream_index = stream->index;
+		ret = av_interleaved_write_frame(format, packet);
+	}
+
+	throw vfbexception(QString("Error encoding %1").arg(fn));
+}
+
+//-----------------------------------------------------------------------------
+void FlacSink::Write(const float *left, const float *right, size_t n)
+{
+	const float *ch[2] = { left, right };
+
+	if(format == NULL)
+		throw vfbexception("FlacSink: not open");
+
+	for(size_t i=0; i<n; ++i)
+	{
+		if(filled == 0 && av_frame_make_writable(frame) < 0)
+			throw vfbexception("Cannot write FLAC frame");
+
+		for(int c=0; c<2; ++c)
+		{
+			int64_t v = ToPCM(ch[c][i], bitDepth);
+			if(bitDepth == 16)
+				((int16_t *)frame->data[0])[filled*2 + c] = int16_t(v);
+			else // the encoder takes the top 24 bits
+				((int32_t *)frame->data[0])[filled*2 + c] = int32_t(v * 256);
+		}
+
+		if(++filled == frameSize)
+		{
+			frame->pts = pts;
+			pts += filled;
+			Encode(frame);
+			filled = 0;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+void FlacSink::Close()
+{
+	if(format == NULL) return;
+
+	try
+	{
+		if(filled)
+		{
+			frame->nb_samples = filled;
+			frame->pts = pts;
+			pts += filled;
+			Encode(frame);
+			filled = 0;
+		}
+		Encode(NULL);
+
+		if(av_write_trailer(format) < 0)
+			throw vfbexception(QString("Error writing %1").arg(fn));
+	}
+	catch(...)
+	{
+		Free();
+		throw;
+	}
+
+	Free();
+}
+#endif
+
+//-----------------------------------------------------------------------------
+void AudioRing::Start(AudioSink *s, long first, long last, int n, long cap)
+{
+	if(writer.joinable())
+		throw vfbexception("AudioRing: already started");
+	if(s == NULL || n <= 0 || first > last)
+		throw vfbexception("AudioRing: bad parameters");
+
+	sink = s;
+	samplesPerFrame = size_t(n);
+	capacity = std::max(1L, std::min(cap, last - first + 1));
+	for(int ch=0; ch<2; ++ch)
+		samples[ch].assign(size_t(capacity) * samplesPerFrame, 0.0f);
+	ready.assign(size_t(capacity), 0);
+
+	base = first;
+	head = first;
+	end = last + 1;
+	aborted = false;
+	error = nullptr;
+
+	writer = std::thread(&AudioRing::Run, this);
+}
+
+//-----------------------------------------------------------------------------
+bool AudioRing::Begin(long frameNum, float **left, float **right)
+{
+	std::unique_lock<std::mutex> guard(lock);
+
+	changed.wait(guard, [&]{ return aborted || frameNum < head + capacity; });
+	if(aborted) return false;
+
+	size_t offset = size_t((frameNum - base) % capacity) * samplesPerFrame;
+	*left = &(samples[0][offset]);
+	*right = &(samples[1][offset]);
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+void AudioRing::Commit(long frameNum)
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	ready[size_t((frameNum - base) % capacity)] = 1;
+	changed.notify_all();
+}
+
+//-----------------------------------------------------------------------------
+void AudioRing::Abort()
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	aborted = true;
+	changed.notify_all();
+}
+
+//-----------------------------------------------------------------------------
+bool AudioRing::Finish()
+{
+	if(writer.joinable()) writer.join();
+
+	if(error)
+	{
+		std::exception_ptr e = error;
+		error = nullptr;
+		std::rethrow_exception(e);
+	}
+
+	return head == end;
+}
+
+//-----------------------------------------------------------------------------
+// The writer: hand each frame to the sink as soon as it and every frame
+// before it are ready. The slot is only released once the sink has
+// returned, so workers never render into samples still being written.
+void AudioRing::Run()
+{
+	for(;;)
+	{
+		size_t slot;
+
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			changed.wait(guard, [&]{ return aborted || head == end ||
+					ready[size_t((head - base) % capacity)]; });
+			if(aborted || head == end) return;
+			slot = size_t((head - base) % capacity);
+		}
+
+		try
+		{
+			sink->Write(&(samples[0][slot*samplesPerFrame]),
+					&(samples[1][slot*samplesPerFrame]), samplesPerFrame);
+		}
+		catch(...)
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			error = std::current_exception();
+			aborted = true;
+			changed.notify_all();
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			ready[slot] = 0;
+			++head;
+			changed.notify_all();
+		}
+	}
+}
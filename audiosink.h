@@ -0,0 +1,190 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+// AudioSink -- somewhere to stream extracted sound as it is produced.
+//
+// A sink takes two channels of [0,1] float samples (as the extractor and
+// the frame window's file audio pass produce them) in order, a block at a
+// time, and never needs to know the total length up front:
+//
+//   WavSink    PCM WAV, or BWF with a bext chunk; the RIFF and data sizes
+//              are patched when the file is closed
+//   FlacSink   FLAC through libavformat/libavcodec, with the BWF metadata
+//              written as Vorbis comments
+//
+// AudioRing sits between SoundExtractor's worker threads, which finish
+// frames out of order, and a sink. It holds a bounded window of frames,
+// each written in place by whichever worker renders it, and a writer
+// thread of its own drains the window to the sink in frame order. Workers
+// that get more than the window ahead of the writer wait, so the sample
+// memory an extraction needs is the size of the ring, not of the reel.
+
+#ifndef AUDIOSINK_H
+#define AUDIOSINK_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <QFile>
+#include <QString>
+
+#include "FilmScan.h" // USELIBAV
+#include "metadata.h"
+
+#define AUDIO_RING_DEFAULT_FRAMES 256
+
+//-----------------------------------------------------------------------------
+class AudioSink {
+public:
+	virtual ~AudioSink() {}
+
+	// n samples of each channel, each in [0,1]. Throws on error.
+	virtual void Write(const float *left, const float *right, size_t n) = 0;
+
+	// Finish the file. Throws on error.
+	virtual void Close() = 0;
+};
+
+// A WavSink or FlacSink by the extension of fn (".flac" for FLAC). meta,
+// if not NULL, is written as a bext chunk or as FLAC tags. The caller
+// deletes the sink.
+AudioSink *OpenAudioSink(const QString &fn, int samplingRate, int bitDepth,
+		const MetaData *meta=NULL);
+
+//-----------------------------------------------------------------------------
+// Samples are mapped to PCM as the muxer does (v * UMAX(bits) -
+// UMAX(bits)/2), clipped to the sample range.
+class WavSink : public AudioSink {
+private:
+	QFile file;
+	int bitDepth;
+	uint64_t riffBase;    // RIFF size, less the data
+	qint64 riffSizePos;
+	qint64 dataSizePos;
+	uint64_t dataSize;
+
+public:
+	WavSink() : bitDepth(0), riffBase(0), riffSizePos(0), dataSizePos(0),
+		dataSize(0) {} ;
+	~WavSink();
+
+	void Open(const QString &fn, int samplingRate, int bitDepth,
+			const MetaData *bext=NULL);
+	void Write(const float *left, const float *right, size_t n) override;
+	void Close() override;
+};
+
+#ifdef USELIBAV
+//-----------------------------------------------------------------------------
+// 16 bit, or 24 bit carried in 32 bit samples as libavcodec's FLAC
+// encoder wants them. Samples are buffered to the encoder's frame size.
+class FlacSink : public AudioSink {
+private:
+	QString fn;
+	AVFormatContext *format;
+	AVCodecContext *codec;
+	AVStream *stream;
+	AVFrame *frame;
+	AVPacket *packet;
+	int bitDepth;
+	int frameSize; // samples per encoder frame
+	int filled;    // samples in frame so far
+	int64_t pts;
+
+	void Encode(AVFrame *f);
+	void Free();
+
+public:
+	FlacSink() : format(NULL), codec(NULL), stream(NULL), frame(NULL),
+		packet(NULL), bitDepth(0), frameSize(0), filled(0), pts(0) {} ;
+	~FlacSink() { Free(); }
+
+	void Open(const QString &fn, int samplingRate, int bitDepth,
+			const MetaData *meta=NULL);
+	void Write(const float *left, const float *right, size_t n) override;
+	void Close() override;
+};
+#endif
+
+//-----------------------------------------------------------------------------
+class AudioRing {
+private:
+	AudioSink *sink;
+	size_t samplesPerFrame;
+	long capacity; // frames
+	long base;     // the first frame; frame f is in slot (f-base)%capacity
+	std::vector<float> samples[2];
+	std::vector<char> ready;
+
+	std::thread writer;
+
+	// guards everything below
+	std::mutex lock;
+	std::condition_variable changed;
+
+	long head; // the next frame to write to the sink
+	long end;  // one past the last frame
+	bool aborted;
+	std::exception_ptr error;
+
+	void Run();
+
+public:
+	AudioRing() : sink(NULL), samplesPerFrame(0), capacity(0), base(0),
+		head(0), end(0), aborted(false) {} ;
+	~AudioRing() { Abort(); if(writer.joinable()) writer.join(); }
+
+	// Stream the frames [first, last] to sink, holding up to capacity
+	// frames of samplesPerFrame samples at a time.
+	void Start(AudioSink *sink, long first, long last, int samplesPerFrame,
+			long capacity=AUDIO_RING_DEFAULT_FRAMES);
+
+	// Where to render frameNum's samples. Blocks until the frame is in
+	// the window; false if the ring was aborted meanwhile.
+	bool Begin(long frameNum, float **left, float **right);
+
+	// frameNum's samples are ready for the sink
+	void Commit(long frameNum);
+
+	// Stop waiting for frames; Begin() and the writer return at once.
+	void Abort();
+
+	// Wait for the writer. Rethrows an error from the sink; false if the
+	// ring was aborted before every frame was written.
+	bool Finish();
+
+	long Capacity() const { return capacity; }
+};
+
+#endif // AUDIOSINK_H
@@ -0,0 +1,516 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <set>
+#include <vector>
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+
+#include "batchmode.h"
+#include "extractjob.h"
+#include "extractscheduler.h"
+#include "project.h"
+#include "vbproject.h"
+#include "vfbexception.h"
+
+#define BATCH_OK 0
+#define BATCH_FAILED 1
+#define BATCH_USAGE 2
+
+class BatchOptions {
+public:
+	QString projectFn;
+	QString settingsFn;
+	QString sourceFn;
+	SourceFormat sourceFormat;
+	QString wavFn;
+	QString videoFn;
+	QString eventsFn;
+	QString queueFn;
+	bool addToQueue;
+	long frameIn;  // frame indices from the first frame of the scan;
+	long frameOut; // -1 for the start/end of the scan
+	int samplingRate;
+	int bitDepth;
+	int numThreads;
+	int numJobs;
+	long jobMemoryMB;
+	bool bwf;
+	bool measureOverlaps;
+
+	BatchOptions()
+		: sourceFormat(SOURCE_UNKNOWN), addToQueue(false), frameIn(-1),
+		frameOut(-1), samplingRate(48000), bitDepth(24), numThreads(0),
+		numJobs(EXTRACTSCHED_DEFAULT_WORKERS),
+		jobMemoryMB(EXTRACTJOB_DEFAULT_MEMORY / (1024*1024)), bwf(false),
+		measureOverlaps(false) {} ;
+};
+
+//-----------------------------------------------------------------------------
+static void BatchUsage(FILE *f)
+{
+	fprintf(f,
+		"usage: " APP_NAME " --batch [options]\n"
+		"  --project FILE    vbproject with the source, frame pitch and events\n"
+		"  --settings FILE   project settings saved from the main window\n"
+		"  --source FILE     scan to read (overrides project and settings)\n"
+		"  --format NAME     source format, as saved in the settings file\n"
+		"  --in N            first frame to process (0 = first of the scan)\n"
+		"  --out N           last frame to process\n"
+		"  --measure-overlaps\n"
+		"                    measure the frame overlaps of the range once and\n"
+		"                    keep them in the --project for extraction\n"
+		"  --wav FILE        extract the soundtrack to a WAV file (FLAC if\n"
+		"                    FILE ends in .flac)\n"
+		"  --bwf             include broadcast WAV (bext) metadata (FLAC\n"
+		"                    tags for FLAC)\n"
+		"  --rate HZ         sampling rate (default 48000)\n"
+		"  --bits N          16 or 24 bit samples (default 24)\n"
+		"  --threads N       extraction threads (default: one per core)\n"
+		"  --memory MB       sample buffer per extraction (default 64)\n"
+		"  --events FILE     export the project's events in range as XML\n"
+		"  --video FILE      mux video and soundtrack (not available)\n"
+		"  --queue FILE      run the extraction queue saved in FILE\n"
+		"  --add-to-queue    with --queue, add the --wav extraction to the\n"
+		"                    queue instead of running anything\n"
+		"  --jobs N          extractions to run at once (default 2)\n");
+}
+
+//-----------------------------------------------------------------------------
+static void Report(const QString &line)
+{
+	fprintf(stdout, "%s\n", line.toUtf8().constData());
+	fflush(stdout);
+}
+
+//-----------------------------------------------------------------------------
+static int ParseBatchArgs(int argc, char *argv[], BatchOptions &opt)
+{
+	for(int i=2; i<argc; ++i)
+	{
+		const char *arg = argv[i];
+		bool ok(true);
+
+		if(strcmp(arg, "--bwf") == 0)
+		{
+			opt.bwf = true;
+			continue;
+		}
+		if(strcmp(arg, "--add-to-queue") == 0)
+		{
+			opt.addToQueue = true;
+			continue;
+		}
+		if(strcmp(arg, "--measure-overlaps") == 0)
+		{
+			opt.measureOverlaps = true;
+			continue;
+		}
+
+		if(i+1 >= argc)
+		{
+			Report(QString("ERROR missing value for %1").arg(arg));
+			return BATCH_USAGE;
+		}
+		QString value = QString::fromLocal8Bit(argv[++i]);
+
+		if(strcmp(arg, "--project") == 0) opt.projectFn = value;
+		else if(strcmp(arg, "--settings") == 0) opt.settingsFn = value;
+		else if(strcmp(arg, "--source") == 0) opt.sourceFn = value;
+		else if(strcmp(arg, "--format") == 0)
+			opt.sourceFormat = FilmScan::StrToSourceFormat(
+					value.toUtf8().constData());
+		else if(strcmp(arg, "--wav") == 0) opt.wavFn = value;
+		else if(strcmp(arg, "--video") == 0) opt.videoFn = value;
+		else if(strcmp(arg, "--events") == 0) opt.eventsFn = value;
+		else if(strcmp(arg, "--in") == 0) opt.frameIn = value.toLong(&ok);
+		else if(strcmp(arg, "--out") == 0) opt.frameOut = value.toLong(&ok);
+		else if(strcmp(arg, "--rate") == 0) opt.samplingRate = value.toInt(&ok);
+		else if(strcmp(arg, "--bits") == 0) opt.bitDepth = value.toInt(&ok);
+		else if(strcmp(arg, "--threads") == 0) opt.numThreads = value.toInt(&ok);
+		else if(strcmp(arg, "--queue") == 0) opt.queueFn = value;
+		else if(strcmp(arg, "--jobs") == 0) opt.numJobs = value.toInt(&ok);
+		else if(strcmp(arg, "--memory") == 0)
+			opt.jobMemoryMB = value.toLong(&ok);
+		else
+		{
+			Report(QString("ERROR unknown option %1").arg(arg));
+			return BATCH_USAGE;
+		}
+
+		if(!ok)
+		{
+			Report(QString("ERROR bad value for %1: %2").arg(arg, value));
+			return BATCH_USAGE;
+		}
+	}
+
+	if(opt.wavFn.isEmpty() && opt.eventsFn.isEmpty() && opt.videoFn.isEmpty()
+			&& opt.queueFn.isEmpty() && !opt.measureOverlaps)
+	{
+		Report("ERROR nothing to do (give --wav, --events, --video, "
+				"--measure-overlaps or --queue)");
+		return BATCH_USAGE;
+	}
+	if(opt.measureOverlaps && (opt.projectFn.isEmpty() ||
+			opt.settingsFn.isEmpty()))
+	{
+		Report("ERROR --measure-overlaps needs --project and --settings");
+		return BATCH_USAGE;
+	}
+	if(opt.addToQueue && (opt.queueFn.isEmpty() || opt.wavFn.isEmpty()))
+	{
+		Report("ERROR --add-to-queue needs --queue and --wav");
+		return BATCH_USAGE;
+	}
+	if(opt.numJobs < 1)
+	{
+		Report("ERROR --jobs must be at least 1");
+		return BATCH_USAGE;
+	}
+	if(opt.jobMemoryMB < 1)
+	{
+		Report("ERROR --memory must be at least 1");
+		return BATCH_USAGE;
+	}
+	if(opt.bitDepth != 16 && opt.bitDepth != 24)
+	{
+		Report("ERROR --bits must be 16 or 24");
+		return BATCH_USAGE;
+	}
+	if(opt.samplingRate <= 0)
+	{
+		Report("ERROR --rate must be positive");
+		return BATCH_USAGE;
+	}
+
+	return BATCH_OK;
+}
+
+//-----------------------------------------------------------------------------
+static void BatchProgress(const ExtractJob &job, void *userData)
+{
+	long *lastPercent = static_cast<long *>(userData);
+	long percent = (job.framesDone * 100) / std::max(1L, job.framesTotal);
+
+	if(percent != *lastPercent || job.framesDone == job.framesTotal)
+	{
+		*lastPercent = percent;
+		Report(QString("PROGRESS extract %1 %2").arg(job.framesDone)
+				.arg(job.framesTotal));
+	}
+}
+
+//-----------------------------------------------------------------------------
+static void MeasureProgress(long done, long total, void *userData)
+{
+	long *lastPercent = static_cast<long *>(userData);
+	long percent = (done * 100) / std::max(1L, total);
+
+	if(percent != *lastPercent || done == total)
+	{
+		*lastPercent = percent;
+		Report(QString("PROGRESS overlaps %1 %2").arg(done).arg(total));
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Scheduler callbacks are serialized, so the per-job state needs no lock
+class QueueProgress {
+public:
+	std::vector<long> lastPercent;
+	std::vector<int> lastState;
+};
+
+static void QueueJobProgress(int jobIndex, const ExtractJob &job,
+		void *userData)
+{
+	QueueProgress *p = static_cast<QueueProgress *>(userData);
+
+	if(size_t(jobIndex) >= p->lastState.size())
+	{
+		p->lastState.resize(jobIndex+1, -1);
+		p->lastPercent.resize(jobIndex+1, -1);
+	}
+
+	if(p->lastState[jobIndex] != job.state)
+	{
+		p->lastState[jobIndex] = job.state;
+		Report(QString("JOB %1 %2 %3").arg(jobIndex)
+				.arg(ExtractJob::StateName(job.state), job.wavFn));
+		if(job.state == EXTRACT_JOB_FAILED)
+			Report(QString("ERROR job %1: %2").arg(jobIndex).arg(job.error));
+		if(job.state == EXTRACT_JOB_DONE)
+			Report(QString("OUTPUT wav %1").arg(job.wavFn));
+		return;
+	}
+
+	long percent = (job.framesDone * 100) / std::max(1L, job.framesTotal);
+	if(percent != p->lastPercent[jobIndex])
+	{
+		p->lastPercent[jobIndex] = percent;
+		Report(QString("PROGRESS job%1 %2 %3 %4").arg(jobIndex)
+				.arg(job.framesDone).arg(job.framesTotal)
+				.arg(job.framesPerSecond, 0, 'f', 1));
+	}
+}
+
+//-----------------------------------------------------------------------------
+static int RunQueue(const BatchOptions &opt)
+{
+	ExtractScheduler scheduler;
+	QueueProgress progress;
+
+	scheduler.LoadQueue(opt.queueFn);
+	scheduler.SetWorkerCount(opt.numJobs);
+	scheduler.SetThreadsPerJob(opt.numThreads);
+	scheduler.SetJobMemoryLimit(size_t(opt.jobMemoryMB) * 1024 * 1024);
+	scheduler.ProgressCallback(QueueJobProgress, &progress);
+
+	return scheduler.Run() ? BATCH_OK : BATCH_FAILED;
+}
+
+//-----------------------------------------------------------------------------
+// Export the events whose start frame is in [first,last]. ExportEvents()
+// selects by row, counting a row for each frame as well as each event.
+static void ExportEventsInRange(const vbproject &project, const QString &fn,
+		long first, long last)
+{
+	std::set<int> rows;
+	int row=0;
+	const VBFilmEvents &events = project.FilmEvents();
+
+	for(auto frameEvents = events.cbegin(); frameEvents != events.cend();
+			frameEvents++, row++)
+	{
+		for(auto event = frameEvents->cbegin(); event != frameEvents->cend();
+				event++, row++)
+		{
+			if(event->Start() >= first && event->Start() <= last)
+				rows.insert(row);
+		}
+	}
+
+	// ExportEvents() reports open failures with a message box, which a
+	// headless run can't show
+	QFile check(fn);
+	if(!check.open(QIODevice::WriteOnly | QIODevice::Text))
+		throw vfbexception(QString("Cannot write %1").arg(fn));
+	check.close();
+
+	project.ExportEvents(fn, [&rows](int r) { return rows.count(r) > 0; });
+	Report(QString("PROGRESS events %1 %2").arg(rows.size()).arg(rows.size()));
+}
+
+//-----------------------------------------------------------------------------
+static int RunBatch(const BatchOptions &opt)
+{
+	vbproject vbp;
+	ExtractSettings settings;
+	Project project;
+	QString source(opt.sourceFn);
+	SourceFormat format(opt.sourceFormat);
+
+	if(!opt.queueFn.isEmpty() && !opt.addToQueue)
+		return RunQueue(opt);
+
+	if(!opt.projectFn.isEmpty() && !vbp.load(opt.projectFn))
+		throw vfbexception(QString("Cannot load project %1")
+				.arg(opt.projectFn));
+	if(!opt.settingsFn.isEmpty())
+		settings = ReadSettingsFile(opt.settingsFn);
+
+	// same precedence and format guess as MainWindow::OpenProject()
+	if(source.isEmpty() && !vbp.FileURL().isEmpty())
+	{
+		source = vbp.FileURL();
+		if(format == SOURCE_UNKNOWN && !source.contains(".dpx",
+				Qt::CaseInsensitive))
+			format = SOURCE_LIBAV;
+	}
+	if(source.isEmpty() && settings.contains("Source Scan"))
+	{
+		source = settings["Source Scan"];
+		if(format == SOURCE_UNKNOWN && settings.contains("Source Format"))
+			format = FilmScan::StrToSourceFormat(
+					settings["Source Format"].toUtf8().constData());
+	}
+	if(source.isEmpty())
+		throw vfbexception("No source scan given");
+
+	if(!project.SourceScan(source.toStdString(), format))
+		throw vfbexception(QString("Cannot read source %1").arg(source));
+
+	const FilmScan &scan = project.inFile;
+	Report(QString("SOURCE %1 %2 %3 %4").arg(scan.FirstFrame())
+			.arg(scan.LastFrame()).arg(scan.Width()).arg(scan.Height()));
+	for(const auto &gap : scan.Gaps())
+		Report(QString("GAP %1 %2").arg(gap.first).arg(gap.second));
+	for(long frame : scan.DPXIndex().Mismatched())
+		Report(QString("MISMATCH %1").arg(frame));
+
+	long first = scan.FirstFrame() + std::max(0L, opt.frameIn);
+	long last = (opt.frameOut < 0) ? scan.LastFrame() :
+		scan.FirstFrame() + opt.frameOut;
+	if(first > last || last > scan.LastFrame())
+		throw vfbexception(QString("Frame range %1-%2 is outside the scan")
+				.arg(opt.frameIn).arg(opt.frameOut));
+
+	if(!opt.videoFn.isEmpty())
+		throw vfbexception("Muxed video output needs the GPU renderer and is "
+				"not available in batch mode");
+
+	if(opt.measureOverlaps)
+	{
+		SoundExtractorParams params = ExtractorParamsFromSettings(settings,
+				scan);
+		params.overlap[3] = vbp.overlap_framestart;
+		params.overlap[2] = vbp.overlap_frameend;
+
+		SoundExtractor extractor;
+		long lastPercent(-1);
+		extractor.SetSource(&scan);
+		extractor.SetParameters(params);
+		extractor.SetThreadCount(opt.numThreads);
+		extractor.ProgressCallback(MeasureProgress, &lastPercent);
+
+		vbp.overlapTrack.Measure(extractor, first, last);
+		if(!vbp.save(opt.projectFn))
+			throw vfbexception(QString("Cannot write project %1")
+					.arg(opt.projectFn));
+
+		Report(QString("OVERLAPS %1 %2").arg(last - first + 1)
+				.arg(vbp.overlapTrack.NumIffy()));
+		Report(QString("OUTPUT project %1").arg(opt.projectFn));
+	}
+
+	if(!opt.wavFn.isEmpty())
+	{
+		if(settings.isEmpty())
+			throw vfbexception("Soundtrack extraction needs --settings");
+
+		ExtractJob job;
+		job.source = source;
+		job.format = format;
+		job.settings = settings;
+		job.wavFn = opt.wavFn;
+		job.frameIn = opt.frameIn;
+		job.frameOut = opt.frameOut;
+		job.samplingRate = opt.samplingRate;
+		job.bitDepth = opt.bitDepth;
+		job.bwf = opt.bwf;
+
+		// the project's frame pitch wins, as in OpenProject()
+		if(!opt.projectFn.isEmpty())
+		{
+			job.hasFramePitch = true;
+			job.framePitchStart = vbp.overlap_framestart;
+			job.framePitchEnd = vbp.overlap_frameend;
+			job.overlapTrack = vbp.overlapTrack;
+		}
+
+		if(opt.addToQueue)
+		{
+			ExtractScheduler scheduler;
+			if(QFileInfo::exists(opt.queueFn))
+				scheduler.LoadQueue(opt.queueFn);
+			else
+				scheduler.SetQueueFile(opt.queueFn);
+			int index = scheduler.AddJob(job);
+			Report(QString("JOB %1 %2 %3").arg(index)
+					.arg(ExtractJob::StateName(job.state), job.wavFn));
+			Report(QString("OUTPUT queue %1").arg(opt.queueFn));
+		}
+		else
+		{
+			long lastPercent(-1);
+			job.Run(&scan, opt.numThreads,
+					size_t(opt.jobMemoryMB) * 1024 * 1024, NULL,
+					BatchProgress, &lastPercent);
+			Report(QString("OUTPUT wav %1").arg(opt.wavFn));
+		}
+	}
+
+	if(!opt.eventsFn.isEmpty())
+	{
+		if(opt.projectFn.isEmpty())
+			throw vfbexception("Event export needs --project");
+
+		// event frames count from the first frame of the scan
+		ExportEventsInRange(vbp, opt.eventsFn, first - scan.FirstFrame(),
+				last - scan.FirstFrame());
+		Report(QString("OUTPUT events %1").arg(opt.eventsFn));
+	}
+
+	return BATCH_OK;
+}
+
+//-----------------------------------------------------------------------------
+int BatchMain(int argc, char *argv[])
+{
+	QCoreApplication app(argc, argv);
+	app.setOrganizationName("USC MIRC");
+	app.setOrganizationDomain("imi.cas.sc.edu");
+	app.setApplicationName(APP_NAME);
+	app.setApplicationVersion(APP_VERSION_STR);
+
+	BatchOptions opt;
+	int status = ParseBatchArgs(argc, argv, opt);
+	if(status != BATCH_OK)
+	{
+		BatchUsage(stderr);
+		return status;
+	}
+
+	try
+	{
+		status = RunBatch(opt);
+	}
+	catch(std::exception &e)
+	{
+		Report(QString("ERROR %1").arg(e.what()));
+		return BATCH_FAILED;
+	}
+	catch(const char *msg) // older readers throw bare strings
+	{
+		Report(QString("ERROR %1").arg(msg));
+		return BATCH_FAILED;
+	}
+
+	Report("DONE");
+	return status;
+}
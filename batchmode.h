@@ -0,0 +1,60 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+// Batch mode -- run extraction and event export from the command line
+// without creating the main window or an OpenGL frame window, so reels can
+// be queued on headless machines. See BatchUsage() for the options.
+//
+// With --queue, the extractions saved in a queue file (see ExtractScheduler)
+// run a few at a time; --add-to-queue appends one to the file instead.
+// JOB lines report each job's state changes and its PROGRESS stage is
+// "job<index>".
+//
+// Progress and results are written to stdout one per line, as a keyword
+// followed by space-separated fields:
+//
+//   SOURCE <first frame> <last frame> <width> <height>
+//   GAP <first> <last>       (frames missing from an image sequence)
+//   MISMATCH <frame>         (a DPX laid out unlike the first frame)
+//   PROGRESS <stage> <done> <total> [<frames per second>]
+//   JOB <index> <state> <wav file>
+//   OUTPUT <kind> <path>
+//   ERROR <message>
+//   DONE
+//
+// BatchMain() returns 0 on success, 1 if any step failed and 2 for bad
+// arguments.
+
+#ifndef BATCHMODE_H
+#define BATCHMODE_H
+
+int BatchMain(int argc, char *argv[]);
+
+#endif // BATCHMODE_H
@@ -0,0 +1,234 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+
+#include "DPX.h"
+#include "FilmScan.h"
+#include "dpxframeindex.h"
+#include "mappedinstream.h"
+
+#define DPXINDEX_VERSION 2
+
+//-----------------------------------------------------------------------------
+DPXFrameInfo::DPXFrameInfo()
+	: fileSize(0), fileTime(0), imageOffset(0), width(0), height(0),
+	timeCode(0), bitDepth(0), numComponents(0), packing(0), encoding(0),
+	byteSwap(0), valid(0)
+{
+	reserved[0] = reserved[1] = 0;
+}
+
+//-----------------------------------------------------------------------------
+void DPXFrameInfo::FromHeader(const dpx::Header &h, uint64_t size,
+		int64_t time)
+{
+	fileSize = size;
+	fileTime = time;
+	imageOffset = h.imageOffset;
+	width = h.Width();
+	height = h.Height();
+	timeCode = h.timeCode;
+	bitDepth = h.BitDepth(0);
+	numComponents = uint8_t(h.ImageElementComponentCount(0));
+	packing = uint8_t(h.ImagePacking(0));
+	encoding = uint8_t(h.ImageEncoding(0));
+	byteSwap = h.RequiresByteSwap();
+	valid = 1;
+}
+
+//-----------------------------------------------------------------------------
+bool DPXFrameInfo::SameLayout(const DPXFrameInfo &o) const
+{
+	return width == o.width && height == o.height &&
+		bitDepth == o.bitDepth && numComponents == o.numComponents &&
+		packing == o.packing && encoding == o.encoding;
+}
+
+//-----------------------------------------------------------------------------
+void DPXFrameInfo::TimeCode(char *str) const
+{
+	dpx::Header h;
+	h.timeCode = timeCode;
+	h.TimeCode(str);
+}
+
+//-----------------------------------------------------------------------------
+void DPXFrameIndex::Build(const FilmScan &scan, int numThreads)
+{
+	firstFrame = scan.FirstFrame();
+	frames.assign(scan.NumFrames(), DPXFrameInfo());
+
+	std::atomic<long> next(0);
+	auto worker = [this, &scan, &next]() {
+		long i;
+		while((i = next++) < long(frames.size()))
+		{
+			// only the header's pages are read, not the image
+			MappedInStream img;
+			img.SetPopulate(false);
+			if(!img.Open(scan.FrameFileName(firstFrame + i).c_str()))
+				continue;
+
+			dpx::Reader dpx;
+			dpx.SetInStream(&img);
+			if(dpx.ReadHeader())
+				frames[i].FromHeader(dpx.header, img.Size(),
+						img.ModifiedTime());
+			img.Close();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for(int t=1; t<numThreads && t<long(frames.size()); ++t)
+		threads.push_back(std::thread(worker));
+	worker();
+	for(std::thread &t : threads)
+		t.join();
+
+	FindMismatched();
+}
+
+//-----------------------------------------------------------------------------
+void DPXFrameIndex::FindMismatched()
+{
+	mismatched.clear();
+
+	const DPXFrameInfo *first(NULL);
+	for(size_t i=0; i<frames.size(); ++i)
+	{
+		if(!frames[i].valid) continue;
+
+		if(first == NULL)
+			first = &frames[i];
+		else if(!frames[i].SameLayout(*first))
+			mismatched.push_back(firstFrame + long(i));
+	}
+}
+
+//-----------------------------------------------------------------------------
+const DPXFrameInfo *DPXFrameIndex::Find(long frameNum) const
+{
+	long i = frameNum - firstFrame;
+	if(i < 0 || i >= long(frames.size()) || !frames[i].valid) return NULL;
+	return &frames[i];
+}
+
+//-----------------------------------------------------------------------------
+namespace {
+
+// Fixed-size header of the index file; the records follow it. Everything
+// is in native byte order, as the file never leaves the machine.
+struct IndexFileHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t recordSize;
+	int64_t firstFrame;
+	int64_t numFrames;
+	int64_t dirTime;
+};
+
+QString IndexFileName(const FilmScan &scan)
+{
+	QByteArray key = QByteArray(scan.GetPath()) + "/" + scan.GetBaseName();
+	QByteArray hash = QCryptographicHash::hash(key,
+			QCryptographicHash::Sha1).toHex();
+
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+		"/sequences/" + QString::fromLatin1(hash) + ".dpxidx";
+}
+
+int64_t DirectoryTime(const FilmScan &scan)
+{
+	return QFileInfo(QString::fromLocal8Bit(scan.GetPath())).lastModified()
+		.toMSecsSinceEpoch();
+}
+
+}
+
+//-----------------------------------------------------------------------------
+bool DPXFrameIndex::Load(const FilmScan &scan)
+{
+	QFile file(IndexFileName(scan));
+	if(!file.open(QIODevice::ReadOnly)) return false;
+
+	IndexFileHeader h;
+	if(file.read(reinterpret_cast<char *>(&h), sizeof(h)) != sizeof(h) ||
+			memcmp(h.magic, "VFBDPXI", 8) != 0 ||
+			h.version != DPXINDEX_VERSION ||
+			h.recordSize != sizeof(DPXFrameInfo) ||
+			h.firstFrame != scan.FirstFrame() ||
+			h.numFrames != scan.NumFrames() ||
+			h.dirTime != DirectoryTime(scan))
+		return false;
+
+	std::vector<DPXFrameInfo> f(h.numFrames);
+	qint64 bytes = qint64(f.size() * sizeof(DPXFrameInfo));
+	if(file.read(reinterpret_cast<char *>(f.data()), bytes) != bytes)
+		return false;
+
+	firstFrame = scan.FirstFrame();
+	frames.swap(f);
+	FindMismatched();
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+void DPXFrameIndex::Save(const FilmScan &scan) const
+{
+	QString fn = IndexFileName(scan);
+	QDir().mkpath(QFileInfo(fn).absolutePath());
+
+	QFile file(fn);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return;
+
+	IndexFileHeader h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, "VFBDPXI", 8);
+	h.version = DPXINDEX_VERSION;
+	h.recordSize = sizeof(DPXFrameInfo);
+	h.firstFrame = firstFrame;
+	h.numFrames = long(frames.size());
+	h.dirTime = DirectoryTime(scan);
+
+	file.write(reinterpret_cast<const char *>(&h), sizeof(h));
+	file.write(reinterpret_cast<const char *>(frames.data()),
+			qint64(frames.size() * sizeof(DPXFrameInfo)));
+}
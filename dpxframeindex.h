@@ -0,0 +1,117 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+// DPXFrameIndex -- the header fields of every frame of a DPX sequence,
+// read once so that frames can be read without parsing their headers.
+//
+// Build() reads the headers of all the frames on a pool of threads (the
+// work is almost all file system latency, so there are more threads than
+// cores). The index is saved as a compact binary file in the user's cache
+// directory, next to the sequence index (see ImageSequence), and is
+// reloaded as long as the directory hasn't changed. Each record carries
+// the file's size and modification time, and readers fall back to parsing
+// the header when the file on disk doesn't match them (a frame rewritten
+// in place).
+//
+// Frames whose layout (dimensions, bit depth, components, packing or
+// encoding) differs from the first frame's are listed by Mismatched().
+
+#ifndef DPXFRAMEINDEX_H
+#define DPXFRAMEINDEX_H
+
+#include <cstdint>
+#include <vector>
+
+#include <QString>
+
+#include "DPXHeader.h"
+
+#define DPXINDEX_BUILD_THREADS 16
+
+class FilmScan;
+
+//-----------------------------------------------------------------------------
+// One frame's header, as much of it as the frame readers use
+class DPXFrameInfo {
+public:
+	uint64_t fileSize;
+	int64_t fileTime;  // modified, in ms since the epoch
+	uint32_t imageOffset;
+	uint32_t width;
+	uint32_t height;
+	uint32_t timeCode;
+	uint8_t bitDepth;
+	uint8_t numComponents;
+	uint8_t packing;   // dpx::Packing
+	uint8_t encoding;  // dpx::Encoding
+	uint8_t byteSwap;
+	uint8_t valid;     // 0 if the header couldn't be read
+	uint8_t reserved[2];
+
+	DPXFrameInfo();
+
+	void FromHeader(const dpx::Header &h, uint64_t fileSize,
+			int64_t fileTime);
+	bool SameLayout(const DPXFrameInfo &other) const;
+
+	// HH:MM:SS:FF
+	void TimeCode(char *str) const;
+};
+
+//-----------------------------------------------------------------------------
+class DPXFrameIndex {
+private:
+	long firstFrame;
+	std::vector<DPXFrameInfo> frames;
+	std::vector<long> mismatched;
+
+	void FindMismatched();
+
+public:
+	DPXFrameIndex() : firstFrame(0) {} ;
+
+	// Read the header of every frame of scan
+	void Build(const FilmScan &scan, int numThreads=DPXINDEX_BUILD_THREADS);
+
+	// Load the index saved for scan, if there is one and it is current
+	bool Load(const FilmScan &scan);
+	// Failing to save only costs a rebuild next time
+	void Save(const FilmScan &scan) const;
+
+	long FirstFrame() const { return firstFrame; }
+	long NumFrames() const { return long(frames.size()); }
+
+	// NULL if frameNum isn't indexed or its header couldn't be read
+	const DPXFrameInfo *Find(long frameNum) const;
+
+	const std::vector<long> &Mismatched() const { return mismatched; }
+};
+
+#endif // DPXFRAMEINDEX_H
@@ -0,0 +1,662 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <vector>
+
+#include "dpxunpack.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || \
+	(defined(__i386__) && defined(__SSE2__))
+#define DPX_UNPACK_HAVE_SSE2
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define DPX_UNPACK_HAVE_AVX2
+#define DPX_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#define DPX_UNPACK_HAVE_AVX2
+#define DPX_TARGET_AVX2
+#endif
+#endif
+
+//-----------------------------------------------------------------------------
+// Scalar kernels (also used for the tails of the vector kernels)
+
+static inline uint32_t Swap32(uint32_t w)
+{
+	w = (w >> 16) | (w << 16);
+	return ((w & 0xFF00FF00) >> 8) | ((w & 0x00FF00FF) << 8);
+}
+
+static inline uint16_t Swap16(uint16_t w)
+{
+	return uint16_t((w >> 8) | (w << 8));
+}
+
+static inline uint16_t Scale10(uint32_t v) { return uint16_t((v<<6) | (v>>4)); }
+static inline uint16_t Scale12(uint32_t v) { return uint16_t((v<<4) | (v>>8)); }
+
+// shift is the number of pad bits below the first sample (2 for method A)
+static void Unpack10Scalar(const uint8_t *src, uint16_t *dst, size_t n,
+		bool swap, int shift)
+{
+	size_t i(0);
+	while(i < n)
+	{
+		uint32_t w;
+		memcpy(&w, src, 4);
+		src += 4;
+		if(swap) w = Swap32(w);
+		w >>= shift;
+
+		for(int k=0; k<3 && i<n; ++k, ++i)
+		{
+			dst[i] = Scale10(w & 0x03FF);
+			w >>= 10;
+		}
+	}
+}
+
+static void Unpack12Scalar(const uint8_t *src, uint16_t *dst, size_t n,
+		bool swap, bool methodA)
+{
+	for(size_t i=0; i<n; ++i, src+=2)
+	{
+		uint16_t w;
+		memcpy(&w, src, 2);
+		if(swap) w = Swap16(w);
+		dst[i] = Scale12(methodA ? (w >> 4) : (w & 0x0FFF));
+	}
+}
+
+static void Unpack16Scalar(const uint8_t *src, uint16_t *dst, size_t n,
+		bool swap)
+{
+	memcpy(dst, src, n*2);
+	if(swap)
+	{
+		for(size_t i=0; i<n; ++i)
+			dst[i] = Swap16(dst[i]);
+	}
+}
+
+#ifdef DPX_UNPACK_HAVE_SSE2
+//-----------------------------------------------------------------------------
+// SSE2 kernels
+
+static inline __m128i Swap32SSE2(__m128i w)
+{
+	w = _mm_or_si128(_mm_slli_epi32(w, 16), _mm_srli_epi32(w, 16));
+	const __m128i lo = _mm_set1_epi32(0x00FF00FF);
+	return _mm_or_si128(
+			_mm_srli_epi32(_mm_andnot_si128(lo, w), 8),
+			_mm_slli_epi32(_mm_and_si128(lo, w), 8));
+}
+
+static inline __m128i Swap16SSE2(__m128i w)
+{
+	return _mm_or_si128(_mm_slli_epi16(w, 8), _mm_srli_epi16(w, 8));
+}
+
+// Four words hold twelve samples. S0, S1 and S2 hold the first, second and
+// third sample of each word; each group of four output samples takes lanes
+// 0 and 3 from one of them, lane 1 from the next and lane 2 from the last.
+#define DPX_SSE2_MERGE(A, ia, ja, B, ib, C, ic) \
+	_mm_or_si128(_mm_or_si128( \
+		_mm_and_si128(_mm_shuffle_epi32(A, _MM_SHUFFLE(ja,0,0,ia)), m03), \
+		_mm_and_si128(_mm_shuffle_epi32(B, _MM_SHUFFLE(0,0,ib,0)), m1)), \
+		_mm_and_si128(_mm_shuffle_epi32(C, _MM_SHUFFLE(0,ic,0,0)), m2))
+
+static void Unpack10SSE2(const uint8_t *src, uint16_t *dst, size_t n,
+		bool swap, int shift)
+{
+	const __m128i mask = _mm_set1_epi32(0x03FF);
+	const __m128i m03 = _mm_set_epi32(-1, 0, 0, -1);
+	const __m128i m1 = _mm_set_epi32(0, 0, -1, 0);
+	const __m128i m2 = _mm_set_epi32(0, -1, 0, 0);
+	const __m128i cnt = _mm_cvtsi32_si128(shift);
+
+	size_t i(0);
+	for( ; i+12 <= n; i+=12, src+=16)
+	{
+		__m128i w = _mm_loadu_si128((const __m128i *)src);
+		if(swap) w = Swap32SSE2(w);
+		w = _mm_srl_epi32(w, cnt);
+
+		__m128i s0 = _mm_and_si128(w, mask);
+		__m128i s1 = _mm_and_si128(_mm_srli_epi32(w, 10), mask);
+		__m128i s2 = _mm_and_si128(_mm_srli_epi32(w, 20), mask);
+
+		__m128i r0 = DPX_SSE2_MERGE(s0, 0, 1, s1, 0, s2, 0);
+		__m128i r1 = DPX_SSE2_MERGE(s1, 1, 2, s2, 1, s0, 2);
+		__m128i r2 = DPX_SSE2_MERGE(s2, 2, 3, s0, 3, s1, 3);
+
+		// 10-bit values pack safely with signed saturation
+		__m128i p01 = _mm_packs_epi32(r0, r1);
+		__m128i p2 = _mm_packs_epi32(r2, r2);
+		p01 = _mm_or_si128(_mm_slli_epi16(p01, 6), _mm_srli_epi16(p01, 4));
+		p2 = _mm_or_si128(_mm_slli_epi16(p2, 6), _mm_srli_epi16(p2, 4));
+
+		_mm_storeu_si128((__m128i *)(dst+i), p01);
+		_mm_storel_epi64((__m128i *)(dst+i+8), p2);
+	}
+
+	Unpack10Scalar(src, dst+i, n-i, swap, shift);
+}
+
+#undef DPX_SSE2_MERGE
+
+static void Unpack12SSE2(const uint8_t *src, uint16_t *dst, size_t n,
+		bool swap, bool methodA)
+{
+	const __m128i mask = _mm_set1_epi16(0x0FFF);
+
+	size_t i(0);
+	for( ; i+8 <= n; i+=8, src+=16)
+	{
+		__m128i w = _mm_loadu_si128((const __m128i *)src);
+		if(swap) w = Swap16SSE2(w);
+		w = methodA ? _mm_srli_epi16(w, 4) : _mm_and_si128(w, mask);
+		w = _mm_or_si128(_mm_slli_epi16(w, 4), _mm_srli_epi16(w, 8));
+		_mm_storeu_si128((__m128i *)(dst+i), w);
+	}
+
+	Unpack12Scalar(src, dst+i, n-i, swap, methodA);
+}
+
+static void Unpack16SSE2(const uint8_t *src, uint16_t *dst, size_t n,
+		bool swap)
+{
+	if(!swap)
+	{
+		memcpy(dst, src, n*2);
+		return;
+	}
+
+	size_t i(0);
+	for( ; i+8 <= n; i+=8, src+=16)
+	{
+		__m128i w = _mm_loadu_si128((const __m128i *)src);
+		_mm_storeu_si128((__m128i *)(dst+i), Swap16SSE2(w));
+	}
+
+	Unpack16Scalar(src, dst+i, n-i, swap);
+}
+#endif // DPX_UNPACK_HAVE_SSE2
+
+#ifdef DPX_UNPACK_HAVE_AVX2
+//-----------------------------------------------------------------------------
+// AVX2 kernels
+
+DPX_TARGET_AVX2
+static inline __m256i Swap32AVX2(__m256i w)
+{
+	const __m256i order = _mm256_setr_epi8(
+			3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12,
+			3,2,1,0, 7,6,5,4, 11,10,9,8, 15,14,13,12);
+	return _mm256_shuffle_epi8(w, order);
+}
+
+DPX_TARGET_AVX2
+static inline __m256i Swap16AVX2(__m256i w)
+{
+	return _mm256_or_si256(_mm256_slli_epi16(w, 8), _mm256_srli_epi16(w, 8));
+}
+
+// Eight words hold 24 samples. Each output lane picks its word with a
+// cross-lane permute and its field with a per-lane variable shift.
+DPX_TARGET_AVX2
+static void Unpack10AVX2(const uint8_t *src, uint16_t *dst, size_t n,
+		bool swap, int shift)
+{
+	const __m256i mask = _mm256_set1_epi32(0x03FF);
+	const int a = shift, b = shift+10, c = shift+20;
+	const __m256i idx0 = _mm256_setr_epi32(0,0,0,1,1,1,2,2);
+	const __m256i idx1 = _mm256_setr_epi32(2,3,3,3,4,4,4,5);
+	const __m256i idx2 = _mm256_setr_epi32(5,5,6,6,6,7,7,7);
+	const __m256i sh0 = _mm256_setr_epi32(a,b,c,a,b,c,a,b);
+	const __m256i sh1 = _mm256_setr_epi32(c,a,b,c,a,b,c,a);
+	const __m256i sh2 = _mm256_setr_epi32(b,c,a,b,c,a,b,c);
+
+	size_t i(0);
+	for( ; i+24 <= n; i+=24, src+=32)
+	{
+		__m256i w = _mm256_loadu_si256((const __m256i *)src);
+		if(swap) w = Swap32AVX2(w);
+
+		__m256i r0 = _mm256_and_si256(
+				_mm256_srlv_epi32(_mm256_permutevar8x32_epi32(w, idx0), sh0),
+				mask);
+		__m256i r1 = _mm256_and_si256(
+				_mm256_srlv_epi32(_mm256_permutevar8x32_epi32(w, idx1), sh1),
+				mask);
+		__m256i r2 = _mm256_and_si256(
+				_mm256_srlv_epi32(_mm256_permutevar8x32_epi32(w, idx2), sh2),
+				mask);
+
+		// packs work within 128-bit lanes; put the quarters back in order
+		__m256i p01 = _mm256_permute4x64_epi64(
+				_mm256_packus_epi32(r0, r1), _MM_SHUFFLE(3,1,2,0));
+		__m256i p2 = _mm256_permute4x64_epi64(
+				_mm256_packus_epi32(r2, r2), _MM_SHUFFLE(3,1,2,0));
+		p01 = _mm256_or_si256(
+				_mm256_slli_epi16(p01, 6), _mm256_srli_epi16(p01, 4));
+		p2 = _mm256_or_si256(
+				_mm256_slli_epi16(p2, 6), _mm256_srli_epi16(p2, 4));
+
+		_mm256_storeu_si256((__m256i *)(dst+i), p01);
+		_mm_storeu_si128((__m128i *)(dst+i+16), _mm256_castsi256_si128(p2));
+	}
+
+	Unpack10Scalar(src, dst+i, n-i, swap, shift);
+}
+
+DPX_TARGET_AVX2
+static void Unpack12AVX2(const uint8_t *src, uint16_t *dst, size_t n,
+		bool swap, bool methodA)
+{
+	const __m256i mask = _mm256_set1_epi16(0x0FFF);
+
+	size_t i(0);
+	for( ; i+16 <= n; i+=16, src+=32)
+	{
+		__m256i w = _mm256_loadu_si256((const __m256i *)src);
+		if(swap) w = Swap16AVX2(w);
+		w = methodA ? _mm256_srli_epi16(w, 4) : _mm256_and_si256(w, mask);
+		w = _mm256_or_si256(_mm256_slli_epi16(w, 4), _mm256_srli_epi16(w, 8));
+		_mm256_storeu_si256((__m256i *)(dst+i), w);
+	}
+
+	Unpack12Scalar(src, dst+i, n-i, swap, methodA);
+}
+
+DPX_TARGET_AVX2
+static void Unpack16AVX2(const uint8_t *src, uint16_t *dst, size_t n,
+		bool swap)
+{
+	if(!swap)
+	{
+		memcpy(dst, src, n*2);
+		return;
+	}
+
+	size_t i(0);
+	for( ; i+16 <= n; i+=16, src+=32)
+	{
+		__m256i w = _mm256_loadu_si256((const __m256i *)src);
+		_mm256_storeu_si256((__m256i *)(dst+i), Swap16AVX2(w));
+	}
+
+	Unpack16Scalar(src, dst+i, n-i, swap);
+}
+
+static bool CPUHasAVX2()
+{
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#else
+	int info[4];
+	__cpuid(info, 0);
+	if(info[0] < 7) return false;
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1<<27)) != 0;
+	if(!osxsave || (_xgetbv(0) & 0x6) != 0x6) return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1<<5)) != 0;
+#endif
+}
+#endif // DPX_UNPACK_HAVE_AVX2
+
+//-----------------------------------------------------------------------------
+size_t DPXPackedSize(DPXPackedFormat fmt, size_t nSamples)
+{
+	switch(fmt)
+	{
+	case DPX_PACKED_10_FILLED_A:
+	case DPX_PACKED_10_FILLED_B:
+		return ((nSamples + 2) / 3) * 4;
+	default:
+		return nSamples * 2;
+	}
+}
+
+//-----------------------------------------------------------------------------
+DPXUnpackISA DPXUnpackBestISA()
+{
+#if defined(DPX_UNPACK_HAVE_AVX2)
+	static const DPXUnpackISA best =
+			CPUHasAVX2() ? DPX_UNPACK_AVX2 : DPX_UNPACK_SSE2;
+	return best;
+#elif defined(DPX_UNPACK_HAVE_SSE2)
+	return DPX_UNPACK_SSE2;
+#else
+	return DPX_UNPACK_SCALAR;
+#endif
+}
+
+const char *DPXUnpackISAName(DPXUnpackISA isa)
+{
+	switch(isa)
+	{
+	case DPX_UNPACK_AVX2: return "AVX2";
+	case DPX_UNPACK_SSE2: return "SSE2";
+	default: return "scalar";
+	}
+}
+
+//-----------------------------------------------------------------------------
+void DPXUnpack(DPXPackedFormat fmt, const void *src, uint16_t *dst,
+		size_t nSamples, bool byteSwap)
+{
+	DPXUnpack(fmt, src, dst, nSamples, byteSwap, DPXUnpackBestISA());
+}
+
+void DPXUnpack(DPXPackedFormat fmt, const void *src, uint16_t *dst,
+		size_t nSamples, bool byteSwap, DPXUnpackISA isa)
+{
+	const uint8_t *s = static_cast<const uint8_t *>(src);
+
+	// never run a kernel the CPU (or this build) can't
+	if(isa > DPXUnpackBestISA()) isa = DPXUnpackBestISA();
+
+	int shift = (fmt == DPX_PACKED_10_FILLED_A) ? 2 : 0;
+	bool methodA = (fmt == DPX_PACKED_12_FILLED_A);
+
+	switch(isa)
+	{
+#ifdef DPX_UNPACK_HAVE_AVX2
+	case DPX_UNPACK_AVX2:
+		switch(fmt)
+		{
+		case DPX_PACKED_10_FILLED_A:
+		case DPX_PACKED_10_FILLED_B:
+			Unpack10AVX2(s, dst, nSamples, byteSwap, shift); return;
+		case DPX_PACKED_12_FILLED_A:
+		case DPX_PACKED_12_FILLED_B:
+			Unpack12AVX2(s, dst, nSamples, byteSwap, methodA); return;
+		case DPX_PACKED_16:
+			Unpack16AVX2(s, dst, nSamples, byteSwap); return;
+		}
+		break;
+#endif
+#ifdef DPX_UNPACK_HAVE_SSE2
+	case DPX_UNPACK_SSE2:
+		switch(fmt)
+		{
+		case DPX_PACKED_10_FILLED_A:
+		case DPX_PACKED_10_FILLED_B:
+			Unpack10SSE2(s, dst, nSamples, byteSwap, shift); return;
+		case DPX_PACKED_12_FILLED_A:
+		case DPX_PACKED_12_FILLED_B:
+			Unpack12SSE2(s, dst, nSamples, byteSwap, methodA); return;
+		case DPX_PACKED_16:
+			Unpack16SSE2(s, dst, nSamples, byteSwap); return;
+		}
+		break;
+#endif
+	default:
+		break;
+	}
+
+	switch(fmt)
+	{
+	case DPX_PACKED_10_FILLED_A:
+	case DPX_PACKED_10_FILLED_B:
+		Unpack10Scalar(s, dst, nSamples, byteSwap, shift); return;
+	case DPX_PACKED_12_FILLED_A:
+	case DPX_PACKED_12_FILLED_B:
+		Unpack12Scalar(s, dst, nSamples, byteSwap, methodA); return;
+	case DPX_PACKED_16:
+		Unpack16Scalar(s, dst, nSamples, byteSwap); return;
+	}
+}
+
+//-----------------------------------------------------------------------------
+void DPXSamplesToGray(const uint16_t *src, double *dst, size_t nPixels,
+		int nChannels)
+{
+	const double scale = 1.0/(nChannels * 0x00FFFF);
+	size_t i(0);
+
+#ifdef DPX_UNPACK_HAVE_SSE2
+	if(nChannels == 1)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128d vscale = _mm_set1_pd(scale);
+
+		for( ; i+8 <= nPixels; i+=8)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i *)(src+i));
+			__m128i lo = _mm_unpacklo_epi16(v, zero);
+			__m128i hi = _mm_unpackhi_epi16(v, zero);
+
+			_mm_storeu_pd(dst+i,
+					_mm_mul_pd(_mm_cvtepi32_pd(lo), vscale));
+			_mm_storeu_pd(dst+i+2, _mm_mul_pd(
+					_mm_cvtepi32_pd(_mm_srli_si128(lo, 8)), vscale));
+			_mm_storeu_pd(dst+i+4,
+					_mm_mul_pd(_mm_cvtepi32_pd(hi), vscale));
+			_mm_storeu_pd(dst+i+6, _mm_mul_pd(
+					_mm_cvtepi32_pd(_mm_srli_si128(hi, 8)), vscale));
+		}
+	}
+#endif
+
+	for( ; i<nPixels; ++i)
+	{
+		const uint16_t *p = src + i*nChannels;
+		uint32_t sum(0);
+		for(int c=0; c<nChannels; ++c)
+			sum += p[c];
+		dst[i] = double(sum) * scale;
+	}
+}
+
+#ifdef DPX_UNPACK_HAVE_SSE2
+// eight 16-bit samples as two vectors of four floats
+static inline void WidenSSE2(const uint16_t *src, __m128 &lo, __m128 &hi)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i v = _mm_loadu_si128((const __m128i *)src);
+	lo = _mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero));
+	hi = _mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero));
+}
+
+// The sums of four RGB pixels, whose twelve samples are x, y and z:
+// regroup them as (r0 r1 r2 r3) + (g0 g1 g2 g3) + (b0 b1 b2 b3)
+static inline __m128 SumTriplesSSE2(__m128 x, __m128 y, __m128 z)
+{
+	__m128 r = _mm_shuffle_ps(x,
+			_mm_shuffle_ps(y, z, _MM_SHUFFLE(1,1,2,2)), _MM_SHUFFLE(2,0,3,0));
+	__m128 g = _mm_shuffle_ps(
+			_mm_shuffle_ps(x, y, _MM_SHUFFLE(0,0,1,1)),
+			_mm_shuffle_ps(y, z, _MM_SHUFFLE(2,2,3,3)), _MM_SHUFFLE(2,0,2,0));
+	__m128 b = _mm_shuffle_ps(
+			_mm_shuffle_ps(x, y, _MM_SHUFFLE(1,1,2,2)), z, _MM_SHUFFLE(3,0,2,0));
+	return _mm_add_ps(_mm_add_ps(r, g), b);
+}
+
+// eight values in [0-65535] held as int32 to uint16 (SSE2 only has a
+// signed saturating pack, so bias into the signed range and back)
+static inline __m128i PackU16SSE2(__m128i lo, __m128i hi)
+{
+	const __m128i bias32 = _mm_set1_epi32(0x8000);
+	const __m128i bias16 = _mm_set1_epi16(short(0x8000));
+	return _mm_xor_si128(bias16, _mm_packs_epi32(
+			_mm_sub_epi32(lo, bias32), _mm_sub_epi32(hi, bias32)));
+}
+
+// eight gray values, scaled, from 8 (nChannels 1) or 24 (nChannels 3)
+// samples
+static inline void GrayEightSSE2(const uint16_t *src, int nChannels,
+		__m128 scale, __m128 &lo, __m128 &hi)
+{
+	if(nChannels == 1)
+	{
+		WidenSSE2(src, lo, hi);
+	}
+	else
+	{
+		__m128 f[6];
+		WidenSSE2(src, f[0], f[1]);
+		WidenSSE2(src+8, f[2], f[3]);
+		WidenSSE2(src+16, f[4], f[5]);
+		lo = SumTriplesSSE2(f[0], f[1], f[2]);
+		hi = SumTriplesSSE2(f[3], f[4], f[5]);
+	}
+	lo = _mm_mul_ps(lo, scale);
+	hi = _mm_mul_ps(hi, scale);
+}
+#endif
+
+void DPXSamplesToGray(const uint16_t *src, float *dst, size_t nPixels,
+		int nChannels)
+{
+	const float scale = 1.0f/(nChannels * 65535.0f);
+	size_t i(0);
+
+#ifdef DPX_UNPACK_HAVE_SSE2
+	if(nChannels == 1 || nChannels == 3)
+	{
+		const __m128 vscale = _mm_set1_ps(scale);
+		for( ; i+8 <= nPixels; i+=8)
+		{
+			__m128 lo, hi;
+			GrayEightSSE2(src + i*nChannels, nChannels, vscale, lo, hi);
+			_mm_storeu_ps(dst+i, lo);
+			_mm_storeu_ps(dst+i+4, hi);
+		}
+	}
+#endif
+
+	for( ; i<nPixels; ++i)
+	{
+		const uint16_t *p = src + i*nChannels;
+		uint32_t sum(0);
+		for(int c=0; c<nChannels; ++c)
+			sum += p[c];
+		dst[i] = float(sum) * scale;
+	}
+}
+
+void DPXSamplesToGray(const uint16_t *src, uint16_t *dst, size_t nPixels,
+		int nChannels)
+{
+	if(nChannels == 1)
+	{
+		memcpy(dst, src, nPixels*2);
+		return;
+	}
+
+	size_t i(0);
+
+#ifdef DPX_UNPACK_HAVE_SSE2
+	if(nChannels == 3)
+	{
+		const __m128 third = _mm_set1_ps(1.0f/3.0f);
+		for( ; i+8 <= nPixels; i+=8)
+		{
+			__m128 lo, hi;
+			GrayEightSSE2(src + i*3, 3, third, lo, hi);
+			_mm_storeu_si128((__m128i *)(dst+i), PackU16SSE2(
+					_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi)));
+		}
+	}
+#endif
+
+	for( ; i<nPixels; ++i)
+	{
+		const uint16_t *p = src + i*nChannels;
+		uint32_t sum(0);
+		for(int c=0; c<nChannels; ++c)
+			sum += p[c];
+		dst[i] = uint16_t((sum + nChannels/2) / nChannels);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// DPXUnpackBenchmark - run each kernel over a 4K luma frame's worth of
+// samples and report the rate at which unpacked samples are written.
+void DPXUnpackBenchmark(std::ostream &out)
+{
+	const size_t nSamples = 4096 * 3112;
+	const int reps = 20;
+
+	static const struct { DPXPackedFormat fmt; const char *name; } fmts[] = {
+		{ DPX_PACKED_10_FILLED_A, "10-bit filled A" },
+		{ DPX_PACKED_10_FILLED_B, "10-bit filled B" },
+		{ DPX_PACKED_12_FILLED_A, "12-bit filled A" },
+		{ DPX_PACKED_12_FILLED_B, "12-bit filled B" },
+		{ DPX_PACKED_16, "16-bit" }
+	};
+
+	std::vector<uint8_t> src(DPXPackedSize(DPX_PACKED_16, nSamples));
+	std::vector<uint16_t> dst(nSamples);
+	uint32_t seed(12345);
+	for(uint8_t &b : src)
+	{
+		seed = seed*1664525u + 1013904223u;
+		b = uint8_t(seed >> 24);
+	}
+
+	out << "DPX unpack kernels, " << nSamples << " samples, best ISA: "
+		<< DPXUnpackISAName(DPXUnpackBestISA()) << "\n";
+
+	for(const auto &f : fmts)
+	{
+		for(int swap=0; swap<2; ++swap)
+		{
+			for(int isa=DPX_UNPACK_SCALAR; isa<=DPXUnpackBestISA(); ++isa)
+			{
+				// warm up caches and page in dst
+				DPXUnpack(f.fmt, src.data(), dst.data(), nSamples, swap,
+						DPXUnpackISA(isa));
+
+				auto start = std::chrono::steady_clock::now();
+				for(int r=0; r<reps; ++r)
+					DPXUnpack(f.fmt, src.data(), dst.data(), nSamples, swap,
+							DPXUnpackISA(isa));
+				std::chrono::duration<double> dt =
+						std::chrono::steady_clock::now() - start;
+
+				double gbps = (double(nSamples) * 2 * reps) / dt.count() / 1e9;
+				out << std::left << std::setw(16) << f.name
+					<< std::setw(8) << (swap ? "swap" : "native")
+					<< std::setw(8) << DPXUnpackISAName(DPXUnpackISA(isa))
+					<< std::right << std::fixed << std::setprecision(2)
+					<< std::setw(8) << gbps << " GB/s\n";
+			}
+		}
+	}
+}
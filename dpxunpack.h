@@ -0,0 +1,94 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+// DPX sample unpacking kernels.
+//
+// Each kernel turns the image payload of a DPX file into native-endian
+// 16-bit samples, doing the byte swap, the unpacking and the rescale to
+// the full 16-bit range in a single pass. There are scalar, SSE2 and AVX2
+// versions of every kernel; DPXUnpack() picks the best one the CPU
+// supports.
+//
+// 10-bit samples are rescaled with (v<<6)|(v>>4) and 12-bit samples with
+// (v<<4)|(v>>8), which map full scale to 0xFFFF exactly.
+
+#ifndef DPXUNPACK_H
+#define DPXUNPACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+enum DPXPackedFormat
+{
+	DPX_PACKED_10_FILLED_A, // 3 samples per 32-bit word, 2 pad bits at LSB
+	DPX_PACKED_10_FILLED_B, // 3 samples per 32-bit word, 2 pad bits at MSB
+	DPX_PACKED_12_FILLED_A, // 1 sample per 16-bit word, 4 pad bits at LSB
+	DPX_PACKED_12_FILLED_B, // 1 sample per 16-bit word, 4 pad bits at MSB
+	DPX_PACKED_16
+};
+
+enum DPXUnpackISA
+{
+	DPX_UNPACK_SCALAR,
+	DPX_UNPACK_SSE2,
+	DPX_UNPACK_AVX2
+};
+
+// number of bytes of payload holding nSamples samples
+size_t DPXPackedSize(DPXPackedFormat fmt, size_t nSamples);
+
+// best kernel set available on this CPU
+DPXUnpackISA DPXUnpackBestISA();
+const char *DPXUnpackISAName(DPXUnpackISA isa);
+
+// Unpack nSamples samples from src to dst. src must hold at least
+// DPXPackedSize(fmt, nSamples) bytes; byteSwap is true when the file's
+// endianness differs from the machine's.
+void DPXUnpack(DPXPackedFormat fmt, const void *src, uint16_t *dst,
+		size_t nSamples, bool byteSwap);
+void DPXUnpack(DPXPackedFormat fmt, const void *src, uint16_t *dst,
+		size_t nSamples, bool byteSwap, DPXUnpackISA isa);
+
+// Average nChannels interleaved 16-bit samples per pixel into a gray value
+// (the conversion ReadFrameDPX uses): in [0-1] for float and double
+// destinations, in [0-65535] for uint16_t ones. One and three channel
+// images have SSE2 kernels.
+void DPXSamplesToGray(const uint16_t *src, double *dst, size_t nPixels,
+		int nChannels);
+void DPXSamplesToGray(const uint16_t *src, float *dst, size_t nPixels,
+		int nChannels);
+void DPXSamplesToGray(const uint16_t *src, uint16_t *dst, size_t nPixels,
+		int nChannels);
+
+// Time every kernel on every available ISA and report GB/s of output.
+void DPXUnpackBenchmark(std::ostream &out);
+
+#endif // DPXUNPACK_H
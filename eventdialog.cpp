@@ -39,6 +39,7 @@
 #include <QInputDialog>
 #include <QMessageBox>
 #include <QPlainTextEdit>
+#include <QProgressDialog>
 #include <QShortcut>
 #include <QSpinBox>
 
@@ -214,7 +215,16 @@ void eventdialog::ImportEvents()
 
     if(fileName.isEmpty()) return;
 
-    lastImport = mainwindow->vbscan.ImportEvents(fileName);
+    QProgressDialog progress("Importing events...", QString(), 0, 100, this);
+    progress.setWindowTitle("Import Events");
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+
+    lastImport = mainwindow->vbscan.ImportEvents(fileName,
+        [&progress](qint64 done, qint64 total) {
+            progress.setValue(total ? int((100*done)/total) : 100); });
+
+    progress.reset();
 
     if(lastImport.size() > 0)
     {
@@ -878,7 +888,7 @@ void eventdialog::UpdateTableOnce()
         static_cast<VBFilmEventsTableModel *>(ui->tableView->model());
     int nRow = tableModel->rowCount();
 
-    QList<int> selectedRows;
+    QSet<int> selectedRows;
     if(ui->tableView->selectionModel()->hasSelection())
     {
         for(auto i : ui->tableView->selectionModel()->selectedRows())
@@ -895,17 +905,25 @@ void eventdialog::UpdateTableOnce()
         if(ui->showImportCheckbox->isChecked() && !lastImport.isEmpty())
             test.AddCondition(lastImport);
 
-        for(int r=0; r<nRow; ++r)
+        CompiledEventFilter compiled = test.Compile();
+
+        // walk the events in table order rather than looking up each row
+        int r=0;
+        for(auto &frameEvents : *(tableModel->FilmEvents()))
         {
-            if(test.EventPasses(*(tableModel->EventAtRow(r))))
-            {
-                ui->tableView->showRow(r);
-                nFiltered++;
-            }
-            else
+            for(auto &event : frameEvents)
             {
-                ui->tableView->hideRow(r);
-                if(selectedRows.contains(r)) nSelectedAndHidden++;
+                if(compiled.EventPasses(event))
+                {
+                    ui->tableView->showRow(r);
+                    nFiltered++;
+                }
+                else
+                {
+                    ui->tableView->hideRow(r);
+                    if(selectedRows.contains(r)) nSelectedAndHidden++;
+                }
+                ++r;
             }
         }
     }
@@ -268,6 +268,11 @@ bool EventFilter::EventPasses(const vbevent &event) const
     }
 }
 
+CompiledEventFilter EventFilter::Compile() const
+{
+    return CompiledEventFilter(*this);
+}
+
 const QStringList& EventFilter::ConditionNames()
 {
     return EventFilterCompName;
@@ -285,3 +290,206 @@ const QStringList& EventFilter::MatchingModeNames()
 {
     return EventFilterMatchingModeName;
 }
+
+//=============================================================================
+
+CompiledEventFilter::CompiledEventFilter(const EventFilter &filter) :
+    matchMode(filter.MatchMode())
+{
+    for(const EventFilterCondition &cond : filter.Conditions())
+    {
+        Condition c;
+        c.comparison = cond.comparison;
+        c.isNegated = cond.isNegated;
+        c.pattern = cond.pattern;
+        c.targetSet = cond.targetSet;
+        c.target = cond.pattern.toDouble(&c.targetIsNumeric);
+        c.attrID = -1;
+
+        // these are the names vbevent::Attribute() answers from the
+        // event's own fields rather than its attribute list
+        QString attr = vbevent::MakeAttributeName(cond.attribute);
+        if((attr.compare("Start",Qt::CaseInsensitive)==0) ||
+            (attr.compare("Frame",Qt::CaseInsensitive)==0))
+            c.source = ATTR_SOURCE_START;
+        else if(attr.compare("End",Qt::CaseInsensitive)==0)
+            c.source = ATTR_SOURCE_END;
+        else if((attr.compare("EventType",Qt::CaseInsensitive)==0) ||
+            (attr.compare("Type",Qt::CaseInsensitive)==0))
+            c.source = ATTR_SOURCE_TYPE;
+        else if(attr.compare("SubType",Qt::CaseInsensitive)==0)
+            c.source = ATTR_SOURCE_SUBTYPE;
+        else if(attr.compare("Notes",Qt::CaseInsensitive)==0)
+            c.source = ATTR_SOURCE_NOTES;
+        else
+        {
+            c.source = ATTR_SOURCE_STORED;
+            if(EventFilterCompIsAttr(c.comparison))
+                c.attrID = vbevent::InternAttributeName(attr);
+        }
+
+        conditions.append(c);
+    }
+}
+
+QString CompiledEventFilter::Value(
+    const Condition &c,
+    const vbevent &event) const
+{
+    switch(c.source)
+    {
+    case ATTR_SOURCE_START:
+        return QString::number(event.Start());
+    case ATTR_SOURCE_END:
+        return QString::number(event.End());
+    case ATTR_SOURCE_TYPE:
+        return event.TypeName();
+    case ATTR_SOURCE_SUBTYPE:
+        return event.Attribute(event.SubTypeID());
+    case ATTR_SOURCE_NOTES:
+        return event.notes;
+    default:
+        return event.Attribute(c.attrID);
+    }
+}
+
+bool CompiledEventFilter::NumericValue(
+    const Condition &c,
+    const vbevent &event,
+    double *value) const
+{
+    bool ok(true);
+
+    switch(c.source)
+    {
+    case ATTR_SOURCE_START:
+        *value = event.Start();
+        break;
+    case ATTR_SOURCE_END:
+        *value = event.End();
+        break;
+    default:
+        *value = Value(c, event).toDouble(&ok);
+    }
+
+    return ok;
+}
+
+bool CompiledEventFilter::ConditionPasses(
+    const Condition &c,
+    const vbevent &event) const
+{
+    bool pass(true);
+    bool neg = c.isNegated;
+    double value;
+
+    switch(c.comparison)
+    {
+    case EVENT_FILTER_COMP_NOT_IN_SET:
+        neg = !neg;
+        [[fallthrough]];
+    case EVENT_FILTER_COMP_IN_SET:
+        pass = c.targetSet.contains(event);
+        break;
+
+    case EVENT_FILTER_COMP_ATTR_NOT_EQUAL:
+        neg = !neg;
+        [[fallthrough]];
+    case EVENT_FILTER_COMP_ATTR_EQUAL:
+        pass = (Value(c,event).compare(c.pattern, Qt::CaseInsensitive)==0);
+        break;
+
+    case EVENT_FILTER_COMP_ATTR_DOES_NOT_CONTAIN:
+        neg = !neg;
+        [[fallthrough]];
+    case EVENT_FILTER_COMP_ATTR_CONTAINS:
+        pass = Value(c,event).contains(c.pattern, Qt::CaseInsensitive);
+        break;
+
+    case EVENT_FILTER_COMP_ATTR_DOES_NOT_START_WITH:
+        neg = !neg;
+        [[fallthrough]];
+    case EVENT_FILTER_COMP_ATTR_STARTS_WITH:
+        pass = Value(c,event).startsWith(c.pattern, Qt::CaseInsensitive);
+        break;
+
+    case EVENT_FILTER_COMP_ATTR_DOES_NOT_EXIST:
+        neg = !neg;
+        [[fallthrough]];
+    case EVENT_FILTER_COMP_ATTR_EXISTS:
+        pass = !Value(c,event).isNull();
+        break;
+
+    // as in EventFilterCondition, a non-numeric value or target
+    // fails the test whether or not it is negated
+    case EVENT_FILTER_COMP_ATTR_NE:
+        neg = !neg;
+        [[fallthrough]];
+    case EVENT_FILTER_COMP_ATTR_EQ:
+        if(!c.targetIsNumeric || !NumericValue(c,event,&value)) return false;
+        pass = (value == c.target);
+        break;
+
+    case EVENT_FILTER_COMP_ATTR_GE:
+        neg = !neg;
+        [[fallthrough]];
+    case EVENT_FILTER_COMP_ATTR_LT:
+        if(!c.targetIsNumeric || !NumericValue(c,event,&value)) return false;
+        pass = (value < c.target);
+        break;
+
+    case EVENT_FILTER_COMP_ATTR_LE:
+        neg = !neg;
+        [[fallthrough]];
+    case EVENT_FILTER_COMP_ATTR_GT:
+        if(!c.targetIsNumeric || !NumericValue(c,event,&value)) return false;
+        pass = (value > c.target);
+        break;
+
+    case EVENT_FILTER_COMP_POS_LEFT:
+        pass = event.BoundsX1() < 0.5;
+        break;
+    case EVENT_FILTER_COMP_POS_RIGHT:
+        pass = event.BoundsX0() > 0.5;
+        break;
+    case EVENT_FILTER_COMP_POS_NOT_SPAN:
+        neg = !neg;
+        [[fallthrough]];
+    case EVENT_FILTER_COMP_POS_SPAN:
+        pass = event.BoundsX0() < 0.5 && event.BoundsX1() > 0.5;
+        break;
+    case EVENT_FILTER_COMP_POS_TOP:
+        pass = event.BoundsY1() < 0.5;
+        break;
+    case EVENT_FILTER_COMP_POS_BOTTOM:
+        pass = event.BoundsY0() > 0.5;
+        break;
+
+    default:
+        pass = false;
+        neg = false;
+    }
+
+    return(neg ? !pass : pass);
+}
+
+bool CompiledEventFilter::EventPasses(const vbevent &event) const
+{
+    switch(matchMode)
+    {
+    case EVENT_FILTER_MATCH_ALL:
+        for(const Condition &c : conditions)
+        {
+            if(!ConditionPasses(c, event)) return false;
+        }
+        return true;
+    case EVENT_FILTER_MATCH_ANY:
+        for(const Condition &c : conditions)
+        {
+            if(ConditionPasses(c, event)) return true;
+        }
+        return false;
+    }
+
+    return false;
+}
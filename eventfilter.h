@@ -127,8 +127,11 @@ static const QStringList EventFilterMatchingModeName = {
 };
 #endif
 
+class CompiledEventFilter;
+
 class EventFilterCondition
 {
+    friend class CompiledEventFilter;
 
 private:
     EventFilterComp comparison;
@@ -205,10 +208,58 @@ public:
     EventFilterCondition Condition(int pos) const;
     void ReplaceCondition(int pos, EventFilterCondition cond);
     bool EventPasses(const vbevent &event) const;
+    CompiledEventFilter Compile() const;
 
     static const QStringList& ConditionNames();
     static const QStringList ConditionNamesSimpleSet();
     static const QStringList& MatchingModeNames();
 };
 
+// CompiledEventFilter
+// ===================
+// An EventFilter prepared for testing many events: attribute names are
+// resolved to interned IDs (or to the event field they alias), and
+// numeric targets are parsed once. Results are the same as
+// EventFilter::EventPasses. The compiled filter doesn't track later
+// changes to the EventFilter it was made from.
+
+class CompiledEventFilter
+{
+public:
+    explicit CompiledEventFilter(const EventFilter &filter);
+
+    bool EventPasses(const vbevent &event) const;
+
+private:
+    enum AttributeSource
+    {
+        ATTR_SOURCE_STORED,
+        ATTR_SOURCE_START,
+        ATTR_SOURCE_END,
+        ATTR_SOURCE_TYPE,
+        ATTR_SOURCE_SUBTYPE,
+        ATTR_SOURCE_NOTES
+    };
+
+    struct Condition
+    {
+        EventFilterComp comparison;
+        bool isNegated;
+        AttributeSource source;
+        AttributeID attrID;
+        QString pattern;
+        double target;
+        bool targetIsNumeric;
+        EventSet targetSet;
+    };
+
+    QString Value(const Condition &c, const vbevent &event) const;
+    bool NumericValue(const Condition &c, const vbevent &event,
+                      double *value) const;
+    bool ConditionPasses(const Condition &c, const vbevent &event) const;
+
+    QVector<Condition> conditions;
+    EventFilterMatchingMode matchMode;
+};
+
 #endif // EVENTFILTER_H
@@ -0,0 +1,126 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+#include <algorithm>
+
+#include "eventintervalindex.h"
+
+void EventIntervalIndex::Insert(vbevent *e)
+{
+    if(!e) return;
+
+    intervals.insert(e, qMakePair(e->Start(), std::max(e->Start(), e->End())));
+    dirty = true;
+}
+
+bool EventIntervalIndex::Remove(vbevent *e)
+{
+    if(!intervals.remove(e)) return false;
+
+    dirty = true;
+    return true;
+}
+
+void EventIntervalIndex::Clear()
+{
+    intervals.clear();
+    nodes.clear();
+    dirty = false;
+}
+
+void EventIntervalIndex::Rebuild() const
+{
+    nodes.clear();
+    nodes.reserve(size_t(intervals.size()));
+
+    for(auto i = intervals.cbegin(), end = intervals.cend(); i != end; ++i)
+        nodes.push_back({ i.value().first, i.value().second, 0, i.key() });
+
+    // order by start, then end, so the results come out in a stable order
+    std::sort(nodes.begin(), nodes.end(),
+        [](const Node &a, const Node &b)
+        {
+            if(a.start != b.start) return a.start < b.start;
+            if(a.end != b.end) return a.end < b.end;
+            return a.event->ID() < b.event->ID();
+        });
+
+    BuildSubtree(0, nodes.size());
+    dirty = false;
+}
+
+uint32_t EventIntervalIndex::BuildSubtree(size_t lo, size_t hi) const
+{
+    // The subtree over nodes[lo,hi) is rooted at the midpoint.
+    if(lo >= hi) return 0;
+
+    size_t mid = lo + (hi-lo)/2;
+    uint32_t m = nodes[mid].end;
+    m = std::max(m, BuildSubtree(lo, mid));
+    m = std::max(m, BuildSubtree(mid+1, hi));
+    nodes[mid].maxEnd = m;
+
+    return m;
+}
+
+void EventIntervalIndex::Query(
+    size_t lo, size_t hi, uint32_t first, uint32_t last,
+    QList<vbevent *> &out) const
+{
+    if(lo >= hi) return;
+
+    size_t mid = lo + (hi-lo)/2;
+    const Node &n = nodes[mid];
+
+    // nothing in this subtree reaches the range
+    if(n.maxEnd < first) return;
+
+    Query(lo, mid, first, last, out);
+
+    // everything from here on to the right starts after the range
+    if(n.start > last) return;
+
+    if(n.end >= first) out.append(n.event);
+
+    Query(mid+1, hi, first, last, out);
+}
+
+QList<vbevent *> EventIntervalIndex::EventsInRange(
+    uint32_t first, uint32_t last) const
+{
+    QList<vbevent *> events;
+
+    if(dirty) Rebuild();
+    if(last < first || nodes.empty()) return events;
+
+    Query(0, nodes.size(), first, last, events);
+
+    return events;
+}
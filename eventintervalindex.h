@@ -0,0 +1,89 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+#ifndef EVENTINTERVALINDEX_H
+#define EVENTINTERVALINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <vector>
+
+#include "vbevent.h"
+
+// Index of events by their [Start, End] frame interval, for finding the
+// events that cover a given frame (or range of frames) without scanning
+// every event.
+//
+// The intervals are kept in a vector sorted by Start and searched as an
+// implicit balanced binary tree, where each node records the largest End
+// in its subtree. Edits only mark the index dirty; the tree is rebuilt
+// on the next query, so a batch of adds costs one sort.
+//
+// The interval of each event is captured when it is inserted. If an
+// event's Start or End changes, remove and re-insert it.
+
+class EventIntervalIndex
+{
+public:
+    EventIntervalIndex() : dirty(false) {}
+
+    void Insert(vbevent *e);
+    bool Remove(vbevent *e);
+    void Clear();
+    int Size() const { return intervals.size(); }
+
+    // events with Start <= frame <= End, in order of Start
+    QList<vbevent *> EventsAt(uint32_t frame) const
+        { return EventsInRange(frame, frame); }
+
+    // events whose interval intersects [first, last], in order of Start
+    QList<vbevent *> EventsInRange(uint32_t first, uint32_t last) const;
+
+private:
+    struct Node
+    {
+        uint32_t start;
+        uint32_t end;
+        uint32_t maxEnd; // largest end in the subtree rooted here
+        vbevent *event;
+    };
+
+    void Rebuild() const;
+    uint32_t BuildSubtree(size_t lo, size_t hi) const;
+    void Query(size_t lo, size_t hi, uint32_t first, uint32_t last,
+               QList<vbevent *> &out) const;
+
+    QHash<vbevent *, QPair<uint32_t, uint32_t>> intervals;
+
+    mutable std::vector<Node> nodes;
+    mutable bool dirty;
+};
+
+#endif // EVENTINTERVALINDEX_H
@@ -0,0 +1,429 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+#include <algorithm>
+
+extern "C"
+{
+#include <libavutil/channel_layout.h>
+#include <libavutil/opt.h>
+}
+
+#include "exportsession.h"
+#include "vfbexception.h"
+
+// samples per audio frame for encoders that take any number (PCM)
+#define EXPORT_AUDIO_FRAME_SAMPLES 1024
+
+static const char *codecNames[] = { "default", "h264", "prores", "ffv1" };
+
+//-----------------------------------------------------------------------------
+const char *ExportCodecName(ExportCodec codec)
+{
+	return codecNames[codec];
+}
+
+bool ExportCodecFromName(const QString &name, ExportCodec *codec)
+{
+	for(int i=0; i<int(sizeof(codecNames)/sizeof(codecNames[0])); ++i)
+	{
+		if(name.compare(codecNames[i], Qt::CaseInsensitive) == 0)
+		{
+			*codec = ExportCodec(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+// want if the encoder takes it, otherwise whatever holds RGBA best
+static enum AVPixelFormat PixelFormat(const AVCodec *enc,
+		enum AVPixelFormat want)
+{
+	if(enc->pix_fmts == NULL)
+		return (want != AV_PIX_FMT_NONE) ? want : AV_PIX_FMT_YUV420P;
+
+	for(const enum AVPixelFormat *p = enc->pix_fmts; *p != AV_PIX_FMT_NONE;
+			++p)
+		if(*p == want) return want;
+
+	return avcodec_find_best_pix_fmt_of_list(enc->pix_fmts, AV_PIX_FMT_RGBA,
+			0, NULL);
+}
+
+//-----------------------------------------------------------------------------
+void ExportSession::Open(const QString &filename, const ExportSettings &s)
+{
+	QByteArray name = filename.toUtf8();
+
+	if(format != NULL)
+		throw vfbexception("ExportSession: already open");
+	if(s.frameRate <= 0 || s.samplingRate <= 0 ||
+			(s.video && (s.width <= 0 || s.height <= 0)))
+		throw vfbexception("ExportSession: bad settings");
+
+	fn = filename;
+	settings = s;
+	videoPts = 0;
+	audioPts = 0;
+	filled = 0;
+
+#if LIBAVFORMAT_VERSION_INT < AV_VERSION_INT(58, 9, 100)
+	av_register_all();
+#endif
+
+	try
+	{
+		if(avformat_alloc_output_context2(&format, NULL, NULL,
+				name.constData()) < 0 || format == NULL)
+			throw vfbexception(QString("Unknown video format: %1").arg(fn));
+
+		if(settings.video) OpenVideo();
+		if(settings.audio) OpenAudio();
+		if(videoCodec == NULL && audioCodec == NULL)
+			throw vfbexception(QString("%1 can hold neither video nor audio")
+					.arg(fn));
+
+		if(!(format->oformat->flags & AVFMT_NOFILE) &&
+				avio_open(&format->pb, name.constData(), AVIO_FLAG_WRITE) < 0)
+			throw vfbexception(QString("Cannot write %1").arg(fn));
+		if(avformat_write_header(format, NULL) < 0)
+			throw vfbexception(QString("Error writing %1").arg(fn));
+
+		// the caller renders; the pipeline converts, encodes and muxes
+		if(videoCodec)
+			pipeline.Start(format, videoStream, videoCodec, AV_PIX_FMT_RGBA);
+	}
+	catch(...)
+	{
+		Free();
+		throw;
+	}
+}
+
+//-----------------------------------------------------------------------------
+void ExportSession::OpenVideo()
+{
+	const AVOutputFormat *of = format->oformat;
+	const AVCodec *enc = NULL;
+	enum AVPixelFormat pixFmt = AV_PIX_FMT_YUV420P;
+
+	switch(settings.videoCodec)
+	{
+	case EXPORT_CODEC_H264:
+		enc = avcodec_find_encoder(AV_CODEC_ID_H264);
+		break;
+	case EXPORT_CODEC_PRORES:
+		// prores_ks has all the profiles, 4444 included
+		if((enc = avcodec_find_encoder_by_name("prores_ks")) == NULL)
+			enc = avcodec_find_encoder(AV_CODEC_ID_PRORES);
+		pixFmt = (settings.proresProfile >= 4) ?
+			AV_PIX_FMT_YUV444P10 : AV_PIX_FMT_YUV422P10;
+		break;
+	case EXPORT_CODEC_FFV1:
+		enc = avcodec_find_encoder(AV_CODEC_ID_FFV1);
+		pixFmt = AV_PIX_FMT_NONE;
+		break;
+	default:
+		if(of->video_codec == AV_CODEC_ID_NONE) return;
+		enc = avcodec_find_encoder(of->video_codec);
+		break;
+	}
+	if(enc == NULL)
+		throw vfbexception(QString("No %1 video encoder")
+				.arg(ExportCodecName(settings.videoCodec)));
+	if(avformat_query_codec(of, enc->id, FF_COMPLIANCE_NORMAL) == 0)
+		throw vfbexception(QString("%1 cannot hold %2 video")
+				.arg(fn).arg(enc->name));
+
+	if((videoStream = avformat_new_stream(format, NULL)) == NULL ||
+			(videoCodec = avcodec_alloc_context3(enc)) == NULL)
+		throw vfbexception("Cannot allocate video encoder");
+
+	videoCodec->width = settings.width;
+	videoCodec->height = settings.height;
+	videoCodec->time_base = AVRational{ 1, settings.frameRate };
+	videoCodec->framerate = AVRational{ settings.frameRate, 1 };
+	videoCodec->pix_fmt = PixelFormat(enc, pixFmt);
+
+	// the encoder's own threads work alongside the pipeline's
+	videoCodec->thread_count = settings.threads;
+	videoCodec->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+
+	switch(settings.videoCodec)
+	{
+	case EXPORT_CODEC_H264:
+		// libx264's options; other H.264 encoders ignore them
+		av_opt_set_int(videoCodec->priv_data, "crf", settings.crf, 0);
+		av_opt_set(videoCodec->priv_data, "preset", "medium", 0);
+		break;
+	case EXPORT_CODEC_PRORES:
+		videoCodec->profile = settings.proresProfile;
+		av_opt_set_int(videoCodec->priv_data, "profile",
+				settings.proresProfile, 0);
+		break;
+	case EXPORT_CODEC_FFV1:
+		videoCodec->level = 3;
+		videoCodec->gop_size = 1;
+		av_opt_set_int(videoCodec->priv_data, "slicecrc", 1, 0);
+		break;
+	default:
+		videoCodec->bit_rate = int64_t(settings.width) * settings.height * 4;
+		videoCodec->gop_size = 12;
+		if(enc->id == AV_CODEC_ID_MPEG2VIDEO)
+			videoCodec->max_b_frames = 2;
+		if(enc->id == AV_CODEC_ID_MPEG1VIDEO)
+			videoCodec->mb_decision = 2;
+		break;
+	}
+
+	if(of->flags & AVFMT_GLOBALHEADER)
+		videoCodec->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+	if(avcodec_open2(videoCodec, enc, NULL) < 0)
+		throw vfbexception(QString("Cannot open the %1 video encoder")
+				.arg(enc->name));
+	if(avcodec_parameters_from_context(videoStream->codecpar, videoCodec) < 0)
+		throw vfbexception("Cannot set video stream parameters");
+	videoStream->time_base = videoCodec->time_base;
+}
+
+//-----------------------------------------------------------------------------
+void ExportSession::OpenAudio()
+{
+	const AVOutputFormat *of = format->oformat;
+	const AVCodec *enc;
+	enum AVCodecID id = of->audio_codec;
+	const int rate = settings.samplingRate;
+
+	// lossless video deserves lossless sound
+	if((settings.videoCodec == EXPORT_CODEC_PRORES ||
+			settings.videoCodec == EXPORT_CODEC_FFV1) &&
+			avformat_query_codec(of, AV_CODEC_ID_PCM_S24LE,
+				FF_COMPLIANCE_NORMAL) == 1)
+		id = AV_CODEC_ID_PCM_S24LE;
+
+	if(id == AV_CODEC_ID_NONE) return;
+	if((enc = avcodec_find_encoder(id)) == NULL)
+		throw vfbexception(QString("No %1 audio encoder")
+				.arg(avcodec_get_name(id)));
+
+	if((audioStream = avformat_new_stream(format, NULL)) == NULL ||
+			(audioCodec = avcodec_alloc_context3(enc)) == NULL ||
+			(audioFrame = av_frame_alloc()) == NULL ||
+			(audioPacket = av_packet_alloc()) == NULL)
+		throw vfbexception("Cannot allocate audio encoder");
+
+	audioCodec->sample_fmt = enc->sample_fmts ?
+		enc->sample_fmts[0] : AV_SAMPLE_FMT_FLTP;
+	audioCodec->sample_rate = rate;
+	audioCodec->bit_rate = 192000;
+	audioCodec->time_base = AVRational{ 1, rate };
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 28, 100)
+	av_channel_layout_default(&audioCodec->ch_layout, 2);
+#else
+	audioCodec->channel_layout = AV_CH_LAYOUT_STEREO;
+	audioCodec->channels = 2;
+#endif
+	if(of->flags & AVFMT_GLOBALHEADER)
+		audioCodec->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+
+	if(avcodec_open2(audioCodec, enc, NULL) < 0)
+		throw vfbexception(QString("Cannot open the %1 audio encoder")
+				.arg(enc->name));
+	if(avcodec_parameters_from_context(audioStream->codecpar, audioCodec) < 0)
+		throw vfbexception("Cannot set audio stream parameters");
+	audioStream->time_base = audioCodec->time_base;
+
+	// samples arrive as planar float, two channels at the output rate
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 28, 100)
+	if(swr_alloc_set_opts2(&swr, &audioCodec->ch_layout,
+			audioCodec->sample_fmt, rate, &audioCodec->ch_layout,
+			AV_SAMPLE_FMT_FLTP, rate, 0, NULL) < 0)
+		swr = NULL;
+#else
+	swr = swr_alloc_set_opts(NULL, AV_CH_LAYOUT_STEREO,
+			audioCodec->sample_fmt, rate, AV_CH_LAYOUT_STEREO,
+			AV_SAMPLE_FMT_FLTP, rate, 0, NULL);
+#endif
+	if(swr == NULL || swr_init(swr) < 0)
+		throw vfbexception("Cannot initialize the audio converter");
+
+	audioFrameSize = (audioCodec->frame_size > 0) ?
+		audioCodec->frame_size : EXPORT_AUDIO_FRAME_SAMPLES;
+	audioFrame->format = audioCodec->sample_fmt;
+	audioFrame->sample_rate = rate;
+	audioFrame->nb_samples = audioFrameSize;
+#if LIBAVUTIL_VERSION_INT >= AV_VERSION_INT(57, 28, 100)
+	av_channel_layout_copy(&audioFrame->ch_layout, &audioCodec->ch_layout);
+#else
+	audioFrame->channel_layout = audioCodec->channel_layout;
+	audioFrame->channels = audioCodec->channels;
+#endif
+	if(av_frame_get_buffer(audioFrame, 0) < 0)
+		throw vfbexception("Cannot allocate audio frame");
+
+	for(int c=0; c<2; ++c)
+		pending[c].assign(size_t(audioFrameSize), 0.0f);
+}
+
+//-----------------------------------------------------------------------------
+// Convert the pending samples and send them to the encoder
+void ExportSession::ConvertAudio()
+{
+	const uint8_t *in[2] = {
+		(const uint8_t *)pending[0].data(),
+		(const uint8_t *)pending[1].data() };
+
+	audioFrame->nb_samples = audioFrameSize;
+	if(av_frame_make_writable(audioFrame) < 0)
+		throw vfbexception("Cannot write audio frame");
+
+	int n = swr_convert(swr, audioFrame->data, audioFrameSize, in, filled);
+	if(n < 0)
+		throw vfbexception("Error converting audio");
+	filled = 0;
+	if(n == 0) return;
+
+	audioFrame->nb_samples = n;
+	audioFrame->pts = audioPts;
+	audioPts += n;
+	EncodeAudio(audioFrame);
+}
+
+//-----------------------------------------------------------------------------
+// NULL flushes the encoder. Packets go through the pipeline, which
+// serializes them with the video's.
+void ExportSession::EncodeAudio(AVFrame *frame)
+{
+	int ret = avcodec_send_frame(audioCodec, frame);
+
+	while(ret >= 0)
+	{
+		ret = avcodec_receive_packet(audioCodec, audioPacket);
+		if(ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) return;
+		if(ret < 0) break;
+
+		ret = pipeline.WritePacket(format, audioPacket,
+				audioCodec->time_base, audioStream);
+	}
+
+	throw vfbexception(QString("Error encoding audio for %1").arg(fn));
+}
+
+//-----------------------------------------------------------------------------
+void ExportSession::Write(const float *left, const float *right, size_t n)
+{
+	const float *ch[2] = { left, right };
+
+	if(format == NULL)
+		throw vfbexception("ExportSession: not open");
+	if(audioCodec == NULL) return;
+
+	for(size_t i=0; i<n; ++i)
+	{
+		for(int c=0; c<2; ++c)
+			pending[c][filled] = ch[c][i]*2.0f - 1.0f;
+
+		if(++filled == audioFrameSize)
+			ConvertAudio();
+	}
+}
+
+//-----------------------------------------------------------------------------
+void ExportSession::Close()
+{
+	if(format == NULL) return;
+
+	try
+	{
+		if(audioCodec)
+		{
+			// encoders with a fixed frame size get a last frame of silence
+			const int caps = AV_CODEC_CAP_VARIABLE_FRAME_SIZE |
+				AV_CODEC_CAP_SMALL_LAST_FRAME;
+			if(filled && audioCodec->frame_size > 0 &&
+					!(audioCodec->codec->capabilities & caps))
+			{
+				for(int c=0; c<2; ++c)
+					std::fill(pending[c].begin() + filled, pending[c].end(),
+							0.0f);
+				filled = audioFrameSize;
+			}
+			if(filled) ConvertAudio();
+			EncodeAudio(NULL);
+		}
+
+		// the rest of the video, and the encoder's delayed packets
+		if(videoCodec) pipeline.Finish();
+
+		if(av_write_trailer(format) < 0)
+			throw vfbexception(QString("Error writing %1").arg(fn));
+	}
+	catch(...)
+	{
+		Abort();
+		throw;
+	}
+
+	Free();
+}
+
+//-----------------------------------------------------------------------------
+void ExportSession::Abort()
+{
+	pipeline.Stop();
+	Free();
+}
+
+//-----------------------------------------------------------------------------
+// The pipeline must be stopped first: it uses the video codec context.
+void ExportSession::Free()
+{
+	av_frame_free(&audioFrame);
+	av_packet_free(&audioPacket);
+	swr_free(&swr);
+	avcodec_free_context(&audioCodec);
+	avcodec_free_context(&videoCodec);
+	if(format)
+	{
+		if(format->pb) avio_closep(&format->pb);
+		avformat_free_context(format);
+		format = NULL;
+	}
+	videoStream = NULL;
+	audioStream = NULL;
+
+	for(int c=0; c<2; ++c)
+		pending[c].clear();
+	audioFrameSize = 0;
+	filled = 0;
+}
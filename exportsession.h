@@ -0,0 +1,164 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+// ExportSession -- write rendered frames and their soundtrack to a video
+// file: the muxer, a video and an audio encoder, and the conversion
+// contexts and buffers between them.
+//
+// A session owns everything it allocates and frees all of it on Close(),
+// Abort() or destruction, and reports every error by throwing, so one
+// process can export any number of files, one session after another.
+//
+// Video: AcquireFrame() a buffer, fill it with an RGBA frame of the
+// exported size and SubmitFrame() it. The frames are converted and
+// encoded on a VideoEncodePipeline's threads.
+//
+// Audio: the session is an AudioSink. Write() takes the [0,1] samples the
+// frame window and SoundExtractor produce, and converts them to the audio
+// encoder's format with swresample.
+//
+// Video codecs:
+//
+//   default   the container's default (MPEG-4 for .mp4, etc.)
+//   h264      H.264, 4:2:0, quality set by crf
+//   prores    ProRes 422 (profiles 0-3) or 4444 (4-5), 10 bit
+//   ffv1      FFV1 version 3, lossless RGB
+//
+// ProRes and FFV1 carry 24 bit PCM audio where the container allows it.
+
+#ifndef EXPORTSESSION_H
+#define EXPORTSESSION_H
+
+#include <cstdint>
+#include <vector>
+
+#include <QString>
+
+#include "audiosink.h"
+#include "videoencoder.h"
+
+extern "C"
+{
+#include <libswresample/swresample.h>
+}
+
+enum ExportCodec {
+	EXPORT_CODEC_DEFAULT,
+	EXPORT_CODEC_H264,
+	EXPORT_CODEC_PRORES,
+	EXPORT_CODEC_FFV1
+};
+
+// "default", "h264", "prores" or "ffv1"
+const char *ExportCodecName(ExportCodec codec);
+bool ExportCodecFromName(const QString &name, ExportCodec *codec);
+
+//-----------------------------------------------------------------------------
+class ExportSettings {
+public:
+	ExportCodec videoCodec;
+	bool video;        // false for a soundtrack-only file
+	int width;         // even, for the 4:2:0 and 4:2:2 codecs
+	int height;
+	int frameRate;     // frames per second
+	int threads;       // encoder threads, 0 for one per core
+	int crf;           // H.264: 0 (lossless) to 51
+	int proresProfile; // 0 proxy, 1 LT, 2 standard, 3 HQ, 4 4444, 5 4444 XQ
+	bool audio;
+	int samplingRate;
+
+	ExportSettings() : videoCodec(EXPORT_CODEC_DEFAULT), video(true),
+		width(640), height(480), frameRate(24), threads(0), crf(18),
+		proresProfile(3), audio(true), samplingRate(48000) {} ;
+};
+
+//-----------------------------------------------------------------------------
+class ExportSession : public AudioSink {
+private:
+	QString fn;
+	ExportSettings settings;
+
+	AVFormatContext *format;
+	AVCodecContext *videoCodec;
+	AVStream *videoStream;
+	AVCodecContext *audioCodec;
+	AVStream *audioStream;
+	struct SwrContext *swr;
+	AVFrame *audioFrame; // in the audio encoder's format
+	AVPacket *audioPacket;
+	VideoEncodePipeline pipeline;
+
+	std::vector<float> pending[2]; // samples waiting for a full audio frame
+	int audioFrameSize;
+	int filled;
+	int64_t audioPts;
+	int64_t videoPts;
+
+	void OpenVideo();
+	void OpenAudio();
+	void ConvertAudio();
+	void EncodeAudio(AVFrame *frame);
+	void Free();
+
+public:
+	ExportSession() : format(NULL), videoCodec(NULL), videoStream(NULL),
+		audioCodec(NULL), audioStream(NULL), swr(NULL), audioFrame(NULL),
+		audioPacket(NULL), audioFrameSize(0), filled(0), audioPts(0),
+		videoPts(0) {} ;
+	~ExportSession() { Abort(); }
+
+	// Create fn, in the format its extension names, and write its header.
+	// Throws if the format, a codec or the file can't be opened.
+	void Open(const QString &fn, const ExportSettings &settings);
+
+	bool IsOpen() const { return format != NULL; }
+	bool HasVideo() const { return videoCodec != NULL; }
+	bool HasAudio() const { return audioCodec != NULL; }
+
+	// Video frames, width*height*4 bytes of RGBA (or more: FrameBytes()).
+	// Frames are numbered in the order they are submitted. Only valid
+	// with HasVideo().
+	size_t FrameBytes() const { return pipeline.BufferSize(); }
+	uint8_t *AcquireFrame() { return pipeline.Acquire(); }
+	void SubmitFrame(uint8_t *buf) { pipeline.Submit(buf, videoPts++); }
+	void ReleaseFrame(uint8_t *buf) { pipeline.Release(buf); }
+
+	// Samples for the audio stream; dropped if the file has none.
+	void Write(const float *left, const float *right, size_t n) override;
+
+	// Encode everything written, finish the file and free the session,
+	// which may then be opened again.
+	void Close() override;
+
+	// Free the session, leaving whatever was written so far.
+	void Abort();
+};
+
+#endif // EXPORTSESSION_H
@@ -34,7 +34,6 @@
 #include <QDateTime>
 #include <QFileDialog>
 #include <QDebug>
-#include <QMessageBox>
 
 ExtractDialog::ExtractDialog(QWidget *parent, MetaData &metadata,
 			const QString &dir) :
@@ -45,8 +44,6 @@ ExtractDialog::ExtractDialog(QWidget *parent, MetaData &metadata,
 
 	meta = &metadata;
 	defaultDir = dir;
-	requestRestart = false;
-	videoIsRisky = false;
 
 	SetOriginator(meta->originator);
 	SetArchiveLocation(meta->archivalLocation);
@@ -58,6 +55,10 @@ ExtractDialog::ExtractDialog(QWidget *parent, MetaData &metadata,
 	ui->datetimeDisplay->setText(
 			QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss"));
 
+	for(ExportCodec codec : { EXPORT_CODEC_DEFAULT, EXPORT_CODEC_H264,
+			EXPORT_CODEC_PRORES, EXPORT_CODEC_FFV1 })
+		ui->videoCodecComboBox->addItem(ExportCodecName(codec));
+
 }
 
 ExtractDialog::~ExtractDialog()
@@ -65,13 +66,6 @@ ExtractDialog::~ExtractDialog()
 	delete ui;
 }
 
-void ExtractDialog::MarkVideoAsRisky(void)
-{
-	ui->muxVideoCheckbox->setChecked(false);
-	on_muxVideoCheckbox_clicked(false);
-	videoIsRisky = true;
-}
-
 QString ExtractDialog::GetFilename(void)
 {
 	return ui->filenameText->text();
@@ -85,6 +79,16 @@ QString ExtractDialog::GetVideoFilename(void)
 		return QString();
 }
 
+ExportCodec ExtractDialog::GetVideoCodec(void)
+{
+	ExportCodec codec;
+
+	if(!ExportCodecFromName(ui->videoCodecComboBox->currentText(), &codec))
+		codec = EXPORT_CODEC_DEFAULT;
+
+	return codec;
+}
+
 QString ExtractDialog::GetOriginator(void)
 {
 	return ui->originatorDisplay->text();
@@ -196,6 +200,17 @@ void ExtractDialog::on_okButton_clicked()
 	accept();
 }
 
+// the container each codec is written to
+static QString VideoSuffix(ExportCodec codec)
+{
+	switch(codec)
+	{
+	case EXPORT_CODEC_PRORES: return "mov";
+	case EXPORT_CODEC_FFV1: return "mkv";
+	default: return "mp4";
+	}
+}
+
 static QString SaveFile(QWidget *parent, QString label, QString defaultPath,
 		QString current, QString ext)
 {
@@ -230,50 +245,39 @@ void ExtractDialog::on_fileBrowseButton_clicked()
 	{
 		QFileInfo fi(filename);
 		ui->filenameVideoText->setText(
-				fi.dir().path() + "/" + fi.completeBaseName() + ".mp4");
+				fi.dir().path() + "/" + fi.completeBaseName() + "." +
+				VideoSuffix(GetVideoCodec()));
 	}
 }
 
 void ExtractDialog::on_muxVideoCheckbox_clicked(bool checked)
 {
-	if(checked && videoIsRisky)
-	{
-		QMessageBox w(QMessageBox::Warning,
-				tr("Video Instability Warning"),
-				tr("The video creation code is unstable and may crash "
-				   "the program when creating a video a second time.\n\n"
-                   "Restart the program to avoid this."),
-				QMessageBox::Cancel | QMessageBox::Ignore | QMessageBox::Abort,
-				this);
-		int answer;
-
-		w.button(QMessageBox::Abort)->setText("Restart");
-		w.setDefaultButton(QMessageBox::Cancel);
-
-		answer = w.exec();
-
-		if(answer == QMessageBox::Abort)
-		{
-			this->requestRestart = true;
-			this->done(this->Rejected);
-			return;
-		}
-		else if(answer == QMessageBox::Cancel)
-		{
-			ui->muxVideoCheckbox->setChecked(false);
-			return;
-		}
-	}
 	ui->filenameVideoText->setEnabled(checked);
 	ui->fileVideoBrowseButton->setEnabled(checked);
+	ui->videoCodecComboBox->setEnabled(checked);
 }
 
 void ExtractDialog::on_fileVideoBrowseButton_clicked()
 {
 	QString filename = SaveFile(this, tr("Save video as"), defaultDir,
-			ui->filenameVideoText->text(), "*.mp4");
+			ui->filenameVideoText->text(),
+			"*." + VideoSuffix(GetVideoCodec()));
 
 	if(filename.isEmpty()) return;
 
 	ui->filenameVideoText->setText(filename);
 }
+
+void ExtractDialog::on_videoCodecComboBox_currentIndexChanged(int index)
+{
+	QString filename = ui->filenameVideoText->text();
+
+	if(index < 0 || filename.isEmpty()) return;
+
+	// keep the name, in the codec's container
+	QString suffix = QFileInfo(filename).suffix();
+	if(!suffix.isEmpty()) filename.chop(suffix.size() + 1);
+
+	ui->filenameVideoText->setText(filename + "." +
+			VideoSuffix(GetVideoCodec()));
+}
@@ -32,6 +32,7 @@
 #define EXTRACTDIALOG_H
 
 #include <QDialog>
+#include "exportsession.h"
 #include "metadata.h"
 
 namespace Ui {
@@ -52,15 +53,11 @@ private:
 	uint16_t version;
 	MetaData *meta;
 	QString defaultDir;
-	bool requestRestart;
-	bool videoIsRisky;
 
 public:
-	void MarkVideoAsRisky(void);
-	bool RequestedRestart(void) {return requestRestart; };
-
 	QString GetFilename(void);
 	QString GetVideoFilename(void);
+	ExportCodec GetVideoCodec(void);
 	QString GetOriginator(void);
 	QString GetOriginatorReference(void);
 	QString GetDescription(void);
@@ -89,6 +86,7 @@ private slots:
 	void on_fileBrowseButton_clicked();
 	void on_muxVideoCheckbox_clicked(bool checked);
 	void on_fileVideoBrowseButton_clicked();
+	void on_videoCodecComboBox_currentIndexChanged(int index);
 };
 
 #endif // EXTRACTDIALOG_H
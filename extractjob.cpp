@@ -0,0 +1,354 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+
+#include "extractjob.h"
+#include "project.h"
+#include "vfbexception.h"
+
+//-----------------------------------------------------------------------------
+// Read settings written by MainWindow::saveproject() into a map of
+// "Key = Value" lines.
+ExtractSettings ReadSettings(QTextStream &in)
+{
+	ExtractSettings settings;
+
+	while(!in.atEnd())
+	{
+		QString line = in.readLine();
+		int eq = line.indexOf('=');
+		if(eq < 0) continue;
+		settings[line.left(eq).trimmed()] = line.mid(eq+1).trimmed();
+	}
+
+	return settings;
+}
+
+ExtractSettings ReadSettingsFile(const QString &fn)
+{
+	QFile file(fn);
+
+	if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+		throw vfbexception(QString("Cannot open settings file %1").arg(fn));
+
+	QTextStream in(&file);
+	return ReadSettings(in);
+}
+
+//-----------------------------------------------------------------------------
+// The extraction parameters GPU_Params_Update() would hand the frame
+// window for these settings.
+SoundExtractorParams ExtractorParamsFromSettings(const ExtractSettings &s,
+		const FilmScan &scan)
+{
+	SoundExtractorParams p;
+	float w = float(scan.Width());
+
+	auto number = [&s](const char *key, double def) {
+		return s.contains(key) ? s[key].toDouble() : def;
+	};
+
+	if(!s.contains("Left Boundary") || !s.contains("Right Boundary"))
+		throw vfbexception("Settings do not give the soundtrack boundaries");
+
+	p.bounds[0] = number("Left Boundary", 0) / w;
+	p.bounds[1] = number("Right Boundary", 0) / w;
+	p.pixBounds[0] = number("Left Pix Boundary", 0) / w;
+	p.pixBounds[1] = number("Right Pix Boundary", 0) / w;
+
+	p.overlap[1] = number("Overlap Search Size", 5) / 100.0f;
+	p.overlap[2] = number("Frame Pitch End", 0) / 1000.0f;
+	p.overlap[3] = number("Frame Pitch Start", 0) / 1000.0f;
+
+	// if neither is checked, the soundtrack is still used
+	if(number("Use Pix Track", 0) != 0)
+		p.overlapTarget = (number("Use Soundtrack", 1) != 0) ? 2 : 1;
+	else
+		p.overlapTarget = 0;
+
+	QString type = s.value("Soundtrack Type", "Mono");
+	if(type == "Stereo") p.stereo = 1;
+	else if(type == "Push-Pull") p.stereo = 2;
+	else p.stereo = 0;
+
+	p.blur = number("Blur", 0) / 100.0f;
+	p.useSCurve = (number("S-Curve On", 0) != 0);
+	p.sCurve = number("S-Curve Value", 300) / 100.0f;
+	p.negative = (number("Negative", 0) != 0);
+	p.lift = number("Lift", 0) / 100.0f;
+	p.gamma = number("Gamma", 100) / 100.0f;
+	p.gain = number("Gain", 100) / 100.0f;
+
+	if(number("Calibrate", 0) != 0)
+	{
+		if(!s.contains("Calibration Mask"))
+			throw vfbexception("Calibration is on but the settings have no "
+					"calibration mask");
+
+		QByteArray bytes = qUncompress(
+				QByteArray::fromBase64(s["Calibration Mask"].toUtf8()));
+		const float *mask = reinterpret_cast<const float *>(bytes.constData());
+		p.calMask.assign(mask, mask + bytes.size()/sizeof(float));
+	}
+
+	return p;
+}
+
+//-----------------------------------------------------------------------------
+// The BWF time reference of a frame: the source timecode (if any) plus the
+// frame offset, in samples. See MainWindow::ComputeTimeReference().
+uint64_t TimeReference(const FilmScan &scan, long frameIndex,
+		int samplingRate, double fps)
+{
+	QStringList tc = scan.TimeCode.split(':', Qt::SkipEmptyParts);
+	double seconds = frameIndex / fps;
+
+	if(tc.size() == 4)
+		seconds += tc[0].toInt()*3600.0 + tc[1].toInt()*60.0 + tc[2].toInt() +
+			tc[3].toInt()/fps;
+
+	return uint64_t(seconds * samplingRate);
+}
+
+//-----------------------------------------------------------------------------
+ExtractJob::ExtractJob()
+	: format(SOURCE_UNKNOWN), frameIn(-1), frameOut(-1), samplingRate(48000),
+	bitDepth(24), bwf(false), hasFramePitch(false), framePitchStart(0),
+	framePitchEnd(0), state(EXTRACT_JOB_QUEUED), framesDone(0),
+	framesTotal(0), framesPerSecond(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+namespace {
+
+class JobProgress {
+public:
+	ExtractJob *job;
+	SoundExtractor *extractor;
+	const std::atomic<bool> *cancel;
+	ExtractJobProgressFunction cb;
+	void *userData;
+	std::chrono::steady_clock::time_point start;
+};
+
+void ExtractProgress(long done, long total, void *userData)
+{
+	(void)total;
+	JobProgress *p = static_cast<JobProgress *>(userData);
+
+	if(p->cancel && *(p->cancel))
+		p->extractor->Cancel();
+
+	p->job->framesDone = done;
+
+	std::chrono::duration<double> elapsed =
+		std::chrono::steady_clock::now() - p->start;
+	if(elapsed.count() > 0)
+		p->job->framesPerSecond = p->job->framesDone / elapsed.count();
+
+	if(p->cb) p->cb(*(p->job), p->userData);
+}
+
+} // namespace
+
+//-----------------------------------------------------------------------------
+bool ExtractJob::Run(const FilmScan *scan, int numThreads, size_t memoryLimit,
+		const std::atomic<bool> *cancel, ExtractJobProgressFunction cb,
+		void *userData)
+{
+	Project project;
+
+	if(scan == NULL)
+	{
+		if(!project.SourceScan(source.toStdString(), format))
+			throw vfbexception(QString("Cannot read source %1").arg(source));
+		scan = &project.inFile;
+	}
+
+	long first = scan->FirstFrame() + std::max(0L, frameIn);
+	long last = (frameOut < 0) ? scan->LastFrame() :
+		scan->FirstFrame() + frameOut;
+	if(first > last || last > scan->LastFrame())
+		throw vfbexception(QString("Frame range %1-%2 is outside the scan")
+				.arg(frameIn).arg(frameOut));
+
+	double fps = settings.value("Frame Rate", "24").toDouble();
+	if(fps <= 0) fps = 24;
+
+	SoundExtractorParams params = ExtractorParamsFromSettings(settings, *scan);
+	params.samplesPerFrame = int(std::lround(samplingRate / fps));
+
+	if(hasFramePitch)
+	{
+		params.overlap[3] = framePitchStart;
+		params.overlap[2] = framePitchEnd;
+	}
+
+	MetaData meta;
+	if(bwf)
+	{
+		meta.description = QFileInfo(source).fileName();
+		meta.timeReference = TimeReference(*scan,
+				first - scan->FirstFrame(), samplingRate, fps);
+		meta.codingHistory = QString("A=PCM,F=%1,W=%2,M=stereo,T=%3 %4\r\n")
+			.arg(samplingRate).arg(bitDepth)
+			.arg(APP_NAME, APP_VERSION_STR);
+	}
+
+	// the ring holds two channels of float samples per frame
+	size_t frameBytes = size_t(params.samplesPerFrame) * 2 * sizeof(float);
+	long ringFrames = std::max(1L, long(memoryLimit / frameBytes));
+
+	framesTotal = last - first + 1;
+	framesDone = 0;
+	framesPerSecond = 0;
+
+	SoundExtractor extractor;
+	JobProgress progress = { this, &extractor, cancel, cb, userData,
+		std::chrono::steady_clock::now() };
+
+	extractor.SetSource(scan);
+	extractor.SetParameters(params);
+	extractor.SetThreadCount(numThreads);
+	extractor.SetOverlapTrack(&overlapTrack);
+	extractor.ProgressCallback(ExtractProgress, &progress);
+
+	if(cancel && *cancel) return false;
+
+	AudioSink *sink = OpenAudioSink(wavFn, samplingRate, bitDepth,
+			bwf ? &meta : NULL);
+	bool done;
+
+	try
+	{
+		done = extractor.Extract(first, last, *sink, ringFrames);
+		if(done) sink->Close();
+	}
+	catch(...)
+	{
+		delete sink;
+		throw;
+	}
+
+	delete sink;
+	return done;
+}
+
+//-----------------------------------------------------------------------------
+void ExtractJob::Save(QSettings &s) const
+{
+	s.setValue("source", source);
+	s.setValue("format", format);
+	s.setValue("wav", wavFn);
+	s.setValue("in", qlonglong(frameIn));
+	s.setValue("out", qlonglong(frameOut));
+	s.setValue("rate", samplingRate);
+	s.setValue("bits", bitDepth);
+	s.setValue("bwf", bwf);
+	s.setValue("hasFramePitch", hasFramePitch);
+	s.setValue("framePitchStart", framePitchStart);
+	s.setValue("framePitchEnd", framePitchEnd);
+	if(overlapTrack.IsEmpty())
+		s.remove("overlapTrack");
+	else
+	{
+		s.setValue("overlapTrack/key", overlapTrack.Key().ToString());
+		s.setValue("overlapTrack/first", qlonglong(overlapTrack.First()));
+		s.setValue("overlapTrack/records", overlapTrack.RecordsToString());
+	}
+	s.setValue("state", StateName(state));
+	s.setValue("error", error);
+	s.setValue("framesDone", qlonglong(framesDone));
+	s.setValue("framesTotal", qlonglong(framesTotal));
+	s.setValue("framesPerSecond", framesPerSecond);
+
+	s.beginGroup("settings");
+	s.remove("");
+	for(auto i = settings.cbegin(); i != settings.cend(); ++i)
+		s.setValue(i.key(), i.value());
+	s.endGroup();
+}
+
+//-----------------------------------------------------------------------------
+void ExtractJob::Load(QSettings &s)
+{
+	source = s.value("source").toString();
+	format = s.value("format", SOURCE_UNKNOWN).toInt();
+	wavFn = s.value("wav").toString();
+	frameIn = long(s.value("in", -1).toLongLong());
+	frameOut = long(s.value("out", -1).toLongLong());
+	samplingRate = s.value("rate", 48000).toInt();
+	bitDepth = s.value("bits", 24).toInt();
+	bwf = s.value("bwf", false).toBool();
+	hasFramePitch = s.value("hasFramePitch", false).toBool();
+	framePitchStart = s.value("framePitchStart", 0).toFloat();
+	framePitchEnd = s.value("framePitchEnd", 0).toFloat();
+	if(!s.contains("overlapTrack/key") || !overlapTrack.Set(
+			s.value("overlapTrack/key").toString(),
+			long(s.value("overlapTrack/first").toLongLong()),
+			s.value("overlapTrack/records").toString()))
+		overlapTrack.Clear();
+	error = s.value("error").toString();
+	framesDone = long(s.value("framesDone", 0).toLongLong());
+	framesTotal = long(s.value("framesTotal", 0).toLongLong());
+	framesPerSecond = s.value("framesPerSecond", 0).toDouble();
+
+	QString st = s.value("state").toString();
+	state = EXTRACT_JOB_QUEUED;
+	for(ExtractJobState t : { EXTRACT_JOB_RUNNING, EXTRACT_JOB_DONE,
+			EXTRACT_JOB_FAILED })
+		if(st == StateName(t)) state = t;
+
+	settings.clear();
+	s.beginGroup("settings");
+	for(const QString &key : s.childKeys())
+		settings[key] = s.value(key).toString();
+	s.endGroup();
+}
+
+//-----------------------------------------------------------------------------
+const char *ExtractJob::StateName(ExtractJobState s)
+{
+	switch(s)
+	{
+	case EXTRACT_JOB_RUNNING: return "running";
+	case EXTRACT_JOB_DONE: return "done";
+	case EXTRACT_JOB_FAILED: return "failed";
+	default: return "queued";
+	}
+}
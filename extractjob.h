@@ -0,0 +1,128 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+// ExtractJob -- one headless soundtrack extraction: a source scan, the
+// main window settings to extract it with, a frame range and a WAV (BWF)
+// or FLAC file.
+//
+// Run() extracts the range with a SoundExtractor streaming to an
+// AudioSink, through a ring of frames sized by the job's memory limit, so
+// the sample memory a job needs is bounded by that rather than the length
+// of the reel.
+//
+// Jobs can be saved to and loaded from a QSettings group, which is how
+// ExtractScheduler persists its queue.
+
+#ifndef EXTRACTJOB_H
+#define EXTRACTJOB_H
+
+#include <atomic>
+
+#include <QMap>
+#include <QSettings>
+#include <QString>
+#include <QTextStream>
+
+#include "FilmScan.h"
+#include "audiosink.h"
+#include "metadata.h"
+#include "overlaptrack.h"
+#include "soundextractor.h"
+
+#define EXTRACTJOB_DEFAULT_MEMORY (64ul*1024*1024)
+
+enum ExtractJobState {
+	EXTRACT_JOB_QUEUED,
+	EXTRACT_JOB_RUNNING,
+	EXTRACT_JOB_DONE,
+	EXTRACT_JOB_FAILED
+};
+
+class ExtractJob;
+
+// called from the extractor's worker threads, one call at a time, as
+// frames are done
+typedef void (*ExtractJobProgressFunction)(const ExtractJob &job,
+		void *userData);
+
+// Settings saved by MainWindow::saveproject(), as "Key = Value" pairs
+typedef QMap<QString, QString> ExtractSettings;
+
+ExtractSettings ReadSettings(QTextStream &in);
+ExtractSettings ReadSettingsFile(const QString &fn);
+SoundExtractorParams ExtractorParamsFromSettings(const ExtractSettings &s,
+		const FilmScan &scan);
+uint64_t TimeReference(const FilmScan &scan, long frameIndex,
+		int samplingRate, double fps);
+
+//-----------------------------------------------------------------------------
+class ExtractJob {
+public:
+	QString source;
+	SourceFormat format;
+	ExtractSettings settings;
+	QString wavFn;
+	long frameIn;  // frame indices from the first frame of the scan;
+	long frameOut; // -1 for the start/end of the scan
+	int samplingRate;
+	int bitDepth;
+	bool bwf;
+
+	// a project's frame pitch overrides the settings', as in OpenProject()
+	bool hasFramePitch;
+	float framePitchStart;
+	float framePitchEnd;
+
+	// a project's overlap track, looked up instead of searching each
+	// frame when it was measured with these settings
+	OverlapTrack overlapTrack;
+
+	// status, updated by Run()
+	ExtractJobState state;
+	QString error;
+	long framesDone;
+	long framesTotal;
+	double framesPerSecond;
+
+	ExtractJob();
+
+	// Extract the soundtrack to wavFn. If scan is NULL the source is
+	// opened here. Throws on error; returns false if cancel was set.
+	bool Run(const FilmScan *scan, int numThreads, size_t memoryLimit,
+			const std::atomic<bool> *cancel=NULL,
+			ExtractJobProgressFunction cb=NULL, void *userData=NULL);
+
+	void Save(QSettings &s) const;
+	void Load(QSettings &s);
+
+	static const char *StateName(ExtractJobState s);
+};
+
+#endif // EXTRACTJOB_H
@@ -0,0 +1,264 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <exception>
+
+#include "extractscheduler.h"
+#include "vfbexception.h"
+
+ExtractScheduler::ExtractScheduler()
+	: numWorkers(EXTRACTSCHED_DEFAULT_WORKERS), threadsPerJob(0),
+	jobMemory(EXTRACTJOB_DEFAULT_MEMORY), progressCB(NULL),
+	progressUserData(NULL), cancelled(false)
+{
+}
+
+//-----------------------------------------------------------------------------
+void ExtractScheduler::LoadQueue(const QString &fn)
+{
+	QSettings s(fn, QSettings::IniFormat);
+	if(s.status() != QSettings::NoError)
+		throw vfbexception(QString("Cannot read queue %1").arg(fn));
+
+	std::lock_guard<std::mutex> guard(lock);
+
+	jobs.clear();
+	int n = s.beginReadArray("jobs");
+	for(int i=0; i<n; ++i)
+	{
+		s.setArrayIndex(i);
+		ExtractJob job;
+		job.Load(s);
+
+		// interrupted: start it over
+		if(job.state == EXTRACT_JOB_RUNNING)
+			job.state = EXTRACT_JOB_QUEUED;
+
+		jobs.push_back(job);
+	}
+	s.endArray();
+
+	queueFn = fn;
+}
+
+//-----------------------------------------------------------------------------
+void ExtractScheduler::SaveQueue()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	if(!SaveQueueLocked())
+		throw vfbexception(QString("Cannot write queue %1").arg(queueFn));
+}
+
+//-----------------------------------------------------------------------------
+// Failing to save the queue doesn't stop the jobs; SaveQueue() reports it.
+bool ExtractScheduler::SaveQueueLocked()
+{
+	if(queueFn.isEmpty()) return true;
+
+	QSettings s(queueFn, QSettings::IniFormat);
+	s.remove("jobs");
+	s.beginWriteArray("jobs", int(jobs.size()));
+	for(size_t i=0; i<jobs.size(); ++i)
+	{
+		s.setArrayIndex(int(i));
+		jobs[i].Save(s);
+	}
+	s.endArray();
+	s.sync();
+
+	return s.status() == QSettings::NoError;
+}
+
+//-----------------------------------------------------------------------------
+int ExtractScheduler::AddJob(const ExtractJob &job)
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	jobs.push_back(job);
+	jobs.back().state = EXTRACT_JOB_QUEUED;
+	if(!SaveQueueLocked())
+		throw vfbexception(QString("Cannot write queue %1").arg(queueFn));
+
+	return int(jobs.size()) - 1;
+}
+
+//-----------------------------------------------------------------------------
+void ExtractScheduler::Clear()
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	jobs.clear();
+	SaveQueueLocked();
+}
+
+//-----------------------------------------------------------------------------
+std::vector<ExtractJob> ExtractScheduler::Jobs()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return jobs;
+}
+
+//-----------------------------------------------------------------------------
+void ExtractScheduler::ProgressCallback(ExtractSchedulerProgressFunction cb,
+		void *userData)
+{
+	progressCB = cb;
+	progressUserData = userData;
+}
+
+//-----------------------------------------------------------------------------
+void ExtractScheduler::Report(int jobIndex, const ExtractJob &job)
+{
+	if(!progressCB) return;
+
+	std::lock_guard<std::mutex> guard(progressLock);
+	progressCB(jobIndex, job, progressUserData);
+}
+
+//-----------------------------------------------------------------------------
+bool ExtractScheduler::Run()
+{
+	cancelled = false;
+
+	int workers = numWorkers;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		int queued = int(std::count_if(jobs.begin(), jobs.end(),
+				[](const ExtractJob &j) {
+					return j.state == EXTRACT_JOB_QUEUED; }));
+		workers = std::min(workers, queued);
+	}
+
+	std::vector<std::thread> threads;
+	for(int i=0; i<workers; ++i)
+		threads.push_back(std::thread(&ExtractScheduler::Worker, this));
+	for(std::thread &t : threads)
+		t.join();
+
+	std::lock_guard<std::mutex> guard(lock);
+	return std::none_of(jobs.begin(), jobs.end(),
+			[](const ExtractJob &j) { return j.state == EXTRACT_JOB_FAILED; });
+}
+
+//-----------------------------------------------------------------------------
+// Mark the first queued job as running and return its index, or -1
+int ExtractScheduler::TakeNextJob()
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	if(cancelled) return -1;
+
+	for(size_t i=0; i<jobs.size(); ++i)
+	{
+		if(jobs[i].state == EXTRACT_JOB_QUEUED)
+		{
+			jobs[i].state = EXTRACT_JOB_RUNNING;
+			jobs[i].error.clear();
+			SaveQueueLocked();
+			return int(i);
+		}
+	}
+
+	return -1;
+}
+
+//-----------------------------------------------------------------------------
+namespace {
+
+class WorkerContext {
+public:
+	ExtractScheduler *scheduler;
+	int jobIndex;
+};
+
+}
+
+void ExtractScheduler::JobProgress(const ExtractJob &job, void *userData)
+{
+	WorkerContext *ctx = static_cast<WorkerContext *>(userData);
+	ExtractScheduler *self = ctx->scheduler;
+
+	{
+		std::lock_guard<std::mutex> guard(self->lock);
+		if(size_t(ctx->jobIndex) < self->jobs.size())
+		{
+			ExtractJob &queued = self->jobs[ctx->jobIndex];
+			queued.framesDone = job.framesDone;
+			queued.framesTotal = job.framesTotal;
+			queued.framesPerSecond = job.framesPerSecond;
+		}
+	}
+
+	self->Report(ctx->jobIndex, job);
+}
+
+//-----------------------------------------------------------------------------
+void ExtractScheduler::Worker()
+{
+	int threads = threadsPerJob;
+	if(threads == 0)
+		threads = std::max(1,
+				int(std::thread::hardware_concurrency()) / numWorkers);
+
+	int i;
+	while((i = TakeNextJob()) >= 0)
+	{
+		// run on a copy so the queue can be saved while the job runs
+		ExtractJob job;
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			job = jobs[i];
+		}
+		Report(i, job);
+
+		WorkerContext ctx = { this, i };
+		bool finished(false);
+
+		try
+		{
+			finished = job.Run(NULL, threads, jobMemory, &cancelled,
+					&ExtractScheduler::JobProgress, &ctx);
+			job.state = finished ? EXTRACT_JOB_DONE : EXTRACT_JOB_QUEUED;
+		}
+		catch(std::exception &e)
+		{
+			job.state = EXTRACT_JOB_FAILED;
+			job.error = e.what();
+		}
+
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			if(size_t(i) < jobs.size()) jobs[i] = job;
+			SaveQueueLocked();
+		}
+		Report(i, job);
+	}
+}
@@ -0,0 +1,103 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+// ExtractScheduler -- runs a queue of ExtractJobs concurrently.
+//
+// A fixed number of worker threads take queued jobs in order; each job runs
+// its own SoundExtractor on the CPU with a share of the cores and a bounded
+// sample buffer (see ExtractJob). If a queue file is set, the queue is
+// saved there whenever a job changes state, and jobs that were running when
+// a batch was interrupted go back to the queue when the file is loaded, so
+// a batch can be resumed by loading the file and running it again.
+
+#ifndef EXTRACTSCHEDULER_H
+#define EXTRACTSCHEDULER_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+#include "extractjob.h"
+
+#define EXTRACTSCHED_DEFAULT_WORKERS 2
+
+// called from the worker threads, one call at a time, after each frame
+// of a job and whenever a job changes state
+typedef void (*ExtractSchedulerProgressFunction)(int jobIndex,
+		const ExtractJob &job, void *userData);
+
+class ExtractScheduler {
+private:
+	std::vector<ExtractJob> jobs;
+	QString queueFn;
+	int numWorkers;
+	int threadsPerJob;
+	size_t jobMemory;
+
+	ExtractSchedulerProgressFunction progressCB;
+	void *progressUserData;
+
+	// guards jobs and the queue file
+	std::mutex lock;
+	std::mutex progressLock;
+	std::atomic<bool> cancelled;
+
+	void Worker();
+	int TakeNextJob();
+	bool SaveQueueLocked();
+	void Report(int jobIndex, const ExtractJob &job);
+	static void JobProgress(const ExtractJob &job, void *userData);
+
+public:
+	ExtractScheduler();
+
+	// Load a queue saved by a previous run and save to it from now on
+	void LoadQueue(const QString &fn);
+	void SetQueueFile(const QString &fn) { queueFn = fn; }
+	void SaveQueue();
+
+	int AddJob(const ExtractJob &job);
+	void Clear(); // not while Run() is in progress
+	std::vector<ExtractJob> Jobs();
+
+	void SetWorkerCount(int n) { numWorkers = std::max(1, n); }
+	// extraction threads per job; 0 shares the cores between the workers
+	void SetThreadsPerJob(int n) { threadsPerJob = std::max(0, n); }
+	void SetJobMemoryLimit(size_t bytes) { jobMemory = bytes; }
+	void ProgressCallback(ExtractSchedulerProgressFunction cb, void *userData);
+
+	// Run every queued job. Blocks until the queue is empty or Cancel() is
+	// called; returns true if no job failed.
+	bool Run();
+	void Cancel() { cancelled = true; }
+};
+
+#endif // EXTRACTSCHEDULER_H
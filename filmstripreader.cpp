@@ -0,0 +1,161 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+#include "filmstripreader.h"
+
+#include <algorithm>
+
+#include "vfbexception.h"
+
+//-----------------------------------------------------------------------------
+template <typename T>
+FilmStripReaderT<T>::FilmStripReaderT(const FilmScan &s, long f, long l,
+		int lookAhead, int threads)
+	: scan(&s), first(f), last(l), nextToRead(f), position(f-1),
+	stopping(false)
+{
+	if(first < scan->FirstFrame() || last < first || last > scan->LastFrame())
+	{
+		throw vfbexception(
+				QString("Frames out of range: %1 - %2").arg(first).arg(last));
+	}
+
+	// one slot for the frame the caller holds, the rest read ahead
+	lookAhead = int(std::min<long>(std::max(lookAhead, 1), Size()));
+	slots.resize(size_t(lookAhead) + 1);
+
+	if(!scan->IsThreadSafe())
+		threads = 1;
+	else if(threads <= 0)
+		threads = std::max(1, int(std::thread::hardware_concurrency()));
+	threads = std::min(threads, lookAhead);
+
+	for(int i=0; i<threads; ++i)
+		workers.push_back(std::thread(&FilmStripReaderT<T>::Worker, this));
+}
+
+//-----------------------------------------------------------------------------
+template <typename T>
+FilmStripReaderT<T>::~FilmStripReaderT()
+{
+	Stop();
+}
+
+//-----------------------------------------------------------------------------
+template <typename T>
+void FilmStripReaderT<T>::Stop()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	slotFree.notify_all();
+
+	for(std::thread &worker : workers)
+		worker.join();
+	workers.clear();
+}
+
+//-----------------------------------------------------------------------------
+template <typename T>
+void FilmStripReaderT<T>::Worker()
+{
+	std::unique_lock<std::mutex> guard(lock);
+
+	while(true)
+	{
+		// a frame may be read once the slot it shares with a frame
+		// lookAhead+1 earlier has been given up by the caller
+		slotFree.wait(guard, [this]() {
+				return stopping || (nextToRead <= last &&
+					nextToRead - position < long(slots.size())); });
+		if(stopping) break;
+
+		long frameNum = nextToRead++;
+		Slot &slot = SlotFor(frameNum);
+		slot.frameNum = frameNum;
+		slot.state = SLOT_DECODING;
+		guard.unlock();
+
+		std::string error;
+		try
+		{
+			if(slot.frame.Rows() != scan->Height() ||
+					slot.frame.Cols() != scan->Width())
+				slot.frame = FilmFrameT<T>(scan->Height(), scan->Width());
+
+			std::unique_lock<std::mutex> reading(readLock, std::defer_lock);
+			if(!scan->IsThreadSafe()) reading.lock();
+			scan->GetFrame(frameNum, (T *)(slot.frame));
+		}
+		catch(std::exception &e)
+		{
+			error = e.what();
+			if(error.empty()) error = "Could not read frame";
+		}
+
+		guard.lock();
+		slot.error = error;
+		slot.state = error.empty() ? SLOT_READY : SLOT_FAILED;
+		slotDone.notify_all();
+	}
+}
+
+//-----------------------------------------------------------------------------
+template <typename T>
+const FilmFrameT<T> *FilmStripReaderT<T>::Next()
+{
+	std::unique_lock<std::mutex> guard(lock);
+
+	if(position >= last) return NULL;
+
+	// the caller is done with the frame it held: its slot is free
+	if(position >= first)
+		SlotFor(position).state = SLOT_EMPTY;
+	++position;
+	slotFree.notify_all();
+
+	Slot &slot = SlotFor(position);
+	slotDone.wait(guard, [&slot, this]() {
+			return slot.frameNum == position &&
+				(slot.state == SLOT_READY || slot.state == SLOT_FAILED); });
+
+	if(slot.state == SLOT_FAILED)
+	{
+		throw vfbexception(
+				"Frame " + std::to_string(position) + ": " + slot.error);
+	}
+
+	return &(slot.frame);
+}
+
+template class FilmStripReaderT<float>;
+template class FilmStripReaderT<uint16_t>;
+template class FilmStripReaderT<double>;
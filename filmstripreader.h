@@ -0,0 +1,152 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+// FilmStripReader -- a lazy, streaming range of gray frames.
+//
+// A FilmStrip holds every frame of a range at once, which is fine for a
+// handful of frames and hopeless for a reel. A FilmStripReader reads the
+// frames of [first,last] in order, on demand: a few worker threads decode
+// up to lookAhead frames ahead of the caller, and a frame's buffer is
+// reused for a later frame as soon as the caller moves past it, so memory
+// stays at lookAhead+1 frames however long the range is.
+//
+//	FilmStripReader strip(scan, first, last);
+//	for(const FilmFrame &frame : strip)
+//		...
+//
+// Sources that aren't FilmScan::IsThreadSafe() are read by one worker at
+// a time, in frame order. A frame that can't be read makes Next() (or the
+// iterator) throw the reader's vfbexception when it gets there.
+
+#ifndef FILMSTRIPREADER_H
+#define FILMSTRIPREADER_H
+
+#include <condition_variable>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FilmScan.h"
+
+#define FILMSTRIP_DEFAULT_LOOKAHEAD 8
+
+template <typename T>
+class FilmStripReaderT {
+private:
+	enum SlotState {
+		SLOT_EMPTY,
+		SLOT_DECODING,
+		SLOT_READY,
+		SLOT_FAILED
+	};
+
+	class Slot {
+	public:
+		long frameNum;
+		SlotState state;
+		FilmFrameT<T> frame;
+		std::string error;
+		Slot() : frameNum(-1), state(SLOT_EMPTY) {} ;
+	};
+
+	const FilmScan *scan;
+	long first;
+	long last;
+	std::vector<Slot> slots;
+	std::vector<std::thread> workers;
+
+	// guards the slots, nextToRead, position and stopping
+	std::mutex lock;
+	std::condition_variable slotFree;
+	std::condition_variable slotDone;
+
+	// serializes reads from sources that aren't FilmScan::IsThreadSafe()
+	std::mutex readLock;
+
+	long nextToRead; // next frame a worker will pick up
+	long position;   // frame the caller holds, first-1 before Next()
+	bool stopping;
+
+	Slot &SlotFor(long frameNum)
+		{ return slots[size_t(frameNum - first) % slots.size()]; }
+	void Worker();
+	void Stop();
+
+public:
+	// threads 0 picks one per core (one for sources that aren't thread safe)
+	FilmStripReaderT(const FilmScan &scan, long first, long last,
+			int lookAhead=FILMSTRIP_DEFAULT_LOOKAHEAD, int threads=0);
+	~FilmStripReaderT();
+
+	FilmStripReaderT(const FilmStripReaderT &) = delete;
+	FilmStripReaderT &operator=(const FilmStripReaderT &) = delete;
+
+	long First() const { return first; }
+	long Last() const { return last; }
+	long Size() const { return last - first + 1; }
+
+	// The next frame, or NULL after the last. The frame stays valid until
+	// the following call; its number is Position().
+	const FilmFrameT<T> *Next();
+	long Position() const { return position; }
+
+	// single pass input iterator over the frames
+	class Iterator {
+	private:
+		FilmStripReaderT *reader;
+		const FilmFrameT<T> *frame;
+	public:
+		typedef std::input_iterator_tag iterator_category;
+		typedef FilmFrameT<T> value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const FilmFrameT<T> *pointer;
+		typedef const FilmFrameT<T> &reference;
+
+		Iterator(FilmStripReaderT *r=NULL)
+			: reader(r), frame(r ? r->Next() : NULL) {} ;
+		reference operator*() const { return *frame; }
+		pointer operator->() const { return frame; }
+		Iterator &operator++() { frame = reader->Next(); return *this; }
+		bool operator==(const Iterator &o) const { return frame == o.frame; }
+		bool operator!=(const Iterator &o) const { return frame != o.frame; }
+		long FrameNumber() const { return reader->Position(); }
+	};
+
+	// begin() starts reading; a reader can only be walked once
+	Iterator begin() { return Iterator(this); }
+	Iterator end() { return Iterator(); }
+};
+
+typedef FilmStripReaderT<float> FilmStripReader;
+typedef FilmStripReaderT<uint16_t> FilmStripReader16;
+
+#endif // FILMSTRIPREADER_H
@@ -20,6 +20,12 @@ uniform sampler2D VBench_P6;
 uniform sampler2D VBench_P7;
 
 uniform sampler2D overlay_tex;
+uniform sampler2D frame_plane1_tex; // planar frames: second and third planes
+uniform sampler2D frame_plane2_tex;
+uniform float plane_mode; // 0 interleaved RGB, 1 planes (YUV, GBR or gray)
+uniform mat3 plane_matrix;
+uniform vec3 plane_scale;
+uniform vec3 plane_offset;
 uniform float overlapshow;
 uniform float rot_angle;
 uniform float spliceshow;
@@ -42,6 +48,21 @@ uniform vec4 loupeview;
 //out int ucol;
 
 layout(location = 0) out vec4 FragColor;
+
+// the input frame as RGB; planar (video) frames are converted here rather
+// than on the CPU: rgb = plane_matrix * (planes*plane_scale - plane_offset)
+vec4 frameTexel(vec2 coord)
+{
+    if(plane_mode == 0.0)
+        return texture(frame_tex, coord);
+
+    vec3 p = vec3(texture(frame_tex, coord).r,
+                  texture(frame_plane1_tex, coord).r,
+                  texture(frame_plane2_tex, coord).r);
+    return vec4(clamp(plane_matrix * (p*plane_scale - plane_offset), 0.0, 1.0),
+                1.0);
+}
+
 vec3 RGBToHSL(vec3 color)
 {
     vec3 hsl; // init to 0 to avoid warnings ? (and reverse if + remove first part)
@@ -249,7 +270,7 @@ void main(void)
         int k;
         vec2 grabberm;
         vec2 grabber;
-        texel = texture(frame_tex, vTexCoord);
+        texel = frameTexel(vTexCoord);
         if(cal_controls.y==1.0)
         {
             grabberm =  vec2(4.0,4.0);
@@ -271,7 +292,7 @@ void main(void)
 
 
 
-                tmps = texture(frame_tex,grabber);
+                tmps = frameTexel(grabber);
 
                 sharp_texel+=tmps*KERNEL_HSHARPEN [k];
                 blur_texel+=(tmps *KERNEL_HBLUR [k]);
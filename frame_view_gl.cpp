@@ -47,6 +47,7 @@
 #include <math.h>
 #include <stdlib.h>
 #include <QPainter>
+#include <QGenericMatrix>
 #if defined(__clang__)
 # pragma clang diagnostic push
 # pragma clang diagnostic ignored "-Wunsequenced"
@@ -303,6 +304,7 @@ Frame_Window::Frame_Window(int w,int h)
 {
     // working data
     FileRealBuffer = NULL;
+    recordingsize = 0;
 
     // view parameters
     WFMzoom=1.0f;
@@ -387,6 +389,8 @@ Frame_Window::Frame_Window(int w,int h)
     is_rendering =false;
     is_debug = false;
     overrideOverlap = 0;
+    overlapTrack = NULL;
+    trackFrame = -1;
 
     fps = 24.0;
     duration = 0; // milliseconds
@@ -407,7 +411,6 @@ Frame_Window::Frame_Window(int w,int h)
     new_frame = false;
 
     audio_draw_buffers = NULL;
-    audio_pbo = 0;
 
     m_posAttr = 0;
     m_texAttr = 0;
@@ -433,6 +436,15 @@ Frame_Window::Frame_Window(int w,int h)
     m_spliceshow_loc = 0;
 
     frame_texture = 0;
+    frame_plane_texture[0] = frame_plane_texture[1] = 0;
+    frame_plane_texture_loc = 0;
+    m_planemode_loc = 0;
+    m_planematrix_loc = 0;
+    m_planescale_loc = 0;
+    m_planeoffset_loc = 0;
+    plane_mode = 0.0f;
+    for(int i=0; i<9; ++i) plane_matrix[i] = (i%4 == 0) ? 1.0f : 0.0f;
+    for(int i=0; i<3; ++i) { plane_scale[i] = 1.0f; plane_offset[i] = 0.0f; }
     adj_frame_fbo = 0;
     adj_frame_texture = 0;
     prev_adj_frame_tex = 0;
@@ -455,8 +467,12 @@ Frame_Window::Frame_Window(int w,int h)
 Frame_Window::~Frame_Window()
 {
     CHECK_GL_ERROR(__FILE__,__LINE__);
+    CUR_OP("Releasing readback buffers");
+    readback.Release();
+
     CUR_OP("Deleting frame_texture");
     glDeleteTextures(1,&frame_texture);
+    glDeleteTextures(2,frame_plane_texture);
 
     CUR_OP("Deleting adj_frame_fbo");
     //glIsFramebuffer returns true, but glDeleteFrameBuffers crashes.
@@ -595,6 +611,10 @@ void Frame_Window::initialize()
     m_bounds_loc = m_program->uniformLocation("bounds");
 
     m_rot_angle= m_program->uniformLocation("rot_angle");
+    m_planemode_loc = m_program->uniformLocation("plane_mode");
+    m_planematrix_loc = m_program->uniformLocation("plane_matrix");
+    m_planescale_loc = m_program->uniformLocation("plane_scale");
+    m_planeoffset_loc = m_program->uniformLocation("plane_offset");
 
     m_neg_loc = m_program->uniformLocation("negative");
     stereo_loc=  m_program->uniformLocation("isstereo");
@@ -607,6 +627,7 @@ void Frame_Window::initialize()
     CHECK_GL_ERROR(__FILE__,__LINE__);
 
     gen_tex_bufs(); //call for all textures and buffers to be created
+    readback.Initialize(this);
     overlap[0]=0;
     overlap[1]=0;
 
@@ -801,6 +822,22 @@ void Frame_Window::gen_tex_bufs()
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     CHECK_GL_ERROR(__FILE__,__LINE__);
 
+    // chroma (or B and R) planes of planar frames
+    glGenTextures(2,frame_plane_texture);
+    frame_plane_texture_loc=texture_index;
+    for (int i = 0; i<2; i++)
+    {
+        glActiveTexture(GL_TEXTURE0+texture_index);
+        glBindTexture(GL_TEXTURE_2D, frame_plane_texture[i]);
+        texture_index++;
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        CHECK_GL_ERROR(__FILE__,__LINE__);
+    }
+
 
     //*************************************
 
@@ -836,6 +873,10 @@ void Frame_Window::gen_tex_bufs()
     glUniform1i(texLoc, overlay_texture_loc);
     texLoc =m_program->uniformLocation("cal_audio_tex");
     glUniform1i(texLoc, cal_audio_texture_loc); // GL Error: invalid operation
+    texLoc = m_program->uniformLocation("frame_plane1_tex");
+    glUniform1i(texLoc, frame_plane_texture_loc);
+    texLoc = m_program->uniformLocation("frame_plane2_tex");
+    glUniform1i(texLoc, frame_plane_texture_loc+1);
 
 
     CHECK_GL_ERROR(__FILE__,__LINE__);
@@ -1051,7 +1092,7 @@ void Frame_Window::savestripimage(QString filename)
     delete []stripbuf;
 }
 
-void Frame_Window::load_frame_texture(FrameTexture *frame)
+void Frame_Window::load_frame_texture(const FrameTexture *frame)
 {
     GLenum componentformat;
     CHECK_GL_ERROR(__FILE__,__LINE__);
@@ -1060,6 +1101,38 @@ void Frame_Window::load_frame_texture(FrameTexture *frame)
     glBindTexture(GL_TEXTURE_2D,frame_texture);
     CHECK_GL_ERROR(__FILE__,__LINE__);
 
+    if(frame->IsPlanar())
+    {
+        // video planes as decoded: one single channel texture each, put
+        // together as RGB by the shader (frameTexel())
+        GLenum internal = (frame->format == GL_UNSIGNED_SHORT) ? GL_R16 : GL_R8;
+        int bytes = (frame->format == GL_UNSIGNED_SHORT) ? 2 : 1;
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for(int i=0; i<frame->nPlanes; ++i)
+        {
+            const FrameTexture::Plane &p = frame->planes[i];
+            if(i > 0)
+            {
+                glActiveTexture(GL_TEXTURE0+frame_plane_texture_loc+i-1);
+                glBindTexture(GL_TEXTURE_2D,frame_plane_texture[i-1]);
+            }
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, p.stride / bytes);
+            glTexImage2D(GL_TEXTURE_2D, 0, internal, p.width, p.height, 0,
+                         GL_RED, frame->format, p.data);
+            CHECK_GL_ERROR(__FILE__,__LINE__);
+        }
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glActiveTexture(GL_TEXTURE0);
+
+        frame->PlaneConversion(plane_matrix, plane_scale, plane_offset);
+        plane_mode = 1.0f;
+        new_frame=true;
+        return;
+    }
+    plane_mode = 0.0f;
+
     switch(frame->nComponents)
     {
     case 4: componentformat = GL_RGBA; break;
@@ -1068,8 +1141,11 @@ void Frame_Window::load_frame_texture(FrameTexture *frame)
     default: throw vfbexception("Invalid num_components");
     }
 
+    // rows are packed: 16 bit RGB rows of odd width aren't 4 byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16, frame->width, frame->height, 0,
-                 componentformat, frame->format, frame->buf);
+                 componentformat, frame->format, frame->Pixels());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
 
     CHECK_GL_ERROR(__FILE__,__LINE__);
     new_frame=true;
@@ -1105,6 +1181,12 @@ void Frame_Window::update_parameters()
     m_program->setUniformValue(m_spliceshow_loc, float(spliceshow));
 
     m_program->setUniformValue(m_inputsize_loc, float(input_w), float(input_h));
+    m_program->setUniformValue(m_planemode_loc, plane_mode);
+    m_program->setUniformValue(m_planematrix_loc, QMatrix3x3(plane_matrix));
+    m_program->setUniformValue(m_planescale_loc,
+                               plane_scale[0], plane_scale[1], plane_scale[2]);
+    m_program->setUniformValue(m_planeoffset_loc,
+                               plane_offset[0], plane_offset[1], plane_offset[2]);
     m_program->setUniformValue(m_overlap_target_loc, overlap_target);
      m_program->setUniformValue(loupeview_loc,loupeview[0],loupeview[1],loupeview[2],loupeview[3]);
    // qDebug()<<loupeview[0]<<","<<loupeview[1]<<","<<loupeview[2]<<","<<loupeview[3];
@@ -1128,6 +1210,230 @@ void Frame_Window::CopyFrameBuffer(GLuint fbo, int width, int height)
     glDrawBuffer(0);
 }
 
+// The overlap render passes (modes 4 and 5) and the search of their output,
+// setting bestmatch and overlap[0]
+void Frame_Window::ComputeOverlap()
+{
+    GLfloat * fullarray ;
+
+    //**************** RENDER Audio & Pix for Overlap for computations*********
+    // x0 = curr *** x1 =prev
+    // Input Textures: adj_frame_texture (adjusted image texture)
+    //   and prev_adj_frame_texture
+    // Renders to: overlap_compare_audio_texture
+    // Description: computes 1d waveform for current and previous adjusted
+    //   frames. pixel column 0 is current and column 1 is previous
+    m_tertexBuffer.write(0,verticesTex, 3 * 4 * sizeof( GLfloat ) );// verticesTex, 3 * 4 * sizeof( GLfloat ) );
+
+    CUR_OP("Audio overlap render (mode 4)");
+    m_program->setUniformValue(m_rendermode_loc, 4.0f);
+    CUR_OP("Set VertextAttribPointer for Audio overlap render (mode 4)");
+    //	glVertexAttribPointer(m_texAttr, 3, GL_FLOAT, GL_FALSE, 0, verticesTex);
+    CHECK_GL_ERROR(__FILE__,__LINE__);
+    CUR_OP("Binding audio_fbo for Audio overlap render (mode 4)");
+    glBindFramebuffer(GL_FRAMEBUFFER,audio_fbo);
+    glDrawBuffer(GL_COLOR_ATTACHMENT2);
+    glViewport(0,0, 2, samplesperframe);
+    glClear(GL_COLOR_BUFFER_BIT);
+    CUR_OP("Drawing elements for Audio overlap render (mode 4)");
+    glDrawArrays( GL_TRIANGLE_STRIP, 0,4);
+    //	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, indices);
+    CHECK_GL_ERROR(__FILE__,__LINE__);
+    glBindFramebuffer(GL_FRAMEBUFFER,audio_fbo);
+
+    // keep both profiles for the cross-correlation after mode 5
+    CUR_OP("reading pixels for overlap profiles");
+    std::vector<float> profiles(2*samplesperframe);
+    glReadBuffer(GL_COLOR_ATTACHMENT2);
+    glReadPixels(0,0,2,samplesperframe,GL_RED, GL_FLOAT,profiles.data());
+    CHECK_GL_ERROR(__FILE__,__LINE__);
+    for(int c=0; c<2; c++)
+    {
+        overlap_profile[c].resize(samplesperframe);
+        for(int i=0; i<samplesperframe; i++)
+            overlap_profile[c][i] = profiles[2*i+c];
+    }
+
+    //****************************overlap renders *****************************
+    // Input Textures: overlap_compare_audio_texture
+    // Renders to: overlaps_audio_texture
+    // Description: slides curr and previous 1d arrays over each other and
+    // takes the absolute value difference
+    //  location is 2 * tex coord
+
+    CUR_OP("Drawing overlaps (mode 5)");
+    m_program->setUniformValue(m_rendermode_loc, 5.0f);
+    CUR_OP("Set vertexAttribPointer for Drawing overlaps (mode 5)");
+    //	glVertexAttribPointer(m_texAttr, 3, GL_FLOAT, GL_FALSE, 0, verticesTex);
+    CHECK_GL_ERROR(__FILE__,__LINE__);
+    CUR_OP("binding audio_fbo for Drawing overlaps (mode 5)");
+    glBindFramebuffer(GL_FRAMEBUFFER,audio_fbo);
+
+    glDrawBuffer(GL_COLOR_ATTACHMENT3);
+
+    glViewport(0,0, 2, samplesperframe);
+
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    //  glBindTexture(GL_TEXTURE_2D,adj_frame_texture);
+
+    CUR_OP("drawing elements for Drawing overlaps (mode 5)");
+    glDrawArrays( GL_TRIANGLE_STRIP, 0,4);
+    //	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, indices);
+    CHECK_GL_ERROR(__FILE__,__LINE__);
+
+    glBindFramebuffer(GL_FRAMEBUFFER,audio_fbo);
+    glReadBuffer(GL_COLOR_ATTACHMENT3);
+    CUR_OP("reading pixels for audio_compare_buffer");
+    glReadPixels(0,0,1,samplesperframe,GL_RED, GL_FLOAT,audio_compare_buffer);
+    CHECK_GL_ERROR(__FILE__,__LINE__);
+
+    //***********************Find best overlap match***************************
+    float low=20.0;
+    float temp;
+    lowloc=0;
+    // for (int i = 4; i<2*(samplesperframe * overlap[1]); i++)
+
+    int start ;
+    int end ;
+    int pitchline;
+    int lowest;
+    fullarray = (static_cast<GLfloat*>(audio_compare_buffer));
+
+    CUR_OP("setting search parameters for finding best overlap");
+    // end = std::max(end,start);
+    bool outsidefind = false;
+    start = (overlap[2]+overlap[3]) * samplesperframe -
+            (overlap[1]*0.5*samplesperframe) ;
+    end = (overlap[2]+overlap[3]) * samplesperframe +
+            (overlap[1]*0.5*samplesperframe) ;
+    pitchline = (overlap[2]+overlap[3]) * samplesperframe;
+
+    start = std::max(4,start);
+    end = std::min(end,samplesperframe-2);
+    end=std::max(end,start);
+    pitchline = (end+start)/2;
+
+    GLfloat* subarray = &fullarray[samplesperframe-end];
+
+    CUR_OP("getting best match from subarray in finding best overlap");
+    GetBestMatchFromFloatArray(subarray,(end-start),end, bestmatch);
+
+    int s_start,s_end;
+    int s_size = end-start;
+    int s_mid = start + (s_size/2);
+    int s_i_size;
+    int best=0;
+
+    for (int i = 1; i<6; i++)
+    {
+        s_i_size =  ((s_size/2)/5);
+        if(i==1)
+        {
+            s_start = s_mid -(4);
+            s_end   = s_mid +(4);
+
+        }
+        else
+        {
+            s_start = s_mid -(s_i_size*i);
+            s_end   = s_mid +(s_i_size*i);
+        }
+
+        s_start= std::max(4,s_start);
+        s_end = std::min(s_end,samplesperframe-2);
+
+        subarray = &fullarray[samplesperframe-s_end];
+
+        CUR_OP("getting best match 2 from subarray in finding best overlap");
+        GetBestMatchFromFloatArray(subarray,(s_end-s_start),s_end,
+                                   match_array[i-1]) ;
+    }
+    if(is_calc)
+    {
+        bestmatch= match_array[0];
+    }
+
+    else
+        bestmatch= match_array[4];
+
+    CUR_OP("recording best overlap");
+    overlap[0] = (float)(bestmatch.postion)/samplesperframe;
+
+    // Normalized cross-correlation of the same profiles over the same
+    // window. Mode 5 compares column 0 at y with column 1 at y+1-overlap,
+    // so column 0 is the head. It gives a fraction of a row and says how
+    // sure it is; the difference scan stands when it is not.
+    CUR_OP("cross-correlating overlap profiles");
+    int ncc_start = is_calc ? std::max(4,s_mid-4) : start;
+    int ncc_end = is_calc ? std::min(s_mid+4,samplesperframe-2) : end;
+    nccmatch = registration.Register(overlap_profile[0].data(),
+                                     overlap_profile[1].data(), samplesperframe,
+                                     ncc_start, ncc_end);
+    if(nccmatch.IsReliable())
+    {
+        bestmatch.postion = qRound(nccmatch.overlap);
+        bestmatch.value = 1.0 - nccmatch.correlation;
+        overlap[0] = nccmatch.overlap / samplesperframe;
+    }
+
+    bool usegl=true;
+
+    if(overrideOverlap > 0)
+    {
+        lowloc = overrideOverlap;
+        usegl = false;
+    }
+
+    CHECK_GL_ERROR(__FILE__,__LINE__);
+
+    CUR_OP("logging results of overlap computation");
+    if(logger)
+        (*logger) <<
+                     " OpenGL overlap "<< bestmatch.postion <<
+                     " NCC " << nccmatch.overlap << " (" <<
+                     nccmatch.correlation << ", " << nccmatch.confidence << ")" <<
+                     " Using " << (overrideOverlap?"Override ":"OpenGL ") <<
+                     lowloc <<
+                     " FrameStart " << overlap[3] <<
+                     " FrameStop " << 1.0+(overlap[3] - overlap[0]) <<
+                                                                       " start search " << start <<
+                                                                       " end search " << end <<
+                                                                       "   " << outsidefind <<
+                                                                       "\n";
+
+    qDebug() << "jitter: " << "smid: " << s_mid <<
+                " Opengl overlap " << bestmatch.postion << " Using OpenGL: " <<
+                usegl << " Override: " << overrideOverlap << " FrameStart   " <<
+                overlap[3] << " frameStop " << (1.0 - overlap[0] + overlap[3]) <<
+                                                                                  " start search" << start << " end search" << end << "   " <<
+                                                                                  outsidefind;
+
+    qDebug()<<"MA[0] "<< match_array[0].postion<<" , "<<match_array[0].value;
+    qDebug()<<"MA[1] "<< match_array[1].postion<<" , "<<match_array[1].value;
+    qDebug()<<"MA[2] "<< match_array[2].postion<<" , "<<match_array[2].value;
+    qDebug()<<"MA[3] "<< match_array[3].postion<<" , "<<match_array[3].value;
+    qDebug()<<"MA[4] "<< match_array[4].postion<<" , "<<match_array[4].value;
+}
+
+// The settings the overlap search is using, as an overlap track's key
+OverlapTrackKey Frame_Window::TrackKey() const
+{
+    OverlapTrackKey key;
+
+    key.bounds[0] = bounds[0];
+    key.bounds[1] = bounds[1];
+    key.pixBounds[0] = pixbounds[0];
+    key.pixBounds[1] = pixbounds[1];
+    key.search = overlap[1];
+    key.pitchEnd = overlap[2];
+    key.pitchStart = overlap[3];
+    key.overlapTarget = int(overlap_target);
+    key.pushPull = (int(stereo) == 2);
+
+    return key;
+}
+
 void Frame_Window::render()
 {
     #ifdef Q_OS_WINDOWS
@@ -1298,172 +1604,19 @@ void Frame_Window::render()
         glReadBuffer(GL_COLOR_ATTACHMENT0);
         CHECK_GL_ERROR(__FILE__,__LINE__);
     }
-    //**************** RENDER Audio & Pix for Overlap for computations*********
-    // x0 = curr *** x1 =prev
-    // Input Textures: adj_frame_texture (adjusted image texture)
-    //   and prev_adj_frame_texture
-    // Renders to: overlap_compare_audio_texture
-    // Description: computes 1d waveform for current and previous adjusted
-    //   frames. pixel column 0 is current and column 1 is previous
-    m_tertexBuffer.write(0,verticesTex, 3 * 4 * sizeof( GLfloat ) );// verticesTex, 3 * 4 * sizeof( GLfloat ) );
-
-    CUR_OP("Audio overlap render (mode 4)");
-    m_program->setUniformValue(m_rendermode_loc, 4.0f);
-    CUR_OP("Set VertextAttribPointer for Audio overlap render (mode 4)");
-    //	glVertexAttribPointer(m_texAttr, 3, GL_FLOAT, GL_FALSE, 0, verticesTex);
-    CHECK_GL_ERROR(__FILE__,__LINE__);
-    CUR_OP("Binding audio_fbo for Audio overlap render (mode 4)");
-    glBindFramebuffer(GL_FRAMEBUFFER,audio_fbo);
-    glDrawBuffer(GL_COLOR_ATTACHMENT2);
-    glViewport(0,0, 2, samplesperframe);
-    glClear(GL_COLOR_BUFFER_BIT);
-    CUR_OP("Drawing elements for Audio overlap render (mode 4)");
-    glDrawArrays( GL_TRIANGLE_STRIP, 0,4);
-    //	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, indices);
-    CHECK_GL_ERROR(__FILE__,__LINE__);
-    glBindFramebuffer(GL_FRAMEBUFFER,audio_fbo);
-
-    //****************************overlap renders *****************************
-    // Input Textures: overlap_compare_audio_texture
-    // Renders to: overlaps_audio_texture
-    // Description: slides curr and previous 1d arrays over each other and
-    // takes the absolute value difference
-    //  location is 2 * tex coord
-
-    CUR_OP("Drawing overlaps (mode 5)");
-    m_program->setUniformValue(m_rendermode_loc, 5.0f);
-    CUR_OP("Set vertexAttribPointer for Drawing overlaps (mode 5)");
-    //	glVertexAttribPointer(m_texAttr, 3, GL_FLOAT, GL_FALSE, 0, verticesTex);
-    CHECK_GL_ERROR(__FILE__,__LINE__);
-    CUR_OP("binding audio_fbo for Drawing overlaps (mode 5)");
-    glBindFramebuffer(GL_FRAMEBUFFER,audio_fbo);
-
-    glDrawBuffer(GL_COLOR_ATTACHMENT3);
-
-    glViewport(0,0, 2, samplesperframe);
-
-    glClear(GL_COLOR_BUFFER_BIT);
-
-    //  glBindTexture(GL_TEXTURE_2D,adj_frame_texture);
-
-    CUR_OP("drawing elements for Drawing overlaps (mode 5)");
-    glDrawArrays( GL_TRIANGLE_STRIP, 0,4);
-    //	glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_BYTE, indices);
-    CHECK_GL_ERROR(__FILE__,__LINE__);
-
-    glBindFramebuffer(GL_FRAMEBUFFER,audio_fbo);
-    glReadBuffer(GL_COLOR_ATTACHMENT3);
-    CUR_OP("reading pixels for audio_compare_buffer");
-    glReadPixels(0,0,1,samplesperframe,GL_RED, GL_FLOAT,audio_compare_buffer);
-    CHECK_GL_ERROR(__FILE__,__LINE__);
-
-    //***********************Find best overlap match***************************
-    float low=20.0;
-    float temp;
-    lowloc=0;
-    // for (int i = 4; i<2*(samplesperframe * overlap[1]); i++)
-
-    int start ;
-    int end ;
-    int pitchline;
-    int lowest;
-    fullarray = (static_cast<GLfloat*>(audio_compare_buffer));
-
-    CUR_OP("setting search parameters for finding best overlap");
-    // end = std::max(end,start);
-    bool outsidefind = false;
-    start = (overlap[2]+overlap[3]) * samplesperframe -
-            (overlap[1]*0.5*samplesperframe) ;
-    end = (overlap[2]+overlap[3]) * samplesperframe +
-            (overlap[1]*0.5*samplesperframe) ;
-    pitchline = (overlap[2]+overlap[3]) * samplesperframe;
-
-    start = std::max(4,start);
-    end = std::min(end,1998);
-    end=std::max(end,start);
-    pitchline = (end+start)/2;
-
-    GLfloat* subarray = &fullarray[samplesperframe-end];
-
-    CUR_OP("getting best match from subarray in finding best overlap");
-    GetBestMatchFromFloatArray(subarray,(end-start),end, bestmatch);
-
-    int s_start,s_end;
-    int s_size = end-start;
-    int s_mid = start + (s_size/2);
-    int s_i_size;
-    int best=0;
-
-    for (int i = 1; i<6; i++)
-    {
-        s_i_size =  ((s_size/2)/5);
-        if(i==1)
-        {
-            s_start = s_mid -(4);
-            s_end   = s_mid +(4);
-
-        }
-        else
-        {
-            s_start = s_mid -(s_i_size*i);
-            s_end   = s_mid +(s_i_size*i);
-        }
-
-        s_start= std::max(4,s_start);
-        s_end = std::min(s_end,1998);
-
-        subarray = &fullarray[samplesperframe-s_end];
-
-        CUR_OP("getting best match 2 from subarray in finding best overlap");
-        GetBestMatchFromFloatArray(subarray,(s_end-s_start),s_end,
-                                   match_array[i-1]) ;
-    }
-    if(is_calc)
+    //**************************** overlap **********************************
+    // Look the overlap up in the project's overlap track if it has this
+    // frame and was measured with these settings; search for it otherwise.
+    if(overlapTrack && overlapTrack->Has(trackFrame) &&
+            overlapTrack->Key() == TrackKey())
     {
-        bestmatch= match_array[0];
+        const OverlapRecord &r = overlapTrack->At(trackFrame);
+        bestmatch.postion = qRound(r.overlap);
+        bestmatch.value = r.minDiff / 1000.0;
+        overlap[0] = r.overlap / SOUNDEXTRACT_OVERLAP_ROWS;
     }
-
     else
-        bestmatch= match_array[4];
-
-    CUR_OP("recording best overlap");
-    overlap[0] = (float)(bestmatch.postion)/2000.0;
-
-    bool usegl=true;
-
-    if(overrideOverlap > 0)
-    {
-        lowloc = overrideOverlap;
-        usegl = false;
-    }
-
-    CHECK_GL_ERROR(__FILE__,__LINE__);
-
-    CUR_OP("logging results of overlap computation");
-    if(logger)
-        (*logger) <<
-                     " OpenGL overlap "<< bestmatch.postion <<
-                     " Using " << (overrideOverlap?"Override ":"OpenGL ") <<
-                     lowloc <<
-                     " FrameStart " << overlap[3] <<
-                     " FrameStop " << 1.0+(overlap[3] - overlap[0]) <<
-                                                                       " start search " << start <<
-                                                                       " end search " << end <<
-                                                                       "   " << outsidefind <<
-                                                                       "\n";
-
-    qDebug() << "jitter: " << "smid: " << s_mid <<
-                " Opengl overlap " << bestmatch.postion << " Using OpenGL: " <<
-                usegl << " Override: " << overrideOverlap << " FrameStart   " <<
-                overlap[3] << " frameStop " << (1.0 - overlap[0] + overlap[3]) <<
-                                                                                  " start search" << start << " end search" << end << "   " <<
-                                                                                  outsidefind;
-
-    qDebug()<<"MA[0] "<< match_array[0].postion<<" , "<<match_array[0].value;
-    qDebug()<<"MA[1] "<< match_array[1].postion<<" , "<<match_array[1].value;
-    qDebug()<<"MA[2] "<< match_array[2].postion<<" , "<<match_array[2].value;
-    qDebug()<<"MA[3] "<< match_array[3].postion<<" , "<<match_array[3].value;
-    qDebug()<<"MA[4] "<< match_array[4].postion<<" , "<<match_array[4].value;
+        ComputeOverlap();
 
     CUR_OP("calling update_parameters() in overlap computation");
     update_parameters();
@@ -1471,9 +1624,9 @@ void Frame_Window::render()
     //*************************************************************************
     // Overlap Compute with new coordinates
     CUR_OP("overlap computer with new coordinates");
-    float bestvalue = 1.0f+(overlap[3] - ((float)(bestloc)/2000.0));
+    float bestvalue = 1.0f+(overlap[3] - ((float)(bestloc)/samplesperframe));
     float bestvalueoffset =
-            1.0f+(overlap[3] - ((float)(bestmatch.postion)/2000.0));
+            1.0f+(overlap[3] - overlap[0]);
 
     GLfloat verticesTRO_ForFile[] ={
         bounds[0], bestvalueoffset, // bottom left corner
@@ -1758,18 +1911,25 @@ void Frame_Window::render()
 
     // is_rendering = recording to filebuffer
     // new_frame indicates a frame texture was loaded
+    // The channels are read back asynchronously; callers must
+    // WaitForReadback() on the samples (or FinishReadbacks()) before use.
     if (is_rendering && new_frame )
     {
+        // the ring is a whole number of frames, so a frame never wraps
+        int ringpos = int(samplepointer % recordingsize);
+
         CUR_OP("reading left channel for audio render for file (mode 1.5)");
         //copy float buffer out for file left channel
-        glReadPixels(0, 0, 1, samplesperframe_file,GL_RED, GL_FLOAT,
-                     &FileRealBuffer[0][samplepointer]);
+        readback.Read(0, 0, 1, samplesperframe_file, GL_RED, GL_FLOAT,
+                      &FileRealBuffer[0][ringpos],
+                      samplesperframe_file * sizeof(float));
 
 
         CUR_OP("reading right channel for audio render for file (mode 1.5)");
         //copy float buffer out for file right channel
-        glReadPixels(1, 0, 1, samplesperframe_file,GL_RED, GL_FLOAT,
-                     &FileRealBuffer[1][samplepointer]);
+        readback.Read(1, 0, 1, samplesperframe_file, GL_RED, GL_FLOAT,
+                      &FileRealBuffer[1][ringpos],
+                      samplesperframe_file * sizeof(float));
 
 
         samplepointer+=samplesperframe_file;
@@ -1798,22 +1958,22 @@ void Frame_Window::render()
     new_frame=false;
 }
 
-void Frame_Window::PrepareRecording(int numsamples)
+void Frame_Window::PrepareRecording(int numframes)
 {
+    recordingsize = std::max(1, numframes) * samplesperframe_file;
+
     FileRealBuffer= new float* [2];
 
-    FileRealBuffer[0] = new float[numsamples];
-    FileRealBuffer[1] = new float[numsamples];
+    FileRealBuffer[0] = new float[recordingsize];
+    FileRealBuffer[1] = new float[recordingsize];
 
     if(logger)
     {
         (*logger) << "FileRealBuffer = [" << FileRealBuffer[0] <<
-                     "," << FileRealBuffer[1] << "] (2x" << numsamples << "\n";
+                     "," << FileRealBuffer[1] << "] (2x" << recordingsize <<
+                     " ring)\n";
 
     }
-    fprintf(stderr, "FileRealBuffer = [%p,%p]\n",
-            FileRealBuffer[0], FileRealBuffer[1]);
-    fflush(stderr);
 
     samplepointer=0;
 }
@@ -1935,11 +2095,14 @@ void Frame_Window::PaintOverlay() {
 }
 void Frame_Window::DestroyRecording()
 {
+    readback.Finish(); // nothing may still be writing into the buffers
+
     delete [] FileRealBuffer[1];
     delete [] FileRealBuffer[0];
 
     delete[] FileRealBuffer ;
     FileRealBuffer = NULL;
+    recordingsize = 0;
     samplepointer=0;
 }
 
@@ -1986,11 +2149,15 @@ void Frame_Window::PrepareVideoOutput(FrameTexture * frame)
     glActiveTexture(GL_TEXTURE0);
 }
 
-void Frame_Window::read_frame_texture(FrameTexture * frame)
+// Read the rendered video output frame. With no dest, the frame is read
+// into vo.videobuffer and is ready on return. Otherwise the read into dest
+// is started asynchronously and the caller must WaitForReadback(dest)
+// before using it.
+void Frame_Window::read_frame_texture(FrameTexture * frame, uint8_t *dest)
 {
-    if(vo.videobuffer == NULL) return;
-
-    glBindBuffer(GL_PIXEL_PACK_BUFFER,0);
+    bool wait = (dest == NULL);
+    if(wait) dest = vo.videobuffer;
+    if(dest == NULL) return;
 
     //  glPixelStorei(GL_UNPACK_SWAP_BYTES,0);
 
@@ -2000,9 +2167,11 @@ void Frame_Window::read_frame_texture(FrameTexture * frame)
 
     // Reference Point: LSJ-20170519-1322
     // See mainwindow.cpp:LSJ-20170519-1322
-    glReadPixels(0, 0, frame->width, frame->height,GL_RGBA,
-                 GL_UNSIGNED_INT_8_8_8_8_REV, vo.videobuffer); //copy buffer out to
+    size_t size = size_t(frame->width) * frame->height * 4;
+    readback.Read(0, 0, frame->width, frame->height, GL_RGBA,
+                  GL_UNSIGNED_INT_8_8_8_8_REV, dest, size);
 
+    if(wait) readback.WaitFor(dest, size);
 }
 
 float *Frame_Window::GetCalibrationMask()
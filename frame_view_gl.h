@@ -52,6 +52,13 @@
 
 #include "vbevent.h"
 #include "frametexture.h"
+#include "pixelreadback.h"
+#include "overlapregistration.h"
+#include "overlaptrack.h"
+
+// frames of file audio the recording ring holds: enough for the frames
+// the muxer renders ahead of the audio it has encoded
+#define FRAME_RECORDING_FRAMES 32
 
 class FrameBucketManager {
 public:
@@ -66,6 +73,8 @@ public:
       int getcurrent();
     QPair<QList<int>, QList<int>> getNeededFrameNumbers(int frame_number) const;
     QList<int> getBuffersSortedByFrameNumber() const;
+    // buckets hold the frames within this distance of the current frame
+    int windowRadius() const { return bufferCount / 2; }
 
 private:
     QList<FrameBucket> buffers;
@@ -106,20 +115,26 @@ public:
 	void ParamUpdateCallback(FrameWindowCallbackFunction cb, void *userData);
 
 	//load frame from pointer
-	void load_frame_texture(FrameTexture *frame);
+	void load_frame_texture(const FrameTexture *frame);
     int originalwx;
     int originalwy;
 	float GetAverage(GLfloat *, int ) ;
 	int GetMinLoc(GLfloat*, int ) ;
 	void GetBestMatchFromFloatArray(GLfloat*, int , int ,overlap_match &) ;
 	float GetMin(GLfloat* dArray, int iSize) ;
-	void PrepareRecording(int numsamples) ;
+	// Record file audio into a ring of numframes frames: frame k's
+	// samples are at (k*samplesperframe_file) % RecordingSize().
+	void PrepareRecording(int numframes=FRAME_RECORDING_FRAMES) ;
 	void ProcessRecording(int numsamples);
 	void DestroyRecording( );
-	float **GetRecording() const { return FileRealBuffer; }
+	int RecordingSize() const { return recordingsize; }
+	int64_t SamplesRecorded() const { return samplepointer; }
     void PrepareVideoOutput(FrameTexture *frame)	;
 	float GetMax(GLfloat* dArray, int iSize) ;
-	void read_frame_texture(FrameTexture *frame);
+	void read_frame_texture(FrameTexture *frame, uint8_t *dest=NULL);
+	void WaitForReadback(const void *dest, size_t size=1)
+		{ readback.WaitFor(dest, size); }
+	void FinishReadbacks() { readback.Finish(); }
 	float *GetCalibrationMask();
 	void SetCalibrationMask(const float *mask);
 	void update_parameters();// update gpu variables and rerender
@@ -171,6 +186,9 @@ public:
 	int channels ;
 	float* audio_sample_buffer;
 	float* audio_compare_buffer;
+	std::vector <float> overlap_profile[2]; // mode 4 columns 0 and 1
+	OverlapRegistration registration;
+	OverlapMatch nccmatch;
     GLfloat loupeview[4];
 
     GLfloat marqueeBounds[4]; // marquee selection boundary, in click order x1,x2,y1,y2
@@ -195,6 +213,8 @@ public:
 	bool is_debug;
 	bool is_videooutput;
 	int overrideOverlap;
+	const OverlapTrack *overlapTrack; // NULL to always search
+	long trackFrame; // frame being rendered, for the overlap track
 
 	float fps;
 	unsigned long duration; // milliseconds
@@ -231,15 +251,18 @@ private:
 	FrameWindowCallbackFunction paramUpdateCB;
 	void *paramUpdateUserData;
 
-	int samplepointer;
+	int64_t samplepointer; // samples recorded so far
+	int recordingsize;     // samples in each channel of FileRealBuffer
 	GLuint loadShader(GLenum type, const char *source);
 	void gen_tex_bufs(); //generation of textures and buffers
 	bool new_frame; //is a new frame from seq
 
 	void CopyFrameBuffer(GLuint fbo, int width, int height);
+	void ComputeOverlap();
+	OverlapTrackKey TrackKey() const;
 
 	GLenum *audio_draw_buffers;
-	GLuint audio_pbo;
+	PixelReadback readback; // asynchronous recording/video readback
 	GLuint m_posAttr; //vertex buffer
 	GLuint m_texAttr;
 	GLuint m_matrixUniform; //sizing matrix currently unused
@@ -295,6 +318,19 @@ private:
     GLuint overlay_texture; //render texture audio rgb for screen display
     GLuint overlay_texture_loc;
 
+    // second and third planes of planar (video) frames; the first plane
+    // goes to frame_texture
+    GLuint frame_plane_texture[2];
+    GLuint frame_plane_texture_loc;
+    GLuint m_planemode_loc;
+    GLuint m_planematrix_loc;
+    GLuint m_planescale_loc;
+    GLuint m_planeoffset_loc;
+    float plane_mode; // 0: interleaved RGB, 1: planes to convert
+    float plane_matrix[9];
+    float plane_scale[3];
+    float plane_offset[3];
+
 
 
     int VBench_currentindex=0;
@@ -0,0 +1,181 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+#include <algorithm>
+
+#include "framecache.h"
+
+//-----------------------------------------------------------------------------
+FrameCache::FrameCache()
+	: pinFirst(0), pinLast(-1), budget(FRAMECACHE_DEFAULT_BUDGET), used(0),
+	hits(0), misses(0), evictions(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+void FrameCache::SetBudget(size_t bytes)
+{
+	budget = bytes;
+	EvictToFit(0);
+}
+
+//-----------------------------------------------------------------------------
+// Memory a cached frame holds: its buffer (at least the image, whatever the
+// reader recorded), plus the decoder's buffers for a planar frame
+static size_t Footprint(const FrameTexture &tex)
+{
+	if(tex.IsPlanar())
+		return size_t(tex.bufSize) + tex.PixelBytes();
+	return std::max(size_t(tex.bufSize), tex.PixelBytes());
+}
+
+//-----------------------------------------------------------------------------
+bool FrameCache::IsPinned(const Key &key) const
+{
+	return key.second >= pinFirst && key.second <= pinLast &&
+		key.first == pinSource;
+}
+
+//-----------------------------------------------------------------------------
+void FrameCache::Erase(std::list<Entry>::iterator entry)
+{
+	used -= entry->bytes;
+	index.erase(entry->key);
+
+	// keep the bigger buffer for the next insert
+	if(entry->tex.bufSize > spare.bufSize)
+		spare.Swap(entry->tex);
+
+	entries.erase(entry);
+}
+
+//-----------------------------------------------------------------------------
+// Drop least recently used, unpinned frames until incoming more bytes fit
+void FrameCache::EvictToFit(size_t incoming)
+{
+	auto entry = entries.end();
+
+	while(used + incoming > budget && entry != entries.begin())
+	{
+		--entry;
+		if(IsPinned(entry->key)) continue;
+
+		Erase(entry++);
+		++evictions;
+	}
+}
+
+//-----------------------------------------------------------------------------
+const FrameTexture *FrameCache::Find(const std::string &source, long frameNum)
+{
+	auto found = index.find(Key(source, frameNum));
+	if(found == index.end())
+	{
+		++misses;
+		return NULL;
+	}
+
+	++hits;
+	entries.splice(entries.begin(), entries, found->second);
+	return &(found->second->tex);
+}
+
+//-----------------------------------------------------------------------------
+const FrameTexture *FrameCache::Insert(const std::string &source,
+		long frameNum, FrameTexture *frame)
+{
+	Key key(source, frameNum);
+	size_t bytes = frame->IsMapped() ? frame->PixelBytes() :
+		Footprint(*frame);
+
+	if(bytes > budget) return NULL;
+
+	auto found = index.find(key);
+	if(found != index.end())
+		Erase(found->second);
+
+	EvictToFit(bytes);
+
+	entries.emplace_front();
+	Entry &entry = entries.front();
+	entry.key = key;
+	entry.tex.Swap(spare);
+
+	if(frame->IsMapped())
+	{
+		entry.tex.CopyPixels(*frame);
+	}
+	else
+	{
+		// the caller gets the spare buffer back for its next read
+		entry.tex.Swap(*frame);
+	}
+
+	entry.bytes = Footprint(entry.tex);
+	used += entry.bytes;
+	index[key] = entries.begin();
+
+	return &(entry.tex);
+}
+
+//-----------------------------------------------------------------------------
+void FrameCache::Pin(const std::string &source, long first, long last)
+{
+	pinSource = source;
+	pinFirst = first;
+	pinLast = last;
+}
+
+//-----------------------------------------------------------------------------
+void FrameCache::Unpin()
+{
+	pinSource.clear();
+	pinFirst = 0;
+	pinLast = -1;
+	EvictToFit(0);
+}
+
+//-----------------------------------------------------------------------------
+void FrameCache::Clear()
+{
+	index.clear();
+	entries.clear();
+	used = 0;
+
+	FrameTexture none;
+	spare.Swap(none);
+}
+
+//-----------------------------------------------------------------------------
+double FrameCache::HitRate() const
+{
+	unsigned long lookups = hits + misses;
+	return lookups ? double(hits) / lookups : 0.0;
+}
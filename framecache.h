@@ -0,0 +1,125 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+// FrameCache -- least-recently-used cache of decoded scan images, keyed by
+// source file name and frame number, with a byte budget.
+//
+// Insert() takes over the pixel buffer of a freshly read FrameTexture (and
+// hands back a buffer from an evicted frame for the next read), so caching
+// a frame costs no copy unless the frame was read through a memory map;
+// mapped frames are copied into memory of their own, since the point is to
+// keep scrubbed frames off the disk or network share.
+//
+// Frames in the pinned range are never evicted, so the frames the frame
+// window's buckets are built from stay resident even if that briefly puts
+// the cache over budget.
+//
+// Not thread-safe: use from the GUI thread only, like
+// FramePrefetcher::GetFrameImage(). Pointers returned by Find() and
+// Insert() are valid until the next call that modifies the cache.
+
+#ifndef FRAMECACHE_H
+#define FRAMECACHE_H
+
+#include <list>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "frametexture.h"
+
+#define FRAMECACHE_DEFAULT_BUDGET (2048ull*1024*1024)
+
+class FrameCache {
+private:
+	typedef std::pair<std::string, long> Key;
+
+	class Entry {
+	public:
+		Key key;
+		FrameTexture tex;
+		size_t bytes;
+	};
+
+	// most recently used first
+	std::list<Entry> entries;
+	std::map<Key, std::list<Entry>::iterator> index;
+
+	// buffer from the last evicted frame, recycled by Insert()
+	FrameTexture spare;
+
+	std::string pinSource;
+	long pinFirst;
+	long pinLast;
+
+	size_t budget;
+	size_t used;
+
+	unsigned long hits;
+	unsigned long misses;
+	unsigned long evictions;
+
+	bool IsPinned(const Key &key) const;
+	void EvictToFit(size_t incoming);
+	void Erase(std::list<Entry>::iterator entry);
+
+public:
+	FrameCache();
+
+	void SetBudget(size_t bytes);
+	size_t Budget() const { return budget; }
+	size_t BytesUsed() const { return used; }
+	size_t NumFrames() const { return entries.size(); }
+
+	// returns NULL on a miss
+	const FrameTexture *Find(const std::string &source, long frameNum);
+
+	// Cache the image in frame, which is left holding a spare buffer (or
+	// nothing). Returns the cached copy, or NULL if the image is bigger
+	// than the whole budget, in which case frame is left untouched.
+	const FrameTexture *Insert(const std::string &source, long frameNum,
+			FrameTexture *frame);
+
+	// Keep frames [first,last] of source resident; replaces any previous
+	// pinned range. Unpin() releases it.
+	void Pin(const std::string &source, long first, long last);
+	void Unpin();
+
+	// drop every frame, and the spare buffer (for a new source)
+	void Clear();
+
+	unsigned long Hits() const { return hits; }
+	unsigned long Misses() const { return misses; }
+	unsigned long Evictions() const { return evictions; }
+	double HitRate() const;
+	void ResetCounters() { hits = 0; misses = 0; evictions = 0; }
+};
+
+#endif // FRAMECACHE_H
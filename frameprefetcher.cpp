@@ -0,0 +1,334 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+#include <cstdlib>
+
+#include "frameprefetcher.h"
+#include "vfbexception.h"
+
+//-----------------------------------------------------------------------------
+FramePrefetcher::FramePrefetcher()
+	: scan(NULL), position(-1), direction(1),
+	depth(PREFETCH_DEFAULT_DEPTH), numThreads(PREFETCH_DEFAULT_THREADS),
+	stopping(false), hits(0), waits(0), misses(0)
+{
+	for(int i=0; i<depth; ++i)
+		slots.push_back(new Slot);
+}
+
+//-----------------------------------------------------------------------------
+FramePrefetcher::~FramePrefetcher()
+{
+	StopWorkers();
+	for(Slot *slot : slots)
+		delete slot;
+}
+
+//-----------------------------------------------------------------------------
+void FramePrefetcher::StartWorkers()
+{
+	stopping = false;
+	if(!scan || !scan->IsReady()) return;
+
+	for(int i=0; i<numThreads; ++i)
+		workers.push_back(std::thread(&FramePrefetcher::Worker, this));
+}
+
+//-----------------------------------------------------------------------------
+void FramePrefetcher::StopWorkers()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	workAvailable.notify_all();
+
+	for(std::thread &worker : workers)
+		worker.join();
+	workers.clear();
+
+	// nothing is in flight now, so every slot can be dropped
+	for(Slot *slot : slots)
+	{
+		slot->state = SLOT_EMPTY;
+		slot->frameNum = -1;
+	}
+}
+
+//-----------------------------------------------------------------------------
+void FramePrefetcher::Worker()
+{
+	std::unique_lock<std::mutex> guard(lock);
+
+	while(!stopping)
+	{
+		Slot *slot = NextPendingSlot();
+		if(slot == NULL)
+		{
+			workAvailable.wait(guard);
+			continue;
+		}
+
+		slot->state = SLOT_DECODING;
+		long frameNum = slot->frameNum;
+		guard.unlock();
+
+		bool ok(true);
+		try
+		{
+			std::unique_lock<std::mutex> reading(readLock, std::defer_lock);
+			if(!scan->IsThreadSafe()) reading.lock();
+			scan->GetFrameImage(frameNum, &(slot->tex));
+		}
+		catch(...)
+		{
+			// leave the error for the synchronous read to report
+			ok = false;
+		}
+
+		guard.lock();
+		slot->state = ok ? SLOT_READY : SLOT_FAILED;
+		slotFinished.notify_all();
+	}
+}
+
+//-----------------------------------------------------------------------------
+// The pending slot closest to the play position is decoded first, so the
+// frame needed next is never stuck behind one needed later.
+FramePrefetcher::Slot *FramePrefetcher::NextPendingSlot()
+{
+	Slot *next(NULL);
+	long nextDist(0);
+
+	for(Slot *slot : slots)
+	{
+		if(slot->state != SLOT_PENDING) continue;
+
+		long dist = std::labs(slot->frameNum - position);
+		if(next == NULL || dist < nextDist)
+		{
+			next = slot;
+			nextDist = dist;
+		}
+	}
+
+	return next;
+}
+
+//-----------------------------------------------------------------------------
+FramePrefetcher::Slot *FramePrefetcher::FindSlot(long frameNum)
+{
+	for(Slot *slot : slots)
+	{
+		if(slot->state != SLOT_EMPTY && slot->frameNum == frameNum)
+			return slot;
+	}
+	return NULL;
+}
+
+//-----------------------------------------------------------------------------
+// Schedule - recycle slots that fell out of the read-ahead window and fill
+// empty slots with the frames in the window that aren't queued yet.
+// Must be called with the lock held.
+void FramePrefetcher::Schedule()
+{
+	if(workers.empty() || position < 0) return;
+
+	for(Slot *slot : slots)
+	{
+		if(slot->state == SLOT_EMPTY || slot->state == SLOT_DECODING)
+			continue;
+
+		long ahead = (slot->frameNum - position) * direction;
+		if(ahead < 1 || ahead > depth)
+		{
+			slot->state = SLOT_EMPTY;
+			slot->frameNum = -1;
+		}
+	}
+
+	bool queued(false);
+	for(int i=1; i<=depth; ++i)
+	{
+		long frameNum = position + i*direction;
+		if(frameNum < scan->FirstFrame() || frameNum > scan->LastFrame())
+			break;
+
+		if(FindSlot(frameNum)) continue;
+
+		Slot *empty(NULL);
+		for(Slot *slot : slots)
+		{
+			if(slot->state == SLOT_EMPTY)
+			{
+				empty = slot;
+				break;
+			}
+		}
+		if(empty == NULL) break;
+
+		empty->frameNum = frameNum;
+		empty->state = SLOT_PENDING;
+		queued = true;
+	}
+
+	if(queued) workAvailable.notify_all();
+}
+
+//-----------------------------------------------------------------------------
+void FramePrefetcher::SetSource(const FilmScan *s)
+{
+	StopWorkers();
+	scan = s;
+	position = -1;
+	ResetCounters();
+	StartWorkers();
+}
+
+//-----------------------------------------------------------------------------
+void FramePrefetcher::Clear()
+{
+	StopWorkers();
+	position = -1;
+	StartWorkers();
+}
+
+//-----------------------------------------------------------------------------
+void FramePrefetcher::SetDepth(int d)
+{
+	if(d < 0) d = 0;
+	if(d == depth) return;
+
+	StopWorkers();
+
+	while(int(slots.size()) > d)
+	{
+		delete slots.back();
+		slots.pop_back();
+	}
+	while(int(slots.size()) < d)
+		slots.push_back(new Slot);
+
+	depth = d;
+	StartWorkers();
+}
+
+//-----------------------------------------------------------------------------
+void FramePrefetcher::SetThreadCount(int n)
+{
+	if(n < 0) n = 0;
+	if(n == numThreads) return;
+
+	StopWorkers();
+	numThreads = n;
+	StartWorkers();
+}
+
+//-----------------------------------------------------------------------------
+void FramePrefetcher::SetDirection(int dir)
+{
+	dir = (dir < 0) ? -1 : 1;
+
+	std::lock_guard<std::mutex> guard(lock);
+	if(dir == direction) return;
+	direction = dir;
+	Schedule();
+}
+
+//-----------------------------------------------------------------------------
+// GetFrameImage - same contract as FilmScan::GetFrameImage(). Must only be
+// called from one thread (the GUI thread).
+FrameTexture *FramePrefetcher::GetFrameImage(long frameNum, FrameTexture *frame)
+{
+	if(!scan)
+		throw vfbexception("FramePrefetcher: no source");
+
+	if(!frame) frame = new FrameTexture;
+
+	std::unique_lock<std::mutex> guard(lock);
+	position = frameNum;
+
+	Slot *slot = FindSlot(frameNum);
+	bool waited(false);
+
+	// not started yet: read it here rather than wait behind the workers
+	if(slot && slot->state == SLOT_PENDING)
+	{
+		slot->state = SLOT_EMPTY;
+		slot->frameNum = -1;
+		slot = NULL;
+	}
+
+	while(slot && slot->state == SLOT_DECODING)
+	{
+		waited = true;
+		slotFinished.wait(guard);
+	}
+
+	if(slot && slot->state == SLOT_READY)
+	{
+		frame->Swap(slot->tex);
+		slot->state = SLOT_EMPTY;
+		slot->frameNum = -1;
+		if(waited) ++waits;
+		else ++hits;
+
+		Schedule();
+		return frame;
+	}
+
+	if(slot)
+	{
+		// the worker failed; retry here so the error reaches the caller
+		slot->state = SLOT_EMPTY;
+		slot->frameNum = -1;
+	}
+	++misses;
+	guard.unlock();
+
+	{
+		std::unique_lock<std::mutex> reading(readLock, std::defer_lock);
+		if(!scan->IsThreadSafe()) reading.lock();
+		frame = scan->GetFrameImage(frameNum, frame);
+	}
+
+	guard.lock();
+	Schedule();
+
+	return frame;
+}
+
+//-----------------------------------------------------------------------------
+void FramePrefetcher::Seek(long frameNum)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	position = frameNum;
+	Schedule();
+}
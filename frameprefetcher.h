@@ -0,0 +1,134 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+// FramePrefetcher -- background read-ahead of scan images.
+//
+// Decodes the frames following the most recently requested frame (in the
+// current play direction) on a small pool of worker threads, into a
+// bounded pool of FrameTexture buffers. GetFrameImage() hands a prefetched
+// buffer to the caller by swapping it with the caller's FrameTexture, so no
+// pixel data is copied; the caller's old buffer is recycled into the pool.
+//
+// Frames that were not prefetched are read synchronously on the calling
+// thread exactly as FilmScan::GetFrameImage() would, so the prefetcher is
+// always safe to put in front of a FilmScan.
+
+#ifndef FRAMEPREFETCHER_H
+#define FRAMEPREFETCHER_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include "FilmScan.h"
+#include "frametexture.h"
+
+#define PREFETCH_DEFAULT_DEPTH 8
+#define PREFETCH_DEFAULT_THREADS 2
+
+class FramePrefetcher {
+private:
+	enum SlotState {
+		SLOT_EMPTY,
+		SLOT_PENDING,  // scheduled, waiting for a worker
+		SLOT_DECODING, // a worker is reading into it
+		SLOT_READY,
+		SLOT_FAILED
+	};
+
+	class Slot {
+	public:
+		long frameNum;
+		SlotState state;
+		FrameTexture tex;
+		Slot() : frameNum(-1), state(SLOT_EMPTY) {} ;
+	};
+
+	const FilmScan *scan;
+	std::vector<Slot *> slots;
+	std::vector<std::thread> workers;
+
+	// guards slots, the request position and the worker stop flag
+	std::mutex lock;
+	std::condition_variable workAvailable;
+	std::condition_variable slotFinished;
+
+	// serializes reads from sources that aren't FilmScan::IsThreadSafe()
+	std::mutex readLock;
+
+	long position;  // last frame requested by the caller
+	int direction;  // +1 forward, -1 reverse
+	int depth;
+	int numThreads;
+	bool stopping;
+
+	std::atomic<unsigned long> hits;
+	std::atomic<unsigned long> waits;
+	std::atomic<unsigned long> misses;
+
+	void StartWorkers();
+	void StopWorkers();
+	void Worker();
+	Slot *NextPendingSlot();
+	Slot *FindSlot(long frameNum);
+	void Schedule();
+
+public:
+	FramePrefetcher();
+	~FramePrefetcher();
+
+	void SetSource(const FilmScan *scan);
+	void Clear();
+
+	void SetDepth(int d);
+	void SetThreadCount(int n);
+	void SetDirection(int dir);
+	int Depth() const { return depth; }
+	int ThreadCount() const { return numThreads; }
+	int Direction() const { return direction; }
+
+	FrameTexture *GetFrameImage(long frameNum, FrameTexture *frame);
+
+	// move the read-ahead window without reading, for a frame the caller
+	// found elsewhere (e.g. in a FrameCache)
+	void Seek(long frameNum);
+
+	// hits: frame was already decoded when requested
+	// waits: frame was being decoded and the caller blocked until done
+	// misses: frame was not prefetched and was read synchronously
+	unsigned long Hits() const { return hits; }
+	unsigned long Waits() const { return waits; }
+	unsigned long Misses() const { return misses; }
+	void ResetCounters() { hits = 0; waits = 0; misses = 0; }
+};
+
+#endif // FRAMEPREFETCHER_H
@@ -29,18 +29,315 @@
 //-----------------------------------------------------------------------------
 
 #include "frametexture.h"
+#include "mappedinstream.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
 
 FrameTexture::FrameTexture()
 {
     buf = nullptr;
+	bufSize = 0;
 	width = 0;
 	height = 0;
 	format = GL_UNSIGNED_INT_10_10_10_2;
 	nComponents = 0;
 	isNonNativeEndianess = false;
+	mappedPixels = nullptr;
+	nPlanes = 0;
+	memset(planes, 0, sizeof(planes));
+	planeLayout = PLANES_YUV;
+	bitDepth = 8;
+	kr = 0.2126f;
+	kb = 0.0722f;
+	fullRange = false;
 }
 
 FrameTexture::~FrameTexture()
 {
 	if(buf) delete [] buf;
 }
+
+void FrameTexture::Swap(FrameTexture &other)
+{
+	std::swap(buf, other.buf);
+	std::swap(bufSize, other.bufSize);
+	std::swap(width, other.width);
+	std::swap(height, other.height);
+	std::swap(format, other.format);
+	std::swap(nComponents, other.nComponents);
+	std::swap(isNonNativeEndianess, other.isNonNativeEndianess);
+	std::swap(mapping, other.mapping);
+	std::swap(mappedPixels, other.mappedPixels);
+	std::swap(nPlanes, other.nPlanes);
+	std::swap(planes, other.planes);
+	std::swap(planeLayout, other.planeLayout);
+	std::swap(bitDepth, other.bitDepth);
+	std::swap(kr, other.kr);
+	std::swap(kb, other.kb);
+	std::swap(fullRange, other.fullRange);
+	std::swap(planeOwner, other.planeOwner);
+}
+
+void FrameTexture::SetMapping(
+		std::shared_ptr<MappedInStream> map, const uint8_t *pixels)
+{
+	ReleasePlanes();
+	mapping = map;
+	mappedPixels = pixels;
+}
+
+// readers call this before writing buf: the image is in buf from now on
+void FrameTexture::ReleaseMapping()
+{
+	mapping.reset();
+	mappedPixels = nullptr;
+	ReleasePlanes();
+}
+
+void FrameTexture::SetPlanes(std::shared_ptr<void> owner, PlaneLayout layout,
+		int n, const Plane p[], int depth)
+{
+	mapping.reset();
+	mappedPixels = nullptr;
+
+	planeOwner = owner;
+	planeLayout = layout;
+	nPlanes = std::min(n, 3);
+	for(int i=0; i<nPlanes; ++i)
+		planes[i] = p[i];
+	bitDepth = depth;
+
+	width = planes[0].width;
+	height = planes[0].height;
+	format = (depth > 8) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE;
+	nComponents = (layout == PLANES_GRAY) ? 1 : 3;
+	isNonNativeEndianess = false;
+}
+
+void FrameTexture::ReleasePlanes()
+{
+	planeOwner.reset();
+	nPlanes = 0;
+	memset(planes, 0, sizeof(planes));
+}
+
+void FrameTexture::PlaneConversion(float matrix[9], float scale[3],
+		float offset[3]) const
+{
+	// samples are LSB aligned in their container: scale takes the
+	// normalized texel back to a code value and then to [0,1]
+	const float container = (format == GL_UNSIGNED_SHORT) ? 65535.0f : 255.0f;
+	const float codes = float((1 << bitDepth) - 1);
+	const float unit = float(1 << (std::max(bitDepth, 8) - 8));
+
+	for(int i=0; i<9; ++i) matrix[i] = 0.0f;
+
+	switch(planeLayout)
+	{
+	case PLANES_GBR:
+		for(int c=0; c<3; ++c)
+		{
+			scale[c] = container / codes;
+			offset[c] = 0.0f;
+		}
+		// planes are G, B, R
+		matrix[0*3+2] = 1.0f;
+		matrix[1*3+0] = 1.0f;
+		matrix[2*3+1] = 1.0f;
+		break;
+
+	case PLANES_GRAY:
+		scale[0] = container / codes;
+		offset[0] = 0.0f;
+		scale[1] = scale[2] = offset[1] = offset[2] = 0.0f;
+		matrix[0*3+0] = matrix[1*3+0] = matrix[2*3+0] = 1.0f;
+		break;
+
+	case PLANES_YUV:
+		if(fullRange)
+		{
+			scale[0] = scale[1] = scale[2] = container / codes;
+			offset[0] = 0.0f;
+			offset[1] = offset[2] = (128.0f * unit) / codes;
+		}
+		else
+		{
+			scale[0] = container / (219.0f * unit);
+			offset[0] = 16.0f / 219.0f;
+			scale[1] = scale[2] = container / (224.0f * unit);
+			offset[1] = offset[2] = 128.0f / 224.0f;
+		}
+
+		// R = Y + 2(1-kr)Cr, B = Y + 2(1-kb)Cb, and G from
+		// Y = kr R + kg G + kb B
+		{
+			const float kg = 1.0f - kr - kb;
+			matrix[0*3+0] = matrix[1*3+0] = matrix[2*3+0] = 1.0f;
+			matrix[0*3+2] = 2.0f * (1.0f - kr);
+			matrix[1*3+1] = -2.0f * kb * (1.0f - kb) / kg;
+			matrix[1*3+2] = -2.0f * kr * (1.0f - kr) / kg;
+			matrix[2*3+1] = 2.0f * (1.0f - kb);
+		}
+		break;
+	}
+}
+
+// log2 of how much smaller a (chroma) plane is than the image
+static int Subsampling(int image, int plane)
+{
+	int s(0);
+	while(s < 4 && ((image + (1 << s) - 1) >> s) > plane) ++s;
+	return s;
+}
+
+void FrameTexture::PlanarToRGB(int y, int x0, int x1, float *r, float *g,
+		float *b) const
+{
+	float m[9], scale[3], offset[3];
+	PlaneConversion(m, scale, offset);
+
+	const bool wide = (format == GL_UNSIGNED_SHORT);
+	const float norm = wide ? 1.0f/65535.0f : 1.0f/255.0f;
+	const uint8_t *row[3];
+	int xShift[3];
+
+	for(int c=0; c<3; ++c)
+	{
+		// gray images have one plane: it stands in for the others
+		const Plane &p = planes[c < nPlanes ? c : 0];
+		row[c] = p.data +
+			size_t(y >> Subsampling(height, p.height)) * p.stride;
+		xShift[c] = Subsampling(width, p.width);
+		scale[c] *= norm;
+	}
+
+	// one pass: fetch, normalize, offset and matrix per pixel
+	for(int x=x0, i=0; x<=x1; ++x, ++i)
+	{
+		float v[3];
+		for(int c=0; c<3; ++c)
+		{
+			int px = x >> xShift[c];
+			float code = wide ?
+				float(((const uint16_t *)(row[c]))[px]) : float(row[c][px]);
+			v[c] = code * scale[c] - offset[c];
+		}
+
+		r[i] = std::min(1.0f, std::max(0.0f, m[0]*v[0] + m[1]*v[1] + m[2]*v[2]));
+		g[i] = std::min(1.0f, std::max(0.0f, m[3]*v[0] + m[4]*v[1] + m[5]*v[2]));
+		b[i] = std::min(1.0f, std::max(0.0f, m[6]*v[0] + m[7]*v[1] + m[8]*v[2]));
+	}
+}
+
+static inline void StoreLuma(float v, float &d) { d = v; }
+static inline void StoreLuma(float v, double &d) { d = v; }
+static inline void StoreLuma(float v, uint16_t &d)
+{
+	d = uint16_t(v * 65535.0f + 0.5f);
+}
+
+template <typename T>
+void FrameTexture::PlanarToLuma(int y, T *luma) const
+{
+	float m[9], scale[3], offset[3];
+	PlaneConversion(m, scale, offset);
+
+	const bool wide = (format == GL_UNSIGNED_SHORT);
+	const float norm = wide ? 1.0f/65535.0f : 1.0f/255.0f;
+
+	if(planeLayout != PLANES_GBR)
+	{
+		// Y is the luma: a single scale and offset of the first plane
+		const uint8_t *row = planes[0].data + size_t(y) * planes[0].stride;
+		const float s = scale[0] * norm;
+		const float o = offset[0];
+
+		if(wide)
+			for(int x=0; x<width; ++x)
+				StoreLuma(std::min(1.0f, std::max(0.0f,
+						((const uint16_t *)row)[x] * s - o)), luma[x]);
+		else
+			for(int x=0; x<width; ++x)
+				StoreLuma(std::min(1.0f, std::max(0.0f, row[x] * s - o)),
+						luma[x]);
+		return;
+	}
+
+	// planes are G, B, R
+	const float s = scale[0] * norm;
+	const float w[3] = { s * (1.0f - kr - kb), s * kb, s * kr };
+	const uint8_t *row[3];
+	for(int c=0; c<3; ++c)
+		row[c] = planes[c].data + size_t(y) * planes[c].stride;
+
+	for(int x=0; x<width; ++x)
+	{
+		float v(0);
+		for(int c=0; c<3; ++c)
+			v += w[c] * (wide ?
+				float(((const uint16_t *)(row[c]))[x]) : float(row[c][x]));
+		StoreLuma(std::min(1.0f, v), luma[x]);
+	}
+}
+
+template void FrameTexture::PlanarToLuma<float>(int, float *) const;
+template void FrameTexture::PlanarToLuma<double>(int, double *) const;
+template void FrameTexture::PlanarToLuma<uint16_t>(int, uint16_t *) const;
+
+size_t FrameTexture::PixelBytes() const
+{
+	size_t pixels = size_t(width) * height;
+
+	if(IsPlanar())
+	{
+		size_t bytes(0);
+		for(int i=0; i<nPlanes; ++i)
+			bytes += size_t(planes[i].width) * planes[i].height *
+				((format == GL_UNSIGNED_SHORT) ? 2 : 1);
+		return bytes;
+	}
+
+	switch(format)
+	{
+	case GL_UNSIGNED_INT_10_10_10_2:
+	case GL_UNSIGNED_INT_8_8_8_8_REV:
+		return pixels * 4;
+	case GL_UNSIGNED_BYTE:
+		return pixels * nComponents;
+	default:
+		return pixels * nComponents * 2;
+	}
+}
+
+void FrameTexture::CopyPixels(const FrameTexture &other)
+{
+	if(other.IsPlanar())
+	{
+		ReleaseMapping();
+		SetPlanes(other.planeOwner, other.planeLayout, other.nPlanes,
+				other.planes, other.bitDepth);
+		kr = other.kr;
+		kb = other.kb;
+		fullRange = other.fullRange;
+		return;
+	}
+
+	size_t bytes = other.PixelBytes();
+
+	ReleaseMapping();
+	if(buf == nullptr || size_t(bufSize) < bytes)
+	{
+		if(buf) delete [] buf;
+		buf = new uint8_t [bytes];
+		bufSize = int(bytes);
+	}
+	if(other.Pixels()) memcpy(buf, other.Pixels(), bytes);
+
+	width = other.width;
+	height = other.height;
+	format = other.format;
+	nComponents = other.nComponents;
+	isNonNativeEndianess = other.isNonNativeEndianess;
+}
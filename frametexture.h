@@ -33,12 +33,68 @@
 
 #include <QOpenGLTexture>
 
+#include <memory>
+
+class MappedInStream;
+
 class FrameTexture
 {
 public:
 	FrameTexture();
 	~FrameTexture();
 
+	// exchange buffers and image descriptions with another texture
+	// without copying any pixel data
+	void Swap(FrameTexture &other);
+
+	// the pixels to upload: either buf, or image data that lives
+	// directly in a memory-mapped source file (see ReadFrameDPX_ImageData)
+	const uint8_t *Pixels() const { return mapping ? mappedPixels : buf; }
+	bool IsMapped() const { return bool(mapping); }
+	void SetMapping(std::shared_ptr<MappedInStream> map, const uint8_t *pixels);
+	void ReleaseMapping();
+
+	// size of the image as handed to OpenGL, wherever the pixels live
+	size_t PixelBytes() const;
+
+	// copy another texture's image into buf (reusing it if it is big
+	// enough), so the copy doesn't depend on the other's mapping. Planar
+	// images are shared rather than copied: their planes never change.
+	void CopyPixels(const FrameTexture &other);
+
+	// Planar images (video decoded by libav) stay in the decoder's frame,
+	// which planeOwner keeps alive: planes[] point into it and nothing is
+	// copied into buf. Each plane is uploaded as a texture of its own and
+	// the conversion to RGB happens in the shader (or PlanarToRGB() on the
+	// CPU). Samples are 8 bit (format GL_UNSIGNED_BYTE) or 16 bit
+	// (GL_UNSIGNED_SHORT) with bitDepth significant bits.
+	enum PlaneLayout { PLANES_YUV, PLANES_GBR, PLANES_GRAY };
+	struct Plane {
+		const uint8_t *data;
+		int stride;   // bytes
+		int width;
+		int height;
+	};
+
+	bool IsPlanar() const { return nPlanes > 0; }
+	void SetPlanes(std::shared_ptr<void> owner, PlaneLayout layout,
+			int nPlanes, const Plane planes[], int bitDepth);
+	void ReleasePlanes();
+
+	// rgb = matrix * (sample*scale - offset), for samples normalized to
+	// their 8 or 16 bit container, with matrix in row-major order
+	void PlaneConversion(float matrix[9], float scale[3],
+			float offset[3]) const;
+
+	// convert columns [x0,x1] of row y of a planar image to RGB in [0,1]
+	void PlanarToRGB(int y, int x0, int x1, float *r, float *g,
+			float *b) const;
+
+	// luma of row y of a planar image, straight from the samples: in
+	// [0,1] for float and double, [0,65535] for uint16_t
+	template <typename T>
+	void PlanarToLuma(int y, T *luma) const;
+
 public:
 	uint8_t *buf;
 	int bufSize;
@@ -48,6 +104,17 @@ public:
 	int nComponents;
 	bool isNonNativeEndianess;
 
+	std::shared_ptr<MappedInStream> mapping;
+	const uint8_t *mappedPixels;
+
+	int nPlanes;          // 0 unless the image is planar
+	Plane planes[3];
+	PlaneLayout planeLayout;
+	int bitDepth;
+	float kr, kb;         // YUV matrix luma coefficients (BT.709 default)
+	bool fullRange;       // YUV samples use the full code range
+	std::shared_ptr<void> planeOwner;
+
 };
 
 #endif // FRAMETEXTURE_H
@@ -0,0 +1,312 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <dirent.h>
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QTextStream>
+
+#include "imagesequence.h"
+#include "vfbexception.h"
+
+#define IMAGESEQ_INDEX_VERSION 1
+
+//-----------------------------------------------------------------------------
+static void DirectoryError(const char *what, const std::string &dir, int err)
+{
+	QString msg;
+
+	msg += QString("FilmScan: %1 directory folder ").arg(what);
+	msg += QString(dir.c_str());
+	msg += QString("\n");
+	if(err != 0) msg += QString(strerror(err));
+	throw vfbexception(msg);
+}
+
+//-----------------------------------------------------------------------------
+// ParseName - true if name is <prefix><numDigits digits><ext>, with the
+// digits returned in frameNum
+bool ImageSequence::ParseName(const char *name, long &frameNum) const
+{
+	if(strncmp(name, prefix.c_str(), prefix.size()) != 0) return false;
+
+	const char *cp = name + prefix.size();
+	long n(0);
+	int d;
+	for(d=0; d<numDigits; ++d, ++cp)
+	{
+		if(*cp < '0' || *cp > '9') return false;
+		n = n*10 + (*cp - '0');
+	}
+	if(*cp >= '0' && *cp <= '9') return false;
+	if(strcmp(cp, ext.c_str()) != 0) return false;
+
+	frameNum = n;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+void ImageSequence::ListDirectory(std::vector<long> &frames) const
+{
+	long frameNum;
+
+#ifdef __linux__
+	// struct linux_dirent64 isn't in the libc headers
+	struct Dirent64 {
+		uint64_t d_ino;
+		int64_t d_off;
+		unsigned short d_reclen;
+		unsigned char d_type;
+		char d_name[1];
+	};
+	const size_t bufSize = 1024*1024;
+	std::vector<char> buf(bufSize);
+
+	int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if(fd < 0)
+		DirectoryError("Cannot read", dir, errno);
+
+	while(1)
+	{
+		long n = syscall(SYS_getdents64, fd, buf.data(), bufSize);
+		if(n < 0)
+		{
+			int err = errno;
+			close(fd);
+			DirectoryError("Error reading", dir, err);
+		}
+		if(n == 0) break;
+
+		for(long pos=0; pos<n; )
+		{
+			const Dirent64 *dp =
+				reinterpret_cast<const Dirent64 *>(buf.data() + pos);
+			pos += dp->d_reclen;
+
+			// is it a file?
+			if(!(dp->d_type == DT_REG || dp->d_type == DT_UNKNOWN)) continue;
+
+			if(ParseName(dp->d_name, frameNum))
+				frames.push_back(frameNum);
+		}
+	}
+	close(fd);
+#else
+	DIR *dirp;
+
+	if((dirp = opendir(dir.c_str())) == NULL)
+		DirectoryError("Cannot read", dir, errno);
+
+	while(1)
+	{
+		errno = 0;
+		struct dirent *dp = readdir(dirp);
+		if(dp == NULL) break;
+
+		#ifdef _DIRENT_HAVE_D_TYPE
+		if(!(dp->d_type == DT_REG || dp->d_type == DT_UNKNOWN)) continue;
+		#endif
+
+		if(ParseName(dp->d_name, frameNum))
+			frames.push_back(frameNum);
+	}
+	int err = errno;
+	closedir(dirp);
+	if(err != 0)
+		DirectoryError("Error reading", dir, err);
+#endif
+}
+
+//-----------------------------------------------------------------------------
+void ImageSequence::Discover(const std::string &d, const std::string &p,
+		int nd, const std::string &e, bool useIndex)
+{
+	dir = d;
+	prefix = p;
+	numDigits = nd;
+	ext = e;
+	runs.clear();
+	fromIndex = false;
+
+	if(useIndex && LoadIndex())
+	{
+		fromIndex = true;
+		return;
+	}
+
+	std::vector<long> frames;
+	frames.reserve(4096);
+	ListDirectory(frames);
+
+	std::sort(frames.begin(), frames.end());
+	for(long f : frames)
+	{
+		if(!runs.empty() && f <= runs.back().second + 1)
+			runs.back().second = std::max(runs.back().second, f);
+		else
+			runs.push_back(Range(f, f));
+	}
+
+	if(useIndex) SaveIndex();
+}
+
+//-----------------------------------------------------------------------------
+ImageSequence::Range ImageSequence::SequenceAround(long frameNum,
+		long maxGap) const
+{
+	if(runs.empty()) return Range(0, -1);
+
+	// the run holding frameNum, or the first one after it
+	auto run = std::lower_bound(runs.begin(), runs.end(), frameNum,
+			[](const Range &r, long f) { return r.second < f; });
+	if(run == runs.end()) --run;
+
+	size_t firstIdx = run - runs.begin();
+	size_t lastIdx = firstIdx;
+	while(firstIdx > 0 &&
+			runs[firstIdx].first - runs[firstIdx-1].second - 1 <= maxGap)
+		firstIdx--;
+	while(lastIdx+1 < runs.size() &&
+			runs[lastIdx+1].first - runs[lastIdx].second - 1 <= maxGap)
+		lastIdx++;
+
+	return Range(runs[firstIdx].first, runs[lastIdx].second);
+}
+
+//-----------------------------------------------------------------------------
+std::vector<ImageSequence::Range> ImageSequence::GapsIn(const Range &r) const
+{
+	std::vector<Range> gaps;
+
+	for(size_t i=1; i<runs.size(); ++i)
+	{
+		long first = std::max(runs[i-1].second + 1, r.first);
+		long last = std::min(runs[i].first - 1, r.second);
+		if(first <= last)
+			gaps.push_back(Range(first, last));
+	}
+
+	return gaps;
+}
+
+//-----------------------------------------------------------------------------
+QString ImageSequence::IndexFileName() const
+{
+	QString key = QString::fromStdString(dir + "\n" + prefix + "\n" +
+			std::to_string(numDigits) + "\n" + ext);
+	QByteArray hash = QCryptographicHash::hash(key.toUtf8(),
+			QCryptographicHash::Sha1).toHex();
+
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+		"/sequences/" + QString::fromLatin1(hash) + ".idx";
+}
+
+//-----------------------------------------------------------------------------
+qint64 ImageSequence::DirectoryTime() const
+{
+	QFileInfo info(QString::fromStdString(dir));
+	return info.lastModified().toMSecsSinceEpoch();
+}
+
+//-----------------------------------------------------------------------------
+// The index is plain text, one field per line:
+//   VFBSEQ <version>
+//   <directory>
+//   <prefix>
+//   <number of digits>
+//   <extension>
+//   <directory modification time, ms>
+//   <number of runs>
+//   <first> <last>   (one line per run)
+bool ImageSequence::LoadIndex()
+{
+	QFile file(IndexFileName());
+	if(!file.open(QIODevice::ReadOnly | QIODevice::Text)) return false;
+
+	QTextStream in(&file);
+	if(in.readLine() != QString("VFBSEQ %1").arg(IMAGESEQ_INDEX_VERSION) ||
+			in.readLine().toStdString() != dir ||
+			in.readLine().toStdString() != prefix ||
+			in.readLine().toInt() != numDigits ||
+			in.readLine().toStdString() != ext ||
+			in.readLine().toLongLong() != DirectoryTime())
+		return false;
+
+	long n = in.readLine().toLong();
+	if(n <= 0) return false;
+
+	std::vector<Range> r(n);
+	for(long i=0; i<n; ++i)
+		in >> r[i].first >> r[i].second;
+	if(in.status() != QTextStream::Ok) return false;
+
+	runs.swap(r);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Failing to write the index only costs a directory listing next time
+void ImageSequence::SaveIndex() const
+{
+	if(runs.empty()) return;
+
+	QString fn = IndexFileName();
+	QDir().mkpath(QFileInfo(fn).absolutePath());
+
+	QFile file(fn);
+	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate |
+			QIODevice::Text))
+		return;
+
+	QTextStream out(&file);
+	out << "VFBSEQ " << IMAGESEQ_INDEX_VERSION << "\n";
+	out << QString::fromStdString(dir) << "\n";
+	out << QString::fromStdString(prefix) << "\n";
+	out << numDigits << "\n";
+	out << QString::fromStdString(ext) << "\n";
+	out << DirectoryTime() << "\n";
+	out << qint64(runs.size()) << "\n";
+	for(const Range &r : runs)
+		out << qint64(r.first) << " " << qint64(r.second) << "\n";
+}
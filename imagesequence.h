@@ -0,0 +1,98 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+// ImageSequence -- find the frames of a numbered image sequence
+// (<prefix><digits><ext>, e.g. reel1_0012345.dpx) in a directory.
+//
+// The directory is listed in one pass with large getdents64() reads on
+// Linux (readdir() elsewhere) and the names are matched and parsed by hand,
+// so a folder of a few hundred thousand frames on a network share is
+// listed in about the time it takes the server to send the names.
+//
+// The result is kept as runs of consecutive frame numbers, which describe
+// the sequence exactly however many frames it has, and is saved to an
+// index file in the user's cache directory along with the directory's
+// modification time. Opening the same reel again reads the index instead
+// of listing the directory, until a file is added to or removed from it.
+
+#ifndef IMAGESEQUENCE_H
+#define IMAGESEQUENCE_H
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <QString>
+
+// Frames separated by more missing frames than this are taken to belong to
+// different sequences that happen to share a name
+#define IMAGESEQ_MAX_GAP 1000
+
+class ImageSequence {
+public:
+	typedef std::pair<long, long> Range; // first and last frame, inclusive
+
+private:
+	std::string dir;
+	std::string prefix;
+	int numDigits;
+	std::string ext;
+
+	std::vector<Range> runs; // frames present; sorted, disjoint, not adjacent
+	bool fromIndex;
+
+	void ListDirectory(std::vector<long> &frames) const;
+	bool ParseName(const char *name, long &frameNum) const;
+	QString IndexFileName() const;
+	qint64 DirectoryTime() const;
+	bool LoadIndex();
+	void SaveIndex() const;
+
+public:
+	ImageSequence() : numDigits(0), fromIndex(false) {} ;
+
+	// Find the frames named <dir>/<prefix><numDigits digits><ext>. Throws
+	// if the directory can't be read.
+	void Discover(const std::string &dir, const std::string &prefix,
+			int numDigits, const std::string &ext, bool useIndex=true);
+
+	const std::vector<Range> &Runs() const { return runs; }
+	bool FromIndex() const { return fromIndex; }
+
+	// The frames belonging to the same sequence as frameNum: the runs
+	// around it joined across gaps of at most maxGap missing frames.
+	// Returns an empty range (first > last) if there are no frames.
+	Range SequenceAround(long frameNum, long maxGap=IMAGESEQ_MAX_GAP) const;
+
+	// missing frames within r
+	std::vector<Range> GapsIn(const Range &r) const;
+};
+
+#endif // IMAGESEQUENCE_H
@@ -29,6 +29,11 @@
 //-----------------------------------------------------------------------------
 
 #include "mainwindow.h"
+#include "batchmode.h"
+#include "dpxunpack.h"
+
+#include <cstring>
+#include <iostream>
 
 #include <QApplication>
 #include <QtPlugin>
@@ -73,6 +78,17 @@ public:
 
 int main(int argc, char *argv[])
 {
+    // report DPX unpacking throughput on this machine and quit
+    if(argc > 1 && strcmp(argv[1], "--benchmark-unpack") == 0)
+    {
+        DPXUnpackBenchmark(std::cout);
+        return 0;
+    }
+
+    // headless extraction/export; see batchmode.h
+    if(argc > 1 && strcmp(argv[1], "--batch") == 0)
+        return BatchMain(argc, argv);
+
     VBApplication a(argc, argv);
 
     for(int i=0; i<argc; i++) std::cerr << i << ": " << argv[i] << "\n";
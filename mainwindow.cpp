@@ -80,10 +80,15 @@
 #include <fcntl.h>
 #include <stdlib.h>
 
+#include <atomic>
+#include <chrono>
 #include <csetjmp>
 #include <csignal>
+#include <thread>
 
 #include "eventdialog.h"
+#include "extractdialog.h"
+#include "extractjob.h"
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "project.h"
@@ -94,38 +99,6 @@
 #include "propertiesdialog.h"
 //#include "table_window.h"
 
-#ifdef USE_MUX_HACK
-#include <stdlib.h>
-#include <stdio.h>
-#include <string.h>
-#include <math.h>
-extern "C"
-{
-#include <libavutil/avassert.h>
-#include <libavutil/channel_layout.h>
-#include <libavutil/opt.h>
-#include <libavutil/mathematics.h>
-#include <libavformat/avformat.h>
-#include <libswscale/swscale.h>
-#include <libswresample/swresample.h>
-}
-
-// The av_err2str(n) macro uses the C99 compound literal construct, which
-// MSVC does not understand.
-// Ref: https://ffmpeg.zeranoe.com/forum/viewtopic.php?t=4220
-// Ref: https://stackoverflow.com/questions/3869963/compound-literals-in-msvc
-#ifdef Q_CC_MSVC
-#define local_av_err2str(n) "MSVC Cannot Show This Error"
-#else
-//#define local_av_err2str(n) av_err2str(n)
-#define local_av_err2str(errnum) \
-    av_make_error_string((char*)__builtin_alloca(AV_ERROR_MAX_STRING_SIZE), \
-    AV_ERROR_MAX_STRING_SIZE, errnum)
-#endif
-
-
-#endif // ifdef USE_MUX_HACK
-
 extern "C" void SegvHandler(int param);
 static jmp_buf segvJumpEnv;
 static long lastFrameLoad = 0;
@@ -396,22 +369,6 @@ MainWindow::MainWindow(QWidget *parent) :
     // start log with timestamp
     Log() << QDateTime::currentDateTime().toString() << "\n";
 
-    isVideoMuxingRisky = false;
-
-#ifdef USE_MUX_HACK
-    encStartFrame = 0;
-    encNumFrames = 0;
-    encCurFrame = 0;
-
-    encVideoBufSize = 0;
-
-    encRGBFrame = NULL;
-    encS16Frame = NULL;
-
-    encAudioLen = 0;
-    encAudioNextPts = 0;
-#endif
-
     playtimer.setTimerType(Qt::PreciseTimer);
     SetPlaybackInterval();
     connect(&playtimer,SIGNAL(timeout()),this,SLOT(playslot()));
@@ -455,12 +412,14 @@ void MainWindow::playslot()
 
 void MainWindow::frameforward()
 {
+    prefetcher.SetDirection(1);
     if(ui->frame_numberSpinBox->value() < ui->frame_numberSpinBox->maximum())
         ui->frame_numberSpinBox->setValue(ui->frame_numberSpinBox->value()+1);
     qDebug()<<"trigger forward";
 }
 void MainWindow::framebackward()
 {
+    prefetcher.SetDirection(-1);
     if(ui->frame_numberSpinBox->value() > ui->frame_numberSpinBox->minimum())
         ui->frame_numberSpinBox->setValue(ui->frame_numberSpinBox->value()-1);
     qDebug()<<"trigger backward";
@@ -1002,21 +961,36 @@ bool MainWindow::Load_Frame_Texture(int frame_num)
 
     traceCurrentOperation = "Retrieving scan image";
 
+    const FrameTexture *frameTex;
     if (frame_num>=0 && frame_num<scan.inFile.LastFrame())
     {
-    currentFrameTexture = this->scan.inFile.GetFrameImage(
-                this->scan.inFile.FirstFrame()+frame_num, currentFrameTexture);
+    const std::string source = this->scan.inFile.GetFileName();
+    const long frameNum = this->scan.inFile.FirstFrame()+frame_num;
+
+    frameTex = frameCache.Find(source, frameNum);
+    if(frameTex == NULL)
+    {
+        currentFrameTexture = this->prefetcher.GetFrameImage(frameNum,
+                currentFrameTexture);
+        frameTex = frameCache.Insert(source, frameNum, currentFrameTexture);
+        if(frameTex == NULL) frameTex = currentFrameTexture;
+    }
+    else
+        this->prefetcher.Seek(frameNum);
     traceCurrentOperation = "Loading scan into texture";
     }
     else
     {
 
+    frame_window->trackFrame = -1;
     frame_window->load_frame_texture(&blankframe);
 
         frame_window->renderNow();
     return true;
     }
- frame_window->load_frame_texture(currentFrameTexture);
+ frame_window->overlapTrack = &vbscan.overlapTrack;
+ frame_window->trackFrame = this->scan.inFile.FirstFrame()+frame_num;
+ frame_window->load_frame_texture(frameTex);
 
     /*
     traceCurrentOperation = "Freeing texture buffer";
@@ -1118,9 +1092,51 @@ bool MainWindow::NewSource(QString filename, SourceFormat ft)
 
     try
     {
+        traceCurrentOperation = "Stopping frame prefetch";
+        prefetcher.SetSource(NULL);
+        if(frameCache.Hits() + frameCache.Misses() > 0)
+        {
+            Log() << "Frame cache: " << frameCache.Hits() << " hits, "
+                << frameCache.Misses() << " misses, "
+                << frameCache.Evictions() << " evictions ("
+                << int(frameCache.HitRate() * 100) << "% hit rate)\n";
+        }
+        frameCache.Unpin();
+        frameCache.Clear();
+        frameCache.ResetCounters();
         traceCurrentOperation = "Opening Source";
         this->scan.SourceScan(filename.toStdString(), ft);
         traceCurrentOperation = "Verifying scan is ready";
+        if(this->scan.inFile.IsReady() && !this->scan.inFile.Gaps().empty())
+        {
+            // missing frames are shown as the frame before them; say where
+            QString gapList;
+            long missing(0);
+            for(const auto &gap : this->scan.inFile.Gaps())
+            {
+                missing += gap.second - gap.first + 1;
+                Log() << "Missing frames " << gap.first << "-" << gap.second
+                    << "\n";
+                if(gapList.count('\n') < 10)
+                    gapList += QString("%1-%2\n").arg(gap.first).arg(gap.second);
+            }
+            QMessageBox::warning(this, APP_NAME,
+                QString("%1 frames are missing from the sequence and will be "
+                        "shown as the frame before each gap:\n\n%2")
+                    .arg(missing).arg(gapList));
+        }
+        if(this->scan.inFile.IsReady() &&
+                !this->scan.inFile.DPXIndex().Mismatched().empty())
+        {
+            const std::vector<long> &mismatched =
+                this->scan.inFile.DPXIndex().Mismatched();
+            for(long frame : mismatched)
+                Log() << "Frame " << frame << " differs from the first frame\n";
+            QMessageBox::warning(this, APP_NAME,
+                QString("%1 frames (the first is frame %2) differ in size, bit "
+                        "depth or packing from the first frame of the "
+                        "sequence.").arg(mismatched.size()).arg(mismatched[0]));
+        }
         if(this->scan.inFile.IsReady())
         {
             if(frame_window)
@@ -1206,6 +1222,8 @@ bool MainWindow::NewSource(QString filename, SourceFormat ft)
             // enable the rest of the UI that was waiting until a project loaded
             ui->actionSave_Settings->setEnabled(true);
             ui->actionProperties->setEnabled(true);
+            ui->actionMeasure_Overlaps->setEnabled(true);
+            ui->actionExport_Video->setEnabled(true);
             ui->actionShow_Overlap->setEnabled(true);
             ui->actionShow_Soundtrack_Only->setEnabled(true);
             ui->actionWaveform_Zoom->setEnabled(true);
@@ -1221,6 +1239,19 @@ bool MainWindow::NewSource(QString filename, SourceFormat ft)
 
             traceCurrentOperation = "Updating GPU params";
             GPU_Params_Update(0);
+            traceCurrentOperation = "Starting frame prefetch";
+            QSettings settings;
+            settings.beginGroup("playback");
+            prefetcher.SetDepth(settings.value("prefetch-depth",
+                PREFETCH_DEFAULT_DEPTH).toInt());
+            prefetcher.SetThreadCount(settings.value("prefetch-threads",
+                PREFETCH_DEFAULT_THREADS).toInt());
+            frameCache.SetBudget(size_t(settings.value("frame-cache-mb",
+                qulonglong(FRAMECACHE_DEFAULT_BUDGET >> 20)).toULongLong())
+                << 20);
+            settings.endGroup();
+            prefetcher.SetSource(&(this->scan.inFile));
+
             traceCurrentOperation = "Displaying first frame";
 
             Load_Frame_Texture(0);
@@ -1338,7 +1369,17 @@ bool MainWindow::saveproject(QTextStream &out)
 
 bool MainWindow::OpenProject(QString fn)
 {
-    if(!vbscan.load(fn)) return false;
+    QProgressDialog progress("Loading project...", QString(), 0, 100, this);
+    progress.setWindowTitle("Open Project");
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+
+    bool loaded = vbscan.load(fn,
+        [&progress](qint64 done, qint64 total) {
+            progress.setValue(total ? int((100*done)/total) : 100); });
+
+    progress.reset();
+    if(!loaded) return false;
 
     float overlap_start = vbscan.overlap_framestart;
     float overlap_end = vbscan.overlap_frameend;
@@ -1830,6 +1871,12 @@ void MainWindow::on_frame_numberSpinBox_valueChanged(int arg1)
     qDebug()<<"This Frame: " <<arg1;
     frame_window->fbm->displayCurrentBuckets();
     QPair<QList<int>, QList<int>> frameloadinfo= frame_window->fbm->getNeededFrameNumbers(arg1);
+
+    // keep the bucket window in RAM while the user scrubs around it
+    const int radius = frame_window->fbm->windowRadius();
+    frameCache.Pin(scan.inFile.GetFileName(),
+                   scan.inFile.FirstFrame() + arg1 - radius,
+                   scan.inFile.FirstFrame() + arg1 + radius);
     qDebug()<<(frameloadinfo.first);
     qDebug()<<(frameloadinfo.second);
 
@@ -1879,1131 +1926,140 @@ void MainWindow::on_HeightCalculateBtn_clicked()
 }
 
 
-
-bool MainWindow::extractGL(QString filename=QString(), bool doTimer=false)
-{
-    bool batch = true;
-    return batch;
-}
-
-
-#ifdef USE_MUX_HACK
-//----------------------------------------------------------------------------
-//---------------------- MUX.C -----------------------------------------------
 //----------------------------------------------------------------------------
-/*
- * Copyright (c) 2003 Fabrice Bellard
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy
- * of this software and associated documentation files (the "Software"), to deal
- * in the Software without restriction, including without limitation the rights
- * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
- * copies of the Software, and to permit persons to whom the Software is
- * furnished to do so, subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in
- * all copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
- * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
- * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
- * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
- * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
- * THE SOFTWARE.
- */
-
-/**
- * @file
- * libavformat API example.
- *
- * Output a media file in any supported libavformat format. The default
- * codecs are used.
- * @example muxing.c
- */
-
-#define STREAM_DURATION   10.0
-#define STREAM_PIX_FMT    AV_PIX_FMT_YUV420P /* default pix_fmt */
-
-#define RGB_PIX_FMT       AV_PIX_FMT_RGBA
-
-#define SCALE_FLAGS SWS_BICUBIC
-
-bool MainWindow::EnqueueNextFrame()
-{
-    if(this->encCurFrame > this->encNumFrames) return false;
-
-    traceCurrentOperation = "Load Texture";
-
-    av_log(NULL, AV_LOG_INFO, "encStartFrame = %ld\n", this->encStartFrame);
-    av_log(NULL, AV_LOG_INFO, "encCurFrame = %ld\n", this->encCurFrame);
-
-    long framenum = this->encStartFrame + this->encCurFrame;
-
-    av_log(NULL, AV_LOG_INFO, "framenum = %ld\n", framenum);
-
-    if(framenum > this->scan.inFile.NumFrames()-1)
-    {
-        // TODO: correct the sound array allocation steps above
-        // so that we don't have to load the final frame twice
-        av_log(NULL, AV_LOG_INFO, "Load_Frame_Texture(%ld)\n", framenum-1);
-        if(!Load_Frame_Texture(framenum - 1)) return false;
-    }
-    else
-    {
-        av_log(NULL, AV_LOG_INFO, "Load_Frame_Texture(%ld)\n", framenum);
-        if(!Load_Frame_Texture(framenum)) return false;
-    }
-
-    // XXX: Warning: this reads to vo.videobuffer instead -- do not change
-    // the argument expecting it to work.
-    av_log(NULL, AV_LOG_INFO, "this->frame_window->read_frame_texture(this->outputFrameTexture)\n");
-    this->frame_window->read_frame_texture(this->outputFrameTexture);
-
-    av_log(NULL, AV_LOG_INFO, "p = new uint8_t[%ld]\n", this->encVideoBufSize);
-    uint8_t *p = new uint8_t[this->encVideoBufSize];
-    av_log(NULL, AV_LOG_INFO, "memcpy(p, this->frame_window->vo.videobuffer, this->encVideoBufSize)\n");
-    memcpy(p, this->frame_window->vo.videobuffer, this->encVideoBufSize);
-    av_log(NULL, AV_LOG_INFO, "enqueue p = %p into this->encVideoQueue\n", p);
-    this->encVideoQueue.push(p);
-
-    // update audio signal render buffer length
-    this->encAudioLen += this->frame_window->samplesperframe_file;
-    av_log(NULL, AV_LOG_INFO, "audio render len = %lu\n", (unsigned long)(this->encAudioLen));
-
-    this->encCurFrame++;
-
-    return true;
-}
-
-uint8_t *MainWindow::GetVideoFromQueue()
-{
-    uint8_t *p;
-
-    av_log(NULL, AV_LOG_INFO, "encVideoQueue.empty() = %c\n", encVideoQueue.empty()?'T':'F');
-    av_log(NULL, AV_LOG_INFO, "encVideoQueue.size() = %lu\n", encVideoQueue.size());
-
-    if(this->encVideoQueue.empty())
-    {
-        if(!EnqueueNextFrame()) return NULL;
-    }
-    p = this->encVideoQueue.front();
-    this->encVideoQueue.pop();
-
-    av_log(NULL, AV_LOG_INFO, "return p = %p\n", p);
-    return p;
-}
-
-AVFrame *MainWindow::GetAudioFromQueue()
-{
-    const int nbits=16;
-
-    while(this->encS16Frame->pts + this->encS16Frame->nb_samples > this->encAudioLen)
-    {
-        if(!EnqueueNextFrame()) return NULL;
-    }
-
-    int64_t offset = this->encAudioNextPts - this->encAudioPad;
-    av_log(NULL, AV_LOG_INFO, "audio render offset = %lld\n", offset);
-    av_log(NULL, AV_LOG_INFO, "audio render len = %lld\n", this->encAudioLen);
-
-    if(this->encS16Frame->channels != 2)
-        throw vfbexception("sound must be stereo");
-
-    int16_t *samples = (int16_t *)(this->encS16Frame->data[0]);
-    int s = 0;
-
-    int16_t v;
+// Render frames [startFrame, startFrame+numFrames) with the soundtrack the
+// frame window reads from them into fn. vidFrameOffset > 0 drops that many
+// frames of picture from the start to sync it to the sound; < 0 drops that
+// many frames of sound instead. Each frame's picture and samples are read
+// back while the next one renders. Returns false if the user cancelled.
+bool MainWindow::ExportVideo(const QString &fn, const ExportSettings &settings,
+                             long startFrame, long numFrames,
+                             long vidFrameOffset, QProgressDialog &progress)
+{
+    if (frame_window == NULL)
+        throw vfbexception("No frame window to render the video");
+
+    // the frame window renders samplesperframe_file samples a frame, which
+    // sets the sampling rate
+    ExportSettings s = settings;
+    s.frameRate = ui->frameRateSpinBox->value();
+    s.samplingRate = frame_window->samplesperframe_file * s.frameRate;
+
+    ExportSession session;
+    session.Open(fn, s);
+
+    if (outputFrameTexture == NULL)
+        outputFrameTexture = new FrameTexture;
+    outputFrameTexture->width = s.width;
+    outputFrameTexture->height = s.height;
+    frame_window->PrepareVideoOutput(outputFrameTexture);
+    frame_window->PrepareRecording();
+    frame_window->is_videooutput = true;
+    frame_window->is_rendering = true;
+
+    const int spf = frame_window->samplesperframe_file;
+    long skipVideo = std::max(0L, vidFrameOffset);
+    long skipAudio = std::max(0L, -vidFrameOffset);
+    uint8_t *picture = NULL;  // the previous frame's, being read back
+    uint8_t *rendered = NULL; // this frame's
+    int64_t sound = -1;       // ring position of the previous frame's samples
+    bool cancelled = false;
+    std::exception_ptr error;
 
-    if(offset < 0)
-    {
-        for(int i = 0; i<this->encS16Frame->nb_samples; ++i)
-        {
-            for(int c = 0; c < this->encS16Frame->channels; ++c)
-            {
-                samples[s++] = 0;
-            }
-        }
-        av_log(NULL, AV_LOG_INFO, "Silence written nb_samples = %d x%d\n",
-               this->encS16Frame->nb_samples, this->encS16Frame->channels);
-    }
-    else
+    try
     {
-        // translate the floating point values to S16:
-        float **audio = this->frame_window->FileRealBuffer;
-        av_log(NULL, AV_LOG_INFO, "audio = FileRealBuffer = [%p,%p]\n",
-               audio[0], audio[1]);
-        av_log(NULL, AV_LOG_INFO, "Audio copy nb_samples = %d x%d\n",
-               this->encS16Frame->nb_samples, this->encS16Frame->channels);
-        for(int i = 0; i<this->encS16Frame->nb_samples; ++i)
+        for (long i = 0; i <= numFrames; ++i)
         {
-            for(int c = 0; c < this->encS16Frame->channels; ++c)
-            {
-                //av_log(NULL, AV_LOG_INFO, "reading audio[%d][%lld]\n", c, offset+i);
-                v = int32_t(
-                            (audio[c][offset+i]*UMAX(nbits))-(UMAX(nbits)/2));
-                //av_log(NULL, AV_LOG_INFO, "writing samples[%d]\n", s);
-                samples[s++] = v;
-            }
-        }
-        av_log(NULL, AV_LOG_INFO, "Audio copied nb_samples = %d x%d\n",
-               this->encS16Frame->nb_samples, this->encS16Frame->channels);
-    }
+            int64_t renderedSound = -1;
 
-    this->encS16Frame->pts = this->encAudioNextPts;
-    this->encAudioNextPts += this->encS16Frame->nb_samples;
-
-    return this->encS16Frame;
-}
-
-static void log_packet(const AVFormatContext *fmt_ctx, const AVPacket *pkt)
-{
-#if 0
-    AVRational *time_base = &fmt_ctx->streams[pkt->stream_index]->time_base;
-
-    printf("pts:%s pts_time:%s dts:%s dts_time:%s duration:%s duration_time:%s stream_index:%d\n",
-           av_ts2str(pkt->pts), av_ts2timestr(pkt->pts, time_base),
-           av_ts2str(pkt->dts), av_ts2timestr(pkt->dts, time_base),
-           av_ts2str(pkt->duration), av_ts2timestr(pkt->duration, time_base),
-           pkt->stream_index);
-#endif
-}
-
-static int write_frame(AVFormatContext *fmt_ctx, const AVRational *time_base, AVStream *st, AVPacket *pkt)
-{
-    /* rescale output packet timestamp values from codec to stream timebase */
-    av_packet_rescale_ts(pkt, *time_base, st->time_base);
-    pkt->stream_index = st->index;
-
-    /* Write the compressed frame to the media file. */
-    log_packet(fmt_ctx, pkt);
-    return av_interleaved_write_frame(fmt_ctx, pkt);
-}
-
-/* Add an output stream. */
-static void add_stream(OutputStream *ost, AVFormatContext *oc,
-                       AVCodec **codec,
-                       enum AVCodecID codec_id)
-{
-    AVCodecContext *c;
-    int i;
-
-    /* find the encoder */
-    *codec = avcodec_find_encoder(codec_id);
-    if (!(*codec)) {
-        fprintf(stderr, "Could not find encoder for '%s'\n",
-                avcodec_get_name(codec_id));
-        exit(1);
-    }
-
-    // allocid: MainWindowStream01
-    ost->st = avformat_new_stream(oc, *codec);
-    if (!ost->st) {
-        fprintf(stderr, "Could not allocate stream\n");
-        exit(1);
-    }
-    av_log(NULL, AV_LOG_INFO,
-           "ALLOC new: MainWindowStream01 ost->st->codec = %p\n",
-           ost->st->codec);
-    ost->st->id = oc->nb_streams-1;
-    c = ost->st->codec;
+            if (i < numFrames)
+            {
+                long frameNum = std::min(startFrame + i,
+                                         long(scan.inFile.NumFrames()) - 1);
+                int64_t recorded = frame_window->SamplesRecorded();
 
-    switch ((*codec)->type) {
-    case AVMEDIA_TYPE_AUDIO:
-        c->sample_fmt  = (*codec)->sample_fmts ?
-                    (*codec)->sample_fmts[0] : AV_SAMPLE_FMT_FLTP;
-        c->bit_rate    = 64000;
+                traceCurrentOperation = "Export frame";
+                if (!Load_Frame_Texture(frameNum))
+                {
+                    cancelled = true;
+                    break;
+                }
+                if (frame_window->SamplesRecorded() > recorded)
+                    renderedSound = recorded % frame_window->RecordingSize();
 
-        if(ost->requestedSamplingRate > 0)
-            c->sample_rate = ost->requestedSamplingRate;
-        else
-            c->sample_rate = 44100;
-
-        /* Ugh. Why would you override your setting as soon as you set it?
-         *
-        if ((*codec)->supported_samplerates) {
-            c->sample_rate = (*codec)->supported_samplerates[0];
-            for (i = 0; (*codec)->supported_samplerates[i]; i++) {
-                if ((*codec)->supported_samplerates[i] == 44100)
-                    c->sample_rate = 44100;
+                if (session.HasVideo())
+                {
+                    rendered = session.AcquireFrame();
+                    frame_window->read_frame_texture(outputFrameTexture,
+                                                     rendered);
+                }
             }
-        }
-        */
 
-        if ((*codec)->channel_layouts) {
-            c->channel_layout = (*codec)->channel_layouts[0];
-            for (i = 0; (*codec)->channel_layouts[i]; i++) {
-                if ((*codec)->channel_layouts[i] == AV_CH_LAYOUT_STEREO)
-                    c->channel_layout = AV_CH_LAYOUT_STEREO;
+            if (picture)
+            {
+                uint8_t *p = picture;
+                picture = NULL;
+                frame_window->WaitForReadback(p);
+                if (skipVideo > 0)
+                {
+                    session.ReleaseFrame(p);
+                    --skipVideo;
+                }
+                else
+                    session.SubmitFrame(p);
             }
-        }
-        else
-            c->channel_layout = AV_CH_LAYOUT_STEREO;
-
-        c->channels = av_get_channel_layout_nb_channels(c->channel_layout);
-
-        ost->st->time_base.num = 1;
-        ost->st->time_base.den = c->sample_rate;
-        break;
-
-    case AVMEDIA_TYPE_VIDEO:
-        c->codec_id = codec_id;
-
-        c->bit_rate = 400000;
-        /* Resolution must be a multiple of two. */
-        if(ost->requestedWidth > 0)
-        {
-            c->width = ost->requestedWidth;
-            c->height = ost->requestedHeight;
-        }
-        else
-        {
-            c->width    = 352;
-            c->height   = 288;
-        }
-
-        c->bit_rate = c->width * c->height * 4;
-
-        /* timebase: This is the fundamental unit of time (in seconds) in terms
-         * of which frame timestamps are represented. For fixed-fps content,
-         * timebase should be 1/framerate and timestamp increments should be
-         * identical to 1. */
-        ost->st->time_base.num = 1;
-        ost->st->time_base.den = ost->requestedTimeBase;
-
-        c->time_base       = ost->st->time_base;
-
-        c->gop_size      = 12; /* emit one intra frame every twelve frames at most */
-        c->pix_fmt       = STREAM_PIX_FMT;
-        if (c->codec_id == AV_CODEC_ID_MPEG2VIDEO) {
-            /* just for testing, we also add B frames */
-            c->max_b_frames = 2;
-        }
-        if (c->codec_id == AV_CODEC_ID_MPEG1VIDEO) {
-            /* Needed to avoid using macroblocks in which some coeffs overflow.
-             * This does not happen with normal video, it just happens here as
-             * the motion of the chroma plane does not match the luma plane. */
-            c->mb_decision = 2;
-        }
-        break;
-
-    default:
-        break;
-    }
-
-#ifndef AV_CODEC_FLAG_GLOBAL_HEADER
-#define AV_CODEC_FLAG_GLOBAL_HEADER CODEC_FLAG_GLOBAL_HEADER
-#endif
-
-    /* Some formats want stream headers to be separate. */
-    if (oc->oformat->flags & AVFMT_GLOBALHEADER)
-        c->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
-}
-
-/**************************************************************/
-/* audio output */
-
-static AVFrame *alloc_audio_frame(enum AVSampleFormat sample_fmt,
-                                  uint64_t channel_layout,
-                                  int sample_rate, int nb_samples)
-{
-    AVFrame *frame = av_frame_alloc();
-    int ret;
-
-    if (!frame) {
-        fprintf(stderr, "Error allocating an audio frame\n");
-        exit(1);
-    }
-
-    frame->format = sample_fmt;
-    frame->channel_layout = channel_layout;
-    frame->sample_rate = sample_rate;
-    frame->nb_samples = nb_samples;
-
-    if (nb_samples) {
-        ret = av_frame_get_buffer(frame, 0);
-        if (ret < 0) {
-            fprintf(stderr, "Error allocating an audio buffer\n");
-            exit(1);
-        }
-    }
-
-    return frame;
-}
-
-static void open_audio(AVFormatContext *oc, AVCodec *codec, OutputStream *ost, AVDictionary *opt_arg)
-{
-    AVCodecContext *c;
-    int nb_samples;
-    int ret;
-    AVDictionary *opt = NULL;
-
-    c = ost->st->codec;
-
-    /* open it */
-    av_dict_copy(&opt, opt_arg, 0);
-    ret = avcodec_open2(c, codec, &opt);
-    av_dict_free(&opt);
-    if (ret < 0) {
-        fprintf(stderr, "Could not open audio codec: %s\n", local_av_err2str(ret));
-        exit(1);
-    }
-
-    /* init signal generator */
-    ost->t     = 0;
-    ost->tincr = 2 * M_PI * 110.0 / c->sample_rate;
-    /* increment frequency by 110 Hz per second */
-    ost->tincr2 = 2 * M_PI * 110.0 / c->sample_rate / c->sample_rate;
-
-#ifndef AV_CODEC_CAP_VARIABLE_FRAME_SIZE
-#define AV_CODEC_CAP_VARIABLE_FRAME_SIZE CODEC_CAP_VARIABLE_FRAME_SIZE
-#endif
-
-    if(c->codec->capabilities & AV_CODEC_CAP_VARIABLE_FRAME_SIZE)
-        nb_samples = 10000;
-    else
-        nb_samples = c->frame_size;
-
-    // allocid: MainWindowFrame01
-    ost->frame     = alloc_audio_frame(c->sample_fmt, c->channel_layout,
-                                       c->sample_rate, nb_samples);
-    av_log(NULL, AV_LOG_INFO, "ALLOC new: MainWindowFrame01 ost->frame = %p\n",
-           ost->frame);
-    // allocid: MainWindowFrame02
-    ost->tmp_frame = alloc_audio_frame(AV_SAMPLE_FMT_S16, c->channel_layout,
-                                       c->sample_rate, nb_samples);
-    av_log(NULL, AV_LOG_INFO,
-           "ALLOC new: MainWindowFrame02 ost->tmp_frame = %p\n",
-           ost->frame);
-
-    /* create resampler context */
-    // allocid: MainWindowSWR01
-    ost->swr_ctx = swr_alloc();
-    if (!ost->swr_ctx) {
-        fprintf(stderr, "Could not allocate resampler context\n");
-        exit(1);
-    }
-    av_log(NULL, AV_LOG_INFO, "ALLOC new: MainWindowSWR01 ost->swr_ctx = %p\n",
-           ost->swr_ctx);
-
-    /* set options */
-    av_opt_set_int       (ost->swr_ctx, "in_channel_count",   c->channels,       0);
-    av_opt_set_int       (ost->swr_ctx, "in_sample_rate",     c->sample_rate,    0);
-    av_opt_set_sample_fmt(ost->swr_ctx, "in_sample_fmt",      AV_SAMPLE_FMT_S16, 0);
-    av_opt_set_int       (ost->swr_ctx, "out_channel_count",  c->channels,       0);
-    av_opt_set_int       (ost->swr_ctx, "out_sample_rate",    c->sample_rate,    0);
-    av_opt_set_sample_fmt(ost->swr_ctx, "out_sample_fmt",     c->sample_fmt,     0);
-
-    /* initialize the resampling context */
-    if ((ret = swr_init(ost->swr_ctx)) < 0) {
-        fprintf(stderr, "Failed to initialize the resampling context\n");
-        exit(1);
-    }
-}
-
-/* Prepare a 16 bit dummy audio frame of 'frame_size' samples and
- * 'nb_channels' channels. */
-AVFrame *MainWindow::get_audio_frame(OutputStream *ost)
-{
-    AVFrame *frame = ost->tmp_frame;
-    int j, i, v;
-    int16_t *q = (int16_t*)frame->data[0];
-    AVRational avr_one;
-    avr_one.num = avr_one.den = 1;
-
-    /* check if we want to generate more frames */
-    if (av_compare_ts(ost->next_pts, ost->st->codec->time_base,
-                      STREAM_DURATION, avr_one) >= 0)
-        return NULL;
-
-    av_log(NULL, AV_LOG_INFO, "Audio generate nb_samples = %d x%d\n",
-           frame->nb_samples, ost->st->codec->channels);
-    for (j = 0; j <frame->nb_samples; j++) {
-        v = (int)(sin(ost->t) * 10000);
-        for (i = 0; i < ost->st->codec->channels; i++)
-            *q++ = v;
-        ost->t     += ost->tincr;
-        ost->tincr += ost->tincr2;
-    }
-
-    frame->pts = ost->next_pts;
-    ost->next_pts  += frame->nb_samples;
-
-    return frame;
-}
-
-/*
- * encode one audio frame and send it to the muxer
- * return 1 when encoding is finished, 0 otherwise
- */
-int MainWindow::write_audio_frame(AVFormatContext *oc, OutputStream *ost)
-{
-    AVCodecContext *c;
-    AVPacket pkt; // data and size must be 0;
-    pkt.data = NULL;
-    pkt.size = 0;
-    AVFrame *frame;
-    int ret;
-    int got_packet = 0;
-    int dst_nb_samples;
-
-    av_init_packet(&pkt);
-    c = ost->st->codec;
-
-#if 0
-    frame = get_audio_frame(ost);
-#else
-    av_log(NULL, AV_LOG_INFO, "frame = this->GetAudioFromQueue()\n");
-    frame = this->GetAudioFromQueue();
-    av_log(NULL, AV_LOG_INFO, "frame = %p\n", frame);
-#endif
-
-    if (frame) {
-        /* convert samples from native format to destination codec format, using the resampler */
-        /* compute destination number of samples */
-        av_log(NULL, AV_LOG_INFO, "dst_nb_samples = av_rescale_rnd(...)\n");
-        dst_nb_samples = av_rescale_rnd(
-                    swr_get_delay(ost->swr_ctx, c->sample_rate) + frame->nb_samples,
-                    c->sample_rate, c->sample_rate, AV_ROUND_UP);
-        av_assert0(dst_nb_samples == frame->nb_samples);
-
-        /* when we pass a frame to the encoder, it may keep a reference to it
-         * internally;
-         * make sure we do not overwrite it here
-         */
-        av_log(NULL, AV_LOG_INFO, "av_frame_make_writable(ost->frame)\n");
-        ret = av_frame_make_writable(ost->frame);
-        if (ret < 0)
-            exit(1);
-
-        /* convert to destination format */
-        ret = swr_convert(ost->swr_ctx,
-                          ost->frame->data, dst_nb_samples,
-                          (const uint8_t **)frame->data, frame->nb_samples);
-        if (ret < 0) {
-            fprintf(stderr, "Error while converting\n");
-            exit(1);
-        }
-        frame = ost->frame;
-
-        AVRational r;
-        r.num = 1;
-        r.den = c->sample_rate;
-
-        frame->pts = av_rescale_q(ost->samples_count, r, c->time_base);
-        ost->samples_count += dst_nb_samples;
-
-        ret = avcodec_encode_audio2(c, &pkt, frame, &got_packet);
-        if (ret < 0) {
-            fprintf(stderr, "Error encoding audio frame: %s\n", local_av_err2str(ret));
-            exit(1);
-        }
-
-        if (got_packet) {
-            ret = write_frame(oc, &c->time_base, ost->st, &pkt);
-            if (ret < 0) {
-                fprintf(stderr, "Error while writing audio frame: %s\n",
-                        local_av_err2str(ret));
-                exit(1);
+            if (sound >= 0)
+            {
+                float **audio = frame_window->FileRealBuffer;
+                for (int c = 0; c < 2; ++c)
+                    frame_window->WaitForReadback(&audio[c][sound],
+                                                  spf * sizeof(float));
+                if (skipAudio > 0)
+                    --skipAudio;
+                else
+                    session.Write(&audio[0][sound], &audio[1][sound], spf);
             }
-        }
-    }
-
-    return (frame || got_packet) ? 0 : 1;
-}
-
-/**************************************************************/
-/* video output */
-
-static AVFrame *alloc_picture(enum AVPixelFormat pix_fmt, int width, int height)
-{
-    AVFrame *picture;
-    int ret;
-
-    picture = av_frame_alloc();
-    if (!picture)
-        return NULL;
-
-    picture->format = pix_fmt;
-    picture->width  = width;
-    picture->height = height;
-
-    /* allocate the buffers for the frame data */
-    ret = av_frame_get_buffer(picture, 32);
-    if (ret < 0) {
-        fprintf(stderr, "Could not allocate frame data.\n");
-        exit(1);
-    }
-
-    return picture;
-}
-
-static void open_video(AVFormatContext *oc, AVCodec *codec, OutputStream *ost, AVDictionary *opt_arg)
-{
-    int ret;
-    AVCodecContext *c = ost->st->codec;
-    AVDictionary *opt = NULL;
-
-    av_log(NULL, AV_LOG_INFO, "av_dict_copy(&opt, opt_arg, 0)\n");
-    av_dict_copy(&opt, opt_arg, 0);
-
-    /* open the codec */
-    av_log(NULL, AV_LOG_INFO, "ret = avcodec_open2(c, codec, &opt)\n");
-    ret = avcodec_open2(c, codec, &opt);
-    av_dict_free(&opt);
-    if (ret < 0) {
-        fprintf(stderr, "Could not open video codec: %s\n", local_av_err2str(ret));
-        exit(1);
-    }
-
-    /* allocate and init a re-usable frame */
-    av_log(NULL, AV_LOG_INFO, "ost->frame = alloc_picture(c->pix_fmt, %d, %d)\n",c->width, c->height);
-    // allocid: MainWindowFrame03
-    ost->frame = alloc_picture(c->pix_fmt, c->width, c->height);
-    if (!ost->frame) {
-        fprintf(stderr, "Could not allocate video frame\n");
-        exit(1);
-    }
-    av_log(NULL, AV_LOG_INFO, "ALLOC new: MainWindowFrame03 ost->frame = %p\n",
-           ost->frame);
-
-    /* If the output format is not RGBA, then a temporary RGBA
-     * picture is needed too. It is then converted to the required
-     * output format. */
-    ost->tmp_frame = NULL;
-    if(1 || c->pix_fmt != AV_PIX_FMT_RGBA)
-    {
-        av_log(NULL, AV_LOG_INFO, "ost->tmp_frame = alloc_picture(AV_PIX_FMT_YUV420P, %d, %d)\n",c->width, c->height);
-        // allocid: MainWindowFrame04
-        ost->tmp_frame = alloc_picture(AV_PIX_FMT_YUV420P, c->width, c->height);
-        if (!ost->tmp_frame) {
-            fprintf(stderr, "Could not allocate temporary picture\n");
-            exit(1);
-        }
-        av_log(NULL, AV_LOG_INFO,
-               "ALLOC new: MainWindowFrame04 ost->tmp_frame = %p\n",
-               ost->tmp_frame);
-    }
-}
-
-/* Prepare a dummy image. */
-static void fill_yuv_image(AVFrame *pict, int frame_index,
-                           int width, int height)
-{
-    int x, y, i, ret;
-
-    /* when we pass a frame to the encoder, it may keep a reference to it
-     * internally;
-     * make sure we do not overwrite it here
-     */
-    ret = av_frame_make_writable(pict);
-    if (ret < 0)
-        exit(1);
-
-    i = frame_index;
-
-    /* Y */
-    for (y = 0; y < height; y++)
-        for (x = 0; x < width; x++)
-            pict->data[0][y * pict->linesize[0] + x] = x + y + i * 3;
-
-    /* Cb and Cr */
-    for (y = 0; y < height / 2; y++) {
-        for (x = 0; x < width / 2; x++) {
-            pict->data[1][y * pict->linesize[1] + x] = 128 + y + i * 2;
-            pict->data[2][y * pict->linesize[2] + x] = 64 + x + i * 5;
-        }
-    }
-}
-
-/* Prepare a dummy image. */
-static void fill_rgba_image(AVFrame *pict, int frame_index,
-                            int width, int height)
-{
-    int x, y, i, ret;
-
-    /* when we pass a frame to the encoder, it may keep a reference to it
-     * internally;
-     * make sure we do not overwrite it here
-     */
-    av_log(NULL, AV_LOG_INFO, "av_frame_make_writable(pict)\n");
-    ret = av_frame_make_writable(pict);
-    if (ret < 0)
-        exit(1);
 
-    i = frame_index;
+            picture = rendered;
+            rendered = NULL;
+            sound = renderedSound;
 
-    av_log(NULL, AV_LOG_INFO, "pict->channels: %d\n", pict->channels);
-    av_log(NULL, AV_LOG_INFO, "pict->data[0]: %p\n", pict->data[0]);
-    av_log(NULL, AV_LOG_INFO, "pict->data[1]: %p\n", pict->data[1]);
-    av_log(NULL, AV_LOG_INFO, "pict->data[2]: %p\n", pict->data[2]);
-    av_log(NULL, AV_LOG_INFO, "pict->data[3]: %p\n", pict->data[3]);
-
-    av_log(NULL, AV_LOG_INFO, "fill RGBA\n");
-    uint8_t *p;
-    for (y = 0; y < height; y++)
-    {
-        for (x = 0; x < width; x++)
-        {
-            p = pict->data[0] + (y * pict->linesize[0] + x*4);
-            p[0] = x + y + i * 3;
-            p[1] = 255;
-            p[2] = 0;
-            p[3] = 255;
-        }
-    }
-}
-
-
-AVFrame *MainWindow::get_video_frame(OutputStream *ost)
-{
-    AVCodecContext *c = ost->st->codec;
-
-#if 0
-    /* check if we want to generate more frames */
-    if (av_compare_ts(ost->next_pts, ost->st->codec->time_base,
-                      STREAM_DURATION, (AVRational){ 1, 1 }) >= 0)
-        return NULL;
-
-    if (1 || c->pix_fmt != AV_PIX_FMT_YUV420P) {
-        /* as we only generate a YUV420P picture, we must convert it
-         * to the codec pixel format if needed */
-        if (!ost->sws_ctx) {
-            ost->sws_ctx = sws_getContext(c->width, c->height,
-                                          AV_PIX_FMT_YUV420P,
-                                          c->width, c->height,
-                                          c->pix_fmt,
-                                          SCALE_FLAGS, NULL, NULL, NULL);
-            if (!ost->sws_ctx) {
-                fprintf(stderr,
-                        "Could not initialize the conversion context\n");
-                exit(1);
-            }
-        }
-        fill_yuv_image(ost->tmp_frame, ost->next_pts, c->width, c->height);
-        sws_scale(ost->sws_ctx,
-                  (const uint8_t * const *)ost->tmp_frame->data, ost->tmp_frame->linesize,
-                  0, c->height, ost->frame->data, ost->frame->linesize);
-    } else {
-        fill_yuv_image(ost->frame, ost->next_pts, c->width, c->height);
-    }
-    //#elif 0
-    /* check if we want to generate more frames */
-    if (av_compare_ts(ost->next_pts, ost->st->codec->time_base,
-                      STREAM_DURATION, (AVRational){ 1, 1 }) >= 0)
-        return NULL;
-
-    if (1 || c->pix_fmt != AV_PIX_FMT_RGBA) {
-        /* as we only generate a RGBA picture, we must convert it
-         * to the codec pixel format if needed */
-        if (!ost->sws_ctx) {
-            av_log(NULL, AV_LOG_INFO, "sws_getContext(...)\n");
-            ost->sws_ctx = sws_getContext(c->width, c->height,
-                                          RGB_PIX_FMT,
-                                          c->width, c->height,
-                                          c->pix_fmt,
-                                          SCALE_FLAGS, NULL, NULL, NULL);
-            if (!ost->sws_ctx) {
-                fprintf(stderr,
-                        "Could not initialize the conversion context\n");
-                exit(1);
+            progress.setValue(int(i));
+            if (progress.wasCanceled())
+            {
+                this->requestCancel = true;
+                cancelled = true;
+                break;
             }
         }
-        av_log(NULL, AV_LOG_INFO, "fill_rgba_image(encRGBFrame, ost->next_pts, c->width, c->height);\n");
-        fill_rgba_image(encRGBFrame, ost->next_pts, c->width, c->height);
-        av_log(NULL, AV_LOG_INFO, "sws_scale(...)\n");
-        sws_scale(ost->sws_ctx,
-                  (const uint8_t * const *)encRGBFrame->data, encRGBFrame->linesize,
-                  0, c->height, ost->frame->data, ost->frame->linesize);
-    } else {
-        fill_rgba_image(ost->frame, ost->next_pts, c->width, c->height);
-    }
-#else
-    /* check if we have more frames */
-    uint8_t *buf;
-
-    // discard the first few frames of video in order to sync to audio
-    while(this->encVideoSkip >0)
-    {
-        av_log(NULL, AV_LOG_INFO, "videoSkip: buf = GetVideoFromQueue()\n");
-        buf = GetVideoFromQueue();
-        if(buf==NULL) return NULL;
-        delete [] buf;
-        this->encVideoSkip--;
-    }
-
-    av_log(NULL, AV_LOG_INFO, "buf = GetVideoFromQueue()\n");
-    buf = GetVideoFromQueue();
-    if(buf==NULL) return NULL;
-
-    if(!ost->sws_ctx)
-    {
-        av_log(NULL, AV_LOG_INFO, "sws_getContext(...)\n");
-        // allocid: MainWindowSWS01
-        ost->sws_ctx = sws_getContext(c->width, c->height,
-                                      RGB_PIX_FMT,
-                                      c->width, c->height,
-                                      c->pix_fmt,
-                                      SCALE_FLAGS, NULL, NULL, NULL);
-        if(!ost->sws_ctx)
-            throw vfbexception("Could not initialize sws_ctx");
-        av_log(NULL, AV_LOG_INFO,
-               "ALLOC new: MainWindowSWS01 ost->sws_ctx = %p\n",
-               ost->sws_ctx);
     }
-
-    uint8_t **bufHandle = &buf;
-
-    av_frame_make_writable(ost->frame);
-    av_log(NULL, AV_LOG_INFO, "sws_scale(...)\n");
-    sws_scale(ost->sws_ctx,
-              (const uint8_t * const *)bufHandle, encRGBFrame->linesize,
-              0, c->height, ost->frame->data, ost->frame->linesize);
-
-    delete [] buf;
-
-#endif
-
-    ost->frame->pts = ost->next_pts++;
-
-    return ost->frame;
-}
-
-/*
- * encode one video frame and send it to the muxer
- * return 1 when encoding is finished, 0 otherwise
- */
-int MainWindow::write_video_frame(AVFormatContext *oc, OutputStream *ost)
-{
-    int ret;
-    AVCodecContext *c;
-    AVFrame *frame;
-    int got_packet = 0;
-    AVPacket pkt;
-    pkt.data = NULL;
-    pkt.size = 0;
-
-    c = ost->st->codec;
-
-    av_log(NULL, AV_LOG_INFO, "frame = get_video_frame(ost)\n");
-    frame = get_video_frame(ost);
-
-    av_log(NULL, AV_LOG_INFO, "av_init_packet(&pkt)\n");
-    av_init_packet(&pkt);
-
-    /* encode the image */
-    av_log(NULL, AV_LOG_INFO, "ret = avcodec_encode_video2(c, &pkt, frame, &got_packet)\n");
-    ret = avcodec_encode_video2(c, &pkt, frame, &got_packet);
-    if (ret < 0) {
-        fprintf(stderr, "Error encoding video frame: %s\n", local_av_err2str(ret));
-        exit(1);
-    }
-
-    if (got_packet) {
-        av_log(NULL, AV_LOG_INFO, "ret = write_frame(oc, &c->time_base, ost->st, &pkt)\n");
-        ret = write_frame(oc, &c->time_base, ost->st, &pkt);
-    } else {
-        ret = 0;
-    }
-
-    if (ret < 0) {
-        fprintf(stderr, "Error while writing video frame: %s\n", local_av_err2str(ret));
-        exit(1);
-    }
-
-    return (frame || got_packet) ? 0 : 1;
-}
-
-static void close_stream(AVFormatContext *oc, OutputStream *ost)
-{
-    // allocid: MainWindowStream01
-    av_log(NULL, AV_LOG_INFO,
-           "ALLOC del: MainWindowStream01 ost->st->codec = %p\n",
-           ost->st->codec);
-    avcodec_close(ost->st->codec);
-
-    // allocid: MainWindowFrame01
-    // allocid: MainWindowFrame03
-    av_log(NULL, AV_LOG_INFO, "ALLOC del: MainWindowFrame ost->frame = %p\n",
-           ost->frame);
-    av_frame_free(&ost->frame);
-
-    // allocid: MainWindowFrame02
-    // allocid: MainWindowFrame04
-    av_log(NULL, AV_LOG_INFO,
-           "ALLOC del: MainWindowFrame ost->tmp_frame = %p\n",
-           ost->tmp_frame);
-    av_frame_free(&ost->tmp_frame);
-
-    // allocid: MainWindowSWS01
-    if(ost->sws_ctx)
-    {
-        av_log(NULL, AV_LOG_INFO, "ALLOC del: MainWindowSWS01 ost->sws_ctx = %p\n",
-               ost->sws_ctx);
-        sws_freeContext(ost->sws_ctx);
-        ost->sws_ctx = NULL;
-    }
-
-    // allocid: MainWindowSWR01
-    if(ost->swr_ctx)
-    {
-        av_log(NULL, AV_LOG_INFO, "ALLOC del: MainWindowSWR01 ost->swr_ctx = %p\n",
-               ost->swr_ctx);
-        swr_free(&ost->swr_ctx);
-    }
-}
-
-/**************************************************************/
-/* media file output */
-
-int MainWindow::MuxMain(const char *fn_arg, long startFrame, long numFrames,
-                        long vidFrameOffset, QProgressDialog &progress)
-{
-    int argc = 2;
-    const char *argv[] = { "mux_main", fn_arg };
-    OutputStream video_st, audio_st;
-    memset(&video_st, 0, sizeof(OutputStream));
-    memset(&audio_st, 0, sizeof(OutputStream));
-    const char *filename = NULL;
-    AVOutputFormat *fmt = NULL;
-    AVFormatContext *oc = NULL;
-    AVCodec *audio_codec = NULL;
-    AVCodec *video_codec = NULL;
-    int ret;
-    int have_video = 0, have_audio = 0;
-    int encode_video = 0, encode_audio = 0;
-    AVDictionary *opt = NULL;
-
-    // can only do MuxMain once without risking a crash, so mark it now.
-    this->isVideoMuxingRisky = true;
-
-    av_log(NULL, AV_LOG_INFO, "MuxMain(\"%s\", %ld, %ld, %ld, progress)\n",
-           fn_arg, startFrame, numFrames, vidFrameOffset);
-
-
-    if (argc < 2) {
-        throw vfbexception("Invalid call to MuxMain");
-    }
-
-    // Call only once (I think libav can handle additional calls all right,
-    // but just in case it doesn't...)
-    static bool needRegisterAll = true;
-    if(needRegisterAll)
+    catch (...)
     {
-        /* Initialize libavcodec, and register all codecs and formats. */
-        av_log(NULL, AV_LOG_INFO, "av_register_all()\n");
-
-        av_register_all();
-        needRegisterAll = false;
-    }
-
-    filename = argv[1];
-    /*
-    if (argc > 3 && !strcmp(argv[2], "-flags")) {
-        av_dict_set(&opt, argv[2]+1, argv[3], 0);
-    }
-    */
-
-    /* allocate the output media context */
-    av_log(NULL, AV_LOG_INFO, "avformat_alloc_output_context2(&oc, NULL, NULL, filename)\n");
-    // allocid: MainWindowOutput01
-    avformat_alloc_output_context2(&oc, NULL, NULL, filename);
-    if (!oc) {
-        printf("Could not deduce output format from file extension: using MPEG.\n");
-        avformat_alloc_output_context2(&oc, NULL, "mpeg", filename);
-    }
-    av_log(NULL, AV_LOG_INFO, "ALLOC new: MainWindowOutput01 oc = %p\n", oc);
-    if (!oc)
-        return 1;
-
-    fmt = oc->oformat;
-
-    /* Add the audio and video streams using the default format codecs
-     * and initialize the codecs. */
-    if (fmt->video_codec != AV_CODEC_ID_NONE) {
-        int fps_timbase =24;
-        //if (ui->filmrate_PD->currentIndex()>1) fps_timbase=25;
-        fps_timbase = ui->frameRateSpinBox->value();
-        video_st.requestedTimeBase = fps_timbase;
-
-        //video_st.requestedWidth = this->scan.inFile.Width();
-        //video_st.requestedHeight = this->scan.inFile.Height();
-        video_st.requestedWidth = 640;
-        video_st.requestedHeight = 480;
-
-        av_log(NULL, AV_LOG_INFO, "add_stream(&video_st, oc, &video_codec, fmt->video_codec)\n");
-        add_stream(&video_st, oc, &video_codec, fmt->video_codec);
-        have_video = 1;
-        encode_video = 1;
-    }
-    if (fmt->audio_codec != AV_CODEC_ID_NONE) {
-        //int samplerate = (this->ui->filerate_PD->currentIndex()+1)*48000;
-        int samplerate = 48000;
-        int frameratesamples ;
-        int fps_timbase =24;
-
-//        if (ui->filmrate_PD->currentIndex()==0)
-//            frameratesamples = (int) (samplerate/23.976);
-//        else if (ui->filmrate_PD->currentIndex()==1)
-//            frameratesamples = (int) (samplerate/24.0);
-//        else
-//        {
-//            frameratesamples =  (int) (samplerate/25.0);
-//            fps_timbase=25;
-//        }
-        fps_timbase = ui->frameRateSpinBox->value();
-        frameratesamples = (int) (samplerate/fps_timbase);
-        av_log(NULL, AV_LOG_INFO, "Requested sample rate: %d\n", samplerate);
-        audio_st.requestedSamplingRate = samplerate;
-        audio_st.requestedSamplesPerFrame = frameratesamples;
-        audio_st.requestedTimeBase = fps_timbase;
-
-        av_log(NULL, AV_LOG_INFO, "add_stream(&audio_st, oc, &audio_codec, fmt->audio_codec)\n");
-        add_stream(&audio_st, oc, &audio_codec, fmt->audio_codec);
-        have_audio = 1;
-        encode_audio = 1;
-    }
-
-    /* Now that all the parameters are set, we can open the audio and
-     * video codecs and allocate the necessary encode buffers. */
-    if (have_video)
-        open_video(oc, video_codec, &video_st, opt);
-
-    /*
-    av_log(NULL, AV_LOG_INFO, "this->encRGBFrame = alloc_picture(AV_PIX_FMT_RGBA,%d,%d)\n",
-            this->scan.inFile.Width(), this->scan.inFile.Height());
-    this->encRGBFrame = alloc_picture(RGB_PIX_FMT,
-            this->scan.inFile.Width(), this->scan.inFile.Height());
-    */
-    this->encRGBFrame = av_frame_alloc();
-    if (!this->encRGBFrame) {
-        av_log(NULL, AV_LOG_INFO, "Could not allocate RGBFrame picture\n");
-        throw vfbexception("Could not allocate RGBFrame picture");
-    }
-    this->encRGBFrame->format = RGB_PIX_FMT;
-    this->encRGBFrame->width = 640;
-    this->encRGBFrame->height = 480;
-    if(av_frame_get_buffer(this->encRGBFrame, 32) < 0)
-        throw vfbexception("Could not allocate encRGBFrame buffer");
-
-    if (have_audio)
-        open_audio(oc, audio_codec, &audio_st, opt);
-
-    av_dump_format(oc, 0, filename, 1);
-
-    av_log(NULL, AV_LOG_INFO, "encS16Frame = audio_st.tmp_frame = %p\n", audio_st.tmp_frame);
-    this->encS16Frame = audio_st.tmp_frame;
-
-    /* open the output file, if needed */
-    if (!(fmt->flags & AVFMT_NOFILE)) {
-        ret = avio_open(&oc->pb, filename, AVIO_FLAG_WRITE);
-        if (ret < 0) {
-            fprintf(stderr, "Could not open '%s': %s\n", filename,
-                    local_av_err2str(ret));
-            return 1;
-        }
+        error = std::current_exception();
     }
 
-    /* Write the stream header, if any. */
-    ret = avformat_write_header(oc, &opt);
-    if (ret < 0) {
-        fprintf(stderr, "Error occurred when opening output file: %s\n",
-                local_av_err2str(ret));
-        return 1;
-    }
-
-    this->encCurFrame = 2;
-    this->encStartFrame = startFrame;
-    this->encNumFrames = numFrames;
-
-    if(vidFrameOffset > 0)
-    {
-        this->encVideoSkip = vidFrameOffset;
-        this->encAudioSkip = 0;
-        this->encVideoPad = 0;
-        this->encAudioPad = 0;
-    }
-    else
+    // the encoder takes back the buffers it didn't get
+    for (uint8_t *p : { picture, rendered })
     {
-        this->encVideoSkip = 0;
-        this->encAudioSkip = -vidFrameOffset * this->frame_window->samplesperframe_file;
-        av_log(NULL, AV_LOG_INFO, "encAudioSkip = %ld\n", this->encAudioSkip);
-        this->encVideoPad = 0;
-        this->encAudioPad = 0;
+        if (p == NULL) continue;
+        frame_window->WaitForReadback(p);
+        session.ReleaseFrame(p);
     }
+    frame_window->is_rendering = false;
+    frame_window->is_videooutput = false;
+    frame_window->DestroyRecording();
 
-    this->frame_window->vo.videobuffer = this->encRGBFrame->data[0];
-
-    this->encVideoBufSize = 640 * 480 * 4;
-
-    // queue up some black frames to sync the video:
-    uint8_t *blackFrame;
-    for(int i=0; i<this->encVideoPad; ++i)
+    if (error || cancelled)
     {
-        const uint8_t black[4] = { 0, 0, 0, 0xFF };
-        blackFrame = new uint8_t[this->encVideoBufSize];
-        for(long p = 0; p<this->encVideoBufSize; p+=4)
-            memcpy(blackFrame+p, black, 4);
-        this->encVideoQueue.push(blackFrame);
-    }
-
-    while (encode_video || encode_audio) {
-        /* select the stream to encode */
-        if (encode_video &&
-                (!encode_audio || av_compare_ts(video_st.next_pts, video_st.st->codec->time_base,
-                                                audio_st.next_pts, audio_st.st->codec->time_base) <= 0)) {
-            av_log(NULL, AV_LOG_INFO, "encode_video = !write_video_frame(oc, &video_st)\n");
-            encode_video = !write_video_frame(oc, &video_st);
-        } else {
-            av_log(NULL, AV_LOG_INFO, "encode_audio = !write_audio_frame(oc, &audio_st)\n");
-            encode_audio = !write_audio_frame(oc, &audio_st);
-        }
-        progress.setValue(this->encCurFrame);
-        if(progress.wasCanceled())
-        {
-            this->requestCancel = true;
-            throw 2;
-        }
+        session.Abort();
+        if (error) std::rethrow_exception(error);
+        return false;
     }
 
-    /* Write the trailer, if any. The trailer must be written before you
-     * close the CodecContexts open when you wrote the header; otherwise
-     * av_write_trailer() may try to use memory that was freed on
-     * av_codec_close(). */
-    av_write_trailer(oc);
-
-    /* Close each codec. */
-    if(have_video)
-        close_stream(oc, &video_st);
-
-    this->frame_window->vo.videobuffer = NULL;
-    av_frame_free(&this->encRGBFrame);
-
-    if(have_audio)
-        close_stream(oc, &audio_st);
-
-    if (!(fmt->flags & AVFMT_NOFILE))
-        /* Close the output file. */
-        avio_closep(&oc->pb);
-
-    /* free the streams */
-    // allocid: MainWindowOutput01
-    av_log(NULL, AV_LOG_INFO, "ALLOC del: MainWindowOutput01 oc = %p\n", oc);
-    avformat_free_context(oc);
-    oc = NULL;
-
-    return 0;
+    session.Close();
+    return true;
 }
 
-#undef STREAM_DURATION
-#undef STREAM_PIX_FMT
-#undef SCALE_FLAGS
-
-//----------------------------------------------------------------------------
-//---------------------- END MUX.C -------------------------------------------
-//----------------------------------------------------------------------------
-#endif
-
 extern "C" void SegvHandler(int param)
 {
     longjmp(segvJumpEnv, 1);
@@ -3451,12 +2507,6 @@ void MainWindow::on_frame_numberSpinBox_editingFinished()
 }
 
 
-void MainWindow::UpdateQueueWidgets(void)
-{
-
-}
-
-
 
 
 void MainWindow::on_soundtrackDefaultsButton_clicked()
@@ -3669,6 +2719,167 @@ MainWindow *MainWindowAncestor(QObject *obj, bool reporting)
     return mainwindow;
 }
 
+// The overlap pre-pass: register every frame of the reel with the one
+// before it, on all cores, and keep the result in the project so display
+// and extraction can look the overlaps up.
+void MainWindow::on_actionMeasure_Overlaps_triggered()
+{
+    if(!scan.inFile.IsReady()) return;
+    playtimer.stop();
+
+    // the extraction parameters for the current settings, as a batch
+    // extraction reads them from a saved settings file
+    QString text;
+    QTextStream out(&text);
+    saveproject(out);
+    out.flush();
+    QTextStream in(&text);
+    ExtractSettings settings = ReadSettings(in);
+
+    // The extractor reads on its own threads while this one keeps
+    // handling events, which may read frames through the prefetcher, so it
+    // gets its own opening of the source rather than share scan.inFile.
+    Project source;
+    SoundExtractor extractor;
+    const long first = scan.inFile.FirstFrame();
+    const long last = scan.inFile.LastFrame();
+    OverlapTrack track;
+    bool done(false);
+    std::exception_ptr error;
+    std::atomic<bool> finished(false);
+
+    try
+    {
+        if(!source.SourceScan(scan.inFile.GetFileName(),
+                              scan.inFile.GetFormat()))
+            throw vfbexception("Cannot open the source again");
+        extractor.SetSource(&source.inFile);
+        extractor.SetParameters(ExtractorParamsFromSettings(settings,
+                                                            source.inFile));
+    }
+    catch(std::exception &e)
+    {
+        QMessageBox::warning(this, "Measure Overlaps",
+                             QString("Cannot measure overlaps: \n") + e.what());
+        return;
+    }
+
+    QProgressDialog progress("Measuring frame overlaps...", "Cancel", 0,
+                             int(last - first + 1), this);
+    progress.setWindowTitle("Measure Overlaps");
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(0);
+
+    std::thread worker([&]() {
+        try
+        {
+            done = track.Measure(extractor, first, last);
+        }
+        catch(...)
+        {
+            error = std::current_exception();
+        }
+        finished = true;
+    });
+
+    while(!finished)
+    {
+        progress.setValue(int(extractor.FramesDone()));
+        if(progress.wasCanceled())
+            extractor.Cancel();
+        qApp->processEvents(QEventLoop::AllEvents, 50);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    worker.join();
+    progress.reset();
+
+    try
+    {
+        if(error) std::rethrow_exception(error);
+    }
+    catch(std::exception &e)
+    {
+        QMessageBox::warning(this, "Measure Overlaps",
+                             QString("Error measuring overlaps: \n") + e.what());
+        return;
+    }
+    if(!done) return;
+
+    vbscan.overlapTrack = track;
+    QMessageBox::information(this, "Measure Overlaps",
+                             QString("Measured %1 frames. %2 uncertain "
+                                     "overlaps were replaced by their "
+                                     "neighbours' median.")
+                             .arg(track.Last() - track.First() + 1)
+                             .arg(track.NumIffy()));
+
+    // show the measured overlap for this frame
+    GPU_Params_Update(true);
+}
+
+// Render every frame of the reel, as the frame window shows it, with its
+// soundtrack to the video file and codec chosen in the extract dialog, or
+// the soundtrack alone to its audio file if no video is asked for.
+void MainWindow::on_actionExport_Video_triggered()
+{
+    if(!scan.inFile.IsReady() || frame_window == NULL) return;
+    playtimer.stop();
+
+    const QString dir = prevExportDir.isEmpty() ? prevProjectDir :
+                                                  prevExportDir;
+    MetaData meta;
+    ExtractDialog dialog(this, meta, dir);
+    dialog.setWindowTitle("Export Video");
+    if(dialog.exec() != QDialog::Accepted) return;
+
+    ExportSettings settings;
+    settings.videoCodec = dialog.GetVideoCodec();
+    QString fn = dialog.GetVideoFilename();
+    if(fn.isEmpty())
+    {
+        fn = dialog.GetFilename();
+        settings.video = false;
+    }
+    if(fn.isEmpty())
+    {
+        QMessageBox::warning(this, "Export Video", "No output file given");
+        return;
+    }
+    if(QFileInfo(fn).isRelative() && !dir.isEmpty())
+        fn = dir + "/" + fn;
+
+    const long numFrames = long(scan.inFile.NumFrames());
+    QProgressDialog progress("Exporting video...", "Cancel", 0,
+                             int(numFrames), this);
+    progress.setWindowTitle("Export Video");
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(0);
+
+    bool done(false);
+    try
+    {
+        done = ExportVideo(fn, settings, 0, numFrames, 0, progress);
+    }
+    catch(std::exception &e)
+    {
+        progress.reset();
+        Load_Frame_Texture(CurrentFrame());
+        QMessageBox::warning(this, "Export Video",
+                             QString("Error exporting video: \n") + e.what());
+        return;
+    }
+    progress.reset();
+    prevExportDir = QFileInfo(fn).absolutePath();
+
+    // back to the frame the export started from
+    Load_Frame_Texture(CurrentFrame());
+    if(!done) return;
+
+    QMessageBox::information(this, "Export Video",
+                             QString("Exported %1 frames to %2")
+                             .arg(numFrames).arg(fn));
+}
+
 void MainWindow::on_actionPlay_Stop_triggered()
 {
     if(!playtimer.isActive())
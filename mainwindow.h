@@ -43,10 +43,12 @@
 #include "frame_view_gl.h"
 #include "eventdialog.h"
 #include "project.h"
+#include "frameprefetcher.h"
+#include "framecache.h"
 #include "metadata.h"
 #include <QSoundEffect>
 #include "vbproject.h"
-#define USE_MUX_HACK
+#include "exportsession.h"
 #include <QImage>
 #include <QColor>
 
@@ -105,47 +107,6 @@ public:
 	operator bool() const { return (err==0); };
 };
 
-class ExtractTask
-{
-public:
-	ExtractedSound params;
-	QString source;
-	SourceFormat srcFormat;
-	QString output;
-	MetaData meta;
-};
-
-#ifdef USE_MUX_HACK
-//----------------------------------------------------------------------------
-//---------------------- MUX.C -----------------------------------------------
-//----------------------------------------------------------------------------
-
-// a wrapper around a single output AVStream
-class OutputStream {
-public:
-	int requestedWidth;
-	int requestedHeight;
-	int requestedSamplingRate;
-	int requestedSamplesPerFrame;
-	int requestedTimeBase;
-
-	AVStream *st;
-
-	/* pts of the next frame that will be generated */
-	int64_t next_pts;
-	int samples_count;
-
-	AVFrame *frame;
-	AVFrame *tmp_frame;
-
-	float t, tincr, tincr2;
-
-	struct SwsContext *sws_ctx;
-	struct SwrContext *swr_ctx;
-};
-
-#endif
-
 class MainWindow : public QMainWindow
 {
 	Q_OBJECT
@@ -165,7 +126,6 @@ public:
     int playdir=1;
     QTimer playtimer;
 	std::vector< ExtractedSound > samplesPlayed;
-	std::vector< ExtractTask > extractQueue;
 	int adminWidth;
 
 	void GUI_Params_Update();
@@ -207,7 +167,6 @@ private:
 	bool NewSource(QString fn, SourceFormat ft=SOURCE_UNKNOWN);
 	bool Load_Frame_Texture(int);
 	void GPU_Params_Update(bool renderyes);
-	void UpdateQueueWidgets(void);
 	QString Compute_Timecode_String(int position);
 	uint64_t ComputeTimeReference(int position, int samplingRate);
 
@@ -245,8 +204,6 @@ private slots:
 	void on_frame_numberSpinBox_valueChanged(int arg1);
 
 private:
-    bool extractGL(QString filename, bool doTimer);
-    bool extractGL(bool doTimer) { return extractGL(QString(), doTimer); }
 //	ExtractedSound Extract(QString filename, QString videoFilename,
 //			long firstFrame, long numFrames, uint8_t flags=0);
 
@@ -322,6 +279,8 @@ private slots:
     void OpenPropertiesWindow();
 
     void on_actionPlay_Stop_triggered();
+    void on_actionMeasure_Overlaps_triggered();
+    void on_actionExport_Video_triggered();
 
     void on_play_btn_clicked();
 
@@ -342,7 +301,8 @@ private:
 	MetaData *currentMeta;
 	FrameTexture *currentFrameTexture;
 	FrameTexture *outputFrameTexture;
-	bool isVideoMuxingRisky;
+	FramePrefetcher prefetcher;
+	FrameCache frameCache;
     int currentframe = 0;
     //QDomDocument xml;
     //QMap<int, EventInfo> map;
@@ -368,40 +328,10 @@ public:
 	void LogClose()
 		{ if(log.device() && log.device()->isOpen()) log.device()->close(); }
 
-#ifdef USE_MUX_HACK
 private:
-
-	long encStartFrame;
-	long encNumFrames;
-	long encCurFrame;
-	long encVideoSkip; // discard scanned video frames from start
-	long encAudioSkip; // discard extracted audio frame snippets from start
-	long encVideoPad;  // add synthetic (black) video frames at start
-	long encAudioPad;  // add synthetic (silent) audio frame snippets at start
-
-	long encVideoBufSize;
-
-	AVFrame *encRGBFrame;
-	AVFrame *encS16Frame;
-
-	std::queue< uint8_t* > encVideoQueue;
-	int64_t encAudioLen; // total number of samples rendered so far
-	int64_t encAudioNextPts;
-
-	bool EnqueueNextFrame();
-	uint8_t *GetVideoFromQueue();
-	AVFrame *GetAudioFromQueue();
-
-	AVFrame *get_audio_frame(OutputStream *ost);
-	int write_audio_frame(AVFormatContext *oc, OutputStream *ost);
-
-	AVFrame *get_video_frame(OutputStream *ost);
-	int write_video_frame(AVFormatContext *oc, OutputStream *ost);
-
-	int MuxMain(const char *fn_arg, long firstFrame, long numFrames,
-			long vidFrameOffset, QProgressDialog &progress);
-
-#endif
+	bool ExportVideo(const QString &fn, const ExportSettings &settings,
+			long startFrame, long numFrames, long vidFrameOffset,
+			QProgressDialog &progress);
 
 };
 
@@ -0,0 +1,224 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+#include <cstring>
+#include <errno.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "mappedinstream.h"
+
+//-----------------------------------------------------------------------------
+MappedInStream::MappedInStream()
+	: map(NULL), mapSize(0), pos(0), populate(true), modTime(0),
+#ifdef _WIN32
+	fileHandle(INVALID_HANDLE_VALUE), mapHandle(NULL)
+#else
+	fd(-1)
+#endif
+{
+}
+
+//-----------------------------------------------------------------------------
+MappedInStream::~MappedInStream()
+{
+	Close();
+}
+
+//-----------------------------------------------------------------------------
+bool MappedInStream::Open(const char *fn)
+{
+	Close();
+
+#ifdef _WIN32
+	fileHandle = CreateFileA(fn, GENERIC_READ, FILE_SHARE_READ, NULL,
+			OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if(fileHandle == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	if(!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+	mapSize = size_t(size.QuadPart);
+
+	// 100 ns intervals since 1601
+	FILETIME ft;
+	if(!GetFileTime(fileHandle, NULL, NULL, &ft))
+	{
+		Close();
+		return false;
+	}
+	modTime = int64_t((uint64_t(ft.dwHighDateTime) << 32 |
+			ft.dwLowDateTime) / 10000) - INT64_C(11644473600000);
+
+	mapHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if(mapHandle == NULL)
+	{
+		Close();
+		return false;
+	}
+
+	map = (const uint8_t *)MapViewOfFile(mapHandle, FILE_MAP_READ, 0, 0, 0);
+	if(map == NULL)
+	{
+		Close();
+		return false;
+	}
+#else
+	if((fd = open(fn, O_RDONLY)) < 0) return false;
+
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		Close();
+		return false;
+	}
+	mapSize = size_t(st.st_size);
+#ifdef __APPLE__
+	modTime = int64_t(st.st_mtimespec.tv_sec)*1000 +
+		st.st_mtimespec.tv_nsec/1000000;
+#else
+	modTime = int64_t(st.st_mtim.tv_sec)*1000 + st.st_mtim.tv_nsec/1000000;
+#endif
+
+	// Fault the pages in now, on the thread that opened the file, rather
+	// than later on whichever thread first touches the pixels (usually the
+	// GUI thread, inside glTexImage2D).
+	int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+	if(populate) flags |= MAP_POPULATE;
+#endif
+	void *m = mmap(NULL, mapSize, PROT_READ, flags, fd, 0);
+	if(m == MAP_FAILED)
+	{
+		int err = errno;
+		Close();
+		errno = err;
+		return false;
+	}
+	map = (const uint8_t *)m;
+
+#ifndef MAP_POPULATE
+	if(populate) madvise(m, mapSize, MADV_WILLNEED);
+#endif
+#endif
+
+	pos = 0;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+void MappedInStream::Close()
+{
+#ifdef _WIN32
+	if(map) UnmapViewOfFile(map);
+	if(mapHandle) CloseHandle(mapHandle);
+	if(fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+	mapHandle = NULL;
+	fileHandle = INVALID_HANDLE_VALUE;
+#else
+	if(map) munmap((void *)map, mapSize);
+	if(fd >= 0) close(fd);
+	fd = -1;
+#endif
+	map = NULL;
+	mapSize = 0;
+	modTime = 0;
+	pos = 0;
+}
+
+//-----------------------------------------------------------------------------
+void MappedInStream::Rewind()
+{
+	pos = 0;
+}
+
+//-----------------------------------------------------------------------------
+size_t MappedInStream::Read(void *buf, const size_t size)
+{
+	if(map == NULL || pos >= mapSize) return 0;
+
+	size_t n = size;
+	if(n > mapSize - pos) n = mapSize - pos;
+
+	memcpy(buf, map + pos, n);
+	pos += n;
+
+	return n;
+}
+
+//-----------------------------------------------------------------------------
+size_t MappedInStream::ReadDirect(void *buf, const size_t size)
+{
+	return Read(buf, size);
+}
+
+//-----------------------------------------------------------------------------
+bool MappedInStream::EndOfFile() const
+{
+	return (pos >= mapSize);
+}
+
+//-----------------------------------------------------------------------------
+bool MappedInStream::Seek(long offset, Origin origin)
+{
+	long base;
+
+	switch(origin)
+	{
+	case kStart: base = 0; break;
+	case kCurrent: base = long(pos); break;
+	case kEnd: base = long(mapSize); break;
+	default: return false;
+	}
+
+	if(base + offset < 0 || size_t(base + offset) > mapSize) return false;
+
+	pos = size_t(base + offset);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+const uint8_t *MappedInStream::Data(size_t offset, size_t size) const
+{
+	if(map == NULL || offset > mapSize || size > mapSize - offset)
+		return NULL;
+
+	return map + offset;
+}
@@ -0,0 +1,88 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+// MappedInStream -- an InStream (see DPXStream.h) that memory-maps the whole
+// file instead of reading it through stdio.
+//
+// It can be handed to a dpx::Reader like any other InStream, but it can also
+// expose the mapped bytes directly through Data(), which lets image payloads
+// that need no unpacking go straight to OpenGL without being copied into
+// an intermediate buffer first.
+
+#ifndef MAPPEDINSTREAM_H
+#define MAPPEDINSTREAM_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "DPXStream.h"
+
+class MappedInStream : public InStream {
+private:
+	const uint8_t *map;
+	size_t mapSize;
+	size_t pos;
+	bool populate;
+	int64_t modTime;
+#ifdef _WIN32
+	void *fileHandle;
+	void *mapHandle;
+#else
+	int fd;
+#endif
+
+public:
+	MappedInStream();
+	virtual ~MappedInStream();
+
+	virtual bool Open(const char *fn);
+	virtual void Close();
+	virtual void Rewind();
+	virtual size_t Read(void *buf, const size_t size);
+	virtual size_t ReadDirect(void *buf, const size_t size);
+	virtual bool EndOfFile() const;
+	virtual bool Seek(long offset, Origin origin);
+
+	bool IsOpen() const { return map != NULL; }
+	size_t Size() const { return mapSize; }
+
+	// the file's last modification, in ms since the epoch
+	int64_t ModifiedTime() const { return modTime; }
+
+	// Open() faults the whole file in unless this is turned off, for a
+	// caller that only reads a header
+	void SetPopulate(bool p) { populate = p; }
+
+	// pointer to <size> mapped bytes starting at <offset>, or NULL if the
+	// file is shorter than that. Valid until Close().
+	const uint8_t *Data(size_t offset, size_t size) const;
+};
+
+#endif // MAPPEDINSTREAM_H
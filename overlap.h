@@ -34,17 +34,18 @@
 class OverlapRecord
 {
 public:
-	unsigned int overlap;
-	unsigned int minDiff;
-	bool isIffy;
+	float overlap;        // 1/SOUNDEXTRACT_OVERLAP_ROWS of the frame, to a
+	                      // fraction of a row
+	unsigned int minDiff; // mismatch at that overlap, 0 = identical
+	bool isIffy;          // the offset is a guess
 
 public:
 	OverlapRecord() : overlap(0), minDiff(0), isIffy(false) {};
-	OverlapRecord(unsigned int n) : overlap(n), minDiff(0), isIffy(false) {} ;
+	OverlapRecord(float n) : overlap(n), minDiff(0), isIffy(false) {} ;
 
-	operator unsigned int() const { return overlap; };
+	operator float() const { return overlap; };
 
-	OverlapRecord& operator =(unsigned int n) { overlap = n; return *this; };
+	OverlapRecord& operator =(float n) { overlap = n; return *this; };
 };
 
 #endif
@@ -0,0 +1,315 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+#include "overlapregistration.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "vfbexception.h"
+
+//-----------------------------------------------------------------------------
+// the profile less its mean, so the sums below do not lose the detail to
+// a large constant
+static void Centered(const float *p, int rows, std::vector<double> &out)
+{
+	double mean = 0;
+	for(int i=0; i<rows; ++i) mean += p[i];
+	mean /= rows;
+
+	out.resize(rows);
+	for(int i=0; i<rows; ++i) out[i] = p[i] - mean;
+}
+
+//-----------------------------------------------------------------------------
+void OverlapRegistration::Plan(int r)
+{
+	if(r == rows) return;
+	if(r < OVERLAP_MIN_ROWS)
+		throw vfbexception(QString("Overlap profiles are too short: %1").arg(r));
+
+	rows = r;
+	int bits = 1;
+	for(size = 2; size < size_t(2*rows); size <<= 1) ++bits;
+
+	twiddle.resize(size/2);
+	for(size_t k=0; k<size/2; ++k)
+		twiddle[k] = std::polar(1.0, -2.0 * M_PI * double(k) / double(size));
+
+	reversed.resize(size);
+	for(size_t k=0; k<size; ++k)
+	{
+		size_t rev = 0;
+		for(int b=0; b<bits; ++b)
+			if(k & (size_t(1) << b)) rev |= size_t(1) << (bits-1-b);
+		reversed[k] = rev;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// in-place radix-2; the inverse is scaled by 1/size
+void OverlapRegistration::FFT(Complex *data, bool inverse) const
+{
+	for(size_t k=0; k<size; ++k)
+		if(k < reversed[k]) std::swap(data[k], data[reversed[k]]);
+
+	for(size_t len=2; len<=size; len <<= 1)
+	{
+		size_t half = len/2;
+		size_t step = size/len;
+		for(size_t i=0; i<size; i+=len)
+		{
+			for(size_t j=0; j<half; ++j)
+			{
+				Complex w = twiddle[j*step];
+				if(inverse) w = std::conj(w);
+				Complex u = data[i+j];
+				Complex v = data[i+j+half] * w;
+				data[i+j] = u + v;
+				data[i+j+half] = u - v;
+			}
+		}
+	}
+
+	if(inverse)
+	{
+		double scale = 1.0 / double(size);
+		for(size_t k=0; k<size; ++k) data[k] *= scale;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Spectra of two real, zero-padded profiles from one complex FFT of a + ib.
+// b may be NULL.
+void OverlapRegistration::Spectra(const double *a, const double *b,
+		Complex *A, Complex *B) const
+{
+	for(int k=0; k<rows; ++k) A[k] = Complex(a[k], b?b[k]:0.0);
+	std::fill(A+rows, A+size, Complex(0,0));
+	FFT(A, false);
+
+	if(!b) return;
+
+	// split on conjugate symmetry: Z[k] = A[k] + iB[k]
+	for(size_t k=0; k<=size/2; ++k)
+	{
+		size_t m = (size-k) & (size-1);
+		Complex zk = A[k];
+		Complex zm = A[m];
+		A[k] = 0.5 * (zk + std::conj(zm));
+		B[k] = Complex(0,-0.5) * (zk - std::conj(zm));
+		A[m] = std::conj(A[k]);
+		B[m] = std::conj(B[k]);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// corr[s] is sum(head[k]*tail[k+s]): overlap L = rows - s. Normalize it over
+// the L rows each side contributes and take the best L in range.
+OverlapMatch OverlapRegistration::Peak(const double *head, const double *tail,
+		const double *corr, double minOverlap, double maxOverlap) const
+{
+	OverlapMatch match;
+
+	int lo = std::max(int(std::ceil(minOverlap)), OVERLAP_MIN_ROWS);
+	int hi = std::min(int(std::floor(maxOverlap)), rows);
+	if(hi < lo) return match;
+
+	// running sums over the first L rows of head and the last L of tail
+	double hs=0, hs2=0, ts=0, ts2=0;
+	for(int L=0; L<lo-1; ++L)
+	{
+		hs += head[L]; hs2 += head[L]*head[L];
+		ts += tail[rows-1-L]; ts2 += tail[rows-1-L]*tail[rows-1-L];
+	}
+
+	std::vector<double> ncc(hi-lo+1);
+	for(int L=lo; L<=hi; ++L)
+	{
+		double h = head[L-1];
+		double t = tail[rows-L];
+		hs += h; hs2 += h*h;
+		ts += t; ts2 += t*t;
+
+		double num = corr[rows-L] - hs*ts/L;
+		double den = (hs2 - hs*hs/L) * (ts2 - ts*ts/L);
+		ncc[L-lo] = (den > 1e-12) ? num/std::sqrt(den) : 0.0;
+	}
+
+	int n = int(ncc.size());
+	int best = int(std::max_element(ncc.begin(), ncc.end()) - ncc.begin());
+	double offset = 0;
+	if(best > 0 && best < n-1)
+	{
+		double a = ncc[best-1], b = ncc[best], c = ncc[best+1];
+		double curve = a - 2*b + c;
+		if(curve < 0)
+			offset = std::max(-0.5, std::min(0.5, 0.5 * (a-c) / curve));
+	}
+
+	// the best value outside the slopes of the peak's own lobe
+	int left = best, right = best;
+	while(left > 0 && ncc[left-1] <= ncc[left]) --left;
+	while(right < n-1 && ncc[right+1] <= ncc[right]) ++right;
+	double second = std::max(ncc[left], ncc[right]);
+	if(left > 0)
+		second = *std::max_element(ncc.begin(), ncc.begin()+left);
+	if(right < n-1)
+		second = std::max(second,
+				*std::max_element(ncc.begin()+right+1, ncc.end()));
+
+	match.overlap = lo + best + offset;
+	match.correlation = ncc[best];
+	match.confidence = ncc[best] - second;
+
+	return match;
+}
+
+//-----------------------------------------------------------------------------
+OverlapMatch OverlapRegistration::Register(const float *head,
+		const float *tail, int r, double minOverlap, double maxOverlap)
+{
+	Plan(r);
+
+	std::vector<double> h, t;
+	Centered(head, rows, h);
+	Centered(tail, rows, t);
+
+	std::vector<Complex> H(size), T(size);
+	Spectra(h.data(), t.data(), H.data(), T.data());
+	for(size_t k=0; k<size; ++k) H[k] = std::conj(H[k]) * T[k];
+	FFT(H.data(), true);
+
+	std::vector<double> corr(rows);
+	for(int s=0; s<rows; ++s) corr[s] = H[s].real();
+
+	return Peak(h.data(), t.data(), corr.data(), minOverlap, maxOverlap);
+}
+
+//-----------------------------------------------------------------------------
+std::vector<OverlapMatch> OverlapRegistration::RegisterSequence(
+		const std::vector< std::vector<float> > &profiles,
+		double minOverlap, double maxOverlap, int threads)
+{
+	if(profiles.size() < 2) return std::vector<OverlapMatch>();
+
+	for(const std::vector<float> &p : profiles)
+		if(p.size() != profiles[0].size())
+			throw vfbexception("Overlap profiles differ in length");
+	Plan(int(profiles[0].size()));
+
+	long pairs = long(profiles.size()) - 1;
+	std::vector<OverlapMatch> matches(pairs);
+
+	// pairs [first,end) use profiles first..end. Each profile is
+	// transformed once, two to a FFT, and two pairs share an inverse.
+	auto worker = [&](long first, long end)
+	{
+		std::vector<Complex> prev(size), A(size), B(size), X(size);
+		std::vector<double> cPrev, cA, cB, corr(rows);
+
+		Centered(profiles[first].data(), rows, cPrev);
+		Spectra(cPrev.data(), NULL, prev.data(), NULL);
+
+		for(long j=first+1; j<=end; j+=2)
+		{
+			bool two = (j+1 <= end);
+			Centered(profiles[j].data(), rows, cA);
+			if(two) Centered(profiles[j+1].data(), rows, cB);
+			Spectra(cA.data(), two?cB.data():NULL, A.data(), B.data());
+
+			// pair j-1 (head j, tail j-1) real, pair j (head j+1, tail j)
+			// imaginary
+			for(size_t k=0; k<size; ++k)
+			{
+				X[k] = std::conj(A[k]) * prev[k];
+				if(two) X[k] += Complex(0,1) * std::conj(B[k]) * A[k];
+			}
+			FFT(X.data(), true);
+
+			for(int s=0; s<rows; ++s) corr[s] = X[s].real();
+			matches[j-1] = Peak(cA.data(), cPrev.data(), corr.data(),
+					minOverlap, maxOverlap);
+			if(!two) break;
+
+			for(int s=0; s<rows; ++s) corr[s] = X[s].imag();
+			matches[j] = Peak(cB.data(), cA.data(), corr.data(),
+					minOverlap, maxOverlap);
+
+			prev.swap(B);
+			cPrev.swap(cB);
+		}
+	};
+
+	if(threads <= 0)
+		threads = std::max(1, int(std::thread::hardware_concurrency()));
+	threads = int(std::min<long>(threads, pairs));
+
+	std::vector<std::thread> workers;
+	for(int i=1; i<threads; ++i)
+		workers.push_back(std::thread(worker,
+				pairs*i/threads, pairs*(i+1)/threads));
+	worker(0, pairs/threads);
+	for(std::thread &w : workers) w.join();
+
+	return matches;
+}
+
+//-----------------------------------------------------------------------------
+template <typename T>
+std::vector<float> OverlapProfile(const FilmFrameT<T> &frame, int col0,
+		int col1)
+{
+	std::vector<float> profile(frame.Height(), 0.0f);
+	if(!frame.Width()) return profile;
+
+	if(col1 < col0) std::swap(col0, col1);
+	col0 = std::max(col0, 0);
+	col1 = std::min(col1, int(frame.Width())-1);
+	if(col1 < col0) return profile;
+
+	double scale = 1.0 / (col1-col0+1);
+	for(unsigned int r=0; r<frame.Height(); ++r)
+	{
+		const T *row = frame[r];
+		double sum = 0;
+		for(int c=col0; c<=col1; ++c) sum += row[c];
+		profile[r] = float(sum * scale);
+	}
+
+	return profile;
+}
+
+template std::vector<float> OverlapProfile(const FilmFrameT<float> &, int, int);
+template std::vector<float> OverlapProfile(const FilmFrameT<uint16_t> &, int,
+		int);
+template std::vector<float> OverlapProfile(const FilmFrameT<double> &, int,
+		int);
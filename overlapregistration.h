@@ -0,0 +1,114 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+// OverlapRegistration -- measure the overlap between consecutive frames by
+// normalized cross-correlation of their soundtrack profiles.
+//
+// A profile is one value per image row: the mean of the track (or picture)
+// columns, as shader mode 4 renders it. Consecutive frames of a scan
+// overlap by L rows when the first L rows of one frame's profile (the
+// head) repeat the last L rows of the other's (the tail); this is the
+// comparison shader mode 5 makes for every L by brute force.
+//
+// Here the raw cross-correlation for every L comes from one FFT, and the
+// window means and energies from prefix sums, so every candidate overlap
+// costs O(n log n) in all instead of O(n) each. The normalized peak is
+// refined to a fraction of a row with a parabola through its neighbours.
+//
+// RegisterSequence() registers every consecutive pair of a sequence of
+// profiles, transforming each profile once (two to a complex FFT), on
+// several threads. Nothing here needs OpenGL.
+
+#ifndef OVERLAPREGISTRATION_H
+#define OVERLAPREGISTRATION_H
+
+#include <complex>
+#include <vector>
+
+#include "FilmScan.h"
+
+// candidate overlaps shorter than this are too noisy to trust
+#define OVERLAP_MIN_ROWS 8
+
+// below either of these a match is only a guess
+#define OVERLAP_MIN_CORRELATION 0.5
+#define OVERLAP_MIN_CONFIDENCE 0.05
+
+class OverlapMatch
+{
+public:
+	double overlap;      // rows, to a fraction of a row; 0 if none found
+	double correlation;  // normalized cross-correlation at the peak, -1..1
+	double confidence;   // how far the peak stands above the next best
+	                     // distinct candidate: 0 (ambiguous) to 2
+
+	OverlapMatch() : overlap(0), correlation(0), confidence(0) {} ;
+	bool IsReliable() const { return correlation >= OVERLAP_MIN_CORRELATION
+			&& confidence >= OVERLAP_MIN_CONFIDENCE; } ;
+};
+
+class OverlapRegistration
+{
+private:
+	typedef std::complex<double> Complex;
+
+	int rows;      // profile length
+	size_t size;   // FFT length: a power of two of at least 2*rows
+	std::vector<Complex> twiddle;
+	std::vector<size_t> reversed;
+
+	void Plan(int rows);
+	void FFT(Complex *data, bool inverse) const;
+	void Spectra(const double *a, const double *b, Complex *A, Complex *B) const;
+	OverlapMatch Peak(const double *head, const double *tail,
+			const double *corr,
+			double minOverlap, double maxOverlap) const;
+
+public:
+	OverlapRegistration() : rows(0), size(0) {} ;
+
+	// head and tail are profiles of the same number of rows; overlaps
+	// from minOverlap to maxOverlap rows are considered
+	OverlapMatch Register(const float *head, const float *tail, int rows,
+			double minOverlap, double maxOverlap);
+
+	// match i is the overlap of frame i and i+1: profiles[i+1] is the
+	// head, profiles[i] the tail. threads 0 picks one per core.
+	std::vector<OverlapMatch> RegisterSequence(
+			const std::vector< std::vector<float> > &profiles,
+			double minOverlap, double maxOverlap, int threads=0);
+};
+
+// the mean of columns [col0,col1] of each row of a frame
+template <typename T>
+std::vector<float> OverlapProfile(const FilmFrameT<T> &frame, int col0,
+		int col1);
+
+#endif // OVERLAPREGISTRATION_H
@@ -0,0 +1,135 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+#include "overlapsearch.h"
+
+#include <algorithm>
+#include <cmath>
+
+// texture() along one axis of n texels at coordinate t, as in
+// soundextractor.cpp: GL_LINEAR between texel centres, GL_CLAMP_TO_EDGE
+static inline float SampleLinear(const float *v, int n, float t)
+{
+	float p = t*n - 0.5f;
+	if(p <= 0.0f) return v[0];
+	if(p >= n-1) return v[n-1];
+	int i = int(p);
+	float f = p - i;
+	return v[i] + f*(v[i+1]-v[i]);
+}
+
+static inline float SmoothStep(float e0, float e1, float x)
+{
+	float t = std::min(std::max((x-e0)/(e1-e0), 0.0f), 1.0f);
+	return t*t*(3.0f-2.0f*t);
+}
+
+//-----------------------------------------------------------------------------
+OverlapSearch::OverlapSearch(const float o[4], int r) : rows(r)
+{
+	std::copy(o, o+4, overlap);
+}
+
+//-----------------------------------------------------------------------------
+void OverlapSearch::Window(int &s_start, int &s_end) const
+{
+	const int n = rows;
+
+	int start = (overlap[2]+overlap[3])*n - (overlap[1]*0.5*n);
+	int end = (overlap[2]+overlap[3])*n + (overlap[1]*0.5*n);
+	start = std::max(4, start);
+	end = std::min(end, n-2);
+	end = std::max(end, start);
+
+	int size = end - start;
+	int mid = start + size/2;
+	int step = (size/2)/5;
+	s_start = std::max(4, mid - step*5);
+	s_end = std::min(mid + step*5, n-2);
+}
+
+//-----------------------------------------------------------------------------
+float OverlapSearch::Error(const float *cur, const float *prev, int height,
+		int row) const
+{
+	const int n = rows;
+	const float pos = 1.0f - (row+0.5f)/n; // 1.0-vTexCoord.y
+	const float pitch = overlap[2] + overlap[3];
+	const float search = overlap[1];
+
+	if(pos > pitch + search || pos < pitch - search)
+		return 1.0f;
+
+	int samp = int(0.25f*(height*2.0f));
+	float step = 1.0f / height;
+	float sum(0.0f);
+	int used(0);
+
+	for(int i=0; i<samp; ++i)
+	{
+		float t = i*step;
+		if(t >= 1.0f || t <= 0.0f) continue;
+		sum += std::fabs(SampleLinear(cur, n, t) -
+				SampleLinear(prev, n, t + 1.0f - pos));
+		++used;
+	}
+
+	float err = used ? sum/used : 1.0f;
+	float weighted = err;
+	if(pos >= pitch - search && pos <= pitch)
+		weighted *= 1.0f + 0.5f*(1.0f - SmoothStep(pitch-search, pitch, pos));
+	if(pos <= pitch + search && pos >= pitch)
+		weighted *= 1.0f + 0.5f*SmoothStep(pitch, pitch+search, pos);
+
+	return (err + weighted) / 2.0f;
+}
+
+//-----------------------------------------------------------------------------
+int OverlapSearch::Find(const float *cur, const float *prev, int height) const
+{
+	const int n = rows;
+	int s_start, s_end;
+	Window(s_start, s_end);
+
+	// candidate s_end-i is output row n-(s_end-i)
+	int best = s_end;
+	float bestValue(0.0f);
+	for(int i=0; i < s_end - s_start; ++i)
+	{
+		float value = Error(cur, prev, height, n - s_end + i);
+		if(i == 0 || value < bestValue)
+		{
+			best = s_end - i;
+			bestValue = value;
+		}
+	}
+
+	return best;
+}
@@ -0,0 +1,71 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+// OverlapSearch -- the overlap search Frame_Window::render() makes on the
+// GPU, shader mode 5 and the scan of its output, done on the CPU.
+//
+// The search takes the render_mode 4 profiles of two consecutive frames
+// (one value per output row) and, for every candidate overlap in the
+// search window, the mean difference between the current profile and the
+// previous one slid along by that overlap, weighted toward the expected
+// frame pitch. The lowest difference wins.
+//
+// Output row R of mode 5 is the fragment at vTexCoord.y = (R+0.5)/rows,
+// which tests the overlap 1.0-vTexCoord.y. The frame window reads the rows
+// from rows-end up and counts the overlap down from end, so candidate L is
+// row rows-L. Error() and Find() keep that mapping, and return what the
+// frame window does for the same profiles.
+
+#ifndef OVERLAPSEARCH_H
+#define OVERLAPSEARCH_H
+
+class OverlapSearch
+{
+private:
+	float overlap[4]; // as Frame_Window::overlap: [1] search area,
+	                  // [2] frame pitch end, [3] frame pitch start
+	int rows;         // profile length (Frame_Window::samplesperframe)
+
+public:
+	OverlapSearch(const float overlap[4], int rows);
+
+	// the candidate overlaps (in rows) the frame window searches outside
+	// of calibration: the widest of its nested windows
+	void Window(int &start, int &end) const;
+
+	// mode 5 output row row for profiles of a frame of height image rows;
+	// 1.0 outside the search
+	float Error(const float *cur, const float *prev, int height,
+			int row) const;
+
+	// the best overlap, in rows, over Window()
+	int Find(const float *cur, const float *prev, int height) const;
+};
+
+#endif // OVERLAPSEARCH_H
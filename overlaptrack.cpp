@@ -0,0 +1,203 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+#include "overlaptrack.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <QRegularExpression>
+#include <QStringList>
+
+//-----------------------------------------------------------------------------
+OverlapTrackKey::OverlapTrackKey()
+	: search(0.0f), pitchEnd(0.0f), pitchStart(0.0f), overlapTarget(0),
+	pushPull(false)
+{
+	bounds[0] = bounds[1] = 0.0f;
+	pixBounds[0] = pixBounds[1] = 0.0f;
+}
+
+OverlapTrackKey::OverlapTrackKey(const SoundExtractorParams &p)
+	: search(p.overlap[1]), pitchEnd(p.overlap[2]), pitchStart(p.overlap[3]),
+	overlapTarget(p.overlapTarget), pushPull(p.stereo == 2)
+{
+	bounds[0] = p.bounds[0];
+	bounds[1] = p.bounds[1];
+	pixBounds[0] = p.pixBounds[0];
+	pixBounds[1] = p.pixBounds[1];
+}
+
+//-----------------------------------------------------------------------------
+bool OverlapTrackKey::operator==(const OverlapTrackKey &k) const
+{
+	auto same = [](float a, float b) { return std::fabs(a-b) < 1e-5f; };
+
+	// the picture bounds only matter if the search reads the picture
+	if(overlapTarget != 0 && !(same(pixBounds[0], k.pixBounds[0]) &&
+			same(pixBounds[1], k.pixBounds[1])))
+		return false;
+
+	return same(bounds[0], k.bounds[0]) && same(bounds[1], k.bounds[1]) &&
+		same(search, k.search) && same(pitchEnd, k.pitchEnd) &&
+		same(pitchStart, k.pitchStart) && overlapTarget == k.overlapTarget &&
+		pushPull == k.pushPull;
+}
+
+//-----------------------------------------------------------------------------
+QString OverlapTrackKey::ToString() const
+{
+	return QString("%1 %2 %3 %4 %5 %6 %7 %8 %9")
+		.arg(bounds[0], 0, 'g', 9).arg(bounds[1], 0, 'g', 9)
+		.arg(pixBounds[0], 0, 'g', 9).arg(pixBounds[1], 0, 'g', 9)
+		.arg(search, 0, 'g', 9).arg(pitchEnd, 0, 'g', 9)
+		.arg(pitchStart, 0, 'g', 9).arg(overlapTarget).arg(int(pushPull));
+}
+
+bool OverlapTrackKey::FromString(const QString &s)
+{
+	QStringList f = s.split(' ', Qt::SkipEmptyParts);
+	if(f.size() != 9) return false;
+
+	bool ok(true), all(true);
+	float *values[7] = { &bounds[0], &bounds[1], &pixBounds[0],
+		&pixBounds[1], &search, &pitchEnd, &pitchStart };
+	for(int i=0; i<7; ++i)
+	{
+		*(values[i]) = f[i].toFloat(&ok);
+		all = all && ok;
+	}
+	overlapTarget = f[7].toInt(&ok);
+	all = all && ok;
+	pushPull = (f[8].toInt(&ok) != 0);
+
+	return all && ok;
+}
+
+//-----------------------------------------------------------------------------
+bool OverlapTrack::Measure(SoundExtractor &extractor, long f, long l)
+{
+	if(!extractor.Register(f, l))
+		return false;
+
+	key = OverlapTrackKey(extractor.Parameters());
+	first = f;
+	records = extractor.Overlaps();
+	Smooth();
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Replace each offset that the registration flagged, or that is too far
+// from the median of the trusted ones within radius, with that median.
+void OverlapTrack::Smooth(int radius, unsigned int tolerance)
+{
+	const long n = long(records.size());
+	std::vector<OverlapRecord> in(records);
+	std::vector<float> window;
+
+	for(long i=0; i<n; ++i)
+	{
+		window.clear();
+		for(long j=std::max(0L, i-radius); j<=std::min(n-1, i+radius); ++j)
+			if(!in[j].isIffy) window.push_back(in[j].overlap);
+		if(window.empty()) continue;
+
+		auto mid = window.begin() + window.size()/2;
+		std::nth_element(window.begin(), mid, window.end());
+		float median = *mid;
+
+		if(in[i].isIffy || std::fabs(in[i].overlap - median) > tolerance)
+		{
+			records[i].overlap = median;
+			records[i].isIffy = true;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+long OverlapTrack::NumIffy() const
+{
+	return long(std::count_if(records.begin(), records.end(),
+			[](const OverlapRecord &r) { return r.isIffy; }));
+}
+
+//-----------------------------------------------------------------------------
+QString OverlapTrack::RecordsToString() const
+{
+	QString s;
+	s.reserve(int(records.size()) * 12);
+
+	for(size_t i=0; i<records.size(); ++i)
+	{
+		const OverlapRecord &r = records[i];
+		if(i) s += (i % 16) ? ' ' : '\n';
+		s += QString::number(r.overlap, 'g', 7);
+		s += ',';
+		s += QString::number(r.minDiff);
+		if(r.isIffy) s += '?';
+	}
+
+	return s;
+}
+
+//-----------------------------------------------------------------------------
+bool OverlapTrack::Set(const QString &keyStr, long f, const QString &recordStr)
+{
+	OverlapTrackKey k;
+	if(!k.FromString(keyStr)) return false;
+
+	std::vector<OverlapRecord> recs;
+	QStringList items = recordStr.split(QRegularExpression("\\s+"),
+			Qt::SkipEmptyParts);
+	for(QString item : items)
+	{
+		OverlapRecord r;
+		if(item.endsWith('?'))
+		{
+			r.isIffy = true;
+			item.chop(1);
+		}
+
+		bool ok(true), okDiff(true);
+		int comma = item.indexOf(',');
+		r.overlap = item.left(comma).toFloat(&ok);
+		if(comma >= 0) r.minDiff = item.mid(comma+1).toUInt(&okDiff);
+		if(!ok || !okDiff) return false;
+
+		recs.push_back(r);
+	}
+
+	key = k;
+	first = f;
+	records.swap(recs);
+	return true;
+}
@@ -0,0 +1,117 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+// OverlapTrack -- the overlap of each frame of a reel with the frame before
+// it, measured once by a pre-pass and kept with the project, so that the
+// frame window and extraction look offsets up instead of searching for
+// them every time a frame is rendered.
+//
+// Measure() registers a range of frames with SoundExtractor::Register(),
+// which reads the frames on several threads and cross-correlates their
+// overlap profiles (OverlapRegistration). The offsets are then smoothed:
+// one that strays from the median of its neighbours by more than
+// OVERLAP_TRACK_TOLERANCE, or that the registration was unsure of, is
+// replaced by that median and flagged isIffy.
+//
+// A track is only good for the geometry it was measured with, which is its
+// OverlapTrackKey. The tone settings (lift, gamma, gain, negative) are not
+// part of the key, so extracting again with new ones reuses the track.
+
+#ifndef OVERLAPTRACK_H
+#define OVERLAPTRACK_H
+
+#include <vector>
+
+#include <QString>
+
+#include "overlap.h"
+#include "soundextractor.h"
+
+#define OVERLAP_TRACK_MEDIAN_RADIUS 3
+#define OVERLAP_TRACK_TOLERANCE 8 // 1/SOUNDEXTRACT_OVERLAP_ROWS of a frame
+
+//-----------------------------------------------------------------------------
+// The settings that decide where the overlap search looks, in the frame
+// window's normalized units (see SoundExtractorParams)
+class OverlapTrackKey {
+public:
+	float bounds[2];
+	float pixBounds[2];
+	float search;     // overlap[1]
+	float pitchEnd;   // overlap[2]
+	float pitchStart; // overlap[3]
+	int overlapTarget;
+	bool pushPull;    // the profile reads half the track
+
+	OverlapTrackKey();
+	OverlapTrackKey(const SoundExtractorParams &p);
+
+	// equal to within rounding through a project file
+	bool operator==(const OverlapTrackKey &k) const;
+	bool operator!=(const OverlapTrackKey &k) const { return !(*this == k); }
+
+	QString ToString() const;
+	bool FromString(const QString &s);
+};
+
+//-----------------------------------------------------------------------------
+class OverlapTrack {
+private:
+	OverlapTrackKey key;
+	long first; // frame number of records[0]
+	std::vector<OverlapRecord> records;
+
+public:
+	OverlapTrack() : first(0) {} ;
+
+	// Register frames [first,last] (absolute frame numbers) with the
+	// extractor's source, parameters and threads, and smooth the result.
+	// Returns false, leaving the track as it was, if cancelled.
+	bool Measure(SoundExtractor &extractor, long first, long last);
+	void Smooth(int radius=OVERLAP_TRACK_MEDIAN_RADIUS,
+			unsigned int tolerance=OVERLAP_TRACK_TOLERANCE);
+	void Clear() { records.clear(); first = 0; }
+
+	const OverlapTrackKey &Key() const { return key; }
+	bool IsEmpty() const { return records.empty(); }
+	long First() const { return first; }
+	long Last() const { return first + long(records.size()) - 1; }
+	bool Has(long frame) const { return frame >= first && frame <= Last(); }
+	const OverlapRecord &At(long frame) const
+		{ return records[size_t(frame - first)]; }
+	long NumIffy() const;
+
+	// the records as text, "overlap,minDiff" with a trailing ? if iffy;
+	// the overlap keeps the registration's fraction of a row
+	QString RecordsToString() const;
+	bool Set(const QString &keyStr, long first, const QString &recordStr);
+};
+
+#endif // OVERLAPTRACK_H
@@ -0,0 +1,188 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#include "pixelreadback.h"
+
+PixelReadback::PixelReadback(int ringSize) :
+	gl(nullptr),
+	slots(size_t(std::max(ringSize, 1))),
+	head(0),
+	count(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+PixelReadback::~PixelReadback()
+{
+	// The GL objects can only be freed with the context current, so the
+	// owner must call Release() before the context goes away.
+}
+
+//-----------------------------------------------------------------------------
+void PixelReadback::Initialize(QOpenGLFunctions_3_3_Core *funcs)
+{
+	if(gl) Release();
+
+	gl = funcs;
+
+	for(Slot &s : slots)
+		gl->glGenBuffers(1, &s.pbo);
+}
+
+//-----------------------------------------------------------------------------
+void PixelReadback::Release()
+{
+	if(!gl) return;
+
+	Finish();
+
+	for(Slot &s : slots)
+	{
+		gl->glDeleteBuffers(1, &s.pbo);
+		s = Slot();
+	}
+
+	gl = nullptr;
+	head = count = 0;
+}
+
+//-----------------------------------------------------------------------------
+void PixelReadback::Read(int x, int y, int width, int height,
+	GLenum format, GLenum type, void *dest, size_t size)
+{
+	if(!gl)
+		return;
+
+	if(count == slots.size())
+		Collect(Oldest());
+
+	Slot &s = slots[head];
+
+	gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+	if(s.capacity < size)
+	{
+		gl->glBufferData(GL_PIXEL_PACK_BUFFER, GLsizeiptr(size), nullptr,
+			GL_STREAM_READ);
+		s.capacity = size;
+	}
+
+	// with a pack buffer bound, the pointer is an offset into the buffer
+	gl->glReadPixels(x, y, width, height, format, type, nullptr);
+	gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	s.fence = gl->glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	s.dest = dest;
+	s.size = size;
+
+	head = (head + 1) % slots.size();
+	count++;
+}
+
+//-----------------------------------------------------------------------------
+bool PixelReadback::Signaled(Slot &s, GLuint64 timeout)
+{
+	if(!s.fence) return true;
+
+	// flush on the first wait so the fence is sure to reach the GPU
+	GLenum r = gl->glClientWaitSync(s.fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout);
+	return (r == GL_ALREADY_SIGNALED || r == GL_CONDITION_SATISFIED ||
+		r == GL_WAIT_FAILED);
+}
+
+//-----------------------------------------------------------------------------
+// Copy the oldest transfer out to its destination, waiting for it if
+// it hasn't finished.
+void PixelReadback::Collect(Slot &s)
+{
+	while(!Signaled(s, 1000000000)) // 1 s
+		;
+
+	if(s.fence)
+	{
+		gl->glDeleteSync(s.fence);
+		s.fence = nullptr;
+	}
+
+	gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, s.pbo);
+	void *p = gl->glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(s.size),
+		GL_MAP_READ_BIT);
+	if(p)
+	{
+		memcpy(s.dest, p, s.size);
+		gl->glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	s.dest = nullptr;
+	s.size = 0;
+	count--;
+}
+
+//-----------------------------------------------------------------------------
+// Collect, in order, the transfers that have already finished.
+void PixelReadback::Poll()
+{
+	while(count && Signaled(Oldest(), 0))
+		Collect(Oldest());
+}
+
+//-----------------------------------------------------------------------------
+// Wait until every transfer into the given region has been copied out.
+// Transfers complete in order, so this collects everything up to the last
+// one that overlaps the region. Regions with nothing pending return
+// immediately.
+void PixelReadback::WaitFor(const void *dest, size_t size)
+{
+	uintptr_t begin = uintptr_t(dest);
+	uintptr_t end = begin + size;
+
+	size_t last = 0; // number of transfers to collect
+	for(size_t i=0; i<count; ++i)
+	{
+		const Slot &s = slots[(head + slots.size() - count + i) % slots.size()];
+		uintptr_t sBegin = uintptr_t(s.dest);
+		if(sBegin < end && begin < sBegin + s.size)
+			last = i+1;
+	}
+
+	while(last--)
+		Collect(Oldest());
+}
+
+//-----------------------------------------------------------------------------
+void PixelReadback::Finish()
+{
+	while(count)
+		Collect(Oldest());
+}
@@ -0,0 +1,95 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+// PixelReadback -- asynchronous glReadPixels through a ring of pixel
+// buffer objects.
+//
+// Read() starts a transfer of a rectangle of the current read framebuffer
+// into the next PBO in the ring and drops a fence after it, then returns
+// without waiting. The pixels are copied to the caller's destination when
+// the transfer is collected: by Poll() if the fence has already signaled,
+// or by WaitFor()/Finish() when the caller needs the data. This lets the
+// readback of frame N overlap with the upload and render of frame N+1.
+//
+// Transfers always complete in the order they were started. When the ring
+// is full, Read() collects the oldest transfer first.
+//
+// All methods must be called with the GL context current. A destination
+// must stay valid until its transfer has been collected.
+
+#ifndef PIXELREADBACK_H
+#define PIXELREADBACK_H
+
+#include <QOpenGLFunctions_3_3_Core>
+
+#include <vector>
+
+#define PIXELREADBACK_DEFAULT_RING 4
+
+class PixelReadback {
+private:
+	class Slot {
+	public:
+		GLuint pbo;
+		size_t capacity;
+		GLsync fence;
+		void *dest;
+		size_t size;
+		Slot() : pbo(0), capacity(0), fence(nullptr), dest(nullptr), size(0) {} ;
+	};
+
+	QOpenGLFunctions_3_3_Core *gl;
+	std::vector<Slot> slots;
+	size_t head;   // slot the next Read() will use
+	size_t count;  // transfers in flight, ending at head
+
+	Slot &Oldest() { return slots[(head + slots.size() - count) % slots.size()]; }
+	bool Signaled(Slot &s, GLuint64 timeout);
+	void Collect(Slot &s);
+
+public:
+	PixelReadback(int ringSize=PIXELREADBACK_DEFAULT_RING);
+	~PixelReadback();
+
+	void Initialize(QOpenGLFunctions_3_3_Core *funcs);
+	void Release();
+	bool IsInitialized() const { return gl != nullptr; }
+
+	void Read(int x, int y, int width, int height,
+		GLenum format, GLenum type, void *dest, size_t size);
+
+	void Poll();
+	void WaitFor(const void *dest, size_t size=1);
+	void Finish();
+
+	size_t NumPending() const { return count; }
+};
+
+#endif // PIXELREADBACK_H
@@ -32,185 +32,256 @@
 #include <sstream>
 #include <string>
 #include <cmath>
+#include <memory>
+#include <vector>
 #include <errno.h>
 
 #include "DPX.h"
+#include "dpxframeindex.h"
+#include "dpxunpack.h"
+#include "mappedinstream.h"
 #include "readframedpx.h"
 #include "vfbexception.h"
 
 using namespace dpx;
 
-/* ReadFrameDPX - read a single frame from a DPX file
- * arguments:
- *   dpxfn: the filename of the dpx file
- *   buf:   an existing target buffer of sufficient size, or NULL
- *
- * The DPX image is returned in buf (which is also returned by the function)
- * in row-major order, top-to-bottom, left-to-right
- */
-double *ReadFrameDPX(const char *dpxfn, double *buf=NULL)
+// DPXReadHeader - parse the header of an opened DPX, or throw
+static void DPXReadHeader(const char *who, const char *dpxfn,
+		dpx::Reader &dpx)
 {
-	InStream img;
-
-	// keep this around, since all the frames will be the same size
-	static unsigned char *byteBuf;
-
-	if(!img.Open(dpxfn))
+	if(!dpx.ReadHeader())
 	{
 		QString msg;
-		msg += "ReadFrameDPX: Cannot open ";
+		msg += who;
+		msg += ": Cannot parse DPX header of ";
 		msg += dpxfn;
 		msg += "\n";
-		if(errno)
-			msg += strerror(errno);
+		if(errno) msg += strerror(errno);
 		throw vfbexception(msg);
 	}
+}
 
-	dpx::Reader dpx;
-	dpx.SetInStream(&img);
-	if(!dpx.ReadHeader())
+// DPXOpenFrame - map a DPX and describe its first image element. The
+// indexed record is used if it matches the file on disk (by size and
+// modification time); only otherwise is the header parsed. Returns true if dpx.header was parsed.
+static bool DPXOpenFrame(const char *who, const char *dpxfn,
+		MappedInStream &img, dpx::Reader &dpx, const DPXFrameInfo *indexed,
+		DPXFrameInfo &info)
+{
+	if(!img.Open(dpxfn))
 	{
 		QString msg;
-		msg += "ReadFrameDPX: Cannot parse DPX header of ";
+		msg += who;
+		msg += ": Cannot open ";
 		msg += dpxfn;
 		msg += "\n";
-		if(errno)
-			msg += strerror(errno);
-		img.Close();
+		if(errno) msg += strerror(errno);
 		throw vfbexception(msg);
 	}
 
-	dpx::DataSize size = dpx.header.ComponentDataSize(0);
-	int bitDepth = dpx.header.ComponentByteCount(0) * 8;
+	dpx.SetInStream(&img);
+
+	if(indexed && indexed->valid && indexed->fileSize == img.Size() &&
+			indexed->fileTime == img.ModifiedTime())
+	{
+		info = *indexed;
+		return false;
+	}
 
-	int numChannels = dpx.header.ImageElementComponentCount(0);
+	DPXReadHeader(who, dpxfn, dpx);
+	info.FromHeader(dpx.header, img.Size(), img.ModifiedTime());
+	return true;
+}
+
+// DPXPackedFormatOf - which of the dpxunpack kernels can read the first
+// image element, if any. 10-bit samples are taken to run on across word
+// (and scanline) boundaries, which is always true for RGB and is what
+// grayscale scans with widths not divisible by 3 need.
+static bool DPXPackedFormatOf(const DPXFrameInfo &info, DPXPackedFormat &fmt)
+{
+	int numChannels = info.numComponents;
+
+	if(info.encoding != kNone) return false;
+
+	switch(info.bitDepth)
+	{
+	case 10:
+		if(numChannels != 1 && numChannels != 3) return false;
+		if(info.packing == kFilledMethodA)
+			fmt = DPX_PACKED_10_FILLED_A;
+		else if(info.packing == kFilledMethodB)
+			fmt = DPX_PACKED_10_FILLED_B;
+		else
+			return false;
+		return true;
+	case 12:
+		if(info.packing == kFilledMethodA)
+			fmt = DPX_PACKED_12_FILLED_A;
+		else if(info.packing == kFilledMethodB)
+			fmt = DPX_PACKED_12_FILLED_B;
+		else
+			return false;
+		return true;
+	case 16:
+		fmt = DPX_PACKED_16;
+		return true;
+	default:
+		return false;
+	}
+}
+
+// ReadDPXSamples - unpack the first image element into native 16-bit
+// samples. Mapped files are unpacked straight from the mapping; otherwise
+// the payload goes through a per-thread scratch buffer.
+static void ReadDPXSamples(InStream *fd, const DPXFrameInfo &info,
+		DPXPackedFormat fmt, uint16_t *dst, size_t nSamples)
+{
+	size_t packedSize = DPXPackedSize(fmt, nSamples);
+	bool swap = info.byteSwap;
+
+	MappedInStream *mapped = dynamic_cast<MappedInStream *>(fd);
+	if(mapped)
+	{
+		const uint8_t *payload = mapped->Data(info.imageOffset, packedSize);
+		if(payload)
+		{
+			DPXUnpack(fmt, payload, dst, nSamples, swap);
+			return;
+		}
+	}
+
+	thread_local std::vector<uint8_t> packed;
+	packed.resize(packedSize);
+
+	// a short file leaves the missing samples black rather than stale
+	fd->Seek(info.imageOffset, fd->kStart);
+	size_t got = fd->Read(packed.data(), packedSize);
+	if(got < packedSize)
+		memset(packed.data()+got, 0, packedSize-got);
+
+	DPXUnpack(fmt, packed.data(), dst, nSamples, swap);
+}
+
+/* ReadFrameDPX - read a single frame from a DPX file
+ * arguments:
+ *   dpxfn: the filename of the dpx file
+ *   buf:   an existing target buffer of sufficient size, or NULL
+ *   info:  the frame's record from a DPXFrameIndex, or NULL
+ *
+ * The DPX image is returned in buf (which is also returned by the function)
+ * in row-major order, top-to-bottom, left-to-right, as gray values: [0-1]
+ * for float and double, [0-65535] for uint16_t
+ */
+template <typename T>
+T *ReadFrameDPX(const char *dpxfn, T *buf, const DPXFrameInfo *indexed)
+{
+	MappedInStream img;
+	dpx::Reader dpx;
+	DPXFrameInfo info;
+
+	// Per-thread scratch space for the packed samples. It is resized for
+	// every frame, so sequences that change resolution are handled, and
+	// it is only reallocated when a frame is bigger than any before it.
+	thread_local std::vector<unsigned char> scratch;
+
+	bool parsed = DPXOpenFrame("ReadFrameDPX", dpxfn, img, dpx, indexed, info);
+
+	int numChannels = info.numComponents;
 
 	if(buf == NULL)
 	{
-		buf = new double [dpx.header.Width() * dpx.header.Height()];
+		buf = new T [size_t(info.width) * info.height];
 		if(buf == NULL)
 		{
 			throw vfbexception("Out of Memory: DPX buf");
 		}
 	}
 
-	if(byteBuf == NULL)
+	// 10-, 12- and 16-bit data: fused unpack and rescale, then average
+	DPXPackedFormat packed;
+	if(DPXPackedFormatOf(info, packed))
 	{
-		byteBuf = new unsigned char
-			[dpx.header.Width() * dpx.header.Height() *
-			numChannels * dpx.header.ComponentByteCount(0)];
+		size_t nPixels = size_t(info.width) * info.height;
+		thread_local std::vector<uint16_t> samples;
+		samples.resize(nPixels * numChannels);
 
-		if(byteBuf == NULL)
-		{
-			throw vfbexception("Out of Memory: DPX byteBuf");
-		}
+		ReadDPXSamples(&img, info, packed, samples.data(),
+				nPixels * numChannels);
+		DPXSamplesToGray(samples.data(), buf, nPixels, numChannels);
+
+		img.Close();
+		return buf;
 	}
 
+	// anything else goes through opendpx, which needs the whole header
+	if(!parsed) DPXReadHeader("ReadFrameDPX", dpxfn, dpx);
+
+	int bitDepth = dpx.header.ComponentByteCount(0) * 8;
+
+	scratch.resize(size_t(dpx.header.Width()) * dpx.header.Height() *
+			numChannels * dpx.header.ComponentByteCount(0));
+	unsigned char *byteBuf = scratch.data();
+
 	dpx.ReadImage(byteBuf);
 
-	// Convert from uint8 [0-255] or unit16 [0-65535] to double [0-1]
+	// Convert from uint8 [0-255] or unit16 [0-65535] to gray
 	// Note that the color-to-grayscale isn't weighted to give green
 	// more influence: so the picture area may not "look nice" to human
 	// perception, but the soundtrack area isn't in color anyway, and the
 	// portions of the code that care about the picture area will work
 	// just as well with this alternate response scale (equal weight) as
 	// with the human perception scale, and the computation is faster.
-	long i;
-	double scale;
+	size_t nPixels = size_t(dpx.header.Width()) * dpx.header.Height();
 
 	if(bitDepth == 8)
 	{
-		scale = 1.0/(numChannels * 0x00FF);
-		if(numChannels == 1)
-		{
-			for(i=0; i< dpx.header.Width() * dpx.header.Height(); i++)
-				buf[i] = double(byteBuf[i]) * scale;
-		}
-		else
-		{
-			for(i=0; i< dpx.header.Width() * dpx.header.Height(); i++)
-				buf[i] =
-					(int(byteBuf[3*i]) +
-					int(byteBuf[3*i+1]) +
-					int(byteBuf[3*i+2]))
-					* scale;
-		}
+		// widen to 16 bits (v*257 maps 0xFF to 0xFFFF) for the gray kernels
+		thread_local std::vector<uint16_t> samples;
+		samples.resize(nPixels * numChannels);
+		for(size_t i=0; i<nPixels * numChannels; ++i)
+			samples[i] = uint16_t(byteBuf[i] * 257);
+		DPXSamplesToGray(samples.data(), buf, nPixels, numChannels);
 	}
 	else if(bitDepth == 16)
 	{
-		scale = 1.0/(numChannels * 0x00FFFF);
-		if(numChannels == 1)
-		{
-			for(i=0; i< dpx.header.Width() * dpx.header.Height(); i++)
-				buf[i] = double(byteBuf[2*i] + 0x0100*byteBuf[2*i+1]) * scale;
-		}
-		else
-		{
-			int c;
-			double rgb[3];
-			for(i=0; i< dpx.header.Width() * dpx.header.Height(); i++)
-			{
-				for(c=0; c<3; c++)
-					rgb[c] = byteBuf[6*i+2*c] + 0x0100*byteBuf[6*i+2*c+1];
-				buf[i] = (rgb[0] + rgb[1] + rgb[2]) * scale;
-			}
-		}
+		DPXSamplesToGray(reinterpret_cast<const uint16_t *>(byteBuf), buf,
+				nPixels, numChannels);
 	}
 	else
-	{
-		fprintf(stderr, "ERROR: Unsupported bit depth: %d in '%s'\n",
-				bitDepth, dpxfn);
-		exit(1);
-	}
-
-	img.Close();
-
-	return buf;
-}
-unsigned char* ReadFrameDPX_ImageData(const char *dpxfn, unsigned char *buf,
-		int &bufSize, int &width,int &height,bool &endian,
-		GLenum &pix_fmt,int &num_components)
-{
-	InStream img;
-
-	// keep this around, since all the frames will be the same size
-	static unsigned char *byteBuf;
-
-	if(!img.Open(dpxfn))
-	{
-		QString msg;
-		msg += "ReadFrameDPX_ImageData: Cannot open ";
-		msg += dpxfn;
-		msg += "\n";
-		if(errno) msg += strerror(errno);
-		throw vfbexception(msg);
-	}
-
-	dpx::Reader dpx;
-	dpx.SetInStream(&img);
-	if(!dpx.ReadHeader())
 	{
 		img.Close();
 		QString msg;
-		msg += "ReadFrameDPX_ImageData: Cannot parse DPX header of  ";
+		msg += "ReadFrameDPX: Unsupported bit depth ";
+		msg += QString::number(bitDepth);
+		msg += " in ";
 		msg += dpxfn;
-		msg += "\n";
-		if(errno) msg += strerror(errno);
 		throw vfbexception(msg);
 	}
 
-	dpx::DataSize size = dpx.header.ComponentDataSize(0);
-	int bitDepth = dpx.header.ComponentByteCount(0) * 8;
+	img.Close();
 
-	int numChannels = dpx.header.ImageElementComponentCount(0);
-	int pixel_size; //in bytes;
-	bool doRawRead(false);
-	int remainder(0);
+	return buf;
+}
+template float *ReadFrameDPX<float>(const char *, float *,
+		const DPXFrameInfo *);
+template double *ReadFrameDPX<double>(const char *, double *,
+		const DPXFrameInfo *);
+template uint16_t *ReadFrameDPX<uint16_t>(const char *, uint16_t *,
+		const DPXFrameInfo *);
+
+// DPXImageLayout - decide how the first image element of a DPX will be
+// handed to OpenGL: the pixel format, the size of the buffer it needs, and
+// whether the file payload can be used as-is (doRawRead).
+static void DPXImageLayout(const DPXFrameInfo &info, int &bufSize, int &width,
+		int &height, GLenum &pix_fmt, int &num_components, int &pixel_size,
+		bool &doRawRead)
+{
+	int numChannels = info.numComponents;
 
-	width=dpx.header.Width();
-	height= dpx.header.Height();
+	width = info.width;
+	height = info.height;
 
-	if(dpx.header.BitDepth(0) == 10 && numChannels == 3)
+	if(info.bitDepth == 10 && numChannels == 3)
 	{
 		pix_fmt = GL_UNSIGNED_INT_10_10_10_2;
 		bufSize = width * height * 4;
@@ -218,7 +289,7 @@ unsigned char* ReadFrameDPX_ImageData(const char *dpxfn, unsigned char *buf,
 		pixel_size=4;
 		doRawRead = true;
 	}
-	else if (dpx.header.BitDepth(0) == 16 && numChannels ==3)
+	else if (info.bitDepth == 16 && numChannels ==3)
 	{
 		// XXX: Why 8 instead of pixel_size of 6?
 		bufSize = width * height * 8;
@@ -227,7 +298,7 @@ unsigned char* ReadFrameDPX_ImageData(const char *dpxfn, unsigned char *buf,
 		pixel_size = 6;
 		doRawRead = true;
 	}
-	else if(dpx.header.BitDepth(0) == 16 && numChannels == 1) //16bit luma
+	else if(info.bitDepth == 16 && numChannels == 1) //16bit luma
 	{
 		bufSize = width * height * 2;
 		pix_fmt = GL_UNSIGNED_SHORT;
@@ -237,21 +308,36 @@ unsigned char* ReadFrameDPX_ImageData(const char *dpxfn, unsigned char *buf,
 	}
 	else
 	{
-		if(
-				dpx.header.ImageElementComponentCount(0) == 1 &&
-				dpx.header.BitDepth(0)==10 &&
-				dpx.header.ImagePacking(0) == 1 &&
-				dpx.header.Width() % 3 != 0 )
-		{
-			remainder = 3 - (width % 3);
-		}
-
 		bufSize = width * height * numChannels * 2;
 		num_components = numChannels;
 		pix_fmt = GL_UNSIGNED_SHORT;
 		pixel_size = 2;
 		doRawRead = false;
 	}
+}
+
+// ReadDPXImageData - read the image of an opened DPX into buf. The header
+// is only parsed (if it wasn't already) when opendpx has to read it.
+static unsigned char *ReadDPXImageData(const char *dpxfn, dpx::Reader &dpx,
+		bool parsed, const DPXFrameInfo &info, unsigned char *buf,
+		int &bufSize, int &width,int &height,bool &endian,
+		GLenum &pix_fmt,int &num_components)
+{
+	int pixel_size; //in bytes;
+	bool doRawRead(false);
+	int capacity(buf ? bufSize : 0);
+
+	DPXImageLayout(info, bufSize, width, height, pix_fmt, num_components,
+			pixel_size, doRawRead);
+
+	// don't trust a buffer sized for an earlier (smaller) frame
+	if(buf != NULL && capacity < bufSize)
+	{
+		delete [] buf;
+		buf = NULL;
+	}
+	else if(buf != NULL)
+		bufSize = capacity;
 
 	if(buf == NULL)
 	{
@@ -262,80 +348,31 @@ unsigned char* ReadFrameDPX_ImageData(const char *dpxfn, unsigned char *buf,
 
 	if(doRawRead)
 	{
-		endian=dpx.header.RequiresByteSwap();
+		endian = info.byteSwap;
 
-		dpx.fd->Seek( dpx.header.imageOffset,dpx.fd->kStart);
-		dpx.fd->Read(buf,dpx.header.Width() * dpx.header.Height() * pixel_size);
+		dpx.fd->Seek(info.imageOffset, dpx.fd->kStart);
+		dpx.fd->Read(buf, size_t(width) * height * pixel_size);
 	}
 	else
 	{
-		if(!remainder)
+		DPXPackedFormat packed;
+
+		if(DPXPackedFormatOf(info, packed))
 		{
-			if(!dpx.ReadImage(buf, kWord, dpx.header.ImageDescriptor(0)))
-				throw("This DPX encoding is not supported (e.g., RLE)");
+			// Our own kernels byteswap, unpack and rescale in one pass.
+			// They also read grayscale 10-bit scans whose width isn't
+			// divisible by 3, which opendpx cannot (it requires the
+			// scanlines to break on word boundaries).
+			ReadDPXSamples(dpx.fd, info, packed,
+					reinterpret_cast<uint16_t *>(buf),
+					size_t(width) * height * num_components);
 		}
 		else
 		{
-			// remainder non-zero means that the DPX is grayscale with
-			// 10-bit samples packed three-to-a-word, but the image width
-			// is not divisible by 3
-			// opendpx cannot read this properly (it requires the scanlines
-			// to break on word boundaries), so we have to read it ourselves
-			// and unpack it manually.
-
-			int numWords = ceil(double(width*height)/3.0);
-			static uint32_t *wbuf(NULL);
-			if(wbuf == NULL)
-			{
-				// make a buffer to hold the 32-bit words
-				wbuf = new uint32_t[numWords];
-				if(wbuf == NULL)
-					throw vfbexception("Out of Memory: DPX word buf");
-
-			}
-
-			// read in the whole array of 32-bit words from the DPX file
-			dpx.fd->Seek(dpx.header.imageOffset, dpx.fd->kStart);
-			dpx.fd->Read(wbuf, numWords*sizeof(uint32_t));
-
-			// swap the bytes in the words if necessary
-			if(dpx.header.RequiresByteSwap())
-			{
-				for(int w=0; w<numWords; ++w)
-				{
-					uint32_t *cp = wbuf+w;
-					*cp = (*cp >> 16) | (*cp << 16);
-					*cp = ((*cp & 0xFF00FF00) >> 8) | ((*cp & 0x00FF00FF) << 8);
-				}
-			}
-
-			// use a proxy to more easily enter the extracted sample values
-			// as 16-bit words in the buf array.
-			uint16_t *ubuf;
-			ubuf = reinterpret_cast<uint16_t *>(buf);
-
-			uint32_t *word; // pointer into wbuf
-			// double scale = 65535.0 / 1023.0; // scale 10-bit to 16-bit
-
-			int nSample = 0; // number of samples remaining in the current word
-			word = wbuf; // start at the beginning of the buffer
-			for(int i=0; i<width*height; ++i)
-			{
-				if(nSample==0)
-				{
-					word++;
-					nSample = 3;
-					*word >>=2; // remove the fill bits
-				}
-				// unpack the 10-bit word and rescale it to 16 bits
-				// ubuf[i] = uint16_t(((*word) & 0x03FF) * scale);
-				// approximate this scaling with bit operations for speed:
-				ubuf[i] = *word & 0x03FF;
-				ubuf[i] = (ubuf[i] << 6) | (ubuf[i] >> 4);
-				// shift the 32-bit word down and update the packed count
-				(*word) >>= 10;
-				nSample--;
-			}
+			if(!parsed) DPXReadHeader("ReadFrameDPX_ImageData", dpxfn, dpx);
+			if(!dpx.ReadImage(buf, kWord, dpx.header.ImageDescriptor(0)))
+				throw vfbexception(
+						"This DPX encoding is not supported (e.g., RLE)");
 		}
 
 		// either way, we've already swapped the bytes if it was needed.
@@ -343,148 +380,74 @@ unsigned char* ReadFrameDPX_ImageData(const char *dpxfn, unsigned char *buf,
 
 	}
 
+	return buf;
+}
+
+unsigned char* ReadFrameDPX_ImageData(const char *dpxfn, unsigned char *buf,
+		int &bufSize, int &width,int &height,bool &endian,
+		GLenum &pix_fmt,int &num_components, const DPXFrameInfo *indexed)
+{
+	MappedInStream img;
+	dpx::Reader dpx;
+	DPXFrameInfo info;
+
+	bool parsed = DPXOpenFrame("ReadFrameDPX_ImageData", dpxfn, img, dpx,
+			indexed, info);
+
+	buf = ReadDPXImageData(dpxfn, dpx, parsed, info, buf, bufSize, width,
+			height, endian, pix_fmt, num_components);
+
 	img.Close();
 
 	return buf;
-
 }
 
-
-#ifdef USEBOOST
-/* ReadFrameDPX - read a single frame from a DPX file
+/* ReadFrameDPX_ImageData - read a single frame from a DPX file for display
  * arguments:
  *   dpxfn: the filename of the dpx file
- *   buf:   an existing target buffer of sufficient size, or NULL
+ *   frame: the texture to fill in (its buffer is reused when possible)
+ *   info:  the frame's record from a DPXFrameIndex, or NULL
  *
- * The DPX image is returned in buf (which is also returned by the function)
- * in row-major order, top-to-bottom, left-to-right
+ * The file is memory-mapped. When the image payload can be given to OpenGL
+ * as-is (the doRawRead layouts), the texture points straight at the mapping
+ * and keeps it alive; nothing is copied. Otherwise the image is unpacked
+ * into the texture's own buffer as usual.
  */
-boost::numeric::ublas::matrix<double> ReadFrameDPX(const char *dpxfn)
+FrameTexture *ReadFrameDPX_ImageData(const char *dpxfn, FrameTexture *frame,
+		const DPXFrameInfo *indexed)
 {
-	InStream img;
-	boost::numeric::ublas::matrix<double> buf;
-
-	// keep this around, since all the frames will be the same size
-	static unsigned char *byteBuf;
-
-	if(!img.Open(dpxfn))
-	{
-		QString msg;
-		msg += "ReadFrameDPX: Cannot open ";
-		msg += dpxfn;
-		msg += "\n";
-		if(errno) msg += strerror(errno);
-		throw vfbexception(msg);
-	}
-
+	std::shared_ptr<MappedInStream> img(new MappedInStream);
 	dpx::Reader dpx;
-	dpx.SetInStream(&img);
-	if(!dpx.ReadHeader())
-	{
-		img.Close();
-		QString msg;
-		msg += "ReadFrameDPX: Cannot parse DPX header of ";
-		msg += dpxfn;
-		msg += "\n";
-		if(errno) msg += strerror(errno);
-		throw vfbexception(msg);
-	}
+	DPXFrameInfo info;
 
-	dpx::DataSize size = dpx.header.ComponentDataSize(0);
-	int bitDepth = dpx.header.ComponentByteCount(0) * 8;
+	bool parsed = DPXOpenFrame("ReadFrameDPX_ImageData", dpxfn, *img, dpx,
+			indexed, info);
 
-	int numChannels = dpx.header.ImageElementComponentCount(0);
+	int pixel_size;
+	bool doRawRead;
+	int bufSize;
 
-	buf.resize(dpx.header.Height(), dpx.header.Width(), false);
+	DPXImageLayout(info, bufSize, frame->width, frame->height, frame->format,
+			frame->nComponents, pixel_size, doRawRead);
 
-	if(byteBuf == NULL)
+	if(doRawRead)
 	{
-		byteBuf = new unsigned char
-			[dpx.header.Width() * dpx.header.Height() *
-			numChannels * dpx.header.ComponentByteCount(0)];
-
-		if(byteBuf == NULL)
+		const uint8_t *pixels = img->Data(info.imageOffset,
+				size_t(frame->width) * frame->height * pixel_size);
+		if(pixels)
 		{
-			throw vfbexception("Out of Memory: DPX byteBuf");
+			frame->isNonNativeEndianess = info.byteSwap;
+			frame->SetMapping(img, pixels);
+			return frame;
 		}
 	}
 
-	dpx.ReadImage(byteBuf);
+	// the payload needs unpacking (or the file is short): use the
+	// texture's own buffer
+	frame->ReleaseMapping();
+	frame->buf = ReadDPXImageData(dpxfn, dpx, parsed, info, frame->buf,
+			frame->bufSize, frame->width, frame->height,
+			frame->isNonNativeEndianess, frame->format, frame->nComponents);
 
-	// Convert from uint8 [0-255] or unit16 [0-65535] to double [0-1]
-	// Note that the color-to-grayscale isn't weighted to give green
-	// more influence: so the picture area may not "look nice" to human
-	// perception, but the soundtrack area isn't in color anyway, and the
-	// portions of the code that care about the picture area will work
-	// just as well with this alternate response scale (equal weight) as
-	// with the human perception scale, and the computation is faster.
-	long i,r,c;
-	double scale;
-
-	if(bitDepth == 8)
-	{
-		scale = 1.0/(numChannels * 0x00FF);
-		if(numChannels == 1)
-		{
-			i = 0;
-			for(r=0; r<dpx.header.Height(); r++)
-			for(c=0; c<dpx.header.Width(); c++)
-			{
-				buf(r,c) = double(byteBuf[i++]) * scale;
-			}
-		}
-		else
-		{
-			i = 0;
-			for(r=0; r<dpx.header.Height(); r++)
-			for(c=0; c<dpx.header.Width(); c++)
-			{
-				buf(r,c) =
-					(int(byteBuf[3*i]) +
-					int(byteBuf[3*i+1]) +
-					int(byteBuf[3*i+2]))
-					* scale;
-				i++;
-			}
-		}
-	}
-	else if(bitDepth == 16)
-	{
-		scale = 1.0/(numChannels * 0x00FFFF);
-		if(numChannels == 1)
-		{
-			i = 0;
-			for(r=0; r<dpx.header.Height(); r++)
-			for(c=0; c<dpx.header.Width(); c++)
-			{
-				buf(r,c) = double(byteBuf[2*i] + 0x0100*byteBuf[2*i+1]) * scale;
-				i++;
-			}
-		}
-		else
-		{
-			int ch;
-			double rgb[3];
-
-			i = 0;
-			for(r=0; r<dpx.header.Height(); r++)
-			for(c=0; c<dpx.header.Width(); c++)
-			{
-				for(ch=0; ch<3; ch++)
-					rgb[ch] = byteBuf[6*i+2*ch] + 0x0100*byteBuf[6*i+2*ch+1];
-				buf(r,c)= (rgb[0] + rgb[1] + rgb[2]) * scale;
-				i++;
-			}
-		}
-	}
-	else
-	{
-		fprintf(stderr, "ERROR: Unsupported bit depth: %d in '%s'\n",
-				bitDepth, dpxfn);
-		exit(1);
-
-	}
-	img.Close();
-	return buf;
+	return frame;
 }
-#endif
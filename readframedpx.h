@@ -31,11 +31,20 @@
 #ifndef READFRAMEDPX_H
 #define READFRAMEDPX_H
 #include <QOpenGLTexture>
-//#include <boost/numeric/ublas/matrix.hpp>
 
-double *ReadFrameDPX(const char *dpxfn, double *buf);
-//boost::numeric::ublas::matrix<double> ReadFrameDPX(const char *dpxfn);
+#include "frametexture.h"
+
+class DPXFrameInfo;
+
+// info is the frame's DPXFrameIndex record, if there is one; the header is
+// then only parsed if the file doesn't match it. T is float, double (gray
+// in [0-1]) or uint16_t (gray in [0-65535]).
+template <typename T>
+T *ReadFrameDPX(const char *dpxfn, T *buf, const DPXFrameInfo *info=NULL);
 unsigned char *ReadFrameDPX_ImageData(const char *dpxfn, unsigned char *buf,
 		int &bufSize, int &width, int &height, bool &endian,
-		GLenum &pix_fmt, int &num_components);
+		GLenum &pix_fmt, int &num_components,
+		const DPXFrameInfo *info=NULL);
+FrameTexture *ReadFrameDPX_ImageData(const char *dpxfn, FrameTexture *frame,
+		const DPXFrameInfo *info=NULL);
 #endif
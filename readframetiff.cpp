@@ -35,14 +35,23 @@
 
 #include "vfbexception.h"
 
-double *ReadFrameTIFF(const char *fn, double *buf)
+template <typename T>
+T *ReadFrameTIFF(const char *fn, T *buf)
 {
 	throw vfbexception("Write ReadFrameTIFF() function.");
 	return buf;
 }
 
+template float *ReadFrameTIFF<float>(const char *, float *);
+template double *ReadFrameTIFF<double>(const char *, double *);
+template uint16_t *ReadFrameTIFF<uint16_t>(const char *, uint16_t *);
+
+/* ReadFrameTIFF_ImageData - read a single TIFF frame for display
+ * buf (of bufSize bytes) is reused if it is big enough for this frame,
+ * otherwise it is replaced, and bufSize is updated to match.
+ */
 unsigned char *ReadFrameTIFF_ImageData(const char *fn, unsigned char *buf,
-		int &width, int &height, bool &endian,
+		int &bufSize, int &width, int &height, bool &endian,
 		GLenum &pix_fmt, int &num_components)
 {
 	TIFF* tif = TIFFOpen(fn, "r");
@@ -140,10 +149,17 @@ unsigned char *ReadFrameTIFF_ImageData(const char *fn, unsigned char *buf,
 		throw vfbexception("Out of memory: TIFF scanline buffer.");
 	}
 
+	int imageSize = imageWidth * imageHeight * numChannels * (bitDepth/8u);
+	if(buf != NULL && bufSize < imageSize)
+	{
+		delete [] buf;
+		buf = NULL;
+	}
+
 	if(buf == NULL)
 	{
-		buf = new unsigned char[
-				imageWidth * imageHeight * numChannels * (bitDepth/8u)];
+		buf = new unsigned char[imageSize];
+		bufSize = imageSize;
 		if(buf==NULL)
 		{
 			_TIFFfree(tbuf);
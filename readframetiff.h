@@ -33,9 +33,13 @@
 
 #include <QOpenGLTexture>
 
-double *ReadFrameTIFF(const char *fn, double *buf);
+#include <cstdint>
+
+// gray values as for ReadFrameDPX(): T is float, double or uint16_t
+template <typename T>
+T *ReadFrameTIFF(const char *fn, T *buf);
 unsigned char *ReadFrameTIFF_ImageData(const char *fn, unsigned char *buf,
-		int &width, int &height, bool &endian,
+		int &bufSize, int &width, int &height, bool &endian,
 		GLenum &pix_fmt, int &num_components);
 
 #endif // READFRAMETIFF_H
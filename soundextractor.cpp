@@ -0,0 +1,794 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "soundextractor.h"
+#include "overlapregistration.h"
+#include "overlapsearch.h"
+#include "overlaptrack.h"
+#include "vfbexception.h"
+
+// Offsets (in steps of two pixels) and weights of the 5x5 render_mode 0
+// kernels, in the order of the shader's ioffset[] table. Tap 18 repeats
+// the shader's +dyStep so the output matches the GPU exactly.
+static const int kernelX[25] = {
+	-2,-1, 0, 1, 2,
+	-2,-1, 0, 1, 2,
+	-2,-1, 0, 1, 2,
+	-2,-1, 0, 1, 2,
+	-2,-1, 0, 1, 2 };
+static const int kernelY[25] = {
+	 2, 2, 2, 2, 2,
+	 1, 1, 1, 1, 1,
+	 0, 0, 0, 0, 0,
+	-1,-1,-1, 1,-1,
+	-2,-2,-2,-2,-2 };
+
+static const float kernelSharpen[25] = {
+	-0.125f,-0.125f,-0.125f,-0.125f,-0.125f,
+	-0.125f, 0.25f,  0.25f,  0.25f, -0.125f,
+	-0.125f, 0.25f,  1.0f,   0.25f, -0.125f,
+	-0.125f, 0.25f,  0.25f,  0.25f, -0.125f,
+	-0.125f,-0.125f,-0.125f,-0.125f,-0.125f };
+
+static const float kernelBlur[25] = {
+	0.03252263605892945f, 0.03778591223705376f, 0.0397232373850157f,
+	0.03778591223705376f, 0.03252263605892945f,
+	0.03778591223705376f, 0.04390096672973462f, 0.04615181742593543f,
+	0.04390096672973462f, 0.03778591223705376f,
+	0.0397232373850157f,  0.04615181742593543f, 0.04851807170510919f,
+	0.04615181742593543f, 0.0397232373850157f,
+	0.03778591223705376f, 0.04390096672973462f, 0.04615181742593543f,
+	0.04390096672973462f, 0.03778591223705376f,
+	0.03252263605892945f, 0.03778591223705376f, 0.0397232373850157f,
+	0.03778591223705376f, 0.03252263605892945f };
+
+// pixels of the source read around the adjusted columns for the kernel
+#define KERNEL_REACH 4
+
+// the HSL lightness the shader takes of each sample
+static inline float Lightness(float r, float g, float b)
+{
+	return (std::max(std::max(r,g),b) + std::min(std::min(r,g),b)) / 2.0f;
+}
+
+// texture() along one axis of n texels at coordinate t: GL_LINEAR
+// filtering between texel centres, GL_CLAMP_TO_EDGE outside
+static inline float SampleLinear(const float *v, int n, float t)
+{
+	float p = t*n - 0.5f;
+	if(p <= 0.0f) return v[0];
+	if(p >= n-1) return v[n-1];
+	int i = int(p);
+	float f = p - i;
+	return v[i] + f*(v[i+1]-v[i]);
+}
+
+static inline uint16_t Swap16(uint16_t v)
+{
+	return uint16_t((v>>8) | (v<<8));
+}
+
+static inline uint32_t Swap32(uint32_t v)
+{
+	return (v>>24) | ((v>>8)&0xff00) | ((v<<8)&0xff0000) | (v<<24);
+}
+
+//-----------------------------------------------------------------------------
+// Add the footprint of n texture() lookups at x = start + i*step to a set
+// of per-column weights. Summing weight*pixel over the columns of a row
+// then gives the same result as summing the n filtered lookups.
+static void AddSamplePoints(std::vector<float> &weights, int width,
+		float start, float step, int n, float w)
+{
+	for(int i=0; i<n; ++i)
+	{
+		float p = (start + i*step)*width - 0.5f;
+		int x = int(std::floor(p));
+		float f = p - x;
+		weights[std::min(std::max(x, 0), width-1)] += w*(1.0f-f);
+		weights[std::min(std::max(x+1, 0), width-1)] += w*f;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Convert columns [x0,x1] of a frame image to planar float RGB in [0,1],
+// reading the pixel formats load_frame_texture() hands to OpenGL.
+static void UnpackColumns(const FrameTexture &tex, int x0, int x1,
+		std::vector<float> plane[3])
+{
+	const uint8_t *pixels = tex.Pixels();
+	const int w = x1 - x0 + 1;
+	const int n = tex.nComponents;
+	const bool swap = tex.isNonNativeEndianess;
+
+	for(int c=0; c<3; ++c)
+		plane[c].resize(size_t(w)*tex.height);
+
+	// video planes: the same conversion the shader does
+	if(tex.IsPlanar())
+	{
+		for(int y=0; y<tex.height; ++y)
+			tex.PlanarToRGB(y, x0, x1, &(plane[0][size_t(y)*w]),
+					&(plane[1][size_t(y)*w]), &(plane[2][size_t(y)*w]));
+		return;
+	}
+
+	if(pixels == NULL)
+		throw vfbexception("SoundExtractor: frame has no image data");
+
+	for(int y=0; y<tex.height; ++y)
+	{
+		float *r = &(plane[0][size_t(y)*w]);
+		float *g = &(plane[1][size_t(y)*w]);
+		float *b = &(plane[2][size_t(y)*w]);
+		size_t rowStart = size_t(y)*tex.width + x0;
+
+		switch(tex.format)
+		{
+		case GL_UNSIGNED_INT_10_10_10_2:
+		case GL_UNSIGNED_INT_8_8_8_8_REV:
+			for(int x=0; x<w; ++x)
+			{
+				uint32_t v;
+				memcpy(&v, pixels + (rowStart+x)*4, 4);
+				if(swap) v = Swap32(v);
+				if(tex.format == GL_UNSIGNED_INT_10_10_10_2)
+				{
+					r[x] = ((v>>22) & 0x3ff) / 1023.0f;
+					g[x] = ((v>>12) & 0x3ff) / 1023.0f;
+					b[x] = ((v>>2) & 0x3ff) / 1023.0f;
+				}
+				else
+				{
+					r[x] = (v & 0xff) / 255.0f;
+					g[x] = ((v>>8) & 0xff) / 255.0f;
+					b[x] = ((v>>16) & 0xff) / 255.0f;
+				}
+			}
+			break;
+		case GL_UNSIGNED_SHORT:
+			for(int x=0; x<w; ++x)
+			{
+				uint16_t v[3];
+				memcpy(v, pixels + (rowStart+x)*n*2, (n==1 ? 1 : 3)*2);
+				if(n==1) v[1] = v[2] = v[0];
+				for(int c=0; c<3; ++c)
+					if(swap) v[c] = Swap16(v[c]);
+				r[x] = v[0] / 65535.0f;
+				g[x] = v[1] / 65535.0f;
+				b[x] = v[2] / 65535.0f;
+			}
+			break;
+		case GL_UNSIGNED_BYTE:
+			for(int x=0; x<w; ++x)
+			{
+				const uint8_t *p = pixels + (rowStart+x)*n;
+				r[x] = p[0] / 255.0f;
+				g[x] = p[n==1 ? 0 : 1] / 255.0f;
+				b[x] = p[n==1 ? 0 : 2] / 255.0f;
+			}
+			break;
+		default:
+			throw vfbexception(QString(
+					"SoundExtractor: unsupported pixel format %1").arg(
+					int(tex.format)));
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Layout - which columns of a frame of a given width the audio and
+// overlap passes read, and with what weight.
+class SoundExtractor::Layout {
+public:
+	int width;
+	int col0, col1;              // adjusted columns
+	std::vector<float> audio[2]; // file audio, left and right half
+	std::vector<float> sound;    // overlap profile, soundtrack
+	std::vector<float> pix;      // overlap profile, picture
+
+	Layout() : width(0), col0(0), col1(-1) {} ;
+	void Build(int w, const SoundExtractorParams &p);
+};
+
+void SoundExtractor::Layout::Build(int w, const SoundExtractorParams &p)
+{
+	std::vector<float> *sets[4] = { &audio[0], &audio[1], &sound, &pix };
+	float trackWidth = p.bounds[1] - p.bounds[0];
+	float pixWidth = p.pixBounds[1] - p.pixBounds[0];
+
+	for(std::vector<float> *set : sets)
+		set->assign(w, 0.0f);
+
+	// render_mode 1.5: 2048 lookups across the track; in stereo each
+	// channel reads 1024 of them from its own half
+	AddSamplePoints(audio[0], w, p.bounds[0], trackWidth/2048.0f, 1024, 1.0f);
+	AddSamplePoints(audio[1], w, p.bounds[0]+trackWidth/2.0f,
+			trackWidth/2048.0f, 1024, 1.0f);
+
+	// render_mode 4: 1024 lookups averaged across the track (its first
+	// half for push-pull) and the picture
+	float soundStep = trackWidth/1024.0f;
+	if(p.stereo == 2) soundStep /= 2.0f;
+	AddSamplePoints(sound, w, p.bounds[0], soundStep, 1024, 1.0f/1024.0f);
+	if(p.overlapTarget != 0)
+		AddSamplePoints(pix, w, p.pixBounds[0], pixWidth/1024.0f, 1024,
+				1.0f/1024.0f);
+
+	col0 = w;
+	col1 = -1;
+	for(int x=0; x<w; ++x)
+	{
+		for(std::vector<float> *set : sets)
+		{
+			if((*set)[x] != 0.0f)
+			{
+				col0 = std::min(col0, x);
+				col1 = std::max(col1, x);
+			}
+		}
+	}
+	if(col1 < col0)
+		throw vfbexception("SoundExtractor: empty soundtrack bounds");
+
+	for(std::vector<float> *set : sets)
+	{
+		set->erase(set->begin()+col1+1, set->end());
+		set->erase(set->begin(), set->begin()+col0);
+	}
+
+	width = w;
+}
+
+//-----------------------------------------------------------------------------
+// Analysis - what the later passes need from one adjusted frame. Rows are
+// in the order of the adjusted texture, which render_mode 0 flips
+// vertically relative to the source image.
+class SoundExtractor::Analysis {
+public:
+	int height;
+	std::vector<float> track[2][3]; // per row and channel, summed over
+	                                // the file audio lookups of each half
+	std::vector<float> profile;     // render_mode 4 overlap profile
+
+	Analysis() : height(0) {} ;
+};
+
+// per-worker buffers, reused from frame to frame
+class SoundExtractor::Workspace {
+public:
+	FrameTexture tex;
+	Layout layout;
+	std::vector<float> src[3];
+	std::vector<float> adj[3];
+	std::vector<float> rowSound[3];
+	std::vector<float> rowPix[3];
+	Analysis prev;
+	Analysis cur;
+	std::vector< std::vector<float> > profiles; // Register() run
+	OverlapRegistration registration;
+};
+
+//-----------------------------------------------------------------------------
+SoundExtractorParams::SoundExtractorParams()
+	: overlapTarget(0), stereo(0), blur(0.0f), useSCurve(false),
+	sCurve(3.0f), samplesPerFrame(SOUNDEXTRACT_DEFAULT_SAMPLES),
+	applyDensity(false), negative(false), lift(0.0f), gamma(1.0f), gain(1.0f)
+{
+	bounds[0] = bounds[1] = 0.0f;
+	pixBounds[0] = pixBounds[1] = 0.0f;
+	overlap[0] = overlap[1] = overlap[2] = overlap[3] = 0.0f;
+}
+
+//-----------------------------------------------------------------------------
+SoundExtractor::SoundExtractor()
+	: scan(NULL), numThreads(0), progressCB(NULL), progressUserData(NULL),
+	frameIn(0), frameOut(-1), runLength(1), nextRun(0), framesDone(0),
+	cancelled(false), track(NULL), useTrack(false), registering(false),
+	sink(NULL), ringFrames(AUDIO_RING_DEFAULT_FRAMES), ring(NULL)
+{
+}
+
+//-----------------------------------------------------------------------------
+SoundExtractor::~SoundExtractor()
+{
+}
+
+//-----------------------------------------------------------------------------
+void SoundExtractor::SetSource(const FilmScan *s)
+{
+	scan = s;
+}
+
+//-----------------------------------------------------------------------------
+void SoundExtractor::SetThreadCount(int n)
+{
+	numThreads = std::max(0, n);
+}
+
+//-----------------------------------------------------------------------------
+void SoundExtractor::ProgressCallback(SoundExtractorProgressFunction cb,
+		void *userData)
+{
+	progressCB = cb;
+	progressUserData = userData;
+}
+
+//-----------------------------------------------------------------------------
+bool SoundExtractor::Extract(long first, long last)
+{
+	registering = false;
+	sink = NULL;
+	useTrack = (track != NULL && !track->IsEmpty() &&
+			track->Key() == OverlapTrackKey(params));
+
+	return Run(first, last);
+}
+
+//-----------------------------------------------------------------------------
+bool SoundExtractor::Extract(long first, long last, AudioSink &s,
+		long frames)
+{
+	registering = false;
+	sink = &s;
+	ringFrames = frames;
+	useTrack = (track != NULL && !track->IsEmpty() &&
+			track->Key() == OverlapTrackKey(params));
+
+	return Run(first, last);
+}
+
+//-----------------------------------------------------------------------------
+void SoundExtractor::Cancel()
+{
+	cancelled = true;
+
+	// wake workers waiting for room in the ring
+	AudioRing *r = ring;
+	if(r) r->Abort();
+}
+
+//-----------------------------------------------------------------------------
+bool SoundExtractor::Register(long first, long last)
+{
+	bool density = params.applyDensity;
+	bool done;
+
+	registering = true;
+	sink = NULL;
+	useTrack = false;
+	params.applyDensity = false;
+	try
+	{
+		done = Run(first, last);
+	}
+	catch(...)
+	{
+		params.applyDensity = density;
+		throw;
+	}
+	params.applyDensity = density;
+
+	return done;
+}
+
+//-----------------------------------------------------------------------------
+bool SoundExtractor::Run(long first, long last)
+{
+	if(scan == NULL || !scan->IsReady())
+		throw vfbexception("SoundExtractor: no source");
+	if(first > last || first < scan->FirstFrame() || last > scan->LastFrame())
+		throw vfbexception(QString("SoundExtractor: bad frame range %1-%2")
+				.arg(first).arg(last));
+	if(params.samplesPerFrame <= 0)
+		throw vfbexception("SoundExtractor: bad samples per frame");
+
+	long total = last - first + 1;
+	int threads = numThreads;
+	if(threads == 0) threads = int(std::thread::hardware_concurrency());
+	if(threads < 1 || !scan->IsThreadSafe()) threads = 1;
+
+	// Each run costs one extra read (the frame before it), so keep runs
+	// long enough for that to stay cheap but short enough that the
+	// threads finish at about the same time.
+	runLength = std::min(256L, std::max(8L, total/(threads*4L)));
+
+	// Streaming, the frames in progress all have to fit in the ring: a
+	// worker more than the ring ahead of the sink waits for it.
+	AudioRing streamRing;
+	if(sink)
+	{
+		streamRing.Start(sink, first, last, params.samplesPerFrame,
+				ringFrames);
+		runLength = std::max(1L,
+				std::min(runLength, streamRing.Capacity()/threads));
+	}
+
+	long numRuns = (total + runLength - 1) / runLength;
+	threads = int(std::min(long(threads), numRuns));
+
+	frameIn = first;
+	frameOut = last;
+	nextRun = 0;
+	framesDone = 0;
+	cancelled = false;
+	error = nullptr;
+
+	for(int ch=0; ch<2; ++ch)
+		channels[ch].assign((registering || sink) ? 0 :
+				size_t(total)*params.samplesPerFrame, 0.0f);
+	overlaps.assign(total, OverlapRecord());
+
+	if(sink) ring = &streamRing;
+
+	std::vector<std::thread> workers;
+	for(int i=0; i<threads; ++i)
+		workers.push_back(std::thread(&SoundExtractor::Worker, this));
+	for(std::thread &worker : workers)
+		worker.join();
+
+	ring = NULL;
+
+	if(error)
+		std::rethrow_exception(error);
+
+	if(sink)
+	{
+		if(cancelled) streamRing.Abort();
+		if(!streamRing.Finish()) return false;
+	}
+
+	return !cancelled;
+}
+
+//-----------------------------------------------------------------------------
+void SoundExtractor::Worker()
+{
+	Workspace ws;
+
+	try
+	{
+		while(!cancelled)
+		{
+			long first = frameIn + (nextRun++)*runLength;
+			if(first > frameOut) break;
+			if(registering)
+				RegisterRun(first, std::min(frameOut, first+runLength-1), ws);
+			else
+				ExtractRun(first, std::min(frameOut, first+runLength-1), ws);
+		}
+	}
+	catch(...)
+	{
+		std::lock_guard<std::mutex> guard(errorLock);
+		if(!error) error = std::current_exception();
+		Cancel();
+	}
+}
+
+//-----------------------------------------------------------------------------
+void SoundExtractor::FrameDone(long total)
+{
+	long done = ++framesDone;
+	if(progressCB)
+	{
+		std::lock_guard<std::mutex> guard(progressLock);
+		progressCB(done, total, progressUserData);
+	}
+}
+
+//-----------------------------------------------------------------------------
+void SoundExtractor::ExtractRun(long first, long last, Workspace &ws)
+{
+	const int n = params.samplesPerFrame;
+	const long total = frameOut - frameIn + 1;
+	const OverlapSearch search(params.overlap, SOUNDEXTRACT_OVERLAP_ROWS);
+
+	// the first frame of the reel has no predecessor; pair it with itself
+	AnalyzeFrame(std::max(scan->FirstFrame(), first-1), ws, ws.prev);
+
+	for(long frameNum = first; frameNum <= last; ++frameNum)
+	{
+		if(cancelled) return;
+
+		AnalyzeFrame(frameNum, ws, ws.cur);
+
+		OverlapRecord overlap = (useTrack && track->Has(frameNum)) ?
+			track->At(frameNum) : OverlapRecord(search.Find(
+					ws.cur.profile.data(), ws.prev.profile.data(),
+					ws.cur.height));
+
+		float *left, *right;
+		AudioRing *r = ring;
+		if(r)
+		{
+			// false once cancelled, or if the sink failed
+			if(!r->Begin(frameNum, &left, &right))
+			{
+				cancelled = true;
+				return;
+			}
+		}
+		else
+		{
+			size_t offset = size_t(frameNum - frameIn) * n;
+			left = &(channels[0][offset]);
+			right = &(channels[1][offset]);
+		}
+
+		RenderAudio(ws.cur, ws.prev,
+				float(overlap.overlap) / SOUNDEXTRACT_OVERLAP_ROWS,
+				left, right);
+		overlaps[frameNum - frameIn] = overlap;
+		if(r) r->Commit(frameNum);
+
+		std::swap(ws.prev, ws.cur);
+
+		FrameDone(total);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// The overlap profiles of a run (and the frame before it), registered
+// pair by pair over the window of the frame window's difference search.
+void SoundExtractor::RegisterRun(long first, long last, Workspace &ws)
+{
+	const long total = frameOut - frameIn + 1;
+
+	ws.profiles.resize(size_t(last - first) + 2);
+	AnalyzeFrame(std::max(scan->FirstFrame(), first-1), ws, ws.cur);
+	ws.profiles[0].swap(ws.cur.profile);
+
+	for(long frameNum = first; frameNum <= last; ++frameNum)
+	{
+		if(cancelled) return;
+
+		AnalyzeFrame(frameNum, ws, ws.cur);
+		ws.profiles[frameNum - first + 1].swap(ws.cur.profile);
+
+		FrameDone(total);
+	}
+
+	int start, end;
+	OverlapSearch(params.overlap, SOUNDEXTRACT_OVERLAP_ROWS).Window(start, end);
+	std::vector<OverlapMatch> matches =
+		ws.registration.RegisterSequence(ws.profiles, start, end, 1);
+
+	for(size_t i=0; i<matches.size(); ++i)
+	{
+		OverlapRecord &r = overlaps[first - frameIn + long(i)];
+		r.overlap = float(matches[i].overlap); // keeps the sub-row peak
+		r.minDiff = (unsigned int)(std::lround(
+				(1.0 - matches[i].correlation) * 1000.0));
+		r.isIffy = !matches[i].IsReliable();
+	}
+}
+
+//-----------------------------------------------------------------------------
+// render_mode 0 over the columns the later passes read, then reduce each
+// adjusted row to its per-channel sums over those passes' lookups.
+void SoundExtractor::AnalyzeFrame(long frameNum, Workspace &ws, Analysis &out)
+{
+	scan->GetFrameImage(frameNum, &(ws.tex));
+
+	const int w = ws.tex.width;
+	const int h = ws.tex.height;
+
+	if(w <= 0 || h <= 0)
+		throw vfbexception(QString("SoundExtractor: empty frame %1")
+				.arg(frameNum));
+	if(ws.layout.width != w)
+		ws.layout.Build(w, params);
+
+	const Layout &layout = ws.layout;
+	const int aw = layout.col1 - layout.col0 + 1;
+	const int s0 = std::max(0, layout.col0 - KERNEL_REACH);
+	const int s1 = std::min(w-1, layout.col1 + KERNEL_REACH);
+	const int sw = s1 - s0 + 1;
+
+	UnpackColumns(ws.tex, s0, s1, ws.src);
+
+	const float *kernel(NULL);
+	float amount(0.0f);
+	if(params.blur > 0.0f)
+	{
+		kernel = kernelSharpen;
+		amount = params.blur;
+	}
+	else if(params.blur < 0.0f)
+	{
+		kernel = kernelBlur;
+		amount = -params.blur*2.0f;
+	}
+
+	const std::vector<float> &cal = params.calMask;
+	const float sCurveMid = std::pow(0.5f, params.sCurve);
+
+	for(int c=0; c<3; ++c)
+		ws.adj[c].resize(size_t(aw)*h);
+
+	for(int row=0; row<h; ++row)
+	{
+		// the adjustment pass draws the source upside down
+		const int srcRow = h-1-row;
+		float calGain(1.0f);
+		if(!cal.empty())
+			calGain = 0.5f / SampleLinear(cal.data(), int(cal.size()),
+					(row+0.5f)/h);
+
+		for(int c=0; c<3; ++c)
+		{
+			const float *src = ws.src[c].data();
+			float *dst = &(ws.adj[c][size_t(row)*aw]);
+
+			for(int x=layout.col0; x<=layout.col1; ++x)
+			{
+				float texel = src[size_t(srcRow)*sw + (x-s0)];
+
+				if(kernel)
+				{
+					float sum(0.0f);
+					for(int k=0; k<25; ++k)
+					{
+						int kx = std::min(std::max(x + 2*kernelX[k], 0), w-1);
+						int ky = std::min(std::max(srcRow + 2*kernelY[k], 0),
+								h-1);
+						sum += kernel[k] * src[size_t(ky)*sw + (kx-s0)];
+					}
+					texel += (sum - texel)*amount;
+				}
+
+				texel *= calGain;
+
+				if(params.useSCurve)
+				{
+					// pow() of a negative is undefined in GLSL; take 0
+					float t = std::pow(std::max(texel, 0.0f), params.sCurve);
+					texel = t / (sCurveMid + t);
+				}
+
+				if(params.applyDensity)
+				{
+					// as render_mode 2, less saturation
+					if(params.negative) texel = 1.0f - texel;
+					texel = std::min(std::max(texel + params.lift, 0.0f), 1.0f);
+					texel = std::pow(texel, params.gamma) * params.gain;
+					texel = std::min(std::max(texel, 0.0f), 1.0f);
+				}
+
+				dst[x-layout.col0] = texel;
+			}
+		}
+	}
+
+	// per-row sums across the lookups of the audio and overlap passes
+	out.height = h;
+	for(int c=0; c<3; ++c)
+	{
+		for(int half=0; half<2; ++half)
+			out.track[half][c].resize(h);
+		ws.rowSound[c].resize(h);
+		ws.rowPix[c].resize(h);
+
+		for(int row=0; row<h; ++row)
+		{
+			const float *a = &(ws.adj[c][size_t(row)*aw]);
+			float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			for(int x=0; x<aw; ++x)
+			{
+				sum[0] += layout.audio[0][x] * a[x];
+				sum[1] += layout.audio[1][x] * a[x];
+				sum[2] += layout.sound[x] * a[x];
+				sum[3] += layout.pix[x] * a[x];
+			}
+			out.track[0][c][row] = sum[0];
+			out.track[1][c][row] = sum[1];
+			ws.rowSound[c][row] = sum[2];
+			ws.rowPix[c][row] = sum[3];
+		}
+	}
+
+	// render_mode 4 draws its rows upside down as well
+	const int n = SOUNDEXTRACT_OVERLAP_ROWS;
+	out.profile.resize(n);
+	for(int r=0; r<n; ++r)
+	{
+		float y = 1.0f - (r+0.5f)/n;
+		float v[3];
+		for(int c=0; c<3; ++c)
+		{
+			float sound = SampleLinear(ws.rowSound[c].data(), h, y);
+			float pix = SampleLinear(ws.rowPix[c].data(), h, y);
+			switch(params.overlapTarget)
+			{
+			case 1: v[c] = pix; break;
+			case 2: v[c] = (sound + pix) / 2.0f; break;
+			default: v[c] = sound; break;
+			}
+		}
+		out.profile[r] = Lightness(v[0], v[1], v[2]);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// render_mode 1.5: one sample per output row, integrating the previous
+// adjusted frame across the track over the span not overlapped by the
+// current one, and blending into the current frame at the seam.
+void SoundExtractor::RenderAudio(const Analysis &cur, const Analysis &prev,
+		float overlapFrac, float *left, float *right) const
+{
+	const int n = params.samplesPerFrame;
+	const float pitchStart = params.overlap[3];
+	const float top = 1.0f + pitchStart - overlapFrac;
+
+	for(int r=0; r<n; ++r)
+	{
+		float y = top + (pitchStart - top)*(r+0.5f)/n;
+		float t[2][3];
+
+		for(int half=0; half<2; ++half)
+			for(int c=0; c<3; ++c)
+				t[half][c] = SampleLinear(prev.track[half][c].data(),
+						prev.height, y);
+
+		if(params.stereo == 0)
+		{
+			float m[3];
+			float yBlend = y - (1.0f - overlapFrac);
+
+			for(int c=0; c<3; ++c)
+				m[c] = t[0][c] + t[1][c];
+
+			if(pitchStart - yBlend <= 0.01f && yBlend > 0.0f)
+			{
+				float mix = (pitchStart - yBlend)*100.0f;
+				for(int c=0; c<3; ++c)
+				{
+					float p = SampleLinear(cur.track[0][c].data(),
+							cur.height, yBlend) +
+						SampleLinear(cur.track[1][c].data(),
+							cur.height, yBlend);
+					m[c] = p + (m[c] - p)*mix;
+				}
+			}
+
+			left[r] = right[r] = Lightness(m[0], m[1], m[2]) / 2048.0f;
+		}
+		else
+		{
+			left[r] = Lightness(t[0][0], t[0][1], t[0][2]) / 1024.0f;
+			right[r] = Lightness(t[1][0], t[1][1], t[1][2]) / 1024.0f;
+		}
+	}
+}
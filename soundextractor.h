@@ -0,0 +1,201 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+// SoundExtractor -- headless (CPU) optical soundtrack extraction.
+//
+// Reproduces the passes Frame_Window::render() runs on the GPU to produce
+// file audio, without needing an OpenGL context or a display:
+//
+//   render_mode 0   adjustment: sharpen/blur kernel, calibration mask and
+//                   s-curve threshold
+//   render_mode 4,5 overlap search between the current and previous frame
+//   render_mode 1.5 file audio: each line of the previous frame is
+//                   integrated across the soundtrack bounds into a sample,
+//                   over the part of the frame not overlapped by the next
+//
+// All positions and bounds are in the same normalized units the frame
+// window uses for its shader uniforms (fractions of frame width/height).
+//
+// The frames to extract are split into short runs that a pool of worker
+// threads takes in turn. A frame's samples depend only on its own adjusted
+// image and the previous frame's, so each worker also reads the frame just
+// before its run, and the runs are stitched simply by writing each frame's
+// samples at its offset in the output.
+//
+// Extract() into Channel() holds the samples of the whole range. Given an
+// AudioSink instead, frames are rendered into an AudioRing and streamed to
+// the sink in order as they complete; runs are kept short enough that
+// every worker fits in the ring at once, so the sample memory is the
+// ring's whatever the length of the range. (Each run still starts from
+// the frame before it, so the seam blend into the next frame carries
+// across runs exactly as it does within one.)
+//
+// Register() runs only the passes the overlap search needs, over the same
+// runs, and measures each frame's overlap by normalized cross-correlation
+// (OverlapRegistration) instead of the shader's difference search. It is
+// the pre-pass behind OverlapTrack; given a track with SetOverlapTrack(),
+// Extract() looks up the overlaps of the frames it covers.
+
+#ifndef SOUNDEXTRACTOR_H
+#define SOUNDEXTRACTOR_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <exception>
+
+#include "FilmScan.h"
+#include "audiosink.h"
+#include "overlap.h"
+
+class OverlapTrack;
+
+#define SOUNDEXTRACT_DEFAULT_SAMPLES 2000
+#define SOUNDEXTRACT_OVERLAP_ROWS 2000 // Frame_Window::samplesperframe
+
+typedef void (*SoundExtractorProgressFunction)(long framesDone,
+		long framesTotal, void *userData);
+
+class SoundExtractorParams {
+public:
+	float bounds[2];    // soundtrack left, right
+	float pixBounds[2]; // picture left, right (overlap target only)
+	float overlap[4];   // as Frame_Window::overlap: [1] search area,
+	                    // [2] frame pitch end, [3] frame pitch start
+	int overlapTarget;  // 0 soundtrack, 1 picture, 2 both
+	int stereo;         // 0 mono, 1 stereo, 2 push-pull
+	float blur;         // [-1,1] negative blurs, positive sharpens
+	bool useSCurve;
+	float sCurve;
+	std::vector<float> calMask; // empty if calibration is not enabled
+	int samplesPerFrame;
+
+	// The frame window applies these to the displayed picture only, so
+	// they are ignored unless applyDensity is set.
+	bool applyDensity;
+	bool negative;
+	float lift;
+	float gamma;
+	float gain;
+
+	SoundExtractorParams();
+};
+
+class SoundExtractor {
+private:
+	class Layout;
+	class Analysis;
+	class Workspace;
+
+	const FilmScan *scan;
+	SoundExtractorParams params;
+	int numThreads;
+
+	SoundExtractorProgressFunction progressCB;
+	void *progressUserData;
+	std::mutex progressLock;
+
+	long frameIn;
+	long frameOut;
+	long runLength;
+	std::atomic<long> nextRun;
+	std::atomic<long> framesDone;
+	std::atomic<bool> cancelled;
+
+	std::mutex errorLock;
+	std::exception_ptr error;
+
+	const OverlapTrack *track;
+	bool useTrack;
+	bool registering;
+
+	AudioSink *sink;  // Extract() to a sink
+	long ringFrames;
+	std::atomic<AudioRing *> ring;
+
+	std::vector<float> channels[2];
+	std::vector<OverlapRecord> overlaps;
+
+	bool Run(long first, long last);
+	void Worker();
+	void FrameDone(long total);
+	void ExtractRun(long first, long last, Workspace &ws);
+	void RegisterRun(long first, long last, Workspace &ws);
+	void AnalyzeFrame(long frameNum, Workspace &ws, Analysis &out);
+	void RenderAudio(const Analysis &cur, const Analysis &prev,
+			float overlapFrac, float *left, float *right) const;
+
+public:
+	SoundExtractor();
+	~SoundExtractor();
+
+	void SetSource(const FilmScan *scan);
+	void SetParameters(const SoundExtractorParams &p) { params = p; }
+	const SoundExtractorParams &Parameters() const { return params; }
+
+	// 0 uses one thread per core. Sources that aren't
+	// FilmScan::IsThreadSafe() are always extracted on one thread.
+	void SetThreadCount(int n);
+	int ThreadCount() const { return numThreads; }
+
+	// cb is called from the worker threads, one call at a time
+	void ProgressCallback(SoundExtractorProgressFunction cb, void *userData);
+
+	// Extract the frames [first, last] (absolute frame numbers). Blocks
+	// until done; returns false if Cancel() was called. Read and format
+	// errors from any worker are rethrown here.
+	bool Extract(long first, long last);
+	void Cancel();
+
+	// Extract [first, last] to sink through a ring of ringFrames frames,
+	// leaving Channel() empty. Errors from the sink are rethrown here;
+	// the caller closes the sink.
+	bool Extract(long first, long last, AudioSink &sink,
+			long ringFrames=AUDIO_RING_DEFAULT_FRAMES);
+
+	// Measure the overlaps of [first, last] only, into Overlaps(), with
+	// the density settings off. Blocks and throws as Extract() does.
+	bool Register(long first, long last);
+
+	// Extract() takes the overlap of each frame the track has from it, if
+	// the track's key matches the parameters. NULL searches every frame.
+	void SetOverlapTrack(const OverlapTrack *t) { track = t; }
+
+	long FramesDone() const { return framesDone; }
+	long NumSamples() const { return long(channels[0].size()); }
+	const std::vector<float> &Channel(int ch) const { return channels[ch]; }
+
+	// the overlap used for (or registered by Register()) each frame, in
+	// 1/SOUNDEXTRACT_OVERLAP_ROWS of the frame height
+	const std::vector<OverlapRecord> &Overlaps() const { return overlaps; }
+};
+
+#endif // SOUNDEXTRACTOR_H
@@ -0,0 +1,57 @@
+#-----------------------------------------------------------------------------
+# This file is part of Virtual Film Bench
+#
+# Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+#
+# Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+# L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+# and Stella Garcia (USC).
+#
+# Funding for Virtual Film Bench development was provided through a grant
+# from the National Endowment for the Humanities with additional support
+# from the National Science Foundation’s Access program.
+#
+# This program is free software; you can redistribute it and/or modify it
+# under the terms of the GNU General Public License as published by the
+# Free Software Foundation; either version 3 of the License, or (at your
+# option) any later version.
+#
+# Virtual Film Bench is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+# or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+# for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; if not, see http://gnu.org/licenses/.
+#
+# For inquiries or permissions, contact
+# Greg Wilsbacher (gregw@mailbox.sc.edu)
+#-----------------------------------------------------------------------------
+
+# ExportSession check: two files exported one after another by the same
+# session, from synthetic frames and samples. It needs libav, but no GL.
+
+# exportsession.h reaches FilmScan.h, and QOpenGLTexture, through
+# audiosink.h
+QT += core gui opengl testlib
+
+CONFIG += console testcase c++17
+CONFIG -= app_bundle
+
+TARGET = tst_exportsession
+TEMPLATE = app
+
+INCLUDEPATH += $$PWD/../..
+
+SOURCES += \
+    tst_exportsession.cpp \
+    ../../exportsession.cpp \
+    ../../videoencoder.cpp
+
+HEADERS += \
+    ../../audiosink.h \
+    ../../exportsession.h \
+    ../../videoencoder.h
+
+LIBS += -lavcodec -lavformat -lavutil
+LIBS += -lswscale -lswresample
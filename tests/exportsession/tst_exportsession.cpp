@@ -0,0 +1,180 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+// Checks that one ExportSession writes complete files one after another:
+// each pass opens a file, encodes synthetic RGBA frames and a tone, closes
+// it, and reads the file back with libavformat to count what landed in it.
+// A session that leaked or reused state from the file before would fail
+// the second pass, which also switches codec and container.
+
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "exportsession.h"
+
+#define TEST_WIDTH 64
+#define TEST_HEIGHT 48
+#define TEST_FRAMES 12
+#define TEST_FPS 24
+#define TEST_RATE 48000
+
+class ExportSessionTest : public QObject {
+	Q_OBJECT
+
+private:
+	QTemporaryDir dir;
+
+	static void Pattern(int frame, uint8_t *buf);
+	static int CountPackets(const QString &fn, enum AVMediaType type,
+			enum AVCodecID *id);
+
+private slots:
+	void initTestCase();
+	void twoSessions();
+};
+
+//-----------------------------------------------------------------------------
+// a gradient that moves with the frame number
+void ExportSessionTest::Pattern(int frame, uint8_t *buf)
+{
+	for(int y=0; y<TEST_HEIGHT; ++y)
+	{
+		for(int x=0; x<TEST_WIDTH; ++x)
+		{
+			uint8_t *p = buf + (size_t(y)*TEST_WIDTH + x)*4;
+			p[0] = uint8_t(x*4 + frame);
+			p[1] = uint8_t(y*4);
+			p[2] = uint8_t(frame*16);
+			p[3] = 0xFF;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Packets of the first stream of type in fn, and its codec in id. -1 if
+// the file can't be read or has no such stream.
+int ExportSessionTest::CountPackets(const QString &fn,
+		enum AVMediaType type, enum AVCodecID *id)
+{
+	AVFormatContext *in = NULL;
+	QByteArray name = fn.toUtf8();
+	int n = -1;
+
+	if(avformat_open_input(&in, name.constData(), NULL, NULL) < 0)
+		return -1;
+
+	int index = -1;
+	if(avformat_find_stream_info(in, NULL) >= 0)
+		index = av_find_best_stream(in, type, -1, -1, NULL, 0);
+
+	if(index >= 0)
+	{
+		AVPacket *packet = av_packet_alloc();
+		*id = in->streams[index]->codecpar->codec_id;
+		n = 0;
+		while(av_read_frame(in, packet) >= 0)
+		{
+			if(packet->stream_index == index) ++n;
+			av_packet_unref(packet);
+		}
+		av_packet_free(&packet);
+	}
+
+	avformat_close_input(&in);
+	return n;
+}
+
+//-----------------------------------------------------------------------------
+void ExportSessionTest::initTestCase()
+{
+	QVERIFY(dir.isValid());
+}
+
+//-----------------------------------------------------------------------------
+void ExportSessionTest::twoSessions()
+{
+	const struct {
+		const char *fn;
+		ExportCodec codec;
+		enum AVCodecID id;
+	} passes[] = {
+		{ "first.mkv", EXPORT_CODEC_FFV1, AV_CODEC_ID_FFV1 },
+		{ "second.mov", EXPORT_CODEC_PRORES, AV_CODEC_ID_PRORES }
+	};
+	const int spf = TEST_RATE / TEST_FPS;
+	std::vector<float> tone(spf);
+	ExportSession session;
+
+	for(const auto &pass : passes)
+	{
+		const QString fn = dir.filePath(pass.fn);
+		ExportSettings settings;
+		settings.videoCodec = pass.codec;
+		settings.width = TEST_WIDTH;
+		settings.height = TEST_HEIGHT;
+		settings.frameRate = TEST_FPS;
+		settings.samplingRate = TEST_RATE;
+
+		session.Open(fn, settings);
+		QVERIFY(session.IsOpen());
+		QVERIFY(session.HasVideo());
+		QVERIFY(session.HasAudio());
+		QVERIFY(session.FrameBytes() >= size_t(TEST_WIDTH*TEST_HEIGHT*4));
+
+		for(int frame=0; frame<TEST_FRAMES; ++frame)
+		{
+			uint8_t *buf = session.AcquireFrame();
+			Pattern(frame, buf);
+			session.SubmitFrame(buf);
+
+			// 1 kHz, in [0,1]
+			for(int i=0; i<spf; ++i)
+				tone[i] = 0.5f + 0.25f*float(std::sin(2.0*M_PI*1000.0*
+						double(frame*spf + i)/TEST_RATE));
+			session.Write(tone.data(), tone.data(), tone.size());
+		}
+
+		session.Close();
+		QVERIFY(!session.IsOpen());
+
+		enum AVCodecID id = AV_CODEC_ID_NONE;
+		QCOMPARE(CountPackets(fn, AVMEDIA_TYPE_VIDEO, &id), TEST_FRAMES);
+		QCOMPARE(id, pass.id);
+		QVERIFY(CountPackets(fn, AVMEDIA_TYPE_AUDIO, &id) > 0);
+	}
+}
+
+QTEST_GUILESS_MAIN(ExportSessionTest)
+
+#include "tst_exportsession.moc"
@@ -0,0 +1,121 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+// Checks that OverlapSearch finds the overlap of a pair of profiles made
+// at a known offset: the previous frame's profile is a signal over [0,1],
+// the current one the same signal moved up by the overlap, so its head
+// repeats the previous frame's tail. The signal is flat at the very end,
+// where the search compares the current frame with the previous frame's
+// clamped edge.
+//
+// Candidate L is mode 5 output row rows-L, which samples the overlap
+// L-0.5 rows (the row's centre), so that is the offset the pair is made
+// at.
+
+#include <QtTest>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "overlapsearch.h"
+
+#define TEST_ROWS 2000   // Frame_Window::samplesperframe
+#define TEST_HEIGHT 1000 // image rows of the frame
+
+class OverlapSearchTest : public QObject {
+	Q_OBJECT
+
+private:
+	static float Signal(double x);
+
+private slots:
+	void knownOffset_data();
+	void knownOffset();
+};
+
+//-----------------------------------------------------------------------------
+// a profile with no repeats over the search, in [0,1]
+float OverlapSearchTest::Signal(double x)
+{
+	x = std::min(x, 0.97);
+	return float(0.5 + 0.3*std::sin(23.0*x) + 0.15*std::sin(71.0*x*x));
+}
+
+//-----------------------------------------------------------------------------
+void OverlapSearchTest::knownOffset_data()
+{
+	QTest::addColumn<float>("pitch");
+	QTest::addColumn<int>("overlap");
+
+	QTest::newRow("at pitch") << 0.1f << 200;
+	QTest::newRow("one row over") << 0.1f << 201;
+	QTest::newRow("below pitch") << 0.1f << 163;
+	QTest::newRow("above pitch") << 0.1f << 237;
+	QTest::newRow("short pitch") << 0.05f << 113;
+	QTest::newRow("long pitch") << 0.2f << 387;
+}
+
+//-----------------------------------------------------------------------------
+void OverlapSearchTest::knownOffset()
+{
+	QFETCH(float, pitch);
+	QFETCH(int, overlap);
+
+	// search 0.1 of the frame around the pitch, as the frame window's
+	// default
+	const float settings[4] = { 0.0f, 0.1f, pitch, 0.0f };
+	OverlapSearch search(settings, TEST_ROWS);
+
+	int start, end;
+	search.Window(start, end);
+	QVERIFY(overlap > start && overlap <= end);
+
+	const double shift = TEST_ROWS - (overlap - 0.5);
+	std::vector<float> prev(TEST_ROWS), cur(TEST_ROWS);
+	for(int r=0; r<TEST_ROWS; ++r)
+	{
+		prev[r] = Signal((r + 0.5) / TEST_ROWS);
+		cur[r] = Signal((r + 0.5 + shift) / TEST_ROWS);
+	}
+
+	QCOMPARE(search.Find(cur.data(), prev.data(), TEST_HEIGHT), overlap);
+
+	// the error at the overlap is the lowest of the window
+	const float best = search.Error(cur.data(), prev.data(), TEST_HEIGHT,
+			TEST_ROWS - overlap);
+	for(int l = start+1; l <= end; ++l)
+		QVERIFY(search.Error(cur.data(), prev.data(), TEST_HEIGHT,
+				TEST_ROWS - l) >= best);
+}
+
+QTEST_APPLESS_MAIN(OverlapSearchTest)
+
+#include "tst_overlapsearch.moc"
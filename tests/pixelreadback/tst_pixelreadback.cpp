@@ -0,0 +1,258 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+// Checks that PixelReadback hands back each frame's pixels, and only those,
+// in the order the frames were rendered, while later frames keep rendering
+// into the same framebuffer.
+//
+// Each frame clears the framebuffer to a colour of its own and starts a
+// read into a buffer of its own. Buffers start out filled with a sentinel
+// (alpha 0xCD; every frame's alpha is 0xFF). After every step the buffers
+// that have been collected must be a prefix of the frames read so far, and
+// each must hold exactly its frame's colour.
+
+#include <QGuiApplication>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFunctions_3_3_Core>
+#include <QSurfaceFormat>
+#include <QtTest>
+
+#include <cstdint>
+#include <vector>
+
+#include "pixelreadback.h"
+
+#define TEST_WIDTH 16
+#define TEST_HEIGHT 8
+#define SENTINEL 0xCD
+
+class PixelReadbackTest : public QObject {
+	Q_OBJECT
+
+private:
+	QOffscreenSurface surface;
+	QOpenGLContext context;
+	QOpenGLFunctions_3_3_Core gl;
+	GLuint fbo;
+	GLuint texture;
+
+	static void Pattern(int frame, uint8_t rgba[4]);
+	void Render(int frame);
+	static bool Holds(const std::vector<uint8_t> &buf, int frame);
+	static bool Untouched(const std::vector<uint8_t> &buf);
+	static int Collected(const std::vector< std::vector<uint8_t> > &bufs,
+			int numRead);
+
+public:
+	PixelReadbackTest() : fbo(0), texture(0) {} ;
+
+private slots:
+	void initTestCase();
+	void cleanupTestCase();
+	void ordered_data();
+	void ordered();
+};
+
+//-----------------------------------------------------------------------------
+void PixelReadbackTest::Pattern(int frame, uint8_t rgba[4])
+{
+	rgba[0] = uint8_t(frame * 37 + 11);
+	rgba[1] = uint8_t(frame * 101 + 3);
+	rgba[2] = uint8_t(frame * 7 + 200);
+	rgba[3] = 0xFF;
+}
+
+//-----------------------------------------------------------------------------
+void PixelReadbackTest::Render(int frame)
+{
+	uint8_t c[4];
+
+	Pattern(frame, c);
+	gl.glClearColor(c[0]/255.0f, c[1]/255.0f, c[2]/255.0f, c[3]/255.0f);
+	gl.glClear(GL_COLOR_BUFFER_BIT);
+}
+
+//-----------------------------------------------------------------------------
+bool PixelReadbackTest::Holds(const std::vector<uint8_t> &buf, int frame)
+{
+	uint8_t c[4];
+
+	Pattern(frame, c);
+	for(size_t i=0; i<buf.size(); ++i)
+		if(buf[i] != c[i%4]) return false;
+	return true;
+}
+
+bool PixelReadbackTest::Untouched(const std::vector<uint8_t> &buf)
+{
+	for(uint8_t b : buf)
+		if(b != SENTINEL) return false;
+	return true;
+}
+
+// The number of frames collected so far, or -1 if they aren't a prefix of
+// the first numRead frames or one holds the wrong pixels.
+int PixelReadbackTest::Collected(
+		const std::vector< std::vector<uint8_t> > &bufs, int numRead)
+{
+	int n = 0;
+
+	while(n < numRead && !Untouched(bufs[n]))
+	{
+		if(!Holds(bufs[n], n)) return -1;
+		++n;
+	}
+	for(size_t i=size_t(n); i<bufs.size(); ++i)
+		if(!Untouched(bufs[i])) return -1;
+	return n;
+}
+
+//-----------------------------------------------------------------------------
+void PixelReadbackTest::initTestCase()
+{
+	QSurfaceFormat format;
+	format.setVersion(3, 3);
+	format.setProfile(QSurfaceFormat::CoreProfile);
+
+	surface.setFormat(format);
+	surface.create();
+	context.setFormat(format);
+	if(!context.create() || !context.makeCurrent(&surface))
+		QSKIP("No OpenGL 3.3 context (is Mesa installed?)");
+	if(!gl.initializeOpenGLFunctions())
+		QSKIP("No OpenGL 3.3 core functions");
+
+	qInfo("GL_RENDERER = %s",
+			reinterpret_cast<const char *>(gl.glGetString(GL_RENDERER)));
+
+	gl.glGenTextures(1, &texture);
+	gl.glBindTexture(GL_TEXTURE_2D, texture);
+	gl.glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, TEST_WIDTH, TEST_HEIGHT, 0,
+			GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+
+	gl.glGenFramebuffers(1, &fbo);
+	gl.glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	gl.glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+			GL_TEXTURE_2D, texture, 0);
+	QCOMPARE(gl.glCheckFramebufferStatus(GL_FRAMEBUFFER),
+			GLenum(GL_FRAMEBUFFER_COMPLETE));
+
+	gl.glDrawBuffer(GL_COLOR_ATTACHMENT0);
+	gl.glReadBuffer(GL_COLOR_ATTACHMENT0);
+	gl.glViewport(0, 0, TEST_WIDTH, TEST_HEIGHT);
+	gl.glPixelStorei(GL_PACK_ALIGNMENT, 1);
+}
+
+void PixelReadbackTest::cleanupTestCase()
+{
+	if(!context.isValid()) return;
+
+	gl.glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	gl.glDeleteFramebuffers(1, &fbo);
+	gl.glDeleteTextures(1, &texture);
+	context.doneCurrent();
+}
+
+//-----------------------------------------------------------------------------
+void PixelReadbackTest::ordered_data()
+{
+	QTest::addColumn<int>("ringSize");
+	QTest::addColumn<int>("numFrames");
+
+	QTest::newRow("ring of 1") << 1 << 9;
+	QTest::newRow("ring of 2") << 2 << 13;
+	QTest::newRow("default ring") << PIXELREADBACK_DEFAULT_RING << 29;
+}
+
+void PixelReadbackTest::ordered()
+{
+	QFETCH(int, ringSize);
+	QFETCH(int, numFrames);
+
+	const size_t size = size_t(TEST_WIDTH) * TEST_HEIGHT * 4;
+	std::vector< std::vector<uint8_t> > bufs(size_t(numFrames),
+			std::vector<uint8_t>(size, SENTINEL));
+	PixelReadback readback(ringSize);
+	int collected = 0;
+
+	readback.Initialize(&gl);
+
+	for(int n=0; n<numFrames; ++n)
+	{
+		// frame n renders over frame n-1, whose read may still be pending
+		Render(n);
+		readback.Read(0, 0, TEST_WIDTH, TEST_HEIGHT, GL_RGBA,
+				GL_UNSIGNED_BYTE, bufs[n].data(), size);
+		QVERIFY(readback.NumPending() <= size_t(ringSize));
+
+		// a full ring collected the oldest read first
+		int now = Collected(bufs, n+1);
+		QVERIFY2(now >= 0, "frames collected out of order or corrupted");
+		QVERIFY(now >= collected);
+		QVERIFY(now >= n+1 - ringSize);
+		collected = now;
+
+		readback.Poll();
+		now = Collected(bufs, n+1);
+		QVERIFY2(now >= 0, "Poll() collected out of order");
+		QVERIFY(now >= collected);
+		collected = now;
+
+		// waiting for one frame collects it and every frame before it
+		if(n % 3 == 2)
+		{
+			readback.WaitFor(bufs[n-1].data(), size);
+			now = Collected(bufs, n+1);
+			QVERIFY2(now >= n, "WaitFor() left an earlier frame pending");
+			collected = now;
+		}
+	}
+
+	readback.Finish();
+	QCOMPARE(readback.NumPending(), size_t(0));
+	QCOMPARE(Collected(bufs, numFrames), numFrames);
+
+	readback.Release();
+}
+
+//-----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+	// Mesa's software rasterizer, so no GPU is needed
+	if(qEnvironmentVariableIsEmpty("LIBGL_ALWAYS_SOFTWARE"))
+		qputenv("LIBGL_ALWAYS_SOFTWARE", "1");
+
+	QGuiApplication app(argc, argv);
+	PixelReadbackTest test;
+	return QTest::qExec(&test, argc, argv);
+}
+
+#include "tst_pixelreadback.moc"
@@ -32,6 +32,8 @@
 #include "vbevent.h"
 
 #include <QDateTime>
+#include <QHash>
+#include <QMutex>
 
 #include <stdexcept>
 #include <algorithm>
@@ -230,7 +232,9 @@ bool vbevent::SetContinuous(bool c)
 
 float vbevent::EffectiveConfidence() const
 {
-    QString confStr = Attribute("Confidence");
+    static const AttributeID confidenceID = InternAttributeName("Confidence");
+
+    QString confStr = Attribute(confidenceID);
     if(confStr.isEmpty())
         return 1.0f;
     else
@@ -265,6 +269,27 @@ QString vbevent::MakeAttributeName(QString str)
     return name;
 }
 
+// InternAttributeName
+// ===================
+// Return the ID of an attribute name, assigning a new one the first time
+// a name is seen. Names that differ only in case or in the conventions
+// MakeAttributeName applies share an ID.
+AttributeID vbevent::InternAttributeName(const QString attribute)
+{
+    static QMutex mutex;
+    static QHash<QString, AttributeID> ids;
+
+    QString key = MakeAttributeName(attribute).toLower();
+
+    QMutexLocker lock(&mutex);
+    auto i = ids.constFind(key);
+    if(i != ids.cend()) return i.value();
+
+    AttributeID id = AttributeID(ids.size());
+    ids.insert(key, id);
+    return id;
+}
+
 void vbevent::SetAttribute(const QString attribute, const QString value)
 {
     QString attr = MakeAttributeName(attribute);
@@ -315,6 +340,7 @@ void vbevent::SetAttribute(const QString attribute, const QString value)
     }
 
     attributes.append(EventAttributePair(attr,value));
+    attributeIDs.append(InternAttributeName(attr));
 }
 
 QString vbevent::Attribute(const QString attribute) const
@@ -341,6 +367,14 @@ QString vbevent::Attribute(const QString attribute) const
     return QString();
 }
 
+QString vbevent::Attribute(AttributeID attrID) const
+{
+    int i = attributeIDs.indexOf(attrID);
+    if(i<0) return QString();
+
+    return attributes.at(i).second;
+}
+
 QString vbevent::SubTypeName() const
 {
     QString subtag = MakeAttributeName(TypeName());
@@ -348,6 +382,24 @@ QString vbevent::SubTypeName() const
     return subtag;
 }
 
+AttributeID vbevent::SubTypeID() const
+{
+    // the subtype name of the core types is fixed, so look it up once
+    static const QVector<AttributeID> coreIDs = []()
+    {
+        QVector<AttributeID> ids;
+        for(int t=0; t<VB_EVENT_OTHER; ++t)
+            ids.append(InternAttributeName(
+                MakeAttributeName(EventTypeName[t])+"Type"));
+        return ids;
+    }();
+
+    if(eventType == VB_EVENT_OTHER)
+        return InternAttributeName(SubTypeName());
+
+    return coreIDs.at(eventType);
+}
+
 void vbevent::SetSubType(QString subType)
 {
     SetAttribute(SubTypeName(),subType);
@@ -36,6 +36,7 @@
 #include <QMap>
 #include <QAbstractTableModel>
 #include <QUuid>
+#include <QVector>
 
 #include <string>
 #include <algorithm>
@@ -71,6 +72,11 @@ typedef QList< EventAttributePair  > EventAttributeList;
 typedef QUuid EventID;
 typedef QSet< EventID > EventSet;
 
+// Attribute names are interned to small integers (case-insensitively,
+// after MakeAttributeName) so that repeated lookups, e.g. by the event
+// filter, don't need to normalize and compare strings.
+typedef int AttributeID;
+
 class vbevent
 {
 public:
@@ -95,6 +101,7 @@ private:
     float  bounds[4]; // x0, x1, y0, y1
     bool isContinuous; // multi-frame: continuous extend? (vs. discrete repeat)
     EventAttributeList attributes;
+    QVector<AttributeID> attributeIDs; // parallel to attributes
 
 public:
     EventID ID() const { return id; }
@@ -130,12 +137,15 @@ public:
     float EffectiveConfidence() const;
 
     static QString MakeAttributeName(QString str);
+    static AttributeID InternAttributeName(const QString attribute);
 
     inline const EventAttributeList &Attributes() const { return attributes; }
     void SetAttribute(const QString attribute, const QString value);
     QString Attribute(const QString attribute) const;
+    QString Attribute(AttributeID attrID) const; // stored attributes only
 
     QString SubTypeName() const;
+    AttributeID SubTypeID() const;
     void SetSubType(QString subType);
     QString SubType() const;
 
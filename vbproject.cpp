@@ -40,6 +40,7 @@
 #include <QRegularExpression>
 #include <QSettings>
 #include <QUrl>
+#include <QXmlStreamReader>
 
 vbproject::vbproject() :
     zeroframe(0),
@@ -151,6 +152,16 @@ bool vbproject::save(QString filename)
                           QString::number(overlap_framestart));
     settings.setAttribute("overlap_frameend",
                           QString::number(overlap_frameend));
+
+    if(!overlapTrack.IsEmpty())
+    {
+        QDomElement track = doc.createElement("overlap_track");
+        track.setAttribute("first", QString::number(overlapTrack.First()));
+        track.setAttribute("key", overlapTrack.Key().ToString());
+        track.appendChild(doc.createTextNode(overlapTrack.RecordsToString()));
+        root.appendChild(track);
+    }
+
     // Add event list to the XML document
     QDomElement eventList = doc.createElement("eventList");
     root.appendChild(eventList);
@@ -240,196 +251,275 @@ bool vbproject::save(QString filename)
     return false;
 }
 
-bool vbproject::load(QString filename)
+//-----------------------------------------------------------------------
+// XML reading helpers
+//
+// Projects and event imports are read with QXmlStreamReader so that
+// only the event being parsed is held in memory, however large the file.
+
+namespace {
+
+// Reports progress through the file being read, at most once per percent
+class XmlReadProgress
 {
-    // Clear existing event list
-    //qDeleteAll(events);
-    FilmEventsTableModel()->Clear();
+public:
+    XmlReadProgress(const QFile &f, const VBProgressFunction &fn) :
+        file(f), func(fn), total(f.size()), lastPercent(-1) {}
 
-    // Load XML data from file
-    QDomDocument doc("vbproject");
-    QFile file(filename);
-    if(!(file.open(QIODevice::ReadOnly | QIODevice::Text)))
-        return false;
-    doc.setContent(&file);
-    file.close();
+    void Update()
+    {
+        if(!func) return;
 
-    QDomElement root = doc.documentElement();
+        qint64 pos = std::min(file.pos(), total);
+        int percent = (total > 0) ? int((100 * pos) / total) : 100;
+        if(percent == lastPercent) return;
 
-    QDomElement notesElement = root.firstChildElement("film_notes");
-    if(!notesElement.isNull())
-        SetFilmNotes(notesElement.text());
-    else
-        SetFilmNotes(QString());
+        lastPercent = percent;
+        func(pos, total);
+    }
 
-    // Extract Document Properties
-    QDomElement propElement = root.firstChildElement("Properties");
-    if(!propElement.isNull())
-    {
-        QDomNodeList propNodeList = propElement.childNodes();
+private:
+    const QFile &file;
+    const VBProgressFunction &func;
+    qint64 total;
+    int lastPercent;
+};
+
+// Build a project event from the attributes of an <event> (or legacy
+// <event_join>) element. Known/expected/special values get bespoke
+// processing; everything else becomes a custom attribute.
+vbevent EventFromProjectXml(const QXmlStreamAttributes &attrs, bool isJoin)
+{
+    QSet<QString> handled;
+    auto take = [&](const QString &name) {
+        handled << name;
+        return attrs.value(name).toString();
+    };
 
-        for(int i=0; i<propNodeList.size(); ++i)
-        {
-            if(propNodeList.at(i).toElement().tagName() == "ConfidenceThreshold")
-            {
-                SetConfidenceThreshold(
-                    propNodeList.at(i).toElement().text().toFloat(),
-                    true);
-            }
-            else
-            {
-                properties.SetValue(
-                    propNodeList.at(i).toElement().tagName(),
-                    propNodeList.at(i).toElement().text());
-            }
-        }
+    vbevent event(take("start").toInt());
+
+    if(attrs.hasAttribute("eventtype"))
+        event.SetType(take("eventtype"));
+    else if(isJoin)
+        event.SetType(VB_EVENT_JOIN);
+
+    if(attrs.hasAttribute("end"))
+        event.SetEnd(take("end").toInt());
+
+    if(attrs.hasAttribute("boundingbox_w"))
+    {
+        float x = take("boundingbox_x").toFloat();
+        float y = take("boundingbox_y").toFloat();
+        float w = take("boundingbox_w").toFloat();
+        float h = take("boundingbox_h").toFloat();
+        event.SetBoundsCenterAndSize(x, y, w, h);
+    }
+    else if(attrs.hasAttribute("boundingbox_x0"))
+    {
+        float x0 = take("boundingbox_x0").toFloat();
+        float x1 = take("boundingbox_x1").toFloat();
+        float y0 = take("boundingbox_y0").toFloat();
+        float y1 = take("boundingbox_y1").toFloat();
+        event.SetBoundsX0X1Y0Y1(x0, x1, y0, y1);
     }
 
-    // read some properties from metadata for compatibility with old XML format
-    // Extract project metadata
-    QDomElement metadata = root.firstChildElement("metadata");
-    if(!metadata.isNull())
+    if(attrs.hasAttribute("IsContinuous"))
+        event.SetContinuous(take("IsContinuous").toLower() == "true");
+
+    // add any other custom attibutes given
+    for(const QXmlStreamAttribute &attr : attrs)
     {
-        if(FileURL().isEmpty() && metadata.hasAttribute("fileURL"))
-            SetFileURL(metadata.attribute("fileURL"));
-        if(Title().isEmpty() && metadata.hasAttribute("title"))
-            SetTitle(metadata.attribute("title"));
-        if(RollID().isEmpty() && metadata.hasAttribute("roll_id"))
-            SetRollID(metadata.attribute("roll_id"));
-        if(FilmAssetID().isEmpty() && metadata.hasAttribute("film_asset_id"))
-            SetFilmAssetID(metadata.attribute("film_asset_id"));
-        if(Notes().isEmpty() && metadata.hasAttribute("notes"))
-            SetNotes(metadata.attribute("notes"));
-
-        if(CreationDate().isEmpty() && metadata.hasAttribute("creationdate"))
-            SetCreationDate(metadata.attribute("creationdate"));
-        if(LastModifiedDate().isEmpty() &&
-            metadata.hasAttribute("lastmodificationdate")
-            )
-            SetLastModificationDate(metadata.attribute("lastmodifieddate"));
+        QString attrName = attr.qualifiedName().toString();
+        if(handled.contains(attrName)) continue;
+
+        event.SetAttribute(attrName, attr.value().toString());
     }
 
-    // Extract project settings
-    QDomElement settings = root.firstChildElement("settings");
-    if(FileURL().isEmpty() && settings.hasAttribute("fileURL"))
-        SetFileURL(settings.attribute("fileURL"));
-    if(FilmGauge().isEmpty() && settings.hasAttribute("filmgauge"))
-        SetFilmGauge(settings.attribute("filmgauge"));
-    if(settings.hasAttribute("zeroframe"))
-        zeroframe = settings.attribute("zeroframe").toInt();
-    else
-        zeroframe = 0;
+    return event;
+}
 
-    overlap_framestart = settings.attribute("overlap_framestart").toFloat();
-    overlap_frameend = settings.attribute("overlap_frameend").toFloat();
+} // namespace
 
-    FilmEventsTableModel()->BeginBatchAddEvent();
+bool vbproject::load(QString filename, const VBProgressFunction &progress)
+{
+    // Clear existing event list
+    FilmEventsTableModel()->Clear();
 
-    // Extract event list
-    QDomElement eventList = root.firstChildElement("eventList");
+    QFile file(filename);
+    if(!(file.open(QIODevice::ReadOnly | QIODevice::Text)))
+        return false;
 
-    // use a list of tags for backwards compatibility with previous vesions
-    QStringList compatibleTags = { "event", "event_join" };
-    for ( const auto& tag : compatibleTags )
-    {
-        QDomNodeList eventNodes = eventList.elementsByTagName(tag);
-        for (int i = 0; i < eventNodes.size(); i++)
-        {
-            QDomElement eventNode = eventNodes.at(i).toElement();
+    // defaults for anything not given in the file
+    SetFilmNotes(QString());
+    zeroframe = 0;
+    overlap_framestart = 0.0f;
+    overlap_frameend = 0.0f;
+    overlapTrack.Clear();
 
-            // Extracted known/expected/special values for bespoke
-            // processing. Remove them as they're processed so that
-            // they don't accidentally get processed a second time in
-            // the final "other attributes" loop.
+    QXmlStreamReader xml(&file);
+    XmlReadProgress report(file, progress);
+    QStringList columns;
 
-            vbevent event(eventNode.attribute("start").toInt());
-            eventNode.removeAttribute("start");
+    // nb: this relies on the order the sections are written by save();
+    // e.g., the metadata and settings only fill in properties that
+    // weren't already set by the Properties section.
 
-            if(eventNode.hasAttribute("eventtype"))
+    if(xml.readNextStartElement())
+    {
+        while(xml.readNextStartElement())
+        {
+            if(xml.name() == QLatin1String("film_notes"))
             {
-                event.SetType(eventNode.attribute("eventtype"));
-                eventNode.removeAttribute("eventtype");
+                SetFilmNotes(
+                    xml.readElementText(QXmlStreamReader::IncludeChildElements));
             }
-            else if(tag == "event_join")
+            else if(xml.name() == QLatin1String("Properties"))
             {
-                event.SetType(VB_EVENT_JOIN);
+                // Extract Document Properties
+                while(xml.readNextStartElement())
+                {
+                    QString name = xml.name().toString();
+                    QString value = xml.readElementText(
+                        QXmlStreamReader::IncludeChildElements);
+
+                    if(name == "ConfidenceThreshold")
+                        SetConfidenceThreshold(value.toFloat(), true);
+                    else
+                        properties.SetValue(name, value);
+                }
             }
-
-            if(eventNode.hasAttribute("end"))
+            else if(xml.name() == QLatin1String("metadata"))
             {
-                event.SetEnd(eventNode.attribute("end").toInt());
-                eventNode.removeAttribute("end");
+                // read some properties from metadata for compatibility
+                // with old XML format
+                QXmlStreamAttributes metadata = xml.attributes();
+                auto attribute = [&](const char *name) {
+                    return metadata.value(name).toString(); };
+
+                if(FileURL().isEmpty() && metadata.hasAttribute("fileURL"))
+                    SetFileURL(attribute("fileURL"));
+                if(Title().isEmpty() && metadata.hasAttribute("title"))
+                    SetTitle(attribute("title"));
+                if(RollID().isEmpty() && metadata.hasAttribute("roll_id"))
+                    SetRollID(attribute("roll_id"));
+                if(FilmAssetID().isEmpty() &&
+                    metadata.hasAttribute("film_asset_id"))
+                    SetFilmAssetID(attribute("film_asset_id"));
+                if(Notes().isEmpty() && metadata.hasAttribute("notes"))
+                    SetNotes(attribute("notes"));
+
+                if(CreationDate().isEmpty() &&
+                    metadata.hasAttribute("creationdate"))
+                    SetCreationDate(attribute("creationdate"));
+                if(LastModifiedDate().isEmpty() &&
+                    metadata.hasAttribute("lastmodificationdate")
+                    )
+                    SetLastModificationDate(attribute("lastmodifieddate"));
+
+                xml.skipCurrentElement();
             }
-
-            if(eventNode.hasAttribute("boundingbox_w"))
+            else if(xml.name() == QLatin1String("settings"))
             {
-                event.SetBoundsCenterAndSize(
-                    eventNode.attribute("boundingbox_x").toFloat(),
-                    eventNode.attribute("boundingbox_y").toFloat(),
-                    eventNode.attribute("boundingbox_w").toFloat(),
-                    eventNode.attribute("boundingbox_h").toFloat());
-                eventNode.removeAttribute("boundingbox_x");
-                eventNode.removeAttribute("boundingbox_y");
-                eventNode.removeAttribute("boundingbox_w");
-                eventNode.removeAttribute("boundingbox_h");
+                // Extract project settings
+                QXmlStreamAttributes settings = xml.attributes();
+
+                if(FileURL().isEmpty() && settings.hasAttribute("fileURL"))
+                    SetFileURL(settings.value("fileURL").toString());
+                if(FilmGauge().isEmpty() && settings.hasAttribute("filmgauge"))
+                    SetFilmGauge(settings.value("filmgauge").toString());
+                if(settings.hasAttribute("zeroframe"))
+                    zeroframe = settings.value("zeroframe").toInt();
+
+                overlap_framestart =
+                    settings.value("overlap_framestart").toFloat();
+                overlap_frameend =
+                    settings.value("overlap_frameend").toFloat();
+
+                xml.skipCurrentElement();
             }
-            else if(eventNode.hasAttribute("boundingbox_x0"))
+            else if(xml.name() == QLatin1String("overlap_track"))
             {
-                event.SetBoundsX0X1Y0Y1(
-                    eventNode.attribute("boundingbox_x0").toFloat(),
-                    eventNode.attribute("boundingbox_x1").toFloat(),
-                    eventNode.attribute("boundingbox_y0").toFloat(),
-                    eventNode.attribute("boundingbox_y1").toFloat());
-                eventNode.removeAttribute("boundingbox_x0");
-                eventNode.removeAttribute("boundingbox_x1");
-                eventNode.removeAttribute("boundingbox_y0");
-                eventNode.removeAttribute("boundingbox_y1");
+                QXmlStreamAttributes attrs = xml.attributes();
+                QString key = attrs.value("key").toString();
+                long first = attrs.value("first").toString().toLong();
+                QString records = xml.readElementText();
+
+                // a track that doesn't parse is measured again
+                if(!overlapTrack.Set(key, first, records))
+                    overlapTrack.Clear();
             }
-
-            if(eventNode.hasAttribute("IsContinuous"))
+            else if(xml.name() == QLatin1String("eventList"))
             {
-                bool c(eventNode.attribute("IsContinuous").toLower() == "true");
-                event.SetContinuous(c);
-                eventNode.removeAttribute("IsContinuous");
-            }
-            // add any other custom attibutes given
-            QDomNamedNodeMap attrMap = eventNode.attributes();
+                // Extract event list. Events may be nested at any depth
+                // below the list; use a list of tags for backwards
+                // compatibility with previous vesions.
+                FilmEventsTableModel()->BeginBatchAddEvent();
 
-            for (int i = 0; i < attrMap.count(); ++i)
-            {
-                QDomAttr attr = attrMap.item(i).toAttr();
-                QString attrName = attr.name();              
-                QString attrValue = attr.value();
+                for(int depth=1; depth>0 && !xml.atEnd(); )
+                {
+                    switch(xml.readNext())
+                    {
+                    case QXmlStreamReader::StartElement:
+                        depth++;
+                        if(xml.name() == QLatin1String("event") ||
+                            xml.name() == QLatin1String("event_join"))
+                        {
+                            FilmEventsTableModel()->AddEvent(
+                                EventFromProjectXml(
+                                    xml.attributes(),
+                                    xml.name() == QLatin1String("event_join")));
+                            report.Update();
+                        }
+                        break;
+                    case QXmlStreamReader::EndElement:
+                        depth--;
+                        break;
+                    default:
+                        break;
+                    }
+                }
 
-                event.SetAttribute(attrName, attrValue);
+                FilmEventsTableModel()->EndBatchAddEvent();
             }
-
-            FilmEventsTableModel()->AddEvent(event);
+            else if(xml.name() == QLatin1String("column-view-order"))
+            {
+                while(xml.readNextStartElement())
+                {
+                    if(xml.name() == QLatin1String("column"))
+                        columns << xml.readElementText(
+                            QXmlStreamReader::IncludeChildElements);
+                    else
+                        xml.skipCurrentElement();
+                }
+            }
+            else
+                xml.skipCurrentElement();
         }
     }
 
-    FilmEventsTableModel()->EndBatchAddEvent();
+    file.close();
 
-    QDomElement columnsView = root.firstChildElement("column-view-order");
-    if(!columnsView.isNull())
+    if(xml.hasError())
     {
-        QStringList columns;
-        QDomNodeList colNodeList = columnsView.elementsByTagName("column");
-        for(int i=0; i<colNodeList.size(); ++i)
-            columns << colNodeList.at(i).toElement().text();
-        if(!columns.isEmpty())
-            FilmEventsTableModel()->SetColumns(columns);
+        qDebug() << "Error reading project" << filename << "line" <<
+            xml.lineNumber() << "column" << xml.columnNumber() << ":" <<
+            xml.errorString();
+        return false;
     }
 
+    if(!columns.isEmpty())
+        FilmEventsTableModel()->SetColumns(columns);
+
     if(InputID().isEmpty()) SetInputID(QUrl(FileURL()).fileName());
 
     return true;
 }
 
-EventSet vbproject::ImportEvents(const QString filename)
+EventSet vbproject::ImportEvents(
+    const QString filename,
+    const VBProgressFunction &progress)
 {
     QFile infile(filename);
-    QDomDocument xmlBOM;
 
     EventSet eventSet;
 
@@ -448,124 +538,121 @@ EventSet vbproject::ImportEvents(const QString filename)
 
     qDebug() << "Reading XML";
 
-    // Set data into the QDomDocument for processing
-    QDomDocument::ParseResult parse = xmlBOM.setContent(&infile);
-    infile.close();
-
-    // nb: the 6.5 docs say casting to bool returns true if there is an
-    // error and false otherwise, but the opposite is the case.
-    if(!bool(parse))
-    {
-        QMessageBox msgError;
-        msgError.setText(
-            QString("Error reading XML file, line %1, column %2<br/>%3")
-                .arg(parse.errorLine)
-                .arg(parse.errorColumn)
-                .arg(parse.errorMessage.toHtmlEscaped()));
-        msgError.setIcon(QMessageBox::Critical);
-        msgError.setWindowTitle("Error reading XML file");
-        msgError.exec();
-        return eventSet;
-    }
-
-    QDomElement root = xmlBOM.documentElement();
-
-    QDomElement element;
-    QDomElement attr;
-    QDomElement subAttr;
+    QXmlStreamReader xml(&infile);
+    XmlReadProgress report(infile, progress);
 
+    // Attributes given outside of an event apply to all the events
+    // that follow them
     vbevent dflt;
 
     FilmEventsTableModel()->BeginBatchAddEvent();
 
-    for(element = root.firstChildElement();
-         !element.isNull();
-         element = element.nextSiblingElement())
+    if(xml.readNextStartElement())
     {
-        if(element.tagName() != "event")
+        while(xml.readNextStartElement())
         {
-            dflt.SetAttribute(
-                element.tagName(),
-                element.firstChild().toText().data());
-            continue;
-        }
+            if(xml.name() != QLatin1String("event"))
+            {
+                QString tagName = xml.name().toString();
+                dflt.SetAttribute(
+                    tagName,
+                    xml.readElementText(QXmlStreamReader::SkipChildElements));
+                continue;
+            }
 
-        int start = 0;
-        int end = 0;
-        QString coord;
-        QString eventTypeName = QString();
-        QString tagName;
+            QString coord;
+            QString eventTypeName = QString();
+            QString tagName;
+            QString text;
 
-        vbevent event;
+            vbevent event;
 
-        for(auto &a: dflt.Attributes())
-            event.SetAttribute(a.first, a.second);
+            for(auto &a: dflt.Attributes())
+                event.SetAttribute(a.first, a.second);
 
-        // loop over the attributes of this event
-        for(attr = element.firstChildElement();
-             !attr.isNull();
-             attr = attr.nextSiblingElement())
-        {
-            tagName = attr.tagName();
-            if(tagName == "join") tagName = "splice";
-            else if (tagName=="event_confidence") tagName="confidence";
+            // loop over the attributes of this event
+            while(xml.readNextStartElement())
+            {
+                QString elementName = xml.name().toString();
+                text = xml.readElementText(QXmlStreamReader::SkipChildElements);
 
+                tagName = elementName;
+                if(tagName == "join") tagName = "splice";
+                else if (tagName=="event_confidence") tagName="confidence";
 
-            if (tagName=="location_absolute_in")
-            {
-                start=attr.firstChild().toText().data().toInt();
-                event.SetStart(start);
-            }
-            else if (tagName=="location_absolute_out")
-            {
-                end=attr.firstChild().toText().data().toInt();
-                event.SetEnd(end);
-            }
-            else if (tagName=="location_pixels")
-            {
-                coord=attr.firstChild().toText().data();
-                if(!coord.isEmpty())
+                if (tagName=="location_absolute_in")
+                {
+                    event.SetStart(text.toInt());
+                }
+                else if (tagName=="location_absolute_out")
                 {
-                    QStringList co = coord.split(",");
-                    if (co.length()>3)
+                    event.SetEnd(text.toInt());
+                }
+                else if (tagName=="location_pixels")
+                {
+                    coord=text;
+                    if(!coord.isEmpty())
                     {
-                        event.SetBoundsCenterAndSize(
-                            co[0].toDouble(),
-                            co[1].toDouble(),
-                            co[2].toDouble(),
-                            co[3].toDouble());
+                        QStringList co = coord.split(",");
+                        if (co.length()>3)
+                        {
+                            event.SetBoundsCenterAndSize(
+                                co[0].toDouble(),
+                                co[1].toDouble(),
+                                co[2].toDouble(),
+                                co[3].toDouble());
+                        }
                     }
                 }
+                else if (tagName=="location_is_continuous")
+                {
+                    bool c(text.toLower()=="true");
+                    event.SetContinuous(c);
+                }
+                else if (vbevent::coreEventTypeNames.
+                         contains(tagName, Qt::CaseInsensitive))
+                {
+                    event.SetType(tagName);
+                    event.SetAttribute(event.SubTypeName(), text);
+                }
+                else if (elementName=="event_type")
+                {
+                    eventTypeName = text;
+                    event.SetType(eventTypeName);
+                }
+                else
+                {
+                    event.SetAttribute(tagName, text);
+                }
             }
-            else if (tagName=="location_is_continuous")
-            {
-                bool c(attr.firstChild().toText().data().toLower()=="true");
-                event.SetContinuous(c);
-            }
-            else if (vbevent::coreEventTypeNames.
-                     contains(tagName, Qt::CaseInsensitive))
-            {
-                event.SetType(tagName);
-                event.SetAttribute(
-                    event.SubTypeName(), attr.firstChild().toText().data());
-            }
-            else if (attr.tagName()=="event_type")
-            {
-                eventTypeName = attr.firstChild().toText().data();
-                event.SetType(eventTypeName);
-            }
-            else
-            {
-                event.SetAttribute(tagName, attr.firstChild().toText().data());
-            }
-        }
 
-        FilmEventsTableModel()->AddEvent(event);
+            if(xml.hasError()) break; // don't add a partial event
+
+            FilmEventsTableModel()->AddEvent(event);
+
+            eventSet += event;
 
-        eventSet += event;
+            report.Update();
+        }
     }
 
     FilmEventsTableModel()->EndBatchAddEvent();
+    infile.close();
+
+    if(xml.hasError())
+    {
+        QMessageBox msgError;
+        msgError.setText(
+            QString("Error reading XML file, line %1, column %2<br/>%3<br/>"
+                    "%4 events were imported before the error.")
+                .arg(xml.lineNumber())
+                .arg(xml.columnNumber())
+                .arg(xml.errorString().toHtmlEscaped())
+                .arg(eventSet.size()));
+        msgError.setIcon(QMessageBox::Critical);
+        msgError.setWindowTitle("Error reading XML file");
+        msgError.exec();
+    }
 
     qDebug() << "Import done; returning";
 
@@ -698,19 +785,42 @@ QList< vbevent* > vbproject::FilmEventsForFrame(uint32_t frame)
     }
 
     // Get the multi-frame events that extend to/past here
-    for(vbevent* ep : multiFrameEvents)
+    for(vbevent* ep : multiFrameEvents.EventsAt(frame))
     {
         // skip Start == frame and frame-1, since they're included above
         uint32_t base = frame;
         if(base>1) base -= 1;
 
-        if((ep->Start() < base) && (ep->End() >= frame))
+        if(ep->Start() < base)
             events.append(ep);
     }
 
     return events;
 }
 
+QList< vbevent* > vbproject::FilmEventsInRange(uint32_t first, uint32_t last)
+{
+    QList< vbevent* > events;
+    if(last < first) return events;
+
+    // Single- and two-frame events starting in the range, or the frame
+    // before it (which may end on the first frame)
+    auto i = FilmEvents().lowerBound(first>0 ? first-1 : 0);
+    for(auto end = FilmEvents().end(); i != end && i.key() <= last; ++i)
+    {
+        for(vbevent &e: i.value())
+        {
+            if(!e.IsMultiFrame() && e.End() >= first)
+                events.append(&e);
+        }
+    }
+
+    // Multi-frame events overlapping the range
+    events.append(multiFrameEvents.EventsInRange(first, last));
+
+    return events;
+}
+
 VBFilmEventsTableModel * vbproject::FilmEventsTableModel()
 {
     if(!filmEventsTableModel)
@@ -853,12 +963,12 @@ void vbproject::UpdateFrameEventBoundingBox(int frame, int eventNum,
 
 void vbproject::MultiFrameEventAdd(vbevent *e)
 {
-    multiFrameEvents.append(e);
+    multiFrameEvents.Insert(e);
 }
 
 void vbproject::MultiFrameEventDelete(vbevent *e)
 {
-    if(!multiFrameEvents.removeOne(e))
+    if(!multiFrameEvents.Remove(e))
     {
         QMessageBox msgError;
         msgError.setText(
@@ -873,7 +983,7 @@ void vbproject::MultiFrameEventDelete(vbevent *e)
 
 void vbproject::MultiFrameEventDeleteAll()
 {
-    multiFrameEvents.clear();
+    multiFrameEvents.Clear();
 }
 
 QStringList vbproject::DefaultAttributeValues(QString attribute) const
@@ -964,6 +1074,9 @@ static VBFilmEvents::size_type FilmEventsSize(const VBFilmEvents &e)
 
 VBFilmEvents::size_type vbproject::NumFilmEvents()
 {
+    if(filmEventsTableModel)
+        return filmEventsTableModel->rowCount();
+
     return FilmEventsSize(filmEvents);
 }
 
@@ -980,7 +1093,9 @@ VBFilmEventsTableModel::VBFilmEventsTableModel(
     filmEvents(filmEventsArg),
     trash(trashArg),
     confidenceThreshold(0.0f),
-    inBatchAddEventMode(false)
+    inBatchAddEventMode(false),
+    rowIndexTotal(0),
+    rowIndexDirty(true)
 {
     columns << "Frame" << "Type" << "SubType" << "Notes" << "CreatorContext" <<
         "CreatorID" << "Confidence" << "Details";
@@ -992,7 +1107,10 @@ int VBFilmEventsTableModel::rowCount(const QModelIndex &parent) const
     if ( parent.isValid() || !filmEvents )
         return 0;
     else
-        return int(FilmEventsSize(*filmEvents));
+    {
+        if(rowIndexDirty) RebuildRowIndex();
+        return rowIndexTotal;
+    }
 }
 
 int VBFilmEventsTableModel::columnCount(const QModelIndex &parent) const
@@ -1004,45 +1122,115 @@ int VBFilmEventsTableModel::columnCount(const QModelIndex &parent) const
         return columns.count();
 }
 
-const vbevent *VBFilmEventsTableModel::EventAtRow(int row) const
+void VBFilmEventsTableModel::RebuildRowIndex() const
 {
-    const vbevent *event(nullptr);
+    rowIndex.clear();
+    rowIndexTotal = 0;
+    rowIndexDirty = false;
+
+    // The tree is sized to a power of two covering the last frame so
+    // that FrameAtRow() can descend it directly. Leave some headroom so
+    // appending events near the end doesn't immediately force a rebuild.
+    uint64_t n = 1024;
+    if(filmEvents && !filmEvents->isEmpty())
+    {
+        uint64_t last = filmEvents->lastKey();
+        while(n <= last + (last>>2))
+            n <<= 1;
+    }
 
-    // Find the frame whose event list contains the target event
-    // Then pick the event from the frame's list at the correct position.
+    rowIndex.fill(0, int(n)+1);
+    if(!filmEvents) return;
 
-    for (auto i = filmEvents->begin(), end = filmEvents->end();
-         i != end && !event; ++i)
+    for (auto i = filmEvents->cbegin(), end = filmEvents->cend(); i != end; ++i)
     {
-        if(row < i.value().length())
+        rowIndex[int(i.key())+1] += i.value().length();
+        rowIndexTotal += i.value().length();
+    }
+
+    // linear-time construction: push each node's sum up to its parent
+    for(int i=1; i<=int(n); ++i)
+    {
+        int parent = i + (i & -i);
+        if(parent <= int(n)) rowIndex[parent] += rowIndex[i];
+    }
+}
+
+void VBFilmEventsTableModel::RowIndexAdd(uint32_t frame, int delta)
+{
+    if(rowIndexDirty) return; // will be rebuilt on next use
+
+    int n = rowIndex.size()-1;
+    if(int64_t(frame) >= n)
+    {
+        rowIndexDirty = true;
+        return;
+    }
+
+    for(int i=int(frame)+1; i<=n; i += (i & -i))
+        rowIndex[i] += delta;
+    rowIndexTotal += delta;
+}
+
+int VBFilmEventsTableModel::RowsBeforeFrame(uint32_t frame) const
+{
+    if(rowIndexDirty) RebuildRowIndex();
+
+    int n = rowIndex.size()-1;
+    if(int64_t(frame) >= n) return rowIndexTotal;
+
+    int rows = 0;
+    for(int i=int(frame); i>0; i -= (i & -i))
+        rows += rowIndex[i];
+
+    return rows;
+}
+
+uint32_t VBFilmEventsTableModel::FrameAtRow(int row, int *offset) const
+{
+    // Find the largest frame f with RowsBeforeFrame(f) <= row.
+    // Caller must ensure 0 <= row < rowCount().
+    int n = rowIndex.size()-1;
+    int pos = 0;
+
+    for(int step = n; step > 0; step >>= 1)
+    {
+        if(pos+step <= n && rowIndex[pos+step] <= row)
         {
-            event = &(i.value().at(row));
+            pos += step;
+            row -= rowIndex[pos];
         }
-        else
-            row -= i.value().length();
     }
 
-    return event;
+    if(offset) *offset = row;
+    return uint32_t(pos);
+}
+
+const vbevent *VBFilmEventsTableModel::EventAtRow(int row) const
+{
+    if(!filmEvents || row < 0 || row >= rowCount()) return nullptr;
+
+    // Find the frame whose event list contains the target event
+    // Then pick the event from the frame's list at the correct position.
+    int r;
+    auto i = filmEvents->constFind(FrameAtRow(row, &r));
+    if(i == filmEvents->cend() || r >= i->length()) return nullptr;
+
+    return &(i.value().at(r));
 }
 
 int VBFilmEventsTableModel::RowOfEvent(const vbevent *event) const
 {
-    int row=0;
-    for (auto i = filmEvents->begin(), end = filmEvents->end();
-         i != end; ++i)
-    {
-        if((*i)[0].Start() >= event->Start())
-        {
-            if((*i)[0].Start() > event->Start()) break;
+    if(!filmEvents || !event) return -1;
 
-            for(auto &e : (*i))
-            {
-                if(e.ID() == event->ID()) return row;
-                else row++;
-            }
-        }
+    auto i = filmEvents->constFind(event->Start());
+    if(i == filmEvents->cend()) return -1;
 
-        row += i->length();
+    int row = RowsBeforeFrame(event->Start());
+    for(auto &e : (*i))
+    {
+        if(e.ID() == event->ID()) return row;
+        else row++;
     }
 
     return -1;
@@ -1050,16 +1238,14 @@ int VBFilmEventsTableModel::RowOfEvent(const vbevent *event) const
 
 int VBFilmEventsTableModel::RowAtFrame(uint32_t frame) const
 {
-    int row=0;
-    for (auto i = filmEvents->begin(), end = filmEvents->end();
-         i != end; ++i)
-    {
-        if((*i)[0].Start() == frame) return row;
-        if((*i)[0].Start() > frame) return std::max(row-1,0);
-        row += i->length();
-    }
+    if(!filmEvents) return 0;
 
-    return std::max(row-1,0); // return last row if we're off the end
+    int row = RowsBeforeFrame(frame);
+    if(filmEvents->contains(frame)) return row;
+
+    // otherwise the last row before this frame (or the last row if
+    // we're off the end)
+    return std::max(row-1,0);
 }
 
 Qt::ItemFlags VBFilmEventsTableModel::flags(const QModelIndex &index) const
@@ -1163,6 +1349,7 @@ void VBFilmEventsTableModel::Clear()
 
     beginResetModel();
     filmEvents->clear();
+    rowIndexDirty = true;
     endResetModel();
 
     emit MultiFrameEventsCleared();
@@ -1179,14 +1366,7 @@ void VBFilmEventsTableModel::AddEvent(const vbevent &event)
     }
 
     // find which row this event will be after it is inserted
-    int r(0);
-    for (auto i = filmEvents->cbegin(), end = filmEvents->cend(); i != end; ++i)
-    {
-        if(i.key() < event.Start())
-            r += i.value().length();
-        else
-            break;
-    }
+    int r = inBatchAddEventMode ? 0 : RowsBeforeFrame(event.Start());
 
     int idx(0);
     if(filmEvents->contains(event.Start()))
@@ -1203,6 +1383,7 @@ void VBFilmEventsTableModel::AddEvent(const vbevent &event)
     {
         beginInsertRows(QModelIndex(), r, r);
         (*filmEvents)[event.Start()].insert(idx,event);
+        RowIndexAdd(event.Start(), 1);
         endInsertRows();
 
         emit FilmEventsTableUpdated();
@@ -1218,6 +1399,7 @@ void VBFilmEventsTableModel::BeginBatchAddEvent()
 {
     beginResetModel();
     inBatchAddEventMode = true;
+    rowIndexDirty = true;
 }
 
 void VBFilmEventsTableModel::EndBatchAddEvent()
@@ -1236,54 +1418,53 @@ void VBFilmEventsTableModel::UpdateEventAtRow(int row, const vbevent &event)
         return;
     }
 
+    if(!filmEvents || row < 0 || row >= rowCount()) return;
+
     // distingish the "row" of the frame's event list from the row of
     // the master table (all frames)
-    int r = row;
+    int r;
+    uint32_t frame = FrameAtRow(row, &r);
+    auto i = filmEvents->find(frame);
 
-    for (auto i = filmEvents->begin(), end = filmEvents->end();
-         i != end; ++i)
+    if(i != filmEvents->end() && r < i->length())
     {
-        if(r < i->length())
+        bool wasMulti = (*i)[r].IsMultiFrame();
+        bool isMulti = event.IsMultiFrame();
+
+        // if the update changes the frame or the ordering
+        // within the frame,
+        // delete the old and then add it as new.
+        if(
+            (i->at(r).Start() == event.Start()) &&
+            ((r==0) || i->at(r-1) < event) &&
+            ((r==i->length()-1 || event < i->at(r+1)))
+            )
         {
-            bool wasMulti = (*i)[r].IsMultiFrame();
-            bool isMulti = event.IsMultiFrame();
-
-            // if the update changes the frame or the ordering
-            // within the frame,
-            // delete the old and then add it as new.
-            if(
-                (i->at(r).Start() == event.Start()) &&
-                ((r==0) || i->at(r-1) < event) &&
-                ((r==i->length()-1 || event < i->at(r+1)))
-                )
-            {
-                // changed from multi to not multi?
-                if(wasMulti && !isMulti)
-                    emit MultiFrameEventDeleted(&((*i)[r]));
+            // The multi-frame index keys on the event's extent, so
+            // drop it before the update and re-add it afterwards if
+            // it is (still) multi-frame.
+            if(wasMulti)
+                emit MultiFrameEventDeleted(&((*i)[r]));
 
-                (*i)[r] = event;
+            (*i)[r] = event;
 
-                // changed to multi?
-                if(isMulti && !wasMulti)
-                    emit MultiFrameEventAdded(&((*i)[r]));
-            }
-            else
-            {
-                if(wasMulti)
-                    emit MultiFrameEventDeleted(&((*i)[r]));
+            if(isMulti)
+                emit MultiFrameEventAdded(&((*i)[r]));
+        }
+        else
+        {
+            if(wasMulti)
+                emit MultiFrameEventDeleted(&((*i)[r]));
 
-                beginRemoveRows(QModelIndex(),row,row);
-                i->remove(r);
-                if(i->isEmpty())
-                    i = filmEvents->erase(i); // clazy:exclude=strict-iterators
-                endRemoveRows();
+            beginRemoveRows(QModelIndex(),row,row);
+            i->remove(r);
+            if(i->isEmpty())
+                filmEvents->erase(i);
+            RowIndexAdd(frame, -1);
+            endRemoveRows();
 
-                AddEvent(event); // AddEvent emits multiAdd signal if needed
-            }
-            break;
+            AddEvent(event); // AddEvent emits multiAdd signal if needed
         }
-        else
-            r -= i->length();
     }
     emit FilmEventsTableUpdated();
 }
@@ -1292,27 +1473,25 @@ vbevent VBFilmEventsTableModel::TakeEvent(int row)
 {
     vbevent event;
 
+    if(!filmEvents || row < 0 || row >= rowCount()) return event;
+
     // distingish the "row" of the frame's event list from the row of
     // the master table (all frames)
-    int r = row;
+    int r;
+    uint32_t frame = FrameAtRow(row, &r);
+    auto i = filmEvents->find(frame);
 
-    for (auto i = filmEvents->begin(), end = filmEvents->end();
-         i != end; ++i)
+    if(i != filmEvents->end() && r < i->length())
     {
-        if(r < i->length())
-        {
-            if((*i)[r].IsMultiFrame())
-                emit MultiFrameEventDeleted(&((*i)[r]));
-
-            beginRemoveRows(QModelIndex(),row,row);
-            event = i->takeAt(r);
-            if(i->isEmpty())
-                i = filmEvents->erase(i); // clazy:exclude=strict-iterators
-            endRemoveRows();
-            break;
-        }
-        else
-            r -= i->length();
+        if((*i)[r].IsMultiFrame())
+            emit MultiFrameEventDeleted(&((*i)[r]));
+
+        beginRemoveRows(QModelIndex(),row,row);
+        event = i->takeAt(r);
+        if(i->isEmpty())
+            filmEvents->erase(i);
+        RowIndexAdd(frame, -1);
+        endRemoveRows();
     }
     emit FilmEventsTableUpdated();
 
@@ -32,8 +32,12 @@
 #define VBPROJECT_H
 
 #include <QObject>
+#include <functional>
+#include <QVector>
 #include <vbevent.h>
 
+#include "eventintervalindex.h"
+#include "overlaptrack.h"
 #include "propertylist.h"
 
 typedef QList<vbevent> VBFrameEvents; // list of all the events that occur (or start) on the same frame as each other
@@ -41,6 +45,9 @@ typedef QMap<uint32_t, VBFrameEvents> VBFilmEvents;
 
 typedef QMap<QString, QStringList> VBFilmEventAttributeValues;
 
+// called with the number of bytes read so far and the file size
+typedef std::function<void(qint64, qint64)> VBProgressFunction;
+
 class VBFilmEventsTableModel : public QAbstractTableModel
 {
     Q_OBJECT
@@ -88,6 +95,20 @@ private:
     float confidenceThreshold;
     QStringList columns;
     bool inBatchAddEventMode;
+
+    // Row index: a Fenwick (binary indexed) tree of the number of events
+    // at each frame number, so that row <-> event lookups are O(log n).
+    // It is updated in place as events are added and removed, and is
+    // rebuilt from the map when marked dirty (batch adds, Clear(), or an
+    // event past the end of the tree).
+    void RebuildRowIndex() const;
+    void RowIndexAdd(uint32_t frame, int delta);
+    int RowsBeforeFrame(uint32_t frame) const;
+    uint32_t FrameAtRow(int row, int *offset) const;
+
+    mutable QVector<int> rowIndex;
+    mutable int rowIndexTotal;
+    mutable bool rowIndexDirty;
 };
 
 class vbproject : public QObject
@@ -109,6 +130,7 @@ public:
     int zeroframe;
     float overlap_framestart;
     float overlap_frameend;
+    OverlapTrack overlapTrack; // from "Measure Overlaps", may be empty
 
     VBFilmEvents::size_type NumFilmEvents();
 
@@ -128,8 +150,10 @@ public:
         { properties.SetValue("ModificationDate", s); }
 
     bool save(QString filename);
-    bool load(QString filename);
-    EventSet ImportEvents(const QString filename);
+    bool load(QString filename,
+              const VBProgressFunction &progress = nullptr);
+    EventSet ImportEvents(const QString filename,
+                          const VBProgressFunction &progress = nullptr);
     void ExportEvents(
         const QString filename,
         std::function<bool(int)> include = [](int a){(void)a; return true;}
@@ -138,6 +162,7 @@ public:
     inline const VBFilmEvents &FilmEvents() const { return filmEvents; }
     inline VBFilmEvents &FilmEvents() { return filmEvents; }
     QList<vbevent *> FilmEventsForFrame(uint32_t frame);
+    QList<vbevent *> FilmEventsInRange(uint32_t first, uint32_t last);
     VBFilmEventsTableModel *FilmEventsTableModel();
 
     QString FilmNotes() const { return filmNotes; }
@@ -166,7 +191,7 @@ private:
     PropertyList properties;
     VBFilmEvents filmEvents;
     VBFilmEventsTableModel *filmEventsTableModel;
-    QList<vbevent*> multiFrameEvents;
+    EventIntervalIndex multiFrameEvents;
 
     QString filmNotes;
 
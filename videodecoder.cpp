@@ -0,0 +1,183 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+#include "videodecoder.h"
+
+//-----------------------------------------------------------------------------
+void VideoDecodeThread::Start(AVFormatContext *f, AVCodecContext *c,
+		int s, size_t n)
+{
+	Stop();
+
+	format = f;
+	codec = c;
+	streamIdx = s;
+	capacity = (n > 0) ? n : 1;
+	seekPending = false;
+	atEnd = false;
+	stopping = false;
+
+	thread = std::thread(&VideoDecodeThread::Run, this);
+}
+
+//-----------------------------------------------------------------------------
+void VideoDecodeThread::Stop()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	changed.notify_all();
+
+	if(thread.joinable()) thread.join();
+
+	ClearQueue();
+}
+
+//-----------------------------------------------------------------------------
+// Must be called with the lock held (or the thread stopped)
+void VideoDecodeThread::ClearQueue()
+{
+	for(AVFrame *frame : queue)
+		av_frame_free(&frame);
+	queue.clear();
+}
+
+//-----------------------------------------------------------------------------
+void VideoDecodeThread::Seek(int64_t ts)
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		ClearQueue();
+		seekPending = true;
+		seekTS = ts;
+		atEnd = false;
+	}
+	changed.notify_all();
+}
+
+//-----------------------------------------------------------------------------
+AVFrame *VideoDecodeThread::Next()
+{
+	std::unique_lock<std::mutex> guard(lock);
+
+	changed.wait(guard, [this]() {
+		return !queue.empty() || (atEnd && !seekPending) || stopping; });
+
+	if(queue.empty()) return NULL;
+
+	AVFrame *frame = queue.front();
+	queue.pop_front();
+	changed.notify_all();
+
+	return frame;
+}
+
+//-----------------------------------------------------------------------------
+void VideoDecodeThread::Run()
+{
+	AVPacket *packet = av_packet_alloc();
+	AVFrame *frame = av_frame_alloc();
+	bool flushed(false); // the end of the stream was sent to the decoder
+
+	std::unique_lock<std::mutex> guard(lock);
+
+	while(!stopping)
+	{
+		if(seekPending)
+		{
+			int64_t ts = seekTS;
+			seekPending = false;
+			guard.unlock();
+
+			av_seek_frame(format, streamIdx, ts, AVSEEK_FLAG_BACKWARD);
+			avcodec_flush_buffers(codec);
+			flushed = false;
+
+			guard.lock();
+			continue;
+		}
+
+		if(queue.size() >= capacity || atEnd)
+		{
+			changed.wait(guard);
+			continue;
+		}
+
+		guard.unlock();
+
+		int err = avcodec_receive_frame(codec, frame);
+		if(err == AVERROR(EAGAIN) ||
+				(err < 0 && err != AVERROR_EOF && !flushed))
+		{
+			// the decoder wants more input (or skip past a decoding error)
+			if(av_read_frame(format, packet) < 0)
+			{
+				avcodec_send_packet(codec, NULL);
+				flushed = true;
+			}
+			else
+			{
+				if(packet->stream_index == streamIdx)
+					avcodec_send_packet(codec, packet);
+				av_packet_unref(packet);
+			}
+			guard.lock();
+			continue;
+		}
+
+		AVFrame *decoded(NULL);
+		if(err == 0)
+		{
+			decoded = av_frame_alloc();
+			av_frame_move_ref(decoded, frame);
+		}
+
+		guard.lock();
+
+		if(seekPending)
+		{
+			// decoded before the seek: not wanted
+			av_frame_free(&decoded);
+			continue;
+		}
+
+		if(decoded)
+			queue.push_back(decoded);
+		else
+			atEnd = true;
+
+		changed.notify_all();
+	}
+
+	guard.unlock();
+	av_frame_free(&frame);
+	av_packet_free(&packet);
+}
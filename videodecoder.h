@@ -0,0 +1,100 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+// VideoDecodeThread -- demux and decode a video stream on a thread of its
+// own, keeping a bounded queue of decoded frames ahead of the reader.
+//
+// Decoding uses avcodec_send_packet()/avcodec_receive_frame(); the codec
+// context should be opened with frame and/or slice threading, so the
+// decoder's own threads work while the reader converts and displays
+// earlier frames. The thread owns the format and codec contexts while it
+// runs: nothing else may use them between Start() and Stop().
+
+#ifndef VIDEODECODER_H
+#define VIDEODECODER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+#define VIDEO_DECODE_QUEUE_FRAMES 8
+
+class VideoDecodeThread {
+private:
+	AVFormatContext *format;
+	AVCodecContext *codec;
+	int streamIdx;
+	size_t capacity;
+
+	std::thread thread;
+
+	// guards everything below
+	std::mutex lock;
+	std::condition_variable changed;
+
+	std::deque<AVFrame *> queue;
+	bool seekPending;
+	int64_t seekTS;
+	bool atEnd;      // every frame has been queued
+	bool stopping;
+
+	void Run();
+	void ClearQueue();
+
+public:
+	VideoDecodeThread()
+		: format(NULL), codec(NULL), streamIdx(0),
+		capacity(VIDEO_DECODE_QUEUE_FRAMES), seekPending(false), seekTS(0),
+		atEnd(false), stopping(false) {} ;
+	~VideoDecodeThread() { Stop(); }
+
+	void Start(AVFormatContext *format, AVCodecContext *codec, int streamIdx,
+			size_t capacity=VIDEO_DECODE_QUEUE_FRAMES);
+	void Stop();
+
+	// Drop the queued frames and carry on from the keyframe at or before
+	// ts (in stream time base units)
+	void Seek(int64_t ts);
+
+	// The next decoded frame, in presentation order; the caller frees it
+	// with av_frame_free(). Blocks until one is ready. NULL at the end of
+	// the stream.
+	AVFrame *Next();
+};
+
+#endif // VIDEODECODER_H
@@ -0,0 +1,366 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+#include <algorithm>
+
+extern "C"
+{
+#include <libavutil/imgutils.h>
+}
+
+#include "videoencoder.h"
+#include "vfbexception.h"
+
+// a free converted frame is reused as is unless the encoder still holds a
+// reference to its data
+static void PrepareFrame(AVFrame *frame, const AVCodecContext *codec)
+{
+	if(frame->buf[0] && av_frame_is_writable(frame)) return;
+
+	av_frame_unref(frame);
+	frame->format = codec->pix_fmt;
+	frame->width = codec->width;
+	frame->height = codec->height;
+	if(av_frame_get_buffer(frame, 32) < 0)
+		throw vfbexception("Could not allocate video frame");
+}
+
+//-----------------------------------------------------------------------------
+void VideoEncodePipeline::Start(AVFormatContext *f, AVStream *st,
+		AVCodecContext *c, enum AVPixelFormat src, size_t minBufferSize,
+		size_t n)
+{
+	Stop();
+
+	format = f;
+	stream = st;
+	codec = c;
+	srcFormat = src;
+	depth = (n > 0) ? n : 1;
+
+	int size = av_image_get_buffer_size(srcFormat, codec->width,
+			codec->height, 1);
+	srcLinesize = av_image_get_linesize(srcFormat, codec->width, 0);
+	if(size <= 0 || srcLinesize <= 0)
+		throw vfbexception("Unsupported video source format");
+	bufferSize = std::max(size_t(size), minBufferSize);
+
+	sws = sws_getContext(codec->width, codec->height, srcFormat,
+			codec->width, codec->height, codec->pix_fmt,
+			SWS_BICUBIC, NULL, NULL, NULL);
+	if(sws == NULL)
+		throw vfbexception("Could not initialize the conversion context");
+
+	numBuffers = 0;
+	inFlight = 0;
+	finishing = false;
+	converted = false;
+	stopping = false;
+	error = nullptr;
+
+	convertThread = std::thread(&VideoEncodePipeline::Convert, this);
+	encodeThread = std::thread(&VideoEncodePipeline::Encode, this);
+}
+
+//-----------------------------------------------------------------------------
+uint8_t *VideoEncodePipeline::Acquire()
+{
+	std::unique_lock<std::mutex> guard(lock);
+
+	// not Start()ed, or already Finish()ed/Stop()ped: there is nothing to
+	// encode the frame and bufferSize is 0
+	if(!encodeThread.joinable())
+		throw vfbexception("Video encoder not started");
+
+	// Enough buffers for both queues, a frame in each thread and one
+	// being rendered. If the caller itself holds them all (rendering
+	// ahead for the audio), waiting would never end: allocate another.
+	const size_t maxBuffers = 2*depth + 3;
+	changed.wait(guard, [this, maxBuffers]() {
+		return !freeBuffers.empty() || numBuffers < maxBuffers ||
+			inFlight == 0 || stopping; });
+
+	if(error) std::rethrow_exception(error);
+	if(stopping) throw vfbexception("Video encoder stopped");
+
+	if(!freeBuffers.empty())
+	{
+		uint8_t *buf = freeBuffers.back();
+		freeBuffers.pop_back();
+		return buf;
+	}
+
+	++numBuffers;
+	return new uint8_t[bufferSize];
+}
+
+//-----------------------------------------------------------------------------
+void VideoEncodePipeline::Submit(uint8_t *buf, int64_t pts)
+{
+	std::unique_lock<std::mutex> guard(lock);
+
+	changed.wait(guard, [this]() {
+		return pictures.size() < depth || stopping; });
+
+	if(stopping)
+	{
+		freeBuffers.push_back(buf);
+		if(error) std::rethrow_exception(error);
+		throw vfbexception("Video encoder stopped");
+	}
+
+	Picture p;
+	p.buf = buf;
+	p.pts = pts;
+	pictures.push_back(p);
+	++inFlight;
+
+	changed.notify_all();
+}
+
+//-----------------------------------------------------------------------------
+void VideoEncodePipeline::Release(uint8_t *buf)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	freeBuffers.push_back(buf);
+	changed.notify_all();
+}
+
+//-----------------------------------------------------------------------------
+int VideoEncodePipeline::WritePacket(AVFormatContext *oc, AVPacket *packet,
+		AVRational timeBase, AVStream *st)
+{
+	av_packet_rescale_ts(packet, timeBase, st->time_base);
+	packet->stream_index = st->index;
+
+	std::lock_guard<std::mutex> guard(muxLock);
+	return av_interleaved_write_frame(oc, packet);
+}
+
+//-----------------------------------------------------------------------------
+// Must be called with the lock held
+void VideoEncodePipeline::Fail(std::exception_ptr e)
+{
+	if(!error) error = e;
+	stopping = true;
+	changed.notify_all();
+}
+
+//-----------------------------------------------------------------------------
+void VideoEncodePipeline::Convert()
+{
+	std::unique_lock<std::mutex> guard(lock);
+
+	for(;;)
+	{
+		changed.wait(guard, [this]() {
+			return stopping || (frames.size() < depth &&
+				(!pictures.empty() || finishing)); });
+		if(stopping) break;
+
+		if(pictures.empty())
+		{
+			converted = true;
+			changed.notify_all();
+			break;
+		}
+
+		Picture p = pictures.front();
+		pictures.pop_front();
+		AVFrame *frame(NULL);
+		if(!freeFrames.empty())
+		{
+			frame = freeFrames.back();
+			freeFrames.pop_back();
+		}
+		changed.notify_all();
+
+		guard.unlock();
+
+		try
+		{
+			if(frame == NULL && (frame = av_frame_alloc()) == NULL)
+				throw vfbexception("Could not allocate video frame");
+			PrepareFrame(frame, codec);
+
+			const uint8_t *src[4] = { p.buf, NULL, NULL, NULL };
+			const int srcStride[4] = { srcLinesize, 0, 0, 0 };
+			sws_scale(sws, src, srcStride, 0, codec->height,
+					frame->data, frame->linesize);
+			frame->pts = p.pts;
+		}
+		catch(...)
+		{
+			guard.lock();
+			freeBuffers.push_back(p.buf);
+			--inFlight;
+			if(frame) freeFrames.push_back(frame);
+			Fail(std::current_exception());
+			break;
+		}
+
+		guard.lock();
+
+		freeBuffers.push_back(p.buf);
+		--inFlight;
+		frames.push_back(frame);
+		changed.notify_all();
+	}
+}
+
+//-----------------------------------------------------------------------------
+void VideoEncodePipeline::SendFrame(AVFrame *frame, AVPacket *packet)
+{
+	int ret = avcodec_send_frame(codec, frame);
+
+	while(ret >= 0)
+	{
+		ret = avcodec_receive_packet(codec, packet);
+		if(ret == AVERROR(EAGAIN) || ret == AVERROR_EOF) return;
+		if(ret < 0) break;
+
+		ret = WritePacket(format, packet, codec->time_base, stream);
+	}
+
+	throw vfbexception("Error encoding video frame");
+}
+
+//-----------------------------------------------------------------------------
+// Sending NULL once everything is converted flushes the encoder.
+void VideoEncodePipeline::Encode()
+{
+	AVPacket *packet = av_packet_alloc();
+	std::unique_lock<std::mutex> guard(lock);
+
+	if(packet == NULL)
+		Fail(std::make_exception_ptr(
+				vfbexception("Could not allocate video packet")));
+
+	while(!stopping)
+	{
+		changed.wait(guard, [this]() {
+			return !frames.empty() || converted || stopping; });
+		if(stopping) break;
+
+		AVFrame *frame(NULL);
+		if(!frames.empty())
+		{
+			frame = frames.front();
+			frames.pop_front();
+			changed.notify_all();
+		}
+
+		guard.unlock();
+
+		try
+		{
+			SendFrame(frame, packet);
+		}
+		catch(...)
+		{
+			guard.lock();
+			if(frame) freeFrames.push_back(frame);
+			Fail(std::current_exception());
+			break;
+		}
+
+		guard.lock();
+
+		if(frame == NULL) break; // flushed
+
+		freeFrames.push_back(frame);
+		changed.notify_all();
+	}
+
+	guard.unlock();
+	av_packet_free(&packet);
+}
+
+//-----------------------------------------------------------------------------
+void VideoEncodePipeline::Finish()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		finishing = true;
+	}
+	changed.notify_all();
+
+	if(convertThread.joinable()) convertThread.join();
+	if(encodeThread.joinable()) encodeThread.join();
+
+	std::exception_ptr e = error;
+	Free();
+	if(e) std::rethrow_exception(e);
+}
+
+//-----------------------------------------------------------------------------
+void VideoEncodePipeline::Stop()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		stopping = true;
+	}
+	changed.notify_all();
+
+	if(convertThread.joinable()) convertThread.join();
+	if(encodeThread.joinable()) encodeThread.join();
+
+	Free();
+}
+
+//-----------------------------------------------------------------------------
+// The threads must be stopped
+void VideoEncodePipeline::Free()
+{
+	for(const Picture &p : pictures)
+		delete [] p.buf;
+	pictures.clear();
+	for(AVFrame *frame : frames)
+		av_frame_free(&frame);
+	frames.clear();
+
+	for(uint8_t *buf : freeBuffers)
+		delete [] buf;
+	freeBuffers.clear();
+	for(AVFrame *frame : freeFrames)
+		av_frame_free(&frame);
+	freeFrames.clear();
+
+	numBuffers = 0;
+	inFlight = 0;
+	bufferSize = 0;
+	error = nullptr;
+
+	if(sws)
+	{
+		sws_freeContext(sws);
+		sws = NULL;
+	}
+}
@@ -0,0 +1,158 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+// VideoEncodePipeline -- convert and encode rendered video frames on
+// threads of their own, so the thread that renders them only renders.
+//
+// Three stages, joined by bounded queues:
+//
+//   render    the caller: renders each frame, reads it back into a buffer
+//             from Acquire() and Submit()s it with its pts
+//   convert   a thread converting the buffers to the encoder's pixel
+//             format with swscale
+//   encode    a thread sending the converted frames to the encoder and the
+//             packets it returns to the muxer
+//
+// Each queue holds at most depth frames, so a stage that gets ahead waits
+// for the one after it. Source buffers and converted frames are recycled
+// rather than allocated per frame. The codec context should be opened
+// with frame and/or slice threading, so the encoder's own threads work
+// alongside the pipeline's.
+//
+// The pipeline owns the codec context between Start() and Finish() or
+// Stop(). Other streams of the same AVFormatContext must be written with
+// WritePacket(), which serializes access to the muxer.
+
+#ifndef VIDEOENCODER_H
+#define VIDEOENCODER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libswscale/swscale.h>
+}
+
+#define VIDEO_ENCODE_QUEUE_FRAMES 4
+
+class VideoEncodePipeline {
+private:
+	class Picture {
+	public:
+		uint8_t *buf;
+		int64_t pts;
+	};
+
+	AVFormatContext *format;
+	AVStream *stream;
+	AVCodecContext *codec;
+	struct SwsContext *sws;
+	enum AVPixelFormat srcFormat;
+	int srcLinesize;
+	size_t bufferSize;
+	size_t depth;
+
+	std::thread convertThread;
+	std::thread encodeThread;
+	std::mutex muxLock;
+
+	// guards everything below
+	std::mutex lock;
+	std::condition_variable changed;
+
+	std::deque<Picture> pictures; // submitted, waiting to be converted
+	std::deque<AVFrame *> frames; // converted, waiting to be encoded
+	std::vector<uint8_t *> freeBuffers;
+	std::vector<AVFrame *> freeFrames;
+	size_t numBuffers; // allocated, free or not
+	size_t inFlight;   // buffers submitted and not yet converted
+	bool finishing;    // nothing more will be submitted
+	bool converted;    // every submitted buffer has been converted
+	bool stopping;
+	std::exception_ptr error;
+
+	void Convert();
+	void Encode();
+	void SendFrame(AVFrame *frame, AVPacket *packet);
+	void Fail(std::exception_ptr e);
+	void Free();
+
+public:
+	VideoEncodePipeline()
+		: format(NULL), stream(NULL), codec(NULL), sws(NULL),
+		srcFormat(AV_PIX_FMT_NONE), srcLinesize(0), bufferSize(0),
+		depth(VIDEO_ENCODE_QUEUE_FRAMES), numBuffers(0), inFlight(0),
+		finishing(false), converted(false), stopping(false) {} ;
+	~VideoEncodePipeline() { Stop(); }
+
+	// Encode frames of srcFormat, at the codec's size, into stream.
+	// Buffers are at least minBufferSize bytes.
+	void Start(AVFormatContext *format, AVStream *stream,
+			AVCodecContext *codec, enum AVPixelFormat srcFormat,
+			size_t minBufferSize=0, size_t depth=VIDEO_ENCODE_QUEUE_FRAMES);
+
+	// A buffer of BufferSize() bytes to render a frame into. Blocks while
+	// the stages after the caller are full. Throws if a stage failed, or
+	// if the pipeline isn't started.
+	uint8_t *Acquire();
+
+	// Queue buf, from Acquire(), to be encoded at pts (in the codec time
+	// base). The pipeline takes it back once it is converted.
+	void Submit(uint8_t *buf, int64_t pts);
+
+	// Give back a buffer from Acquire() without encoding it. Buffers must
+	// be submitted or released before Finish() or Stop().
+	void Release(uint8_t *buf);
+
+	size_t BufferSize() const { return bufferSize; }
+
+	// Write a packet, in timeBase units, to st of oc (the pipeline's own
+	// or another stream of the same muxer). Returns
+	// av_interleaved_write_frame()'s result.
+	int WritePacket(AVFormatContext *oc, AVPacket *packet,
+			AVRational timeBase, AVStream *st);
+
+	// Encode everything submitted, flush the encoder and stop the threads.
+	// Rethrows an error from either stage.
+	void Finish();
+
+	// Stop the threads, dropping whatever is queued
+	void Stop();
+};
+
+#endif // VIDEOENCODER_H
@@ -0,0 +1,192 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstdlib>
+#include <iterator>
+
+#include "videoseek.h"
+
+//-----------------------------------------------------------------------------
+void VideoSeekIndex::Start(const std::string &filename, int streamIdx)
+{
+	Stop();
+
+	pts.clear();
+	keyframes.clear();
+	ready = false;
+	cancel = false;
+	builder = std::thread(&VideoSeekIndex::Build, this, filename, streamIdx);
+}
+
+//-----------------------------------------------------------------------------
+void VideoSeekIndex::Stop()
+{
+	cancel = true;
+	if(builder.joinable()) builder.join();
+}
+
+//-----------------------------------------------------------------------------
+// Build - read every packet of the stream (without decoding) and sort the
+// timestamps into presentation order. If anything fails the index is
+// simply never ready, and seeking keeps assuming a constant frame rate.
+void VideoSeekIndex::Build(const std::string filename, int streamIdx)
+{
+	AVFormatContext *format(NULL);
+
+	if(avformat_open_input(&format, filename.c_str(), NULL, NULL) < 0)
+		return;
+	if(avformat_find_stream_info(format, NULL) < 0 ||
+			streamIdx >= int(format->nb_streams))
+	{
+		avformat_close_input(&format);
+		return;
+	}
+
+	// only the video stream's packets are wanted
+	for(unsigned int i=0; i<format->nb_streams; ++i)
+		if(int(i) != streamIdx) format->streams[i]->discard = AVDISCARD_ALL;
+
+	AVPacket *packet = av_packet_alloc();
+	if(packet == NULL)
+	{
+		avformat_close_input(&format);
+		return;
+	}
+
+	std::vector<std::pair<int64_t, bool> > packets;
+	bool complete(true);
+
+	while(av_read_frame(format, packet) >= 0)
+	{
+		if(packet->stream_index == streamIdx)
+		{
+			int64_t ts = (packet->pts != AV_NOPTS_VALUE) ? packet->pts :
+				packet->dts;
+			if(ts == AV_NOPTS_VALUE) complete = false;
+			packets.push_back(std::make_pair(ts,
+					(packet->flags & AV_PKT_FLAG_KEY) != 0));
+		}
+		av_packet_unref(packet);
+
+		if(cancel)
+		{
+			complete = false;
+			break;
+		}
+	}
+	av_packet_free(&packet);
+	avformat_close_input(&format);
+
+	if(!complete || packets.empty()) return;
+
+	std::sort(packets.begin(), packets.end());
+
+	std::vector<int64_t> p;
+	std::vector<long> k;
+	p.reserve(packets.size());
+	for(size_t i=0; i<packets.size(); ++i)
+	{
+		p.push_back(packets[i].first);
+		if(packets[i].second) k.push_back(long(i));
+	}
+	if(k.empty() || k[0] != 0) k.insert(k.begin(), 0);
+
+	pts.swap(p);
+	keyframes.swap(k);
+	ready = true;
+}
+
+//-----------------------------------------------------------------------------
+long VideoSeekIndex::KeyframeBefore(long frameNum) const
+{
+	auto k = std::upper_bound(keyframes.begin(), keyframes.end(), frameNum);
+	return (k == keyframes.begin()) ? 0 : *(k-1);
+}
+
+//-----------------------------------------------------------------------------
+long VideoSeekIndex::FrameAt(int64_t ts) const
+{
+	return long(std::lower_bound(pts.begin(), pts.end(), ts) - pts.begin());
+}
+
+//-----------------------------------------------------------------------------
+void VideoFrameCache::SetCapacity(size_t n)
+{
+	capacity = std::max(size_t(1), n);
+	while(frames.size() > capacity)
+	{
+		av_frame_free(&(frames.begin()->second));
+		frames.erase(frames.begin());
+	}
+}
+
+//-----------------------------------------------------------------------------
+const AVFrame *VideoFrameCache::Find(long frameNum) const
+{
+	auto f = frames.find(frameNum);
+	return (f == frames.end()) ? NULL : f->second;
+}
+
+//-----------------------------------------------------------------------------
+const AVFrame *VideoFrameCache::Put(long frameNum, const AVFrame *frame)
+{
+	auto f = frames.find(frameNum);
+	if(f != frames.end())
+		return f->second;
+
+	if(frames.size() >= capacity)
+	{
+		// the frames at either end are the furthest from frameNum
+		auto first = frames.begin();
+		auto last = std::prev(frames.end());
+		auto drop = (std::labs(first->first - frameNum) >
+				std::labs(last->first - frameNum)) ? first : last;
+		av_frame_free(&(drop->second));
+		frames.erase(drop);
+	}
+
+	// Another reference to the decoder's buffers, not a copy of the pixels:
+	// the decoder won't reuse them while the cache holds the reference,
+	// but they are shared and must not be written to.
+	AVFrame *ref = av_frame_clone(frame);
+	if(ref == NULL) return NULL;
+
+	frames[frameNum] = ref;
+	return ref;
+}
+
+//-----------------------------------------------------------------------------
+void VideoFrameCache::Clear()
+{
+	for(auto &f : frames)
+		av_frame_free(&(f.second));
+	frames.clear();
+}
@@ -0,0 +1,118 @@
+//-----------------------------------------------------------------------------
+// This file is part of Virtual Film Bench
+//
+// Copyright (c) 2025 University of South Carolina and Thomas Aschenbach
+//
+// Project contributors include: Thomas Aschenbach (Colorlab, inc.),
+// L. Scott Johnson (USC), Greg Wilsbacher (USC), Pingping Cai (USC),
+// and Stella Garcia (USC).
+//
+// Funding for Virtual Film Bench development was provided through a grant
+// from the National Endowment for the Humanities with additional support
+// from the National Science Foundation’s Access program.
+//
+// This program is free software; you can redistribute it and/or modify it
+// under the terms of the GNU General Public License as published by the
+// Free Software Foundation; either version 3 of the License, or (at your
+// option) any later version.
+//
+// Virtual Film Bench is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+// or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+// for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, see http://gnu.org/licenses/.
+//
+// For inquiries or permissions, contact
+// Greg Wilsbacher (gregw@mailbox.sc.edu)
+//-----------------------------------------------------------------------------
+
+// Frame-accurate seeking in libav video sources.
+//
+// VideoSeekIndex demuxes the whole stream once, on a background thread
+// with its own AVFormatContext, and records every frame's presentation
+// timestamp and which frames are keyframes. Frame numbers are positions in
+// presentation order, which is what the timestamps of decoded frames are
+// matched against, so long-GOP, open-GOP and variable frame rate files
+// land on the right frame. Until the index is ready a constant frame rate
+// is assumed.
+//
+// VideoFrameCache keeps references to recently decoded frames, so stepping
+// backward through a GOP decodes it once rather than once per step.
+
+#ifndef VIDEOSEEK_H
+#define VIDEOSEEK_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+#define VIDEO_GOP_CACHE_FRAMES 48
+
+//-----------------------------------------------------------------------------
+class VideoSeekIndex {
+private:
+	std::vector<int64_t> pts;     // of each frame, in presentation order
+	std::vector<long> keyframes;  // frame numbers, ascending
+
+	std::thread builder;
+	std::atomic<bool> ready;
+	std::atomic<bool> cancel;
+
+	void Build(const std::string filename, int streamIdx);
+
+public:
+	VideoSeekIndex() : ready(false), cancel(false) {} ;
+	~VideoSeekIndex() { Stop(); }
+
+	// index streamIdx of filename in the background
+	void Start(const std::string &filename, int streamIdx);
+	void Stop();
+
+	// nothing else may be called until the index is ready
+	bool IsReady() const { return ready; }
+
+	long NumFrames() const { return long(pts.size()); }
+	int64_t PTS(long frameNum) const { return pts[frameNum]; }
+
+	// the last keyframe at or before frameNum
+	long KeyframeBefore(long frameNum) const;
+
+	// the frame with timestamp ts, or the first one after it
+	long FrameAt(int64_t ts) const;
+};
+
+//-----------------------------------------------------------------------------
+class VideoFrameCache {
+private:
+	std::map<long, AVFrame *> frames;
+	size_t capacity;
+
+public:
+	VideoFrameCache() : capacity(VIDEO_GOP_CACHE_FRAMES) {} ;
+	~VideoFrameCache() { Clear(); }
+
+	void SetCapacity(size_t n);
+
+	// NULL if frameNum isn't cached
+	const AVFrame *Find(long frameNum) const;
+
+	// Keep a reference to frame (its buffers are shared, not copied) as
+	// frameNum, dropping the cached frame furthest from it if the cache is
+	// full. Returns the cached frame.
+	const AVFrame *Put(long frameNum, const AVFrame *frame);
+
+	void Clear();
+};
+
+#endif // VIDEOSEEK_H